@@ -22,6 +22,55 @@ typedef enum {
     WORKLOAD_MIXED
 } workload_type_t;
 
+// RESPB decoder selection
+typedef enum {
+    RESPB_DECODER_SWITCH = 0,   // Hand-written switch (respb_parse_command)
+    RESPB_DECODER_TABLE,        // Schema table interpreter (respb_parse_command_table)
+    RESPB_DECODER_BOTH
+} respb_decoder_t;
+
+// Reply shapes for the reply-path benchmarks
+typedef enum {
+    REPLY_KIND_OK = 0,          // +OK (SET)
+    REPLY_KIND_INT,             // :n (INCR)
+    REPLY_KIND_BULK,            // 64-byte GET hit
+    REPLY_KIND_NULL,            // GET miss
+    REPLY_KIND_MGET,            // 10 values, every third one null
+    REPLY_KIND_LRANGE,          // 100 list elements
+    REPLY_KIND_HGETALL,         // 20 field/value pairs
+    REPLY_KIND_EXEC,            // Nested: OK, int, 2-element array, error
+    REPLY_KIND_MIXED,           // All of the above in turn
+    REPLY_KIND_COUNT
+} reply_kind_t;
+
+// Benchmark modes
+typedef enum {
+    BENCH_MODE_PARSE = 0,       // One parse call per frame
+    BENCH_MODE_BATCH,           // Also drain the RESPB workload with respb_parse_batch()
+    BENCH_MODE_STREAM,          // Feed both protocols in recv()-sized chunks
+    BENCH_MODE_MSET,            // MSET with 10, 100, 1k and 10k keys
+    BENCH_MODE_ITER,            // Argument iterator vs full parse on MGET/MSET/SADD
+    BENCH_MODE_SKIP,            // Also size the RESPB workload with respb_peek_frame()
+    BENCH_MODE_PASSTHROUGH,     // RESP passthrough shares, sds copy vs borrowed decode
+    BENCH_MODE_MODULES,         // Core vs generated vs runtime-registered module commands
+    BENCH_MODE_NAMES,           // Command name lookup: perfect hash vs strcasecmp vs dict
+    BENCH_MODE_SERIALIZE,       // Schema encoder throughput per command category
+    BENCH_MODE_IOV,             // Scatter/gather vs memcpy serializer on large values
+    BENCH_MODE_SIZE,            // Exact-size vs grow-and-retry pipeline buffers
+    BENCH_MODE_PIPELINE,        // Pipeline builder throughput at depths 1 to 10k
+    BENCH_MODE_REPLY,           // Reply decoding per reply shape, RESPB vs RESP
+    BENCH_MODE_CLIENT,          // Client read path: hiredis reader vs RESPB reply decoder
+    BENCH_MODE_VARINT,          // Fixed-width vs varint lengths: wire size and decode cost
+    BENCH_MODE_COMPRESS,        // LZ4-compressed frames: bandwidth saved vs CPU spent
+    BENCH_MODE_KEYDICT,         // Key IDs on Zipfian keys: wire size and decode cost
+    BENCH_MODE_HANDSHAKE,       // Per-connection protocol detection and upgrade cost
+    BENCH_MODE_TRANSCODE,       // RESP -> RESPB transcoder throughput by thread count
+    BENCH_MODE_ROUNDTRIP,       // RESP -> RESPB -> RESP transcoding per workload type
+    BENCH_MODE_AOF,             // Parallel RESPB AOF load vs RESP replay
+    BENCH_MODE_INDEX,           // Frame index build cost and seek latency
+    BENCH_MODE_COMPACT          // AOF compaction throughput and replay-time reduction
+} benchmark_mode_t;
+
 // Workload structure
 typedef struct {
     uint8_t *data;
@@ -63,15 +112,26 @@ typedef struct {
     int bench_resp;
     int bench_respb;
     workload_type_t workload_type;
+    respb_decoder_t respb_decoder;
+    benchmark_mode_t mode;
+    size_t batch_size;
+    size_t chunk_size;
     const char *resp_workload_file;
     const char *respb_workload_file;
     benchmark_metrics_t resp_metrics;
     benchmark_metrics_t respb_metrics;
+    benchmark_metrics_t respb_table_metrics;
 } benchmark_config_t;
 
 // Workload functions
 workload_t *workload_load(const char *filename);
 workload_t *workload_generate_synthetic(size_t target_size, workload_type_t type);
+workload_t *workload_generate_multikey(size_t target_size, uint16_t opcode,
+                                       size_t nelems, int respb);
+workload_t *workload_generate_passthrough(size_t target_size, unsigned percent);
+workload_t *workload_generate_modules(size_t target_size, const uint32_t subcommands[4]);
+workload_t *workload_generate_replies(size_t target_size, reply_kind_t kind, int respb);
+const char *workload_reply_kind_name(reply_kind_t kind);
 void workload_free(workload_t *wl);
 void workload_reset(workload_t *wl);
 int workload_has_more(const workload_t *wl);
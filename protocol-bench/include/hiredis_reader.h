@@ -0,0 +1,93 @@
+/*
+ * hiredis Reply Reader API
+ *
+ * The RESP reply reader of hiredis (read.c) with its default reply object
+ * functions (hiredis.c), reduced to RESP2 for standalone use in the
+ * benchmark. Allocations go through counting wrappers, like hiredis'
+ * pluggable hiredisAllocFuncs.
+ */
+
+#ifndef HIREDIS_READER_H
+#define HIREDIS_READER_H
+
+#include <stddef.h>
+
+/* ==================== Type Definitions ==================== */
+
+#define REDIS_ERR -1
+#define REDIS_OK 0
+
+#define REDIS_ERR_PROTOCOL 4
+#define REDIS_ERR_OOM 5
+
+#define REDIS_REPLY_STRING 1
+#define REDIS_REPLY_ARRAY 2
+#define REDIS_REPLY_INTEGER 3
+#define REDIS_REPLY_NIL 4
+#define REDIS_REPLY_STATUS 5
+#define REDIS_REPLY_ERROR 6
+
+#define REDIS_READER_MAX_BUF (1024 * 16)    /* Discard read bytes above this */
+#define REDIS_READER_STACK_SIZE 9           /* Nesting depth */
+
+/* Reply object created by the default object functions */
+typedef struct redisReply {
+    int type;
+    long long integer;                /* REDIS_REPLY_INTEGER */
+    size_t len;                       /* Length of str */
+    char *str;                        /* STRING, STATUS and ERROR, NUL-terminated */
+    size_t elements;                  /* Number of elements (ARRAY) */
+    struct redisReply **element;      /* Elements (ARRAY) */
+} redisReply;
+
+/* One level of the nesting stack */
+typedef struct redisReadTask {
+    int type;
+    long long elements;               /* Number of elements in a multibulk */
+    int idx;                          /* Index in parent (array) object */
+    void *obj;                        /* Holds user-generated value for a read task */
+    struct redisReadTask *parent;
+} redisReadTask;
+
+typedef struct redisReader {
+    int err;                          /* Error flags, 0 when there is no error */
+    char errstr[128];
+
+    char *buf;                        /* Read buffer (the sds in hiredis) */
+    size_t buf_alloc;
+    size_t pos;                       /* Buffer cursor */
+    size_t len;                       /* Buffer length */
+    size_t maxbuf;                    /* Max length of unused buffer */
+
+    redisReadTask task[REDIS_READER_STACK_SIZE];
+    int ridx;                         /* Index of current read task */
+    void *reply;                      /* Temporary reply pointer */
+} redisReader;
+
+/* ==================== Public API ==================== */
+
+redisReader *redisReaderCreate(void);
+void redisReaderFree(redisReader *r);
+
+/**
+ * Append received bytes to the reader's buffer
+ */
+int redisReaderFeed(redisReader *r, const char *buf, size_t len);
+
+/**
+ * Parse the next reply. Returns REDIS_OK with *reply set to a redisReply,
+ * or to NULL when the buffer holds no complete reply; REDIS_ERR on a
+ * protocol error or OOM (see r->err)
+ */
+int redisReaderGetReply(redisReader *r, void **reply);
+
+void freeReplyObject(void *reply);
+
+/* ==================== Allocation Counters ==================== */
+
+/* malloc/calloc/realloc calls made by the reader and reply objects */
+extern unsigned long long hiredis_alloc_count;
+/* free() calls */
+extern unsigned long long hiredis_free_count;
+
+#endif // HIREDIS_READER_H
@@ -8,6 +8,8 @@
 
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
+#include <sys/uio.h>
 
 // RESPB Opcodes (Request commands: 0x0000-0xEFFF)
 // String Operations (0x0000-0x003F)
@@ -298,6 +300,8 @@
 
 // Module and special opcodes
 #define RESPB_OP_MODULE     0xF000
+#define RESPB_OP_COMPRESSED 0xF001  // LZ4-compressed frame (respb_compress.h)
+#define RESPB_OP_KEY_BIND   0xF002  // Bind a key ID (respb_keydict.h)
 #define RESPB_OP_RESP_PASSTHROUGH 0xFFFF
 
 // Module IDs (high 16 bits of 4-byte subcommand)
@@ -305,13 +309,33 @@
 #define RESPB_MODULE_BF     0x0001
 #define RESPB_MODULE_FT     0x0002
 
-// Response opcodes (0x8000-0xFFFE)
+// Response opcodes (0x8000-0xFFFE), numbered as in respb-commands.md
 #define RESPB_RESP_OK       0x8000
 #define RESPB_RESP_ERROR    0x8001
-#define RESPB_RESP_NULL     0x8002
-#define RESPB_RESP_INT      0x8003
-#define RESPB_RESP_BULK     0x8004
-#define RESPB_RESP_ARRAY    0x8005
+#define RESPB_RESP_INT      0x8002
+#define RESPB_RESP_BULK     0x8003
+#define RESPB_RESP_ARRAY    0x8004
+#define RESPB_RESP_NULL     0x8005
+
+// Handshake (respb-specs.md): [0xD3][0xC1][1B version][1B flags]. The flags
+// byte selects wire options for the rest of the connection
+#define RESPB_MAGIC_0       0xD3
+#define RESPB_MAGIC_1       0xC1
+#define RESPB_VERSION       0x01
+#define RESPB_HANDSHAKE_SIZE 4
+
+// Handshake flags
+#define RESPB_FLAG_VARINT   0x01    // String lengths, group counts and the
+                                    // passthrough length are LEB128 varints
+#define RESPB_FLAG_COMPRESS 0x02    // Peer accepts 0xF001 compressed frames
+#define RESPB_FLAG_KEYDICT  0x04    // 2-byte string fields may reference a
+                                    // key bound with 0xF002 (not with VARINT)
+
+// With RESPB_FLAG_KEYDICT, this 2-byte length is followed by a 2-byte key ID
+#define RESPB_KEY_REF       0xFFFF
+
+// Longest LEB128 encoding of a 32-bit length
+#define RESPB_VARINT_MAX    5
 
 // Maximum arguments per command
 #define RESPB_MAX_ARGS      64
@@ -336,6 +360,75 @@ typedef struct {
     uint32_t resp_length;   // Length of following RESP text data
 } respb_resp_passthrough_t;
 
+// Typed views of decoded numeric fields. respb_parse_command() fills the
+// view named for the opcodes listed with it; other opcodes leave it unset.
+// The serializers read numeric fields back from the same view.
+typedef struct {
+    uint8_t flags;
+    int64_t expiry;         // GETEX, HGETEX, HSETEX: 0 unless flags & 0x01
+} respb_set_view_t;         // SET, GETEX, HGETEX, HSETEX, JSON.SET (flags only)
+
+typedef struct {
+    int64_t increment;
+} respb_incr_view_t;        // INCRBY, DECRBY, HINCRBY
+
+typedef struct {
+    double increment;
+} respb_incrbyfloat_view_t; // INCRBYFLOAT, HINCRBYFLOAT, ZINCRBY, JSON.NUMINCRBY, JSON.NUMMULTBY
+
+typedef struct {
+    int64_t ttl;
+} respb_setex_view_t;       // SETEX (seconds), PSETEX (milliseconds)
+
+typedef struct {
+    int64_t value;
+} respb_index_view_t;       // LINDEX, LSET, JSON.ARRINSERT (index), LREM (count), SETRANGE, GETBIT, SETBIT (offset)
+
+typedef struct {
+    int64_t start;
+    int64_t stop;
+    uint8_t flags;          // ZRANGE, ZREVRANGE only
+} respb_range_view_t;       // GETRANGE, SUBSTR, LRANGE, LTRIM, ZRANGE, ZREVRANGE, ZREMRANGEBYRANK, JSON.ARRTRIM
+
+typedef struct {
+    double min;
+    double max;
+    uint8_t flags;          // ZRANGEBYSCORE, ZREVRANGEBYSCORE only
+} respb_score_range_view_t; // ZCOUNT, ZRANGEBYSCORE, ZREVRANGEBYSCORE, ZREMRANGEBYSCORE
+
+typedef struct {
+    int64_t time;           // Seconds, milliseconds or Unix timestamp per opcode
+    uint8_t flags;
+} respb_expire_view_t;      // EXPIRE, PEXPIRE, EXPIREAT, PEXPIREAT, HEXPIRE, HPEXPIRE, HEXPIREAT, HPEXPIREAT
+
+typedef struct {
+    uint8_t flags;
+    uint16_t count;         // Score/member (ZADD) or lon/lat/member (GEOADD) entries
+    uint32_t at[RESPB_MAX_ARGS - 1];  // raw_payload offset of each stored entry's numbers
+} respb_zadd_view_t;        // ZADD, GEOADD; see respb_zadd_score(), respb_geoadd_coords()
+
+typedef struct {
+    int64_t cursor;
+} respb_scan_view_t;        // SCAN, SSCAN, HSCAN, ZSCAN
+
+typedef struct {
+    int64_t timeout;
+} respb_timeout_view_t;     // BLPOP, BRPOP, BRPOPLPUSH, BLMOVE, BLMPOP, BZPOPMIN, BZPOPMAX, BZMPOP
+
+typedef union {
+    respb_set_view_t set;
+    respb_incr_view_t incr;
+    respb_incrbyfloat_view_t incrbyfloat;
+    respb_setex_view_t setex;
+    respb_index_view_t index;
+    respb_range_view_t range;
+    respb_score_range_view_t score_range;
+    respb_expire_view_t expire;
+    respb_zadd_view_t zadd;
+    respb_scan_view_t scan;
+    respb_timeout_view_t timeout;
+} respb_view_t;
+
 // Parsed command
 typedef struct {
     uint16_t opcode;
@@ -351,13 +444,21 @@ typedef struct {
     // RESP passthrough fields (when opcode == RESPB_OP_RESP_PASSTHROUGH)
     uint32_t resp_length;
     const uint8_t *resp_data;
+    // Decoded numeric fields; zero them in a command built by hand
+    respb_view_t view;
 } respb_command_t;
 
+struct respb_keydict;
+
 // Parser state
 typedef struct {
     const uint8_t *buffer;
     size_t buffer_len;
     size_t pos;
+    uint8_t flags;          // Negotiated RESPB_FLAG_* options (0 after init)
+    uint8_t *inflate_buf;   // Receives the frame inside a 0xF001 frame; args
+    size_t inflate_cap;     // then point here. NULL after init: rejected
+    struct respb_keydict *keydict;  // Key IDs for RESPB_FLAG_KEYDICT (NULL after init)
 } respb_parser_t;
 
 // Parser functions
@@ -373,6 +474,35 @@ void respb_write_u64(uint8_t *buf, uint64_t val);
 size_t respb_serialize_header(uint8_t *buf, uint16_t opcode, uint16_t mux_id);
 size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command_t *cmd);
 
+// Exact size of the frame respb_serialize_command() writes for cmd, 0 if it
+// cannot serialize cmd. A buffer of this size never makes it return 0
+size_t respb_serialized_size(const respb_command_t *cmd);
+
+// Sum of respb_serialized_size() over cmds[0..count), so a pipeline can be
+// encoded into one allocation. Stores each frame size in sizes[] unless it is
+// NULL. Returns 0 if any command cannot be serialized
+size_t respb_serialized_size_batch(const respb_command_t *cmds, size_t count, size_t *sizes);
+
+// Strings shorter than this are copied into the scratch buffer: below it an
+// extra iovec costs more than the memcpy it saves
+#define RESPB_IOV_COPY_MAX  512
+
+// Scatter/gather form of respb_serialize_command() for writev()/sendmsg().
+// Header, numeric fields and length prefixes are written to scratch; strings
+// of RESPB_IOV_COPY_MAX bytes or more, and passthrough RESP text, are
+// referenced in place, so cmd's buffers must outlive the write. Fills up to
+// max_iov entries and sets *iovcnt. Returns the frame size, 0 if scratch or
+// iov is too small or the command does not fit its schema
+size_t respb_serialize_iov(uint8_t *scratch, size_t scratch_len, struct iovec *iov,
+                           size_t max_iov, size_t *iovcnt, const respb_command_t *cmd);
+
+// Wire-option form of respb_serialize_command(): flags 0 is the same call,
+// RESPB_FLAG_VARINT encodes through the schema tables with varint lengths.
+// Commands whose group count argc cannot decide (EVAL, FCALL, BITFIELD)
+// need respb_serialize_schema_flags()
+size_t respb_serialize_command_flags(uint8_t *buf, size_t buf_len, const respb_command_t *cmd,
+                                     uint8_t flags);
+
 // Helper functions for reading
 static inline uint16_t respb_read_u16(const uint8_t *buf) {
     return ((uint16_t)buf[0] << 8) | buf[1];
@@ -390,4 +520,66 @@ static inline uint64_t respb_read_u64(const uint8_t *buf) {
            ((uint64_t)buf[6] << 8) | buf[7];
 }
 
+static inline double respb_read_f64(const uint8_t *buf) {
+    uint64_t bits = respb_read_u64(buf);
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+// LEB128: 7 bits per byte, low bits first, high bit set on every byte but
+// the last. Lengths below 128 take one byte
+static inline size_t respb_varint_size(uint32_t val) {
+    size_t n = 1;
+    while (val >= 0x80) {
+        val >>= 7;
+        n++;
+    }
+    return n;
+}
+
+static inline size_t respb_write_varint(uint8_t *buf, uint32_t val) {
+    size_t n = 0;
+    while (val >= 0x80) {
+        buf[n++] = (uint8_t)(val | 0x80);
+        val >>= 7;
+    }
+    buf[n++] = (uint8_t)val;
+    return n;
+}
+
+// Read a varint from buf[0..len). Returns the bytes used, 0 if buf ends
+// inside it, -1 if it is longer than RESPB_VARINT_MAX or exceeds 32 bits
+static inline int respb_read_varint(const uint8_t *buf, size_t len, uint32_t *val) {
+    if (len > 0 && buf[0] < 0x80) {
+        *val = buf[0];
+        return 1;
+    }
+    uint32_t v = 0;
+    for (size_t i = 0; i < RESPB_VARINT_MAX; i++) {
+        if (i == len) return 0;
+        uint8_t b = buf[i];
+        if (i == RESPB_VARINT_MAX - 1 && b > 0x0F) return -1;
+        v |= (uint32_t)(b & 0x7F) << (7 * i);
+        if (!(b & 0x80)) {
+            *val = v;
+            return (int)i + 1;
+        }
+    }
+    return -1;
+}
+
+// Score of ZADD entry i (0-based, i < argc - 1), read from the frame at the
+// offset the parser recorded, however the member was encoded
+static inline double respb_zadd_score(const respb_command_t *cmd, size_t i) {
+    return respb_read_f64(cmd->raw_payload + cmd->view.zadd.at[i]);
+}
+
+// Coordinates of GEOADD entry i (0-based, i < argc - 1)
+static inline void respb_geoadd_coords(const respb_command_t *cmd, size_t i,
+                                       double *longitude, double *latitude) {
+    *longitude = respb_read_f64(cmd->raw_payload + cmd->view.zadd.at[i]);
+    *latitude = respb_read_f64(cmd->raw_payload + cmd->view.zadd.at[i] + 8);
+}
+
 #endif // RESPB_H
@@ -0,0 +1,48 @@
+/*
+ * RESPB AOF Loader
+ * Replays a file of RESPB frames: one pass over the frame lengths finds the
+ * boundaries, worker threads decode disjoint ranges, and a single applier
+ * receives the commands in file order
+ */
+
+#ifndef RESPB_AOF_H
+#define RESPB_AOF_H
+
+#include "respb.h"
+
+// Frames per batch handed to the applier. Each batch in flight holds this
+// many respb_command_t
+#define RESPB_AOF_BATCH         256
+
+// Batches decoded ahead of the applier, per worker thread
+#define RESPB_AOF_AHEAD         4
+
+#define RESPB_AOF_MAX_THREADS   64
+
+typedef struct {
+    uint64_t commands;      // Commands applied
+    uint64_t batches;
+    size_t bytes;           // Input bytes applied
+    size_t error_pos;       // Offset of the first bad or truncated frame
+} respb_aof_stats_t;
+
+// Receives cmds[0..count) in file order, on the thread that called
+// respb_aof_load(). Argument spans point into the loaded data. Returns 1 to
+// continue, 0 to stop
+typedef int (*respb_aof_apply_fn)(void *ctx, const respb_command_t *cmds, size_t count);
+
+// Load the fixed-width frames data[0..len) with nthreads decoding threads (1
+// decodes on the calling thread). Compressed and key bind frames carry
+// connection state and are rejected. Returns 1 when every frame was
+// applied, 0 if apply stopped or memory ran out, -1 on an unknown opcode or
+// a frame cut short. On -1, every frame before stats->error_pos has been
+// applied, so truncating the file there recovers it. stats may be NULL
+int respb_aof_load(const uint8_t *data, size_t len, int nthreads,
+                   respb_aof_apply_fn apply, void *ctx, respb_aof_stats_t *stats);
+
+// mmap path and load it as above. Returns 0 with errno set if the file
+// cannot be read
+int respb_aof_load_file(const char *path, int nthreads, respb_aof_apply_fn apply, void *ctx,
+                        respb_aof_stats_t *stats);
+
+#endif // RESPB_AOF_H
@@ -0,0 +1,70 @@
+/*
+ * RESPB Argument Arena
+ * Growable argument storage and a compact command struct for frames with
+ * any number of arguments
+ */
+
+#ifndef RESPB_ARGS_H
+#define RESPB_ARGS_H
+
+#include "respb.h"
+
+// Arguments held inside respb_cmd_t before spilling to the arena
+#define RESPB_INLINE_ARGS   4
+
+// Initial arena capacity in argument spans
+#define RESPB_ARENA_DEFAULT 1024
+
+// One arena block; older blocks stay reachable through prev until reset
+typedef struct respb_arena_block {
+    struct respb_arena_block *prev;
+    size_t used;
+    size_t capacity;
+    respb_arg_t args[];
+} respb_arena_block_t;
+
+// Argument arena. Spans handed out stay valid until respb_arena_reset(), which
+// folds all blocks into a single one sized to the high-water mark, so a steady
+// workload stops allocating after its largest command.
+typedef struct {
+    respb_arena_block_t *head;  // Current block
+    size_t total;               // Capacity of all blocks
+} respb_arena_t;
+
+// Compact parsed command (88 bytes vs ~1.1 KB for respb_command_t).
+// Up to RESPB_INLINE_ARGS spans live inline, larger frames point into the
+// arena. RESP passthrough frames carry the RESP text as their single arg.
+typedef struct {
+    uint16_t opcode;
+    uint16_t mux_id;
+    uint32_t argc;
+    uint32_t module_subcommand; // Module ID << 16 | command ID (module frames only)
+    uint32_t raw_payload_len;
+    const uint8_t *raw_payload;
+    union {
+        respb_arg_t inline_args[RESPB_INLINE_ARGS];
+        respb_arg_t *spill;
+    } u;
+} respb_cmd_t;
+
+// Arena lifecycle (init returns 1 on success)
+int respb_arena_init(respb_arena_t *arena, size_t initial_args);
+void respb_arena_reset(respb_arena_t *arena);
+void respb_arena_free(respb_arena_t *arena);
+
+// Reserve n contiguous argument spans (NULL on allocation failure)
+respb_arg_t *respb_arena_alloc(respb_arena_t *arena, size_t n);
+
+// Table-driven decode into a compact command, with no argument limit.
+// Returns 1 on success, 0 if more data is needed, -1 on unknown opcode or
+// allocation failure. Fixed-width frames only: -1 if parser->flags has
+// RESPB_FLAG_VARINT or RESPB_FLAG_KEYDICT, and 0xF001/0xF002 frames are
+// unknown opcodes here
+int respb_parse_compact(respb_parser_t *parser, respb_cmd_t *cmd, respb_arena_t *arena);
+
+// Argument spans of a compact command
+static inline const respb_arg_t *respb_cmd_args(const respb_cmd_t *cmd) {
+    return cmd->argc <= RESPB_INLINE_ARGS ? cmd->u.inline_args : cmd->u.spill;
+}
+
+#endif // RESPB_ARGS_H
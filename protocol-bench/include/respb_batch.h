@@ -0,0 +1,47 @@
+/*
+ * RESPB Batch Parser
+ * Decodes many pipelined frames in one pass into struct-of-arrays output
+ */
+
+#ifndef RESPB_BATCH_H
+#define RESPB_BATCH_H
+
+#include "respb.h"
+
+#define RESPB_CACHE_LINE 64
+
+// Struct-of-arrays output of respb_parse_batch(). Each array starts on its
+// own cache line. frame_offsets and arg_first hold count + 1 entries, so
+// frame i spans [frame_offsets[i], frame_offsets[i + 1]) of the input and
+// owns args[arg_first[i] .. arg_first[i + 1]).
+typedef struct {
+    uint16_t *opcodes;
+    uint16_t *mux_ids;
+    uint32_t *subcommands;      // Module subcommand (0 for non-module frames)
+    uint32_t *frame_offsets;    // Byte offset of each frame in the input
+    uint32_t *arg_first;        // Index of each frame's first arg span
+    respb_arg_t *args;          // Arg spans pointing into the input buffer
+    size_t frame_capacity;
+    size_t arg_capacity;
+    // Result of the last respb_parse_batch() call
+    size_t count;               // Frames decoded
+    size_t consumed;            // Bytes consumed (end of the last whole frame)
+    int status;                 // 1 = done or batch full, 0 = partial frame at
+                                // `consumed`, -1 = unknown opcode at `consumed`,
+                                // -2 = the frame at `consumed` has more args
+                                // than arg_capacity
+    void *block;                // Single aligned allocation behind the arrays
+} respb_batch_t;
+
+// Allocate room for max_frames frames and max_args arg spans (1 on success)
+int respb_batch_init(respb_batch_t *batch, size_t max_frames, size_t max_args);
+void respb_batch_free(respb_batch_t *batch);
+
+// Decode up to max frames from buf (at most 4 GiB per call). Stops early at a
+// partial frame, an unknown opcode, or when the next frame's args do not fit
+// in the remaining arg capacity. If even the first frame's args do not fit,
+// nothing is decoded and status is -2: retry with a larger batch. Returns
+// the number of frames decoded.
+size_t respb_parse_batch(const uint8_t *buf, size_t len, respb_batch_t *out, size_t max);
+
+#endif // RESPB_BATCH_H
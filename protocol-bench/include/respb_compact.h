@@ -0,0 +1,51 @@
+/*
+ * RESPB AOF Compaction
+ * Rewrites a RESPB AOF without the writes a later SET or DEL of the same
+ * key supersedes, so replay cost follows the dataset rather than its history
+ */
+
+#ifndef RESPB_COMPACT_H
+#define RESPB_COMPACT_H
+
+#include "respb.h"
+#include "respb_index.h"
+
+typedef struct {
+    uint64_t commands;      // Frames read
+    uint64_t kept;          // Frames written, SELECTs included
+    uint64_t keys;          // Last-writer entries: one per key and fence segment
+    uint64_t fences;        // Frames kept as barriers (see respb_compact())
+    size_t in_bytes;
+    size_t out_bytes;
+    size_t memory;          // Key table size, at its largest
+    size_t error_pos;       // Offset of the bad frame on -1
+} respb_compact_stats_t;
+
+// Receives the compacted AOF in order. Returns 1 to continue, 0 to stop
+typedef int (*respb_compact_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+// Two passes over the fixed-width frames data[0..len). Any command not
+// listed below could read or write keys it does not name, so it is kept as
+// a fence and nothing is dropped across it. The first pass records, per
+// (db, key, fences before), the offset of the last overwrite: a SET
+// without NX/XX, SETEX, PSETEX, DEL, UNLINK or GETDEL. The second writes
+// every frame except those on a key overwritten later before the next
+// fence. EXPIRE, INCRBY and the other commands that change only their first
+// key (HSET, ZADD, LPUSH and similar) are dropped with their key like SET.
+// A DEL whose keys nothing kept has given a value is dropped as well.
+// MULTI and EXEC are kept unless emptied, and SELECT is written only where
+// the database of the next kept frame changes. Keys are not copied: the
+// table holds their offsets into data, which must stay mapped. Returns 1,
+// 0 if write stopped or memory ran out, -1 on an unknown opcode, a frame
+// cut short, or a compressed or key bind frame (stats->error_pos set).
+// stats may be NULL
+int respb_compact(const uint8_t *data, size_t len, respb_compact_write_fn write, void *ctx,
+                  respb_compact_stats_t *stats);
+
+// mmap in_path and write its compaction to out_path, also appended to
+// index unless it is NULL. Returns 1, 0 on an I/O error (errno set), -1 on
+// a bad frame
+int respb_compact_file(const char *in_path, const char *out_path, respb_index_t *index,
+                       respb_compact_stats_t *stats);
+
+#endif // RESPB_COMPACT_H
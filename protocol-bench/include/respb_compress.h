@@ -0,0 +1,60 @@
+/*
+ * RESPB Frame Compression
+ * 0xF001 frames carry one LZ4-compressed frame; large values are compressed
+ * above a size threshold and inflated by the parsers
+ */
+
+#ifndef RESPB_COMPRESS_H
+#define RESPB_COMPRESS_H
+
+#include "respb.h"
+
+// [0xF001][2B mux_id][4B raw_len][4B comp_len][LZ4 block]. The block inflates
+// to raw_len bytes holding exactly one frame (header included) on the same
+// mux_id. The lengths stay fixed-width in varint mode
+#define RESPB_COMPRESSED_HEADER_SIZE 12
+
+#define RESPB_LZ4_HASH_LOG      12      // 4096-entry match table (16 KB)
+
+// Frames shorter than this gain too little to pay for compression
+#define RESPB_COMPRESS_DEFAULT_THRESHOLD 1024
+
+// Encoder state, reused across frames
+typedef struct {
+    size_t threshold;       // Frames shorter than this are written as-is
+    int acceleration;       // LZ4 acceleration: 1 = best ratio, higher = faster
+    uint8_t *scratch;       // Uncompressed frame, grown as needed
+    size_t scratch_cap;
+    uint32_t table[1 << RESPB_LZ4_HASH_LOG];
+} respb_compressor_t;
+
+void respb_compressor_init(respb_compressor_t *c, size_t threshold, int acceleration);
+void respb_compressor_free(respb_compressor_t *c);
+
+// LZ4 block format. Compress src[0..len) into dst and return the block size,
+// 0 if it does not fit in cap bytes. table is RESPB_LZ4_HASH_LOG scratch
+size_t respb_lz4_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                          uint32_t *table, int acceleration);
+
+// Inflate a block that must produce exactly raw_len bytes. Returns 1, or -1
+// on a malformed block; never reads or writes out of bounds
+int respb_lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t raw_len);
+
+// Write frame[0..frame_len) to buf: as a 0xF001 frame when it is at least
+// c->threshold bytes and compression makes it smaller, otherwise copied.
+// frame must not overlap buf. Returns the bytes written, 0 if buf is too small
+size_t respb_compress_frame(respb_compressor_t *c, uint8_t *buf, size_t buf_len,
+                            const uint8_t *frame, size_t frame_len);
+
+// respb_serialize_command_flags() followed by respb_compress_frame().
+// Returns the bytes written, 0 if cmd cannot be serialized into buf_len bytes
+size_t respb_serialize_compressed(respb_compressor_t *c, uint8_t *buf, size_t buf_len,
+                                  const respb_command_t *cmd, uint8_t flags);
+
+// Inflate the 0xF001 frame at parser->pos into parser->inflate_buf and set
+// *inner to a parser over it, with the same flags. Returns 1 and advances
+// parser->pos past the frame, 0 if it is incomplete, -1 if the parser has
+// no inflate buffer large enough or the block is malformed
+int respb_inflate_frame(respb_parser_t *parser, respb_parser_t *inner);
+
+#endif // RESPB_COMPRESS_H
@@ -0,0 +1,35 @@
+/*
+ * RESPB Frame Scanner
+ * Frame size, opcode and mux_id without decoding any arguments
+ */
+
+#ifndef RESPB_FRAME_H
+#define RESPB_FRAME_H
+
+#include "respb.h"
+
+// What a proxy needs to route one frame
+typedef struct {
+    uint16_t opcode;
+    uint16_t mux_id;
+    uint32_t module_subcommand; // Module ID << 16 | command ID (module frames only)
+    size_t length;              // Header + payload bytes
+} respb_frame_info_t;
+
+// Size the fixed-width frame at the start of buf by walking its length
+// prefixes; no argument spans are produced. 0xF001 and 0xF002 frames are
+// sized from their headers. Returns 1 with *info set, 0 if the frame is
+// incomplete, -1 on unknown opcode
+int respb_peek_frame(const uint8_t *buf, size_t len, respb_frame_info_t *info);
+
+// respb_peek_frame() for a connection that negotiated flags: varint lengths
+// with RESPB_FLAG_VARINT, [0xFFFF][2B key ID] string fields with
+// RESPB_FLAG_KEYDICT. Both together, or a malformed varint, return -1
+int respb_peek_frame_flags(const uint8_t *buf, size_t len, uint8_t flags,
+                           respb_frame_info_t *info);
+
+// Same scan as respb_peek_frame(), size only. Returns 1 with *frame_len set,
+// 0 if the frame is incomplete, -1 on unknown opcode
+int respb_frame_length(const uint8_t *buf, size_t len, size_t *frame_len);
+
+#endif // RESPB_FRAME_H
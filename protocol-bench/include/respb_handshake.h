@@ -0,0 +1,85 @@
+/*
+ * RESPB Handshake
+ * Protocol detection for a port that serves RESP and RESPB, and the
+ * [0xD3][0xC1][version][flags] upgrade with flag negotiation
+ */
+
+#ifndef RESPB_HANDSHAKE_H
+#define RESPB_HANDSHAKE_H
+
+#include "respb.h"
+
+// Flags this tree implements
+#define RESPB_FLAGS_SUPPORTED   (RESPB_FLAG_VARINT | RESPB_FLAG_COMPRESS | RESPB_FLAG_KEYDICT)
+
+// Flags that change how the sender encodes frames. The client sends its
+// first frames right after the handshake, so these cannot be negotiated
+// down: the server accepts them all or fails the handshake
+#define RESPB_FLAGS_ENCODING    (RESPB_FLAG_VARINT | RESPB_FLAG_KEYDICT)
+
+// Sent instead of the acknowledgment when the handshake is refused, so a
+// RESP-only client library sees an ordinary error and can fall back
+#define RESPB_HANDSHAKE_ERROR   "-ERR unsupported RESPB handshake\r\n"
+
+typedef enum {
+    RESPB_PROTO_UNKNOWN = 0,    // Need more bytes
+    RESPB_PROTO_RESP,           // Anything not starting with 0xD3
+    RESPB_PROTO_RESPB,          // Starts with the magic
+    RESPB_PROTO_INVALID         // 0xD3 without 0xC1: neither protocol
+} respb_protocol_t;
+
+// Classify a connection from its first bytes. One byte decides RESP; RESPB
+// needs both magic bytes
+static inline respb_protocol_t respb_detect_protocol(const uint8_t *data, size_t len) {
+    if (len == 0) return RESPB_PROTO_UNKNOWN;
+    if (data[0] != RESPB_MAGIC_0) return RESPB_PROTO_RESP;
+    if (len < 2) return RESPB_PROTO_UNKNOWN;
+    return data[1] == RESPB_MAGIC_1 ? RESPB_PROTO_RESPB : RESPB_PROTO_INVALID;
+}
+
+// Server side of a connection, before the first command
+typedef enum {
+    RESPB_HS_DETECT = 0,        // No bytes yet
+    RESPB_HS_HELLO,             // Magic started, waiting for the rest
+    RESPB_HS_RESP,              // Plain RESP connection
+    RESPB_HS_RESPB,             // Upgraded; hs->flags are in effect
+    RESPB_HS_FAILED             // Refused; close after sending the reply
+} respb_hs_state_t;
+
+typedef struct {
+    respb_hs_state_t state;
+    uint8_t supported;          // Flags the server offers
+    uint8_t version;            // Version the client sent
+    uint8_t flags;              // Negotiated flags once upgraded
+    uint8_t have;               // Handshake bytes held in hello
+    uint8_t hello[RESPB_HANDSHAKE_SIZE];
+} respb_handshake_t;
+
+void respb_handshake_init(respb_handshake_t *hs, uint8_t supported);
+
+// Feed the first bytes read from the connection; handshake bytes split
+// across reads are held in hs. *consumed is set to the handshake bytes
+// taken from data (0 for RESP), and the rest belongs to the first command.
+// Returns 0 when more bytes are needed, 1 once the protocol is decided
+// (with the acknowledgment in reply for an upgrade), or -1 when the
+// handshake is refused (with RESPB_HANDSHAKE_ERROR in reply). *reply_len
+// is the reply size, 0 if none; reply needs room for the error string
+int respb_handshake_feed(respb_handshake_t *hs, const uint8_t *data, size_t len,
+                         size_t *consumed, uint8_t *reply, size_t *reply_len);
+
+// Set up a parser for an upgraded connection
+static inline void respb_handshake_apply(const respb_handshake_t *hs, respb_parser_t *parser) {
+    parser->flags = hs->state == RESPB_HS_RESPB ? hs->flags : 0;
+}
+
+// Client hello and server acknowledgment share one format. Writes
+// RESPB_HANDSHAKE_SIZE bytes
+size_t respb_write_handshake(uint8_t *buf, uint8_t version, uint8_t flags);
+
+// Client side: read the server's answer, which arrives ahead of the first
+// reply. Returns 1 with *flags set to the flags the server accepted, 0 if
+// more bytes are needed, -1 if it is not an acknowledgment (a RESP error
+// means the server refused or does not speak RESPB)
+int respb_read_handshake_ack(const uint8_t *data, size_t len, uint8_t *flags);
+
+#endif // RESPB_HANDSHAKE_H
@@ -0,0 +1,89 @@
+/*
+ * RESPB Frame Index
+ * Sidecar index for RESPB AOF files: sparse checkpoints of (command ordinal,
+ * byte offset, opcode histogram), built while the frames are written, for
+ * seeking to the Nth command and splitting a file between threads without
+ * parsing it from the start
+ */
+
+#ifndef RESPB_INDEX_H
+#define RESPB_INDEX_H
+
+#include "respb.h"
+
+// Commands between checkpoints. A seek walks at most this many frame
+// lengths; the index costs about 30 bytes per checkpoint plus 6 per opcode
+// seen in each interval
+#define RESPB_INDEX_DEFAULT_INTERVAL    4096
+
+// File: [8B "RESPBIDX"][4B version][4B interval][8B commands][8B bytes]
+// [4B npoints][4B ncounts], then npoints x [8B ordinal][8B offset][4B nhist]
+// and ncounts x [2B opcode][4B count], each point's counts in point order.
+// Big-endian, like frames
+#define RESPB_INDEX_VERSION     1
+
+typedef struct {
+    uint64_t ordinal;       // Commands before this one
+    uint64_t offset;        // Byte offset of command `ordinal`
+    uint32_t hist;          // Its counts: counts[hist..hist + nhist)
+    uint32_t nhist;
+} respb_index_point_t;
+
+// Frames with this opcode in one interval. Module frames count as 0xF000
+typedef struct {
+    uint16_t opcode;
+    uint32_t count;
+} respb_index_count_t;
+
+// The last interval stays open while frames are appended: its histogram is
+// kept in pending until the next checkpoint, and is written out by save
+typedef struct {
+    uint32_t interval;
+    uint64_t commands;      // Frames indexed
+    uint64_t bytes;         // Bytes indexed, the offset of the next frame
+    respb_index_point_t *points;
+    size_t npoints;
+    size_t points_cap;
+    respb_index_count_t *counts;
+    size_t ncounts;
+    size_t counts_cap;
+    uint32_t *pending;      // Opcode -> frames in the last interval, or NULL
+    uint16_t *seen;         // Opcodes with a pending count
+    size_t nseen;
+} respb_index_t;
+
+// Empty index with a checkpoint every interval commands (0 for the default)
+void respb_index_init(respb_index_t *idx, uint32_t interval);
+void respb_index_free(respb_index_t *idx);
+
+// Index the complete frames data[0..len), which follow the bytes already
+// indexed. Call it with each block written to the file: transcoder output
+// or an AOF append. Returns 1, 0 if out of memory, -1 on an unknown opcode
+// or a frame cut short (nothing after it is indexed)
+int respb_index_append(respb_index_t *idx, const uint8_t *data, size_t len);
+
+// Offset of command ordinal in data[0..len), the file the index was built
+// for or a longer one it was appended to since. Walks the frame lengths from
+// the nearest checkpoint. Returns 1 with *offset set, 0 if data holds no
+// such command, -1 on a bad frame
+int respb_index_seek(const respb_index_t *idx, const uint8_t *data, size_t len,
+                     uint64_t ordinal, size_t *offset);
+
+// Cut the indexed bytes into at most nparts ranges of about equal size, at
+// checkpoints, for threads to decode on their own. Fills offsets[0..n] with
+// range boundaries (offsets[0] = 0, offsets[n] = bytes) and returns n
+size_t respb_index_split(const respb_index_t *idx, size_t nparts, uint64_t *offsets);
+
+// Frames with opcode in the intervals of points[first..last)
+uint64_t respb_index_count(const respb_index_t *idx, uint16_t opcode, size_t first, size_t last);
+
+// Write the index to path through a temporary file and rename(), so a
+// reader never sees a partial index. Returns 1, or 0 with errno set
+int respb_index_save(const respb_index_t *idx, const char *path);
+
+// Read an index written by respb_index_save() into an initialized idx.
+// Returns 1, 0 with errno set on an I/O error, -1 if the file is not a
+// valid index
+int respb_index_load(respb_index_t *idx, const char *path);
+
+#endif // RESPB_INDEX_H
@@ -0,0 +1,57 @@
+/*
+ * RESPB Argument Iterator
+ * Cursor over a frame that decodes one field at a time, on demand
+ */
+
+#ifndef RESPB_ITER_H
+#define RESPB_ITER_H
+
+#include "respb_schema.h"
+
+// One decoded field; `kind` selects the union member
+typedef struct {
+    uint8_t kind;               // RESPB_FIELD_STR2 .. RESPB_FIELD_F64
+    union {
+        respb_arg_t str;        // STR2, STR4
+        uint64_t u;             // U8, U16
+        int64_t i;              // I64
+        double f;               // F64
+    };
+} respb_value_t;
+
+// Iterator state. Group counts and OPT gates are consumed internally and
+// never yielded. RESP passthrough frames yield their RESP text as one STR4.
+typedef struct {
+    const uint8_t *buf;
+    size_t pos;                 // Next field
+    size_t end;                 // End of the buffer (of the RESP text for passthrough)
+    const respb_schema_t *schema;   // NULL for RESP passthrough
+    const respb_field_t *field;
+    const respb_field_t *fields_end;
+    const respb_field_t *group_start;
+    const respb_field_t *group_end;
+    uint32_t group_left;
+    uint8_t last_u8;
+    uint16_t opcode;
+    uint16_t mux_id;
+    uint32_t module_subcommand; // Module frames only
+} respb_arg_iter_t;
+
+// Position the iterator on the first field of the frame at the start of buf.
+// Only the header is read here; fields are bounds-checked as they are decoded.
+// Returns 1 on success, 0 if the header is incomplete, -1 on unknown opcode
+int respb_arg_iter_init(respb_arg_iter_t *it, const uint8_t *buf, size_t len);
+
+// Decode the next field. Returns 1 with *value set, 0 at the end of the
+// frame, -1 if the frame is truncated
+int respb_arg_iter_next(respb_arg_iter_t *it, respb_value_t *value);
+
+// Next string field, skipping numeric ones: yields the same spans, in the
+// same order, as the args[] filled by the table-driven decoder
+int respb_arg_iter_next_str(respb_arg_iter_t *it, respb_arg_t *arg);
+
+// Skip the fields not yet read and set *frame_len to the frame's total size.
+// Returns 1, or 0 if the frame is truncated
+int respb_arg_iter_finish(respb_arg_iter_t *it, size_t *frame_len);
+
+#endif // RESPB_ITER_H
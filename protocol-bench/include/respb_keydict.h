@@ -0,0 +1,68 @@
+/*
+ * RESPB Key Dictionary
+ * Per-connection key IDs: a 0xF002 frame binds a key to a 2-byte ID, and
+ * later frames send [0xFFFF][2B id] in place of [2B len][key]
+ */
+
+#ifndef RESPB_KEYDICT_H
+#define RESPB_KEYDICT_H
+
+#include "respb.h"
+
+// Bind frame: [0xF002][2B mux_id][2B key_id][2B keylen][key]. The binding
+// holds for the whole connection, whatever the mux_id. Binding an ID again
+// replaces its key
+#define RESPB_KEYDICT_MAX_IDS   0x10000     // IDs 0x0000-0xFFFF
+
+// Both sides keep one. Key bytes are copied into a buffer of max_bytes;
+// when it fills, the bound keys move to a new one and the bytes of replaced
+// keys are reclaimed. Spans handed out stay valid until a bind that moves
+// the keys, or respb_keydict_reset()
+typedef struct respb_keydict {
+    uint32_t *offsets;      // id -> key offset in bytes, UINT32_MAX if unbound
+    uint16_t *lens;         // id -> key length
+    uint32_t capacity;      // IDs 0..capacity-1 can be bound
+    uint32_t count;         // Bound IDs
+    uint8_t *bytes;         // Key copies, replaced ones until the next compaction
+    size_t bytes_used;
+    size_t bytes_live;      // Bytes of bound keys
+    size_t bytes_cap;
+    uint32_t *slots;        // Key -> id + 1 hash index (0 = empty), for senders
+    uint32_t slot_mask;
+} respb_keydict_t;
+
+// Room for capacity IDs (at most RESPB_KEYDICT_MAX_IDS) and max_bytes of
+// key data. Returns 1 on success, 0 if out of memory
+int respb_keydict_init(respb_keydict_t *d, uint32_t capacity, size_t max_bytes);
+void respb_keydict_free(respb_keydict_t *d);
+void respb_keydict_reset(respb_keydict_t *d);
+
+// Bind id to key[0..len), copying the bytes. Binding the key an ID already
+// has is a no-op. Returns 1, or -1 if id is out of range, the bound keys
+// would exceed max_bytes, or out of memory while compacting
+int respb_keydict_bind(respb_keydict_t *d, uint32_t id, const uint8_t *key, size_t len);
+
+// Key bound to id, 1 with *key set or 0 if unbound
+static inline int respb_keydict_get(const respb_keydict_t *d, uint32_t id, respb_arg_t *key) {
+    if (id >= d->capacity || d->offsets[id] == UINT32_MAX) return 0;
+    key->data = d->bytes + d->offsets[id];
+    key->len = d->lens[id];
+    return 1;
+}
+
+// ID bound to key[0..len), -1 if none
+int respb_keydict_find(const respb_keydict_t *d, const uint8_t *key, size_t len);
+
+// Write a bind frame. Returns its size, 0 if buf is too small or len does
+// not fit 2 bytes
+size_t respb_serialize_key_bind(uint8_t *buf, size_t buf_len, uint16_t mux_id, uint16_t id,
+                                const uint8_t *key, size_t len);
+
+// Serialize cmd with the schema encoder, sending every 2-byte string field
+// bound in d as a reference. Numeric fields are encoded as by
+// respb_serialize_command_flags(). Returns the frame size, 0 if buf is too
+// small or cmd has no schema
+size_t respb_serialize_command_dict(uint8_t *buf, size_t buf_len, const respb_command_t *cmd,
+                                    const respb_keydict_t *d);
+
+#endif // RESPB_KEYDICT_H
@@ -0,0 +1,29 @@
+/*
+ * RESP Passthrough Decoder
+ * Parses RESP multibulk commands in place, from a borrowed buffer
+ */
+
+#ifndef RESPB_PASSTHROUGH_H
+#define RESPB_PASSTHROUGH_H
+
+#include "respb.h"
+
+// Same limits as the Valkey parser (valkey_resp_parser.c)
+#define RESPB_RESP_MAX_BULK     (512 * 1024 * 1024)
+#define RESPB_RESP_MAX_LINE     (1024 * 64)
+
+// Parse one RESP multibulk command starting at *pos. Argument spans point
+// into buf; nothing is copied or allocated. Stores up to max_args spans and
+// sets *argc to the number of bulks in the command (0 for "*0" or "*-1").
+// Returns 1 and advances *pos on success, 0 (pos untouched) if more data is
+// needed, -1 on a protocol error
+int respb_resp_parse(const uint8_t *buf, size_t len, size_t *pos,
+                     respb_arg_t *args, size_t max_args, size_t *argc);
+
+// Decode the RESP text of a passthrough frame parsed by respb_parse_command().
+// The payload must hold exactly one command. Returns 1 with the spans set,
+// -1 if cmd is not a passthrough frame or its payload is not one command
+int respb_parse_passthrough(const respb_command_t *cmd, respb_arg_t *args,
+                            size_t max_args, size_t *argc);
+
+#endif // RESPB_PASSTHROUGH_H
@@ -0,0 +1,61 @@
+/*
+ * RESPB Pipeline Builder
+ * Encodes many commands into one reusable send buffer
+ */
+
+#ifndef RESPB_PIPELINE_H
+#define RESPB_PIPELINE_H
+
+#include "respb.h"
+
+// One queued command. offset counts bytes appended since init, so it stays
+// valid while the buffer is compacted or grown
+typedef struct {
+    uint64_t offset;
+    uint32_t length;
+    uint16_t opcode;
+    uint16_t mux_id;
+} respb_pipeline_entry_t;
+
+// Unsent frames live in buf[head, tail). Appends go at tail; when tail
+// reaches the end, the unsent bytes move to the front, and the buffer
+// doubles only if they still do not fit. Once everything is sent, head and
+// tail go back to 0, so a steady pipeline reuses the same memory.
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t head;                        // First unsent byte
+    size_t tail;                        // End of encoded frames
+    uint64_t base;                      // Stream offset of buf[0]
+    respb_pipeline_entry_t *entries;    // Frames not yet fully sent
+    size_t first;                       // Index of the oldest entry
+    size_t count;
+    size_t entry_cap;
+} respb_pipeline_t;
+
+void respb_pipeline_init(respb_pipeline_t *p);
+void respb_pipeline_free(respb_pipeline_t *p);
+
+// Encode cmd (with its own mux_id) at the end of the pipeline. Returns 1 on
+// success, 0 if out of memory, -1 if respb_serialize_command() cannot encode
+// cmd; on failure the pipeline is unchanged
+int respb_pipeline_append(respb_pipeline_t *p, const respb_command_t *cmd);
+
+// Contiguous bytes ready for write()/send(), starting with the oldest unsent
+// frame. The pointer is valid until the next append
+static inline size_t respb_pipeline_pending(const respb_pipeline_t *p, const uint8_t **data) {
+    *data = p->buf + p->head;
+    return p->tail - p->head;
+}
+
+// Mark n bytes of the pending region as sent (n may end mid-frame). Frames
+// sent in full leave the entry list
+void respb_pipeline_consume(respb_pipeline_t *p, size_t n);
+
+// Frames not yet sent in full, oldest first (i < p->count)
+static inline const respb_pipeline_entry_t *respb_pipeline_entry(const respb_pipeline_t *p,
+                                                                  size_t i) {
+    return &p->entries[p->first + i];
+}
+
+#endif // RESPB_PIPELINE_H
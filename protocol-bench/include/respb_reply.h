@@ -0,0 +1,72 @@
+/*
+ * RESPB Reply Codec
+ * Encodes and decodes 0x8000-0x8005 reply frames without copying payloads
+ */
+
+#ifndef RESPB_REPLY_H
+#define RESPB_REPLY_H
+
+#include "respb.h"
+
+// Type byte in front of each array element. 0x01-0x04 are the tags of
+// respb-specs.md; status and error replies inside arrays (EXEC) extend them
+#define RESPB_REPLY_TAG_BULK    0x01
+#define RESPB_REPLY_TAG_INT     0x02
+#define RESPB_REPLY_TAG_NULL    0x03
+#define RESPB_REPLY_TAG_ARRAY   0x04
+#define RESPB_REPLY_TAG_STATUS  0x05
+#define RESPB_REPLY_TAG_ERROR   0x06
+
+// Null markers inside a bulk length or an array count
+#define RESPB_REPLY_NULL_BULK   0xFFFFFFFFu
+#define RESPB_REPLY_NULL_ARRAY  0xFFFF
+
+#define RESPB_REPLY_MAX_DEPTH   32      // Nested arrays the decoders accept
+
+// Same order as the reply opcodes: type == opcode - RESPB_RESP_OK
+typedef enum {
+    RESPB_REPLY_STATUS = 0,     // [2B len][text]
+    RESPB_REPLY_ERROR,          // [2B len][message]
+    RESPB_REPLY_INT,            // [8B int64]
+    RESPB_REPLY_BULK,           // [4B len][data]
+    RESPB_REPLY_ARRAY,          // [2B count] then count tagged elements
+    RESPB_REPLY_NULL            // No payload (also null bulk and null array)
+} respb_reply_type_t;
+
+// One reply value. A reply is a pre-order array of nodes: an ARRAY node is
+// followed by its elements, and span counts the node and everything below
+// it, so nodes[i + nodes[i].span] is the next sibling
+typedef struct {
+    uint8_t type;
+    uint32_t span;
+    uint32_t count;             // ARRAY: direct elements
+    int64_t integer;            // INT
+    const uint8_t *data;        // STATUS, ERROR, BULK: points into the input
+    size_t len;
+} respb_reply_t;
+
+// Decode the reply frame at *pos. Stores up to max_nodes nodes and sets
+// *nnodes to the number the reply holds; if that exceeds max_nodes, parse
+// again with more room. Returns 1 and advances *pos on success, 0 (pos
+// untouched) if more data is needed, -1 on a non-reply opcode, an unknown
+// element tag or nesting deeper than RESPB_REPLY_MAX_DEPTH
+int respb_reply_parse(const uint8_t *buf, size_t len, size_t *pos, uint16_t *mux_id,
+                      respb_reply_t *nodes, size_t max_nodes, size_t *nnodes);
+
+// Encode nodes[0..nnodes) (one reply, count set on arrays; span is ignored)
+// as a reply frame. Returns the frame size, 0 if buf is too small, the nodes
+// do not form exactly one reply, or a length does not fit its field
+// (status/error over 65535 bytes, arrays over 65534 elements)
+size_t respb_serialize_reply(uint8_t *buf, size_t buf_len, uint16_t mux_id,
+                             const respb_reply_t *nodes, size_t nnodes);
+
+// RESP2 text of the same reply (null as "$-1"). Same return values
+size_t respb_reply_to_resp(uint8_t *buf, size_t buf_len,
+                           const respb_reply_t *nodes, size_t nnodes);
+
+// Decode one RESP2 reply (+ - : $ *) into nodes, in place, with the contract
+// of respb_reply_parse(). This is the text baseline for reply benchmarks
+int respb_resp_reply_parse(const uint8_t *buf, size_t len, size_t *pos,
+                           respb_reply_t *nodes, size_t max_nodes, size_t *nnodes);
+
+#endif // RESPB_REPLY_H
@@ -0,0 +1,236 @@
+/*
+ * RESPB Schema Tables
+ * Per-opcode field descriptors generated from respb-commands.md
+ */
+
+#ifndef RESPB_SCHEMA_H
+#define RESPB_SCHEMA_H
+
+#include "respb.h"
+
+// Field kinds understood by the table-driven decoder
+typedef enum {
+    RESPB_FIELD_STR2 = 0,   // [2B len][bytes], stored as an argument
+    RESPB_FIELD_STR4,       // [4B len][bytes], stored as an argument
+    RESPB_FIELD_U8,         // [1B] flags, enum or subcommand
+    RESPB_FIELD_U16,        // [2B] port, db index
+    RESPB_FIELD_I64,        // [8B] signed integer
+    RESPB_FIELD_F64,        // [8B] IEEE-754 double
+    RESPB_FIELD_GROUP,      // [2B count] then the next `arg` fields repeated count times
+    RESPB_FIELD_OPT,        // Next field present only if (last U8 & arg)
+    RESPB_FIELD_KIND_COUNT
+} respb_field_kind_t;
+
+// One wire field; `arg` is the group body length or the OPT flag mask
+typedef struct {
+    uint8_t kind;
+    uint8_t arg;
+} respb_field_t;
+
+// Schema flags
+#define RESPB_SCHEMA_TAIL        0x01  // Spec leaves a trailer undefined (not decoded)
+#define RESPB_SCHEMA_SUBCOMMAND  0x02  // First field is a [1B subcommand]
+#define RESPB_SCHEMA_MODULE      0x04  // Module command (opcode 0xF000)
+
+// Per-command schema: fields[0..nfields)
+typedef struct {
+    const char *name;
+    uint32_t code;          // Core opcode, or module_id << 16 | command_id
+    const respb_field_t *fields;
+    uint8_t nfields;
+    uint8_t flags;
+} respb_schema_t;
+
+// Dense command_id -> schema map for one module (NULL = unassigned)
+typedef struct {
+    const respb_schema_t *const *commands;
+    uint32_t count;
+} respb_schema_module_t;
+
+#define RESPB_SCHEMA_CORE_LIMIT    0x0500  // Core opcodes are 0x0000-0x04FF
+#define RESPB_SCHEMA_MODULE_LIMIT  3       // Generated modules: JSON, BF, FT
+
+// Generated tables (src/respb_schema_table.c)
+extern const respb_field_t respb_schema_fields[];
+extern const size_t respb_schema_field_count;
+extern const respb_schema_t respb_schemas[];
+extern const size_t respb_schema_count;
+extern const uint16_t respb_schema_core_index[RESPB_SCHEMA_CORE_LIMIT];
+extern const respb_schema_module_t respb_schema_modules[RESPB_SCHEMA_MODULE_LIMIT];
+extern const char *const respb_opcode_names[RESPB_SCHEMA_CORE_LIMIT];
+extern const uint32_t respb_name_bucket_count;
+extern const uint16_t respb_name_seeds[];   // Per-bucket rehash seed
+extern const uint16_t respb_name_slots[];   // Slot -> respb_schemas[] index
+
+// Schema lookup (NULL if the opcode has no schema). Module commands go
+// through the registry: module_id -> command_id -> schema, two array loads
+const respb_schema_t *respb_schema_lookup(uint16_t opcode);
+const respb_schema_t *respb_schema_lookup_module(uint16_t module_id, uint16_t command_id);
+
+// Case-insensitive command name -> schema (core or module), NULL if unknown.
+// name need not be NUL-terminated. Subcommands ("CLIENT KILL") resolve
+// through their parent's name, which is what RESP carries in argv[0]
+const respb_schema_t *respb_command_lookup(const char *name, size_t len);
+
+// Hash functions of the generated name table (scripts/generate_schema.py):
+// FNV-1a over the upper-cased name, and a seeded murmur3 finalizer
+static inline uint32_t respb_name_hash(const char *name, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = (uint8_t)name[i];
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        h = (h ^ c) * 16777619u;
+    }
+    return h;
+}
+
+static inline uint32_t respb_name_mix(uint32_t h, uint32_t seed) {
+    h ^= seed;
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35u;
+    h ^= h >> 16;
+    return h;
+}
+
+// Register the commands of module_id, replacing any earlier registration
+// (including the generated JSON/BF/FT tables). The low 16 bits of each
+// schema's code are its command_id and the high 16 bits must be module_id.
+// The registry keeps pointers to schemas and their fields, so both must
+// outlive it. count == 0 unregisters the module. Not thread-safe: register
+// before decoding starts. Returns 1 on success, 0 if out of memory, -1 on
+// an invalid descriptor or duplicate command_id
+int respb_register_module(uint16_t module_id, const respb_schema_t *schemas, size_t count);
+
+// Decode the payload fields of one command starting at *pos. Stores up to
+// max_args argument spans and sets *argc to the number of spans in the frame.
+// Returns 1 and advances *pos on success, 0 (pos untouched) if more data is needed,
+// -1 on a malformed descriptor
+int respb_schema_decode(const respb_schema_t *schema, const uint8_t *buf, size_t len,
+                        size_t *pos, respb_arg_t *args, size_t max_args, size_t *argc);
+
+// respb_schema_decode() for a connection that negotiated flags: with
+// RESPB_FLAG_VARINT, STR2/STR4 lengths and group counts are varints, STR2
+// fields may exceed 64 KB, and a malformed varint returns -1. With
+// RESPB_FLAG_KEYDICT, a STR2 key reference is stored as {NULL, key ID} for
+// the caller to resolve; both flags together return -1
+int respb_schema_decode_flags(const respb_schema_t *schema, uint8_t flags, const uint8_t *buf,
+                              size_t len, size_t *pos, respb_arg_t *args, size_t max_args,
+                              size_t *argc);
+
+// Where respb_schema_decode_at() found a frame's numeric fields: fixed[]
+// those outside groups in wire order (NULL for one an OPT flag left out),
+// entry[] the first field of each group entry that opens with a number, as
+// ZADD's score does. Counts include fields past the end of the arrays
+#define RESPB_SCHEMA_AT_FIXED 8
+typedef struct {
+    const uint8_t *fixed[RESPB_SCHEMA_AT_FIXED];
+    size_t nfixed;
+    const uint8_t *entry[RESPB_MAX_ARGS - 1];
+    size_t nentries;
+} respb_schema_at_t;
+
+// respb_schema_decode_flags() that also fills *at (when not NULL)
+int respb_schema_decode_at(const respb_schema_t *schema, uint8_t flags, const uint8_t *buf,
+                           size_t len, size_t *pos, respb_arg_t *args, size_t max_args,
+                           size_t *argc, respb_schema_at_t *at);
+
+// Value of one numeric field for the encoder, read as the field kind says:
+// u for U8, U16 and GROUP counts, i for I64, f for F64
+typedef union {
+    uint64_t u;
+    int64_t i;
+    double f;
+} respb_num_t;
+
+// Encode the payload fields of one command at *pos: STR2/STR4 fields take the
+// next span of args[], every U8/U16/I64/F64 field and group count the next
+// entry of nums[], both in wire order. OPT fields take nothing; they follow
+// the last U8 as the decoder does. Returns 1 and advances *pos on success,
+// 0 (pos untouched) if buf is too small, -1 if a value does not fit its
+// field or args/nums are not consumed exactly
+int respb_schema_encode(const respb_schema_t *schema, uint8_t *buf, size_t len, size_t *pos,
+                        const respb_arg_t *args, size_t argc,
+                        const respb_num_t *nums, size_t nnums);
+
+// Header (core or module) plus respb_schema_encode(). Returns the frame
+// size, 0 if buf is too small or the values do not match the schema
+size_t respb_serialize_schema(uint8_t *buf, size_t buf_len, const respb_schema_t *schema,
+                              uint16_t mux_id, const respb_arg_t *args, size_t argc,
+                              const respb_num_t *nums, size_t nnums);
+
+// Encoder counterparts of respb_schema_decode_flags()
+int respb_schema_encode_flags(const respb_schema_t *schema, uint8_t flags, uint8_t *buf,
+                              size_t len, size_t *pos, const respb_arg_t *args, size_t argc,
+                              const respb_num_t *nums, size_t nnums);
+size_t respb_serialize_schema_flags(uint8_t *buf, size_t buf_len, const respb_schema_t *schema,
+                                    uint8_t flags, uint16_t mux_id, const respb_arg_t *args,
+                                    size_t argc, const respb_num_t *nums, size_t nnums);
+
+// Frame size respb_serialize_schema() would produce, 0 if the values do not
+// match the schema
+size_t respb_serialized_schema_size(const respb_schema_t *schema, const respb_arg_t *args,
+                                    size_t argc, const respb_num_t *nums, size_t nnums);
+
+// Where respb_command_t.view keeps the numeric fields of schema that sit
+// outside groups (OPT-gated ones included): one {kind, offset in
+// respb_view_t} per field in wire order, *count of them. A field the view
+// has no member for, such as SETBIT's bit, has offset RESPB_VIEW_NONE: the
+// decoders skip it and the serializers refuse the layout. NULL if the
+// opcode has no view but numeric fields, as LCS. ZADD and GEOADD entry
+// numbers are read with respb_zadd_score()/respb_geoadd_coords()
+#define RESPB_VIEW_NONE 0xFF
+const respb_field_t *respb_view_fields(const respb_schema_t *schema, size_t *count);
+
+// Read a view member located by respb_view_fields()
+static inline respb_num_t respb_view_get(const respb_view_t *view, respb_field_t slot) {
+    const uint8_t *p = (const uint8_t *)view + slot.arg;
+    respb_num_t num = {0};
+    switch (slot.kind) {
+        case RESPB_FIELD_U8: num.u = *p; break;
+        case RESPB_FIELD_U16: { uint16_t v; memcpy(&v, p, sizeof(v)); num.u = v; break; }
+        case RESPB_FIELD_I64: memcpy(&num.i, p, sizeof(num.i)); break;
+        case RESPB_FIELD_F64: memcpy(&num.f, p, sizeof(num.f)); break;
+    }
+    return num;
+}
+
+// Store the wire field at p (NULL for a field a flag left out: 0) in the
+// view member located by respb_view_fields()
+static inline void respb_view_load(respb_view_t *view, respb_field_t slot, const uint8_t *p) {
+    uint8_t *dst = (uint8_t *)view + slot.arg;
+    switch (slot.kind) {
+        case RESPB_FIELD_U8: *dst = p ? p[0] : 0; break;
+        case RESPB_FIELD_U16: {
+            uint16_t v = p ? respb_read_u16(p) : 0;
+            memcpy(dst, &v, sizeof(v));
+            break;
+        }
+        case RESPB_FIELD_I64: {
+            int64_t v = p ? (int64_t)respb_read_u64(p) : 0;
+            memcpy(dst, &v, sizeof(v));
+            break;
+        }
+        case RESPB_FIELD_F64: {
+            double v = p ? respb_read_f64(p) : 0.0;
+            memcpy(dst, &v, sizeof(v));
+            break;
+        }
+    }
+}
+
+// Fill cmd->view from the numbers respb_schema_decode_at() found in the
+// frame at cmd->raw_payload, after it decoded cmd->args. Leaves the view
+// alone when respb_view_fields() has none for the schema
+void respb_view_fill(const respb_schema_t *schema, const respb_schema_at_t *at,
+                     respb_command_t *cmd);
+
+// Table-driven decoder, same contract as respb_parse_command():
+// returns 1 on success, 0 if more data is needed, -1 on unknown opcode
+int respb_parse_command_table(respb_parser_t *parser, respb_command_t *cmd);
+
+// Size in bytes of the generated descriptor tables
+size_t respb_schema_table_size(void);
+
+#endif // RESPB_SCHEMA_H
@@ -0,0 +1,58 @@
+/*
+ * RESPB Streaming Parser
+ * Resumable decoding of frames that arrive split across recv() calls
+ */
+
+#ifndef RESPB_STREAM_H
+#define RESPB_STREAM_H
+
+#include "respb.h"
+#include "respb_schema.h"
+
+// Progress through the frame being reassembled
+typedef enum {
+    RESPB_STREAM_HEADER = 0,    // Waiting for the 4B (or 8B module/passthrough) header
+    RESPB_STREAM_FIELDS,        // Walking the opcode's schema fields
+    RESPB_STREAM_PASSTHROUGH    // Waiting for the rest of the RESP text
+} respb_stream_stage_t;
+
+// Streaming parser state. Frames that fit in one feed are decoded in place;
+// a frame cut off by the end of a feed is copied into `buf` and the decoder
+// remembers the field it stopped at, so later feeds never rescan it. The
+// complete frame is decoded once more to fill the arguments and view.
+typedef struct {
+    uint8_t *buf;               // Reassembled bytes of the pending frame
+    size_t len;
+    size_t cap;
+    size_t need;                // Decoding resumes once len reaches need
+    size_t pos;                 // Bytes of buf already decoded
+    int active;                 // A partial frame is pending
+    respb_stream_stage_t stage;
+    const respb_schema_t *schema;
+    uint16_t field;             // Next field, index into schema->fields
+    uint16_t group_start;
+    uint16_t group_end;
+    uint32_t group_left;
+    uint8_t last_u8;
+    uint8_t flags;              // Negotiated RESPB_FLAG_* options (0 after init)
+} respb_stream_t;
+
+void respb_stream_init(respb_stream_t *stream);
+void respb_stream_reset(respb_stream_t *stream);
+void respb_stream_free(respb_stream_t *stream);
+
+// Feed the next bytes of the connection. Returns 1 when a command is complete
+// (cmd filled, *consumed = bytes of data used), 0 when all of data was
+// consumed without completing a frame, -1 on an unknown opcode. Argument
+// pointers stay valid until the next call or until data is released.
+// Fixed-width frames only: -1 if stream->flags has RESPB_FLAG_VARINT or
+// RESPB_FLAG_KEYDICT, and 0xF001/0xF002 frames are unknown opcodes here.
+int respb_parser_feed(respb_stream_t *stream, const uint8_t *data, size_t len,
+                      size_t *consumed, respb_command_t *cmd);
+
+// Bytes of the pending partial frame held by the parser
+static inline size_t respb_stream_pending(const respb_stream_t *stream) {
+    return stream->active ? stream->len : 0;
+}
+
+#endif // RESPB_STREAM_H
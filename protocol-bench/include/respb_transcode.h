@@ -0,0 +1,86 @@
+/*
+ * RESP <-> RESPB Transcoder
+ * Converts RESP command streams (AOF files, captured traffic) to RESPB
+ * frames, on several threads for large inputs, and parsed RESPB frames
+ * back to RESP for RESP-only servers and replicas
+ */
+
+#ifndef RESPB_TRANSCODE_H
+#define RESPB_TRANSCODE_H
+
+#include "respb.h"
+#include "respb_index.h"
+
+// Largest frame respb_transcode_command() can write for a command whose
+// RESP text is resp_len bytes long with argc bulks
+#define RESPB_TRANSCODE_BOUND(resp_len, argc) ((resp_len) + (argc) + 16)
+
+#define RESPB_TRANSCODE_DEFAULT_CHUNK   (8 * 1024 * 1024)
+#define RESPB_TRANSCODE_MAX_THREADS     64
+
+typedef struct {
+    uint64_t commands;      // Frames written (empty "*0" commands are dropped)
+    uint64_t passthrough;   // Of which 0xFFFF frames
+    uint64_t in_bytes;
+    uint64_t out_bytes;
+    uint32_t chunks;
+    uint32_t resplits;      // Chunks redone after a wrong boundary guess
+    size_t error_pos;       // Input offset of the bad command on failure
+} respb_transcode_stats_t;
+
+// Transcode one command. argv[0..argc) are its bulks as parsed by
+// respb_resp_parse(), name first, and resp[0..resp_len) its RESP text.
+// Commands whose arguments map exactly onto their schema become RESPB
+// frames, with numeric fields parsed from their decimal text. Everything
+// else (unknown commands, options without a field, too many arguments)
+// becomes a passthrough frame with the original text, so nothing is lost.
+// Returns the frame size, 0 if buf is smaller than RESPB_TRANSCODE_BOUND
+// and the frame does not fit. *passthrough is set when the text was wrapped
+size_t respb_transcode_command(uint8_t *buf, size_t buf_len, uint16_t mux_id,
+                               const respb_arg_t *argv, size_t argc,
+                               const uint8_t *resp, size_t resp_len, int *passthrough);
+
+// Receives transcoded output in input order. Returns 1 to continue, 0 to stop
+typedef int (*respb_transcode_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+// Transcode the RESP text data[0..len) on nthreads threads. The input is cut
+// into chunk_size pieces at guessed command boundaries, which the chunks are
+// checked against once the previous chunk is done; a wrong guess redoes
+// the chunk. Returns 1 on success, 0 if write stopped or memory ran out, -1
+// on malformed or truncated input (stats->error_pos set). stats may be NULL
+int respb_transcode_parallel(const uint8_t *data, size_t len, int nthreads, size_t chunk_size,
+                             respb_transcode_write_fn write, void *ctx,
+                             respb_transcode_stats_t *stats);
+
+// mmap in_path and write its transcoding to out_path, as above. Unless
+// index is NULL, the frames written are also appended to it (respb_index.h).
+// Returns 1 on success, 0 on an I/O error (errno set), -1 on malformed input
+int respb_transcode_file(const char *in_path, const char *out_path, int nthreads,
+                         size_t chunk_size, respb_index_t *index,
+                         respb_transcode_stats_t *stats);
+
+// Write cmd as a RESP multibulk request: the command name, then its fields
+// in wire order. flags are the negotiated flags cmd was parsed with, which
+// decide how its raw payload is laid out. Numbers are written in decimal,
+// doubles in the shortest form strtod() reads back exactly. A flags byte
+// becomes the option names respb_transcode_command() reads (SET, ZADD,
+// GEOADD, EXPIRE, HEXPIRE and their variants, JSON.SET); any other U8
+// field must be 0 and take no argument of its own. A group count is
+// written only where RESP carries one (numkeys, FIELDS numfields).
+// Passthrough frames give their RESP text and key bind frames nothing.
+// Returns 1 with *resp_len set, 0 if buf is too small, -1 if the frame has
+// no RESP form (an unnamed flag or enum value, a subcommand, an undecoded
+// trailer, a NaN)
+int respb_to_resp(uint8_t *buf, size_t buf_len, const respb_command_t *cmd, uint8_t flags,
+                  size_t *resp_len);
+
+// Scatter/gather form of respb_to_resp() for writev(), as
+// respb_serialize_iov(): strings of RESPB_IOV_COPY_MAX bytes or more and
+// passthrough text are referenced in place, everything else goes to
+// scratch. Fills up to max_iov entries and sets *iovcnt. Same returns; 0
+// also when iov is too small
+int respb_to_resp_iov(uint8_t *scratch, size_t scratch_len, struct iovec *iov, size_t max_iov,
+                      size_t *iovcnt, const respb_command_t *cmd, uint8_t flags,
+                      size_t *resp_len);
+
+#endif // RESPB_TRANSCODE_H
@@ -54,6 +54,12 @@ typedef struct valkey_client {
  */
 void valkey_client_init(valkey_client *c, const uint8_t *buf, size_t len);
 
+/**
+ * Append newly received bytes to the client's query buffer
+ * (discarding already parsed bytes first)
+ */
+void valkey_client_feed(valkey_client *c, const uint8_t *buf, size_t len);
+
 /**
  * Free resources associated with a client
  */
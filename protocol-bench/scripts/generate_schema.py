@@ -0,0 +1,363 @@
+#!/usr/bin/env python3
+"""
+Generate the RESPB schema table (src/respb_schema_table.c)
+Parses the opcode tables in respb-commands.md into per-opcode field
+descriptors and cross-checks coverage against valkey_commands.csv
+"""
+
+import re
+import sys
+import csv
+import argparse
+from pathlib import Path
+
+# Opcode rows inside the ``` blocks of respb-commands.md
+ROW_RE = re.compile(r'^(0x[0-9A-Fa-f]{8}|0x[0-9A-Fa-f]{4})\s+(\S+)\s*(.*)$')
+TOKEN_RE = re.compile(r'\[[^\]]*\]|\)\.\.\.|\(|\)|\.\.\.|[^\[\]\(\)]+')
+SIZED_RE = re.compile(r'^(\d)B (\w+?)(\?)?$')
+DATA_RE = re.compile(r'^(\w+?)(\?)?$')
+
+# Sections of the spec that do not describe request payloads
+SKIP_SECTIONS = ('Control Operations', 'RESP Passthrough', 'Response Opcodes',
+                 'Opcode Summary', 'Usage Examples')
+
+MODULE_IDS = {'JSON': 0x0000, 'BF': 0x0001, 'FT': 0x0002}
+
+# 8-byte fields carried as IEEE-754 doubles rather than int64
+FLOAT_FIELDS = {'float', 'score', 'longitude', 'latitude', 'radius',
+                'error_rate', 'number'}
+FLOAT_OVERRIDES = {
+    'ZCOUNT': {'min', 'max'},
+    'ZRANGEBYSCORE': {'min', 'max'},
+    'ZREVRANGEBYSCORE': {'min', 'max'},
+    'ZREMRANGEBYSCORE': {'min', 'max'},
+    'ZINCRBY': {'increment'},
+}
+
+# Optional fields whose presence is signalled by a bit in the preceding
+# [1B flags] byte; every other optional is absent unless listed in
+# ALWAYS_PRESENT (the fixed layouts the existing parser already reads)
+GATED_OPTIONALS = {
+    'GETEX': {'expiry': 0x01},
+    'HGETEX': {'expiry': 0x01},
+    'HSETEX': {'expiry': 0x01},
+}
+ALWAYS_PRESENT = {
+    'SET': {'expiry'},
+    'COPY': {'db'},
+}
+
+SCHEMA_TAIL = 0x01        # payload ends in an unspecified trailer
+SCHEMA_SUBCOMMAND = 0x02  # first field is a [1B subcommand]
+SCHEMA_MODULE = 0x04      # module command (opcode 0xF000)
+
+
+class Command:
+    def __init__(self, name, opcode, module_id=None, command_id=None):
+        self.name = name
+        self.opcode = opcode
+        self.module_id = module_id
+        self.command_id = command_id
+        self.fields = []   # (kind, arg, name)
+        self.flags = 0
+
+
+def tokenize(payload):
+    return [t for t in (m.group(0).strip() for m in TOKEN_RE.finditer(payload)) if t]
+
+
+def is_data(tok):
+    return tok.startswith('[') and DATA_RE.match(tok[1:-1]) is not None
+
+
+def parse_fields(cmd, tokens, i, in_group):
+    """Parse tokens into field tuples; returns (fields, next_index)"""
+    fields = []
+    while i < len(tokens):
+        tok = tokens[i]
+        if tok in (')', ')...'):
+            if not in_group:
+                raise ValueError(f'{cmd.name}: unbalanced group')
+            return fields, i + 1
+        if tok == '...':
+            i += 1
+            continue
+        if not tok.startswith('['):
+            # Free text such as "No payload"
+            i += 1
+            continue
+
+        m = SIZED_RE.match(tok[1:-1])
+        if not m:
+            # [...complex options], [additional args...], ...
+            cmd.flags |= SCHEMA_TAIL
+            return fields, len(tokens)
+
+        size, name, optional = int(m.group(1)), m.group(2), bool(m.group(3))
+        nxt = tokens[i + 1] if i + 1 < len(tokens) else None
+
+        if size in (2, 4) and nxt is not None and is_data(nxt) and name.endswith('len'):
+            dm = DATA_RE.match(nxt[1:-1])
+            fields.append(('STR2' if size == 2 else 'STR4', 0, dm.group(1),
+                           optional or bool(dm.group(2))))
+            i += 2
+        elif size == 2 and nxt == '(':
+            body, i = parse_fields(cmd, tokens, i + 2, True)
+            fields.append(('GROUP', body, name, optional))
+        elif (size == 2 and nxt is not None and i + 3 < len(tokens)
+              and SIZED_RE.match(nxt[1:-1] if nxt.startswith('[') else '')
+              and is_data(tokens[i + 2]) and tokens[i + 3] == '...'):
+            # [2B count][2B keylen][key]... shorthand for a one-field group
+            body, _ = parse_fields(cmd, tokens[i + 1:i + 3], 0, False)
+            fields.append(('GROUP', body, name, optional))
+            i += 4
+        else:
+            if size == 1:
+                kind = 'U8'
+            elif size == 2:
+                kind = 'U16'
+            elif size == 8:
+                floats = FLOAT_OVERRIDES.get(cmd.name, set())
+                kind = 'F64' if name in FLOAT_FIELDS or name in floats else 'I64'
+            else:
+                raise ValueError(f'{cmd.name}: unsupported field [{tok}]')
+            fields.append((kind, 0, name, optional))
+            i += 1
+    if in_group:
+        raise ValueError(f'{cmd.name}: unterminated group')
+    return fields, i
+
+
+def resolve_optionals(cmd, fields):
+    """Drop or gate optional fields and flatten groups into descriptors"""
+    gated = GATED_OPTIONALS.get(cmd.name, {})
+    always = ALWAYS_PRESENT.get(cmd.name, set())
+    out = []
+    for kind, arg, name, optional in fields:
+        if optional and name not in always:
+            if name not in gated:
+                continue
+            out.append(('OPT', gated[name], name))
+        if kind == 'GROUP':
+            body = resolve_optionals(cmd, arg)
+            if not body:
+                raise ValueError(f'{cmd.name}: empty group {name}')
+            out.append(('GROUP', len(body), name))
+            out.extend(body)
+        else:
+            out.append((kind, arg, name))
+    return out
+
+
+def load_spec(path):
+    commands = []
+    section = ''
+    in_block = False
+    for line in Path(path).read_text().splitlines():
+        if line.startswith('## '):
+            section = line[3:].strip()
+            continue
+        if line.startswith('```'):
+            in_block = not in_block
+            continue
+        if not in_block or section.startswith(SKIP_SECTIONS):
+            continue
+        m = ROW_RE.match(line.rstrip())
+        if not m:
+            continue
+        code, name, payload = m.group(1), m.group(2), m.group(3)
+        if len(code) == 10:
+            value = int(code, 16)
+            prefix = name.split('.')[0]
+            if MODULE_IDS.get(prefix) != value >> 16:
+                raise ValueError(f'{name}: module id mismatch')
+            cmd = Command(name, 0xF000, value >> 16, value & 0xFFFF)
+            cmd.flags |= SCHEMA_MODULE
+        else:
+            cmd = Command(name, int(code, 16))
+
+        fields, _ = parse_fields(cmd, tokenize(payload), 0, False)
+        cmd.fields = resolve_optionals(cmd, fields)
+        if cmd.fields and cmd.fields[0][0] == 'U8' and cmd.fields[0][2] == 'subcommand':
+            cmd.flags |= SCHEMA_SUBCOMMAND
+        commands.append(cmd)
+    return commands
+
+
+def check_coverage(commands, csv_path):
+    """Every command in valkey_commands.csv must resolve to a schema"""
+    names = {c.name for c in commands}
+    containers = {c.name for c in commands if c.flags & SCHEMA_SUBCOMMAND}
+    missing = []
+    with open(csv_path, newline='') as f:
+        for row in csv.DictReader(f):
+            name = row['command'].strip().upper()
+            if name in names:
+                continue
+            parent = name.split(' ')[0]
+            if ' ' in name and parent in containers:
+                continue
+            missing.append(name)
+    return missing
+
+
+def name_hash(name):
+    """FNV-1a over the upper-cased name, then the murmur3 finalizer.
+    Must match respb_name_hash() in include/respb_schema.h"""
+    h = 2166136261
+    for c in name.upper().encode():
+        h = ((h ^ c) * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def name_mix(h, seed):
+    """Per-bucket rehash; must match respb_name_mix()"""
+    h ^= seed
+    h ^= h >> 16
+    h = (h * 0x85EBCA6B) & 0xFFFFFFFF
+    h ^= h >> 13
+    h = (h * 0xC2B2AE35) & 0xFFFFFFFF
+    h ^= h >> 16
+    return h
+
+
+def reduce(h, n):
+    """Map a 32-bit hash onto [0, n) with a multiply-shift"""
+    return (h * n) >> 32
+
+
+def build_name_hash(names):
+    """Minimal perfect hash (hash and displace): names hash into buckets,
+    each bucket gets the first seed that sends its names to free slots.
+    Returns (seeds per bucket, schema index per slot)"""
+    hashes = [name_hash(n) for n in names]
+    if len(set(hashes)) != len(hashes):
+        raise ValueError('command name hash collision')
+    n = len(names)
+    nbuckets = (n + 3) // 4
+    buckets = [[] for _ in range(nbuckets)]
+    for i, h in enumerate(hashes):
+        buckets[reduce(h, nbuckets)].append(i)
+
+    seeds = [0] * nbuckets
+    slots = [None] * n
+    for b in sorted(range(nbuckets), key=lambda b: -len(buckets[b])):
+        if not buckets[b]:
+            continue
+        for seed in range(1, 65536):
+            taken = [reduce(name_mix(hashes[i], seed), n) for i in buckets[b]]
+            if len(set(taken)) == len(taken) and all(slots[t] is None for t in taken):
+                break
+        else:
+            raise ValueError('no seed found for command name bucket')
+        seeds[b] = seed
+        for i, t in zip(buckets[b], taken):
+            slots[t] = i
+    return seeds, slots
+
+
+def emit_table(commands, out):
+    core = sorted((c for c in commands if c.module_id is None), key=lambda c: c.opcode)
+    modules = sorted((c for c in commands if c.module_id is not None),
+                     key=lambda c: (c.module_id, c.command_id))
+    ordered = core + modules
+
+    w = out.write
+    w('/*\n')
+    w(' * RESPB Schema Table\n')
+    w(' * Generated by scripts/generate_schema.py from respb-commands.md - do not edit\n')
+    w(' */\n\n')
+    w('#include "respb_schema.h"\n\n')
+
+    w('const respb_field_t respb_schema_fields[] = {\n')
+    first = {}
+    pos = 0
+    for c in ordered:
+        first[c.name] = pos
+        if c.fields:
+            w(f'    /* {c.name} */\n')
+        for kind, arg, name in c.fields:
+            w(f'    {{RESPB_FIELD_{kind}, {arg}}}, /* {name} */\n')
+            pos += 1
+    w('};\n\n')
+    w(f'const size_t respb_schema_field_count = {pos};\n\n')
+
+    w('const respb_schema_t respb_schemas[] = {\n')
+    for c in ordered:
+        flags = []
+        if c.flags & SCHEMA_TAIL:
+            flags.append('RESPB_SCHEMA_TAIL')
+        if c.flags & SCHEMA_SUBCOMMAND:
+            flags.append('RESPB_SCHEMA_SUBCOMMAND')
+        if c.flags & SCHEMA_MODULE:
+            flags.append('RESPB_SCHEMA_MODULE')
+        code = c.opcode if c.module_id is None else (c.module_id << 16) | c.command_id
+        width = 4 if c.module_id is None else 8
+        w(f'    {{"{c.name}", 0x{code:0{width}X}, respb_schema_fields + {first[c.name]}, '
+          f'{len(c.fields)}, {" | ".join(flags) if flags else "0"}}},\n')
+    w('};\n\n')
+    w(f'const size_t respb_schema_count = {len(ordered)};\n\n')
+
+    w('/* Core opcode -> command name (NULL = unassigned) */\n')
+    w('const char *const respb_opcode_names[RESPB_SCHEMA_CORE_LIMIT] = {\n')
+    for c in core:
+        w(f'    [0x{c.opcode:04X}] = "{c.name}",\n')
+    w('};\n\n')
+
+    seeds, slots = build_name_hash([c.name for c in ordered])
+    w('/* Command name -> schema: minimal perfect hash, see respb_command_lookup() */\n')
+    w(f'const uint32_t respb_name_bucket_count = {len(seeds)};\n\n')
+    w('const uint16_t respb_name_seeds[] = {\n')
+    for i in range(0, len(seeds), 12):
+        w('    ' + ' '.join(f'{s},' for s in seeds[i:i + 12]) + '\n')
+    w('};\n\n')
+    w('const uint16_t respb_name_slots[] = {\n')
+    for i in range(0, len(slots), 12):
+        w('    ' + ' '.join(f'{s},' for s in slots[i:i + 12]) + '\n')
+    w('};\n\n')
+
+    w('/* Core opcode -> schema index + 1 (0 = unassigned) */\n')
+    w('const uint16_t respb_schema_core_index[RESPB_SCHEMA_CORE_LIMIT] = {\n')
+    for i, c in enumerate(core):
+        w(f'    [0x{c.opcode:04X}] = {i + 1},\n')
+    w('};\n\n')
+
+    by_module = {}
+    for i, c in enumerate(modules):
+        by_module.setdefault(c.module_id, []).append((c.command_id, len(core) + i))
+    for mid, entries in sorted(by_module.items()):
+        size = max(cid for cid, _ in entries) + 1
+        w(f'static const respb_schema_t *const module_{mid:04x}_commands[{size}] = {{\n')
+        for cid, idx in entries:
+            w(f'    [0x{cid:04X}] = &respb_schemas[{idx}],\n')
+        w('};\n\n')
+    w('/* Initial contents of the module registry (respb_register_module()) */\n')
+    w('const respb_schema_module_t respb_schema_modules[RESPB_SCHEMA_MODULE_LIMIT] = {\n')
+    for mid, entries in sorted(by_module.items()):
+        size = max(cid for cid, _ in entries) + 1
+        w(f'    [0x{mid:04X}] = {{module_{mid:04x}_commands, {size}}},\n')
+    w('};\n')
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Generate the RESPB schema table')
+    parser.add_argument('--spec', default='../respb-commands.md', help='Opcode mapping document')
+    parser.add_argument('--commands', default='../valkey_commands.csv', help='Valkey command list')
+    parser.add_argument('--output', '-o', default='src/respb_schema_table.c', help='Output C file')
+    args = parser.parse_args()
+
+    commands = load_spec(args.spec)
+    missing = check_coverage(commands, args.commands)
+    if missing:
+        print(f"Commands without a schema: {', '.join(missing)}", file=sys.stderr)
+        sys.exit(1)
+
+    with open(args.output, 'w') as out:
+        emit_table(commands, out)
+
+    core = sum(1 for c in commands if c.module_id is None)
+    print(f"Generated {args.output}: {core} core + {len(commands) - core} module schemas")
+
+
+if __name__ == '__main__':
+    main()
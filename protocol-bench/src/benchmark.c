@@ -5,11 +5,35 @@
 
 #include "benchmark.h"
 #include "respb.h"
+#include "respb_schema.h"
+#include "respb_batch.h"
+#include "respb_stream.h"
+#include "respb_args.h"
+#include "respb_iter.h"
+#include "respb_frame.h"
+#include "respb_passthrough.h"
+#include "respb_pipeline.h"
+#include "respb_reply.h"
+#include "respb_compress.h"
+#include "respb_keydict.h"
+#include "respb_handshake.h"
+#include "respb_transcode.h"
+#include "respb_aof.h"
+#include "respb_index.h"
+#include "respb_compact.h"
 #include "valkey_resp_parser.h"
+#include "hiredis_reader.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
 #include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 static int benchmark_resp_parsing(workload_t *wl, benchmark_metrics_t *metrics, 
                                   int iterations, int sample_latency) {
@@ -88,8 +112,11 @@ static int benchmark_resp_parsing(workload_t *wl, benchmark_metrics_t *metrics,
     return 1;
 }
 
+typedef int (*respb_parse_fn)(respb_parser_t *parser, respb_command_t *cmd);
+
 static int benchmark_respb_parsing(workload_t *wl, benchmark_metrics_t *metrics,
-                                   int iterations, int sample_latency) {
+                                   int iterations, int sample_latency,
+                                   respb_parse_fn parse) {
     benchmark_metrics_init(metrics);
     benchmark_timer_t timer;
     benchmark_timer_start(&timer);
@@ -109,46 +136,2526 @@ static int benchmark_respb_parsing(workload_t *wl, benchmark_metrics_t *metrics,
                 clock_gettime(CLOCK_MONOTONIC, &cmd_start);
             }
             
-            int result = respb_parse_command(&parser, &cmd);
+            int result = parse(&parser, &cmd);
+            
+            if (sample_latency && metrics->latency_sample_count < MAX_LATENCY_SAMPLES) {
+                clock_gettime(CLOCK_MONOTONIC, &cmd_end);
+                uint64_t latency_ns = (cmd_end.tv_sec - cmd_start.tv_sec) * 1000000000ULL +
+                                     (cmd_end.tv_nsec - cmd_start.tv_nsec);
+                benchmark_record_latency(metrics, latency_ns);
+            }
+            
+            if (result == 1) {
+                metrics->commands_processed++;
+                size_t bytes_consumed = parser.pos;
+                metrics->bytes_processed += bytes_consumed;
+                wl->current_pos += bytes_consumed;
+            } else if (result == 0) {
+                // Incomplete command - check if we're at end of buffer
+                if (parser.pos >= parser.buffer_len || wl->current_pos + parser.pos >= wl->size) {
+                    // End of workload
+                    break;
+                }
+                fprintf(stderr, "RESPB incomplete command at position %zu, parser pos %zu, buffer len %zu, opcode 0x%04X\n",
+                       wl->current_pos, parser.pos, parser.buffer_len, cmd.opcode);
+                fflush(stderr);
+                break;
+            } else {
+                // Error
+                fprintf(stderr, "RESPB parse error at position %zu, opcode 0x%04X, parser pos %zu, buffer len %zu\n",
+                       wl->current_pos, cmd.opcode, parser.pos, parser.buffer_len);
+                fflush(stderr);
+                return 0;
+            }
+        }
+    }
+    
+    benchmark_timer_stop(&timer, metrics);
+    benchmark_compute_percentiles(metrics);
+    
+    return 1;
+}
+
+static int benchmark_respb_batch(workload_t *wl, benchmark_metrics_t *metrics,
+                                 int iterations, size_t batch_size) {
+    benchmark_metrics_init(metrics);
+    
+    respb_batch_t batch;
+    size_t arg_capacity = batch_size * 16;
+    if (!respb_batch_init(&batch, batch_size, arg_capacity)) {
+        fprintf(stderr, "Failed to allocate batch of %zu frames\n", batch_size);
+        return 0;
+    }
+    
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    
+    for (int iter = 0; iter < iterations; iter++) {
+        size_t pos = 0;
+        
+        while (pos < wl->size) {
+            size_t n = respb_parse_batch(wl->data + pos, wl->size - pos, &batch, batch_size);
+            metrics->commands_processed += n;
+            metrics->bytes_processed += batch.consumed;
+            pos += batch.consumed;
+            
+            if (n > 0) continue;
+            if (batch.status == -2) {
+                // A single frame has more args than the batch holds: grow it
+                respb_batch_free(&batch);
+                arg_capacity *= 2;
+                if (!respb_batch_init(&batch, batch_size, arg_capacity)) {
+                    fprintf(stderr, "Failed to grow batch to %zu args\n", arg_capacity);
+                    return 0;
+                }
+                continue;
+            }
+            if (batch.status == -1) {
+                fprintf(stderr, "RESPB batch parse error at position %zu, opcode 0x%04X\n",
+                        pos, respb_read_u16(wl->data + pos));
+                respb_batch_free(&batch);
+                return 0;
+            }
+            break; // Trailing partial frame
+        }
+    }
+    
+    benchmark_timer_stop(&timer, metrics);
+    benchmark_compute_percentiles(metrics);
+    
+    respb_batch_free(&batch);
+    return 1;
+}
+
+static int benchmark_resp_stream(workload_t *wl, benchmark_metrics_t *metrics,
+                                 int iterations, size_t chunk_size) {
+    benchmark_metrics_init(metrics);
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    
+    for (int iter = 0; iter < iterations; iter++) {
+        valkey_client client;
+        valkey_client_init(&client, NULL, 0);
+        
+        for (size_t off = 0; off < wl->size; off += chunk_size) {
+            size_t n = wl->size - off < chunk_size ? wl->size - off : chunk_size;
+            valkey_client_feed(&client, wl->data + off, n);
+            metrics->bytes_processed += n;
+            
+            for (;;) {
+                int result = valkey_parse_command(&client);
+                if (result == 1) {
+                    metrics->commands_processed++;
+                    for (int i = 0; i < client.argc; i++) {
+                        if (client.argv[i]) decrRefCount(client.argv[i]);
+                    }
+                    client.argc = 0;
+                    client.argv_len_sum = 0;
+                } else if (result == 0) {
+                    break; // Wait for the next chunk
+                } else {
+                    fprintf(stderr, "RESP stream parse error at chunk offset %zu\n", off);
+                    valkey_client_free(&client);
+                    return 0;
+                }
+            }
+        }
+        
+        valkey_client_free(&client);
+    }
+    
+    benchmark_timer_stop(&timer, metrics);
+    benchmark_compute_percentiles(metrics);
+    return 1;
+}
+
+static int benchmark_respb_stream(workload_t *wl, benchmark_metrics_t *metrics,
+                                  int iterations, size_t chunk_size) {
+    benchmark_metrics_init(metrics);
+    respb_stream_t stream;
+    respb_stream_init(&stream);
+    respb_command_t cmd;
+    
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    
+    for (int iter = 0; iter < iterations; iter++) {
+        respb_stream_reset(&stream);
+        
+        for (size_t off = 0; off < wl->size; off += chunk_size) {
+            size_t n = wl->size - off < chunk_size ? wl->size - off : chunk_size;
+            size_t used = 0;
+            metrics->bytes_processed += n;
+            
+            while (used < n) {
+                size_t consumed;
+                int result = respb_parser_feed(&stream, wl->data + off + used, n - used,
+                                               &consumed, &cmd);
+                used += consumed;
+                if (result == 1) {
+                    metrics->commands_processed++;
+                } else if (result == 0) {
+                    break; // Wait for the next chunk
+                } else {
+                    fprintf(stderr, "RESPB stream parse error at position %zu\n", off + used);
+                    respb_stream_free(&stream);
+                    return 0;
+                }
+            }
+        }
+    }
+    
+    benchmark_timer_stop(&timer, metrics);
+    benchmark_compute_percentiles(metrics);
+    
+    respb_stream_free(&stream);
+    return 1;
+}
+
+static int benchmark_respb_compact(workload_t *wl, benchmark_metrics_t *metrics,
+                                   int iterations) {
+    benchmark_metrics_init(metrics);
+    respb_arena_t arena;
+    if (!respb_arena_init(&arena, RESPB_ARENA_DEFAULT)) {
+        fprintf(stderr, "Failed to allocate argument arena\n");
+        return 0;
+    }
+    respb_cmd_t cmd;
+    
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    
+    for (int iter = 0; iter < iterations; iter++) {
+        respb_parser_t parser;
+        respb_parser_init(&parser, wl->data, wl->size);
+        
+        while (parser.pos < parser.buffer_len) {
+            size_t start_pos = parser.pos;
+            int result = respb_parse_compact(&parser, &cmd, &arena);
+            if (result != 1) {
+                if (result == 0) break; // Trailing partial frame
+                fprintf(stderr, "RESPB compact parse error at position %zu\n", start_pos);
+                respb_arena_free(&arena);
+                return 0;
+            }
+            metrics->commands_processed++;
+            metrics->bytes_processed += parser.pos - start_pos;
+            respb_arena_reset(&arena); // Command handled, its spans are no longer needed
+        }
+    }
+    
+    benchmark_timer_stop(&timer, metrics);
+    benchmark_compute_percentiles(metrics);
+    
+    respb_arena_free(&arena);
+    return 1;
+}
+
+// What an iterator consumer reads from each frame
+typedef enum {
+    ITER_FIRST_KEY = 0,         // Routing: first string argument only
+    ITER_ALL_ARGS               // Streaming into storage: every field
+} iter_consumer_t;
+
+static int benchmark_respb_iter(workload_t *wl, benchmark_metrics_t *metrics,
+                                int iterations, iter_consumer_t consumer) {
+    benchmark_metrics_init(metrics);
+    uint64_t checksum = 0;
+    
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    
+    for (int iter = 0; iter < iterations; iter++) {
+        size_t pos = 0;
+        while (pos < wl->size) {
+            respb_arg_iter_t it;
+            size_t frame_len;
+            int result = respb_arg_iter_init(&it, wl->data + pos, wl->size - pos);
+            if (result == -1) {
+                fprintf(stderr, "RESPB iterator error at position %zu\n", pos);
+                return 0;
+            }
+            
+            if (result == 1 && consumer == ITER_FIRST_KEY) {
+                respb_arg_t key;
+                if (respb_arg_iter_next_str(&it, &key) == 1) checksum += key.len;
+            } else if (result == 1) {
+                respb_value_t value;
+                while (respb_arg_iter_next(&it, &value) == 1) checksum++;
+            }
+            if (result == 0 || !respb_arg_iter_finish(&it, &frame_len)) break; // Trailing partial frame
+            
+            metrics->commands_processed++;
+            metrics->bytes_processed += frame_len;
+            pos += frame_len;
+        }
+    }
+    
+    benchmark_timer_stop(&timer, metrics);
+    benchmark_compute_percentiles(metrics);
+    
+    // Keep the consumer loop from being optimized away
+    if (checksum == 0) fprintf(stderr, "RESPB iterator yielded no arguments\n");
+    return 1;
+}
+
+// Proxy-style pass: frame boundaries and routing fields only
+static int benchmark_respb_skip(workload_t *wl, benchmark_metrics_t *metrics,
+                                int iterations) {
+    benchmark_metrics_init(metrics);
+    uint64_t checksum = 0;
+    
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    
+    for (int iter = 0; iter < iterations; iter++) {
+        size_t pos = 0;
+        while (pos < wl->size) {
+            respb_frame_info_t info;
+            int result = respb_peek_frame(wl->data + pos, wl->size - pos, &info);
+            if (result != 1) {
+                if (result == 0) break; // Trailing partial frame
+                fprintf(stderr, "RESPB skip-scan error at position %zu\n", pos);
+                return 0;
+            }
+            checksum += info.opcode ^ info.mux_id;
+            metrics->commands_processed++;
+            metrics->bytes_processed += info.length;
+            pos += info.length;
+        }
+    }
+    
+    benchmark_timer_stop(&timer, metrics);
+    benchmark_compute_percentiles(metrics);
+    
+    // Keep the routing fields from being optimized away
+    if (checksum == 0 && metrics->commands_processed > 0) {
+        fprintf(stderr, "RESPB skip-scan read no routing fields\n");
+    }
+    return 1;
+}
+
+// How passthrough payloads are decoded after the frame is parsed
+typedef enum {
+    PASSTHROUGH_SDS_COPY = 0,   // valkey_client_init(): sds copy, one robj per argument
+    PASSTHROUGH_BORROWED        // respb_parse_passthrough(): spans into the frame
+} passthrough_decoder_t;
+
+static int benchmark_respb_passthrough(workload_t *wl, benchmark_metrics_t *metrics,
+                                       int iterations, passthrough_decoder_t decoder) {
+    benchmark_metrics_init(metrics);
+    respb_command_t cmd;
+    respb_arg_t args[RESPB_MAX_ARGS];
+    uint64_t checksum = 0;
+    
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    
+    for (int iter = 0; iter < iterations; iter++) {
+        respb_parser_t parser;
+        respb_parser_init(&parser, wl->data, wl->size);
+        
+        while (parser.pos < parser.buffer_len) {
+            size_t start_pos = parser.pos;
+            int result = respb_parse_command(&parser, &cmd);
+            if (result != 1) {
+                if (result == 0) break; // Trailing partial frame
+                fprintf(stderr, "RESPB parse error at position %zu\n", start_pos);
+                return 0;
+            }
+            
+            if (cmd.opcode != RESPB_OP_RESP_PASSTHROUGH) {
+                checksum += cmd.argc;
+            } else if (decoder == PASSTHROUGH_BORROWED) {
+                size_t argc;
+                if (respb_parse_passthrough(&cmd, args, RESPB_MAX_ARGS, &argc) != 1) {
+                    fprintf(stderr, "RESP passthrough error at position %zu\n", start_pos);
+                    return 0;
+                }
+                checksum += argc;
+            } else {
+                valkey_client client;
+                valkey_client_init(&client, cmd.resp_data, cmd.resp_length);
+                result = valkey_parse_command(&client);
+                checksum += client.argc;
+                valkey_client_free(&client);
+                if (result != 1) {
+                    fprintf(stderr, "RESP passthrough error at position %zu\n", start_pos);
+                    return 0;
+                }
+            }
+            metrics->commands_processed++;
+            metrics->bytes_processed += parser.pos - start_pos;
+        }
+    }
+    
+    benchmark_timer_stop(&timer, metrics);
+    benchmark_compute_percentiles(metrics);
+    
+    // Keep the decoded arguments from being optimized away
+    if (checksum == 0 && metrics->commands_processed > 0) {
+        fprintf(stderr, "RESPB passthrough benchmark decoded no arguments\n");
+    }
+    return 1;
+}
+
+// Command name lookups: the generated perfect hash against the two usual
+// alternatives, a strcasecmp() chain and Valkey's command dict
+typedef const respb_schema_t *(*name_lookup_fn)(const char *name, size_t len);
+
+static const respb_schema_t *lookup_strcasecmp_chain(const char *name, size_t len) {
+    (void)len;
+    for (size_t i = 0; i < respb_schema_count; i++) {
+        if (strcasecmp(name, respb_schemas[i].name) == 0) return &respb_schemas[i];
+    }
+    return NULL;
+}
+
+// Valkey hashes command names with SipHash-1-2 over lower-cased bytes
+// (siphash_nocase) into a chained, power-of-two dict
+#define SIP_ROTL(x, b) (uint64_t)(((x) << (b)) | ((x) >> (64 - (b))))
+#define SIP_ROUND(v0, v1, v2, v3) do { \
+    v0 += v1; v1 = SIP_ROTL(v1, 13); v1 ^= v0; v0 = SIP_ROTL(v0, 32); \
+    v2 += v3; v3 = SIP_ROTL(v3, 16); v3 ^= v2; \
+    v0 += v3; v3 = SIP_ROTL(v3, 21); v3 ^= v0; \
+    v2 += v1; v1 = SIP_ROTL(v1, 17); v1 ^= v2; v2 = SIP_ROTL(v2, 32); \
+} while (0)
+
+static uint64_t siphash_nocase(const char *in, size_t len, uint64_t k0, uint64_t k1) {
+    uint64_t v0 = 0x736f6d6570736575ULL ^ k0;
+    uint64_t v1 = 0x646f72616e646f6dULL ^ k1;
+    uint64_t v2 = 0x6c7967656e657261ULL ^ k0;
+    uint64_t v3 = 0x7465646279746573ULL ^ k1;
+    uint64_t b = (uint64_t)len << 56;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t m = 0;
+        for (int j = 0; j < 8; j++) m |= (uint64_t)(uint8_t)tolower((uint8_t)in[i + j]) << (8 * j);
+        v3 ^= m;
+        SIP_ROUND(v0, v1, v2, v3);
+        v0 ^= m;
+    }
+    for (int j = 0; i + j < len; j++) b |= (uint64_t)(uint8_t)tolower((uint8_t)in[i + j]) << (8 * j);
+    v3 ^= b;
+    SIP_ROUND(v0, v1, v2, v3);
+    v0 ^= b;
+    v2 ^= 0xff;
+    SIP_ROUND(v0, v1, v2, v3);
+    SIP_ROUND(v0, v1, v2, v3);
+    return v0 ^ v1 ^ v2 ^ v3;
+}
+
+typedef struct name_dict_entry {
+    const respb_schema_t *schema;
+    struct name_dict_entry *next;
+} name_dict_entry_t;
+
+static struct {
+    name_dict_entry_t **table;
+    name_dict_entry_t *entries;
+    uint64_t mask;
+} name_dict;
+
+static int name_dict_build(void) {
+    size_t size = 4;
+    while (size < respb_schema_count) size *= 2; // Valkey grows at load factor 1
+    name_dict.table = calloc(size, sizeof(*name_dict.table));
+    name_dict.entries = calloc(respb_schema_count, sizeof(*name_dict.entries));
+    if (!name_dict.table || !name_dict.entries) return 0;
+    name_dict.mask = size - 1;
+    for (size_t i = 0; i < respb_schema_count; i++) {
+        const char *name = respb_schemas[i].name;
+        uint64_t slot = siphash_nocase(name, strlen(name), 0x0706050403020100ULL,
+                                       0x0f0e0d0c0b0a0908ULL) & name_dict.mask;
+        name_dict.entries[i].schema = &respb_schemas[i];
+        name_dict.entries[i].next = name_dict.table[slot];
+        name_dict.table[slot] = &name_dict.entries[i];
+    }
+    return 1;
+}
+
+static void name_dict_free(void) {
+    free(name_dict.table);
+    free(name_dict.entries);
+    memset(&name_dict, 0, sizeof(name_dict));
+}
+
+static const respb_schema_t *lookup_valkey_dict(const char *name, size_t len) {
+    uint64_t slot = siphash_nocase(name, len, 0x0706050403020100ULL,
+                                   0x0f0e0d0c0b0a0908ULL) & name_dict.mask;
+    for (name_dict_entry_t *e = name_dict.table[slot]; e; e = e->next) {
+        if (strcasecmp(name, e->schema->name) == 0) return e->schema;
+    }
+    return NULL;
+}
+
+// Nanoseconds per lookup over names[], which must all resolve
+static double benchmark_name_lookup(name_lookup_fn lookup, char **names, const size_t *lens,
+                                    size_t count, int iterations) {
+    uint64_t checksum = 0;
+    size_t rounds = (size_t)iterations * 1000;
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            const respb_schema_t *schema = lookup(names[i], lens[i]);
+            if (!schema) {
+                fprintf(stderr, "Command name not found: %s\n", names[i]);
+                return -1.0;
+            }
+            checksum += schema->code;
+        }
+    }
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    if (checksum == 0) fprintf(stderr, "Name lookups returned no opcodes\n");
+    return (double)elapsed_ns / (double)(rounds * count);
+}
+
+// One command for the serializer benchmark: 12-byte keys, 32-byte values,
+// flags clear, groups of 4
+#define SERIALIZE_MAX_VALUES 48
+
+typedef struct {
+    const respb_schema_t *schema;
+    respb_arg_t args[SERIALIZE_MAX_VALUES];
+    respb_num_t nums[SERIALIZE_MAX_VALUES];
+    size_t argc;
+    size_t nnums;
+} serialize_sample_t;
+
+static int serialize_sample_init(serialize_sample_t *s, const respb_schema_t *schema) {
+    static const char key[] = "key:00000042";
+    static const char value[] = "value:0123456789abcdef0123456789";
+    const respb_field_t *f = schema->fields;
+    const respb_field_t *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL, *group_end = NULL;
+    uint16_t left = 0;
+    s->schema = schema;
+    s->argc = s->nnums = 0;
+    while (f < end) {
+        if (s->argc == SERIALIZE_MAX_VALUES || s->nnums == SERIALIZE_MAX_VALUES) return 0;
+        switch (f->kind) {
+            case RESPB_FIELD_STR2:
+                s->args[s->argc].data = (const uint8_t *)key;
+                s->args[s->argc++].len = sizeof(key) - 1;
+                break;
+            case RESPB_FIELD_STR4:
+                s->args[s->argc].data = (const uint8_t *)value;
+                s->args[s->argc++].len = sizeof(value) - 1;
+                break;
+            case RESPB_FIELD_F64:
+                s->nums[s->nnums++].f = 1.5;
+                break;
+            case RESPB_FIELD_I64:
+                s->nums[s->nnums++].i = 1000;
+                break;
+            case RESPB_FIELD_GROUP:
+                s->nums[s->nnums++].u = 4;
+                group_start = f + 1;
+                group_end = group_start + f->arg;
+                left = 4;
+                f = group_start;
+                continue;
+            case RESPB_FIELD_OPT:
+                f++; /* flags are clear: gated fields are absent */
+                break;
+            default:
+                s->nums[s->nnums++].u = 0;
+                break;
+        }
+        f++;
+        if (f == group_end && --left) f = group_start;
+    }
+    return 1;
+}
+
+// Commands/sec and MB/s encoding samples[] with respb_serialize_schema(), or
+// with respb_serialize_command() when inline is set
+static int benchmark_serialize(const serialize_sample_t *samples, size_t count, int iterations,
+                               int inline_cases, double *cmds_per_sec, double *mb_per_sec) {
+    static uint8_t buf[4096];
+    respb_command_t *cmds = NULL;
+    if (inline_cases) {
+        cmds = calloc(count, sizeof(*cmds));
+        if (!cmds) return 0;
+        for (size_t i = 0; i < count; i++) {
+            cmds[i].opcode = (uint16_t)samples[i].schema->code;
+            cmds[i].argc = samples[i].argc;
+            memcpy(cmds[i].args, samples[i].args, samples[i].argc * sizeof(respb_arg_t));
+        }
+    }
+    
+    size_t rounds = (size_t)iterations * 1000;
+    uint64_t bytes = 0;
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t i = 0; i < count; i++) {
+            const serialize_sample_t *s = &samples[i];
+            size_t n = inline_cases
+                ? respb_serialize_command(buf, sizeof(buf), &cmds[i])
+                : respb_serialize_schema(buf, sizeof(buf), s->schema, 0,
+                                         s->args, s->argc, s->nums, s->nnums);
+            if (n == 0) {
+                fprintf(stderr, "Failed to serialize %s\n", s->schema->name);
+                free(cmds);
+                return 0;
+            }
+            bytes += n;
+        }
+    }
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    free(cmds);
+    double seconds = elapsed_ns / 1000000000.0;
+    *cmds_per_sec = seconds > 0 ? (double)(rounds * count) / seconds : 0.0;
+    *mb_per_sec = seconds > 0 ? (double)bytes / (1024.0 * 1024.0) / seconds : 0.0;
+    return 1;
+}
+
+static double metrics_throughput(const benchmark_metrics_t *metrics) {
+    if (metrics->total_time_ns == 0) return 0.0;
+    return (double)metrics->commands_processed / (metrics->total_time_ns / 1000000000.0);
+}
+
+static int run_mset_benchmarks(benchmark_config_t *config) {
+    static const size_t key_counts[] = {10, 100, 1000, 10000};
+    const size_t nsizes = sizeof(key_counts) / sizeof(key_counts[0]);
+    const size_t target_size = 8 * 1024 * 1024;
+    double tput[4][3] = {{0}};
+    
+    for (size_t s = 0; s < nsizes; s++) {
+        size_t nkeys = key_counts[s];
+        benchmark_metrics_t metrics;
+        printf("\n--- MSET with %zu keys ---\n", nkeys);
+        
+        if (config->bench_resp) {
+            workload_t *wl = workload_generate_multikey(target_size, RESPB_OP_MSET, nkeys, 0);
+            if (!wl) return 0;
+            int ok = benchmark_resp_parsing(wl, &metrics, config->iterations, 0);
+            workload_free(wl);
+            if (!ok) return 0;
+            benchmark_print_metrics(&metrics, "RESP");
+            tput[s][0] = metrics_throughput(&metrics);
+        }
+        
+        if (config->bench_respb) {
+            workload_t *wl = workload_generate_multikey(target_size, RESPB_OP_MSET, nkeys, 1);
+            if (!wl) return 0;
+            
+            // respb_command_t keeps the first RESPB_MAX_ARGS spans of each frame
+            int ok = benchmark_respb_parsing(wl, &metrics, config->iterations, 0,
+                                             respb_parse_command);
+            if (ok) {
+                benchmark_print_metrics(&metrics, "RESPB (respb_command_t)");
+                tput[s][1] = metrics_throughput(&metrics);
+                ok = benchmark_respb_compact(wl, &metrics, config->iterations);
+            }
+            workload_free(wl);
+            if (!ok) return 0;
+            benchmark_print_metrics(&metrics, "RESPB (respb_cmd_t + arena)");
+            tput[s][2] = metrics_throughput(&metrics);
+        }
+    }
+    
+    printf("\n=== MSET Scaling (commands/sec) ===\n\n");
+    printf("  %6s  %14s  %14s  %14s\n", "Keys", "RESP", "RESPB fixed", "RESPB arena");
+    for (size_t s = 0; s < nsizes; s++) {
+        printf("  %6zu  %14.0f  %14.0f  %14.0f\n",
+               key_counts[s], tput[s][0], tput[s][1], tput[s][2]);
+    }
+    printf("\nsizeof(respb_command_t) = %zu, sizeof(respb_cmd_t) = %zu\n",
+           sizeof(respb_command_t), sizeof(respb_cmd_t));
+    printf("RESPB fixed stores at most %d args per command; arena stores all of them\n",
+           RESPB_MAX_ARGS);
+    return 1;
+}
+
+static int run_iter_benchmarks(benchmark_config_t *config) {
+    static const uint16_t opcodes[] = {RESPB_OP_MGET, RESPB_OP_MSET, RESPB_OP_SADD};
+    static const char *names[] = {"MGET", "MSET", "SADD"};
+    const size_t nworkloads = sizeof(opcodes) / sizeof(opcodes[0]);
+    const size_t nelems = 24; // Fits respb_command_t, so the full parse keeps every arg
+    double tput[3][3] = {{0}};
+    
+    for (size_t w = 0; w < nworkloads; w++) {
+        workload_t *wl = workload_generate_multikey(8 * 1024 * 1024, opcodes[w], nelems, 1);
+        if (!wl) return 0;
+        benchmark_metrics_t metrics;
+        
+        int ok = benchmark_respb_parsing(wl, &metrics, config->iterations, 0,
+                                         respb_parse_command);
+        tput[w][0] = metrics_throughput(&metrics);
+        ok = ok && benchmark_respb_iter(wl, &metrics, config->iterations, ITER_FIRST_KEY);
+        tput[w][1] = metrics_throughput(&metrics);
+        ok = ok && benchmark_respb_iter(wl, &metrics, config->iterations, ITER_ALL_ARGS);
+        tput[w][2] = metrics_throughput(&metrics);
+        workload_free(wl);
+        if (!ok) return 0;
+    }
+    
+    printf("\n=== RESPB Argument Iterator (%zu elements per command, commands/sec) ===\n\n",
+           nelems);
+    printf("  %-6s  %14s  %14s  %14s\n", "", "Full parse", "Iter first key", "Iter all");
+    for (size_t w = 0; w < nworkloads; w++) {
+        printf("  %-6s  %14.0f  %14.0f  %14.0f\n", names[w], tput[w][0], tput[w][1], tput[w][2]);
+    }
+    return 1;
+}
+
+static int run_passthrough_benchmarks(benchmark_config_t *config) {
+    static const unsigned shares[] = {0, 10, 50, 100};
+    const size_t nshares = sizeof(shares) / sizeof(shares[0]);
+    double tput[4][2] = {{0}};
+    
+    for (size_t s = 0; s < nshares; s++) {
+        workload_t *wl = workload_generate_passthrough(8 * 1024 * 1024, shares[s]);
+        if (!wl) return 0;
+        benchmark_metrics_t metrics;
+        
+        int ok = benchmark_respb_passthrough(wl, &metrics, config->iterations,
+                                             PASSTHROUGH_SDS_COPY);
+        tput[s][0] = metrics_throughput(&metrics);
+        ok = ok && benchmark_respb_passthrough(wl, &metrics, config->iterations,
+                                               PASSTHROUGH_BORROWED);
+        tput[s][1] = metrics_throughput(&metrics);
+        workload_free(wl);
+        if (!ok) return 0;
+    }
+    
+    printf("\n=== RESP Passthrough Decoding (commands/sec) ===\n\n");
+    printf("  %-12s  %14s  %14s  %8s\n", "Passthrough", "sds copy", "Borrowed", "Speedup");
+    for (size_t s = 0; s < nshares; s++) {
+        printf("  %11u%%  %14.0f  %14.0f  %7.2fx\n", shares[s], tput[s][0], tput[s][1],
+               tput[s][0] > 0 ? tput[s][1] / tput[s][0] : 0.0);
+    }
+    return 1;
+}
+
+static int run_module_benchmarks(benchmark_config_t *config) {
+    // JSON.SET, JSON.GET, BF.ADD, FT.SEARCH, then the same layouts registered
+    // at runtime as commands 0-3 of module 0x0100
+    static const uint32_t generated[4] = {0x00000000, 0x00000001, 0x00010000, 0x00020001};
+    static const uint32_t registered[4] = {0x01000000, 0x01000001, 0x01000002, 0x01000003};
+    static respb_schema_t schemas[4];
+    for (size_t i = 0; i < 4; i++) {
+        schemas[i] = *respb_schema_lookup_module(generated[i] >> 16, generated[i] & 0xFFFF);
+        schemas[i].code = registered[i];
+    }
+    if (respb_register_module(0x0100, schemas, 4) != 1) {
+        fprintf(stderr, "Failed to register benchmark module\n");
+        return 0;
+    }
+    
+    static const char *names[] = {"Core (GET/SET/DEL/MGET)", "Generated modules",
+                                  "Registered modules"};
+    double tput[3][2] = {{0}};
+    int ok = 1;
+    for (size_t w = 0; w < 3 && ok; w++) {
+        workload_t *wl = w == 0 ? workload_generate_passthrough(8 * 1024 * 1024, 0) :
+                         workload_generate_modules(8 * 1024 * 1024, w == 1 ? generated : registered);
+        if (!wl) {
+            ok = 0;
+            break;
+        }
+        benchmark_metrics_t metrics;
+        ok = benchmark_respb_parsing(wl, &metrics, config->iterations, 0, respb_parse_command);
+        tput[w][0] = metrics_throughput(&metrics);
+        ok = ok && benchmark_respb_parsing(wl, &metrics, config->iterations, 0,
+                                           respb_parse_command_table);
+        tput[w][1] = metrics_throughput(&metrics);
+        workload_free(wl);
+    }
+    respb_register_module(0x0100, NULL, 0);
+    if (!ok) return 0;
+    
+    printf("\n=== RESPB Module Commands (commands/sec) ===\n\n");
+    printf("  %-24s  %14s  %14s\n", "", "Switch", "Table-driven");
+    for (size_t w = 0; w < 3; w++) {
+        printf("  %-24s  %14.0f  %14.0f\n", names[w], tput[w][0], tput[w][1]);
+    }
+    return 1;
+}
+
+static int run_name_benchmarks(benchmark_config_t *config) {
+    // Every command name, upper-case and lower-case, as clients send them
+    size_t count = respb_schema_count * 2;
+    char **names = calloc(count, sizeof(*names));
+    size_t *lens = calloc(count, sizeof(*lens));
+    int ok = names && lens && name_dict_build();
+    for (size_t i = 0; ok && i < respb_schema_count; i++) {
+        size_t len = strlen(respb_schemas[i].name);
+        names[2 * i] = strdup(respb_schemas[i].name);
+        names[2 * i + 1] = strdup(respb_schemas[i].name);
+        ok = names[2 * i] && names[2 * i + 1];
+        for (size_t j = 0; ok && j < len; j++) {
+            names[2 * i + 1][j] = (char)tolower((uint8_t)names[2 * i + 1][j]);
+        }
+        lens[2 * i] = lens[2 * i + 1] = len;
+    }
+    
+    static const char *labels[] = {"Perfect hash", "strcasecmp chain", "Valkey dict (siphash)"};
+    name_lookup_fn fns[] = {respb_command_lookup, lookup_strcasecmp_chain, lookup_valkey_dict};
+    double ns[3] = {0};
+    for (size_t m = 0; ok && m < 3; m++) {
+        ns[m] = benchmark_name_lookup(fns[m], names, lens, count, config->iterations);
+        ok = ns[m] >= 0;
+    }
+    
+    for (size_t i = 0; names && i < count; i++) free(names[i]);
+    free(names);
+    free(lens);
+    name_dict_free();
+    if (!ok) return 0;
+    
+    printf("\n=== Command Name Lookup (%zu names, mixed case) ===\n\n", count);
+    for (size_t m = 0; m < 3; m++) {
+        printf("  %-22s  %8.1f ns/lookup  %6.2fx\n", labels[m], ns[m],
+               ns[0] > 0 ? ns[m] / ns[0] : 0.0);
+    }
+    return 1;
+}
+
+static int run_serialize_benchmarks(benchmark_config_t *config) {
+    // Opcode ranges of respb-commands.md
+    static const struct {
+        const char *name;
+        uint16_t first, last;
+    } categories[] = {
+        {"String", 0x0000, 0x003F}, {"List", 0x0040, 0x007F},
+        {"Set", 0x0080, 0x00BF}, {"Sorted set", 0x00C0, 0x00FF},
+        {"Hash", 0x0100, 0x013F}, {"Bitmap", 0x0140, 0x015F},
+        {"HyperLogLog", 0x0160, 0x017F}, {"Geo", 0x0180, 0x01BF},
+        {"Stream", 0x01C0, 0x01FF}, {"Pub/Sub", 0x0200, 0x023F},
+        {"Transaction", 0x0240, 0x025F}, {"Scripting", 0x0260, 0x02BF},
+        {"Generic key", 0x02C0, 0x02FF}, {"Connection", 0x0300, 0x033F},
+        {"Cluster", 0x0340, 0x03BF}, {"Server", 0x03C0, 0x04FF},
+    };
+    static const uint16_t inline_opcodes[] = {
+        RESPB_OP_GET, RESPB_OP_SET, RESPB_OP_APPEND, RESPB_OP_MGET, RESPB_OP_MSET,
+        RESPB_OP_LPUSH, RESPB_OP_SADD, RESPB_OP_HSET, RESPB_OP_HGET,
+    };
+    const size_t ncategories = sizeof(categories) / sizeof(categories[0]);
+    const size_t ninline = sizeof(inline_opcodes) / sizeof(inline_opcodes[0]);
+    
+    serialize_sample_t *samples = calloc(respb_schema_count, sizeof(*samples));
+    if (!samples) return 0;
+    
+    printf("\n=== Serialize Throughput (respb_serialize_schema, %zu layouts) ===\n\n",
+           respb_schema_count);
+    printf("  %-13s %8s %14s %10s\n", "Category", "Layouts", "Commands/sec", "MB/s");
+    
+    // Core categories, then every module command as one row
+    int ok = 1;
+    for (size_t c = 0; ok && c <= ncategories; c++) {
+        size_t count = 0;
+        for (size_t i = 0; i < respb_schema_count; i++) {
+            const respb_schema_t *schema = &respb_schemas[i];
+            int module = (schema->flags & RESPB_SCHEMA_MODULE) != 0;
+            int member = c == ncategories ? module
+                : !module && schema->code >= categories[c].first && schema->code <= categories[c].last;
+            if (member && serialize_sample_init(&samples[count], schema)) count++;
+        }
+        if (count == 0) continue;
+        double cps, mbps;
+        ok = benchmark_serialize(samples, count, config->iterations, 0, &cps, &mbps);
+        if (ok) {
+            printf("  %-13s %8zu %13.2fM %10.1f\n",
+                   c == ncategories ? "Modules" : categories[c].name, count, cps / 1e6, mbps);
+        }
+    }
+    
+    // The opcodes respb_serialize_command() writes inline
+    size_t count = 0;
+    for (size_t i = 0; ok && i < ninline; i++) {
+        ok = serialize_sample_init(&samples[count++], respb_schema_lookup(inline_opcodes[i]));
+    }
+    double inline_cps = 0, inline_mbps = 0, schema_cps = 0, schema_mbps = 0;
+    ok = ok && benchmark_serialize(samples, count, config->iterations, 1, &inline_cps, &inline_mbps) &&
+         benchmark_serialize(samples, count, config->iterations, 0, &schema_cps, &schema_mbps);
+    free(samples);
+    if (!ok) return 0;
+    
+    printf("\n  GET/SET/APPEND/MGET/MSET/LPUSH/SADD/HSET/HGET:\n");
+    printf("  %-22s %13.2fM %10.1f\n", "Hand-written cases", inline_cps / 1e6, inline_mbps);
+    printf("  %-22s %13.2fM %10.1f  (%.2fx)\n", "Schema encoder", schema_cps / 1e6, schema_mbps,
+           inline_cps > 0 ? schema_cps / inline_cps : 0.0);
+    return 1;
+}
+
+// SET, APPEND, PUBLISH and JSON.SET with value_size-byte values, serialized
+// into one flat buffer or as an iovec array. Reports frames/sec, frame GB/s
+// and the bytes each path copies per frame
+static int benchmark_serialize_iov(const uint8_t *value, size_t value_size, size_t frames,
+                                   int use_iov, double *frames_per_sec, double *gb_per_sec,
+                                   double *copied_per_frame) {
+    static const uint16_t opcodes[] = {RESPB_OP_SET, RESPB_OP_APPEND, RESPB_OP_PUBLISH,
+                                       RESPB_OP_MODULE};
+    respb_command_t cmds[4];
+    memset(cmds, 0, sizeof(cmds));
+    for (size_t i = 0; i < 4; i++) {
+        respb_command_t *cmd = &cmds[i];
+        cmd->opcode = opcodes[i];
+        cmd->args[0].data = (const uint8_t *)"key:00000042";
+        cmd->args[0].len = 12;
+        size_t value_arg = 1;
+        if (cmd->opcode == RESPB_OP_MODULE) {
+            cmd->module_id = RESPB_MODULE_JSON;  // JSON.SET key $ value
+            cmd->args[1].data = (const uint8_t *)"$";
+            cmd->args[1].len = 1;
+            value_arg = 2;
+        }
+        cmd->args[value_arg].data = value;
+        cmd->args[value_arg].len = value_size;
+        cmd->argc = value_arg + 1;
+    }
+    
+    size_t out_len = value_size + 64;
+    uint8_t *out = use_iov ? NULL : malloc(out_len);
+    if (!use_iov && !out) return 0;
+    uint8_t scratch[256];
+    struct iovec iov[8];
+    uint64_t bytes = 0, copied = 0;
+    
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    for (size_t f = 0; f < frames; f++) {
+        const respb_command_t *cmd = &cmds[f & 3];
+        size_t n;
+        if (use_iov) {
+            size_t iovcnt;
+            n = respb_serialize_iov(scratch, sizeof(scratch), iov, 8, &iovcnt, cmd);
+            for (size_t i = 0; i < iovcnt; i++) {
+                uint8_t *base = iov[i].iov_base;
+                if (base >= scratch && base < scratch + sizeof(scratch)) copied += iov[i].iov_len;
+            }
+        } else {
+            n = respb_serialize_command(out, out_len, cmd);
+            copied += n;
+        }
+        if (n == 0) {
+            fprintf(stderr, "Failed to serialize %zu-byte value\n", value_size);
+            free(out);
+            return 0;
+        }
+        bytes += n;
+    }
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    free(out);
+    
+    double seconds = elapsed_ns / 1000000000.0;
+    *frames_per_sec = seconds > 0 ? frames / seconds : 0.0;
+    *gb_per_sec = seconds > 0 ? bytes / 1e9 / seconds : 0.0;
+    *copied_per_frame = (double)copied / frames;
+    return 1;
+}
+
+static int run_iov_benchmarks(benchmark_config_t *config) {
+    static const size_t value_sizes[] = {1024, 100 * 1024, 1024 * 1024, 10 * 1024 * 1024};
+    const size_t nsizes = sizeof(value_sizes) / sizeof(value_sizes[0]);
+    uint8_t *value = malloc(value_sizes[nsizes - 1]);
+    if (!value) return 0;
+    memset(value, 'v', value_sizes[nsizes - 1]);
+    
+    printf("\n=== Scatter/Gather Serializer (SET, APPEND, PUBLISH, JSON.SET) ===\n\n");
+    printf("  %-8s  %-8s %13s %10s %14s\n", "Value", "Path", "Frames/sec", "Frame GB/s", "Copied/frame");
+    int ok = 1;
+    for (size_t s = 0; ok && s < nsizes; s++) {
+        // About 64 MB of values per iteration, at least one of each command
+        size_t frames = (size_t)config->iterations * (64 * 1024 * 1024 / value_sizes[s]);
+        if (frames < 4) frames = 4;
+        double fps[2], gbps[2], copied[2];
+        for (int use_iov = 0; ok && use_iov <= 1; use_iov++) {
+            ok = benchmark_serialize_iov(value, value_sizes[s], frames, use_iov,
+                                         &fps[use_iov], &gbps[use_iov], &copied[use_iov]);
+        }
+        if (!ok) break;
+        char label[32];
+        snprintf(label, sizeof(label), "%zuKB", value_sizes[s] / 1024);
+        printf("  %-8s  %-8s %13.0f %10.2f %14.0f\n", label, "memcpy", fps[0], gbps[0], copied[0]);
+        printf("  %-8s  %-8s %13.0f %10.2f %14.0f  (%.1fx)\n", "", "iovec", fps[1], gbps[1], copied[1],
+               fps[0] > 0 ? fps[1] / fps[0] : 0.0);
+    }
+    free(value);
+    return ok;
+}
+
+// Pipeline of count mixed commands: GET, SET (16 B-4 KB values), MGET, HSET,
+// ZREM, LPUSH and JSON.SET, with argument bytes taken from data
+static void build_pipeline_commands(respb_command_t *cmds, size_t count, const uint8_t *data) {
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < count; i++) {
+        respb_command_t *cmd = &cmds[i];
+        memset(cmd, 0, offsetof(respb_command_t, args));
+        memset(&cmd->view, 0, sizeof(cmd->view));
+        seed = seed * 1103515245 + 12345;
+        size_t value_len = 16 + (seed >> 8) % 4080;
+        size_t argc;
+        switch (i % 7) {
+            case 0: cmd->opcode = RESPB_OP_GET; argc = 1; break;
+            case 1: cmd->opcode = RESPB_OP_SET; argc = 2; break;
+            case 2: cmd->opcode = RESPB_OP_MGET; argc = 4; break;
+            case 3: cmd->opcode = RESPB_OP_HSET; argc = 5; break;
+            case 4: cmd->opcode = RESPB_OP_ZREM; argc = 4; break;
+            case 5: cmd->opcode = RESPB_OP_LPUSH; argc = 5; break;
+            default:
+                cmd->opcode = RESPB_OP_MODULE;
+                cmd->module_id = RESPB_MODULE_JSON;  // JSON.SET
+                cmd->command_id = 0x0000;
+                cmd->module_subcommand = (uint32_t)RESPB_MODULE_JSON << 16;
+                argc = 3;
+                break;
+        }
+        cmd->argc = argc;
+        for (size_t a = 0; a < argc; a++) {
+            cmd->args[a].data = data;
+            cmd->args[a].len = a == argc - 1 && (i % 7 == 1 || i % 7 == 6) ? value_len : 12;
+        }
+    }
+}
+
+// Encode batches of count commands into one buffer each: sized exactly with
+// respb_serialized_size_batch(), or grown by doubling from 4 KB whenever
+// respb_serialize_command() reports a full buffer
+static int benchmark_pipeline_sizing(const respb_command_t *cmds, size_t count, size_t batches,
+                                     int exact, double *cmds_per_sec, double *allocs_per_batch,
+                                     double *slack_per_batch) {
+    uint64_t allocs = 0, slack = 0;
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    for (size_t b = 0; b < batches; b++) {
+        size_t cap = exact ? respb_serialized_size_batch(cmds, count, NULL) : 4096;
+        uint8_t *buf = malloc(cap);
+        if (!buf || cap == 0) {
+            free(buf);
+            return 0;
+        }
+        allocs++;
+        size_t pos = 0;
+        for (size_t i = 0; i < count; i++) {
+            size_t n;
+            while ((n = respb_serialize_command(buf + pos, cap - pos, &cmds[i])) == 0) {
+                if (exact || cap > ((size_t)1 << 30)) {
+                    free(buf);
+                    return 0;
+                }
+                cap *= 2;
+                uint8_t *grown = realloc(buf, cap);
+                if (!grown) {
+                    free(buf);
+                    return 0;
+                }
+                buf = grown;
+                allocs++;
+            }
+            pos += n;
+        }
+        slack += cap - pos;
+        free(buf);
+    }
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    double seconds = elapsed_ns / 1000000000.0;
+    *cmds_per_sec = seconds > 0 ? (double)(batches * count) / seconds : 0.0;
+    *allocs_per_batch = (double)allocs / batches;
+    *slack_per_batch = (double)slack / batches;
+    return 1;
+}
+
+static int run_size_benchmarks(benchmark_config_t *config) {
+    const size_t count = 1000;
+    const size_t batches = (size_t)config->iterations * 100;
+    static uint8_t data[4096];
+    memset(data, 'x', sizeof(data));
+    respb_command_t *cmds = malloc(count * sizeof(*cmds));
+    if (!cmds) return 0;
+    build_pipeline_commands(cmds, count, data);
+    size_t frame_bytes = respb_serialized_size_batch(cmds, count, NULL);
+    
+    double cps[2], allocs[2], slack[2];
+    int ok = frame_bytes > 0;
+    for (int exact = 0; ok && exact <= 1; exact++) {
+        ok = benchmark_pipeline_sizing(cmds, count, batches, exact,
+                                       &cps[exact], &allocs[exact], &slack[exact]);
+    }
+    
+    // Cost of sizing alone
+    double size_ns = 0;
+    if (ok) {
+        uint64_t checksum = 0;
+        benchmark_timer_t timer;
+        benchmark_timer_start(&timer);
+        for (size_t b = 0; b < batches; b++) {
+            checksum += respb_serialized_size_batch(cmds, count, NULL);
+        }
+        size_ns = (double)benchmark_timer_elapsed_ns(&timer) / (double)(batches * count);
+        ok = checksum == (uint64_t)frame_bytes * batches;
+    }
+    free(cmds);
+    if (!ok) return 0;
+    
+    printf("\n=== Pipeline Buffer Sizing (%zu-command batches, %zu bytes each) ===\n\n",
+           count, frame_bytes);
+    printf("  %-20s %14s %12s %12s\n", "Strategy", "Commands/sec", "Allocs", "Slack bytes");
+    printf("  %-20s %13.2fM %12.1f %12.0f\n", "Grow and retry", cps[0] / 1e6, allocs[0], slack[0]);
+    printf("  %-20s %13.2fM %12.1f %12.0f  (%.2fx)\n", "Exact size", cps[1] / 1e6, allocs[1],
+           slack[1], cps[0] > 0 ? cps[1] / cps[0] : 0.0);
+    printf("\n  respb_serialized_size(): %.1f ns/command\n", size_ns);
+    return 1;
+}
+
+// Fill a pipeline with depth commands, flush it, repeat until total commands
+// are encoded. With raw set, the same commands go through
+// respb_serialize_command() into a fixed buffer with no bookkeeping
+static int benchmark_pipeline_depth(const respb_command_t *cmds, size_t ncmds, size_t depth,
+                                    size_t total, int raw, double *cmds_per_sec,
+                                    double *mb_per_sec, size_t *buffer_size) {
+    respb_pipeline_t p;
+    respb_pipeline_init(&p);
+    size_t raw_cap = 0;
+    uint8_t *raw_buf = NULL;
+    if (raw) {
+        // Exact room for the largest window of depth commands
+        for (size_t i = 0; i < ncmds; i++) {
+            size_t window = 0;
+            for (size_t j = 0; j < depth; j++) window += respb_serialized_size(&cmds[(i + j) % ncmds]);
+            if (window > raw_cap) raw_cap = window;
+            if (depth >= ncmds) break;
+        }
+        raw_buf = malloc(raw_cap);
+        if (!raw_buf) return 0;
+    }
+    
+    uint64_t bytes = 0;
+    size_t next = 0;
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    for (size_t done = 0; done < total; done += depth) {
+        size_t pos = 0;
+        for (size_t i = 0; i < depth; i++) {
+            const respb_command_t *cmd = &cmds[next];
+            if (++next == ncmds) next = 0;
+            if (raw) {
+                size_t n = respb_serialize_command(raw_buf + pos, raw_cap - pos, cmd);
+                if (n == 0) {
+                    free(raw_buf);
+                    return 0;
+                }
+                pos += n;
+            } else if (respb_pipeline_append(&p, cmd) != 1) {
+                respb_pipeline_free(&p);
+                return 0;
+            }
+        }
+        if (!raw) {
+            const uint8_t *data;
+            pos = respb_pipeline_pending(&p, &data);
+            respb_pipeline_consume(&p, pos);
+        }
+        bytes += pos;
+    }
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    *buffer_size = raw ? raw_cap : p.cap;
+    free(raw_buf);
+    respb_pipeline_free(&p);
+    
+    double seconds = elapsed_ns / 1000000000.0;
+    size_t encoded = (total + depth - 1) / depth * depth;
+    *cmds_per_sec = seconds > 0 ? encoded / seconds : 0.0;
+    *mb_per_sec = seconds > 0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0;
+    return 1;
+}
+
+static int run_pipeline_benchmarks(benchmark_config_t *config) {
+    static const size_t depths[] = {1, 10, 100, 1000, 10000};
+    const size_t ndepths = sizeof(depths) / sizeof(depths[0]);
+    const size_t ncmds = 1000;
+    const size_t total = (size_t)config->iterations * 100000;
+    static uint8_t data[4096];
+    memset(data, 'x', sizeof(data));
+    respb_command_t *cmds = malloc(ncmds * sizeof(*cmds));
+    if (!cmds) return 0;
+    build_pipeline_commands(cmds, ncmds, data);
+    
+    printf("\n=== Pipeline Builder (%zu commands per depth) ===\n\n", total);
+    printf("  %-7s %14s %10s %12s %14s\n", "Depth", "Commands/sec", "MB/s", "Buffer", "Raw serialize");
+    int ok = 1;
+    for (size_t d = 0; ok && d < ndepths; d++) {
+        double cps[2], mbps[2];
+        size_t buffer[2];
+        for (int raw = 0; ok && raw <= 1; raw++) {
+            ok = benchmark_pipeline_depth(cmds, ncmds, depths[d], total, raw,
+                                          &cps[raw], &mbps[raw], &buffer[raw]);
+        }
+        if (ok) {
+            printf("  %-7zu %13.2fM %10.0f %12zu %13.2fM  (%.2fx)\n", depths[d], cps[0] / 1e6,
+                   mbps[0], buffer[0], cps[1] / 1e6, cps[1] > 0 ? cps[0] / cps[1] : 0.0);
+        }
+    }
+    free(cmds);
+    return ok;
+}
+
+// Decode every reply in wl, iterations times, with the RESPB or the RESP2
+// reply parser into one reused node array
+static int benchmark_reply_decode(const workload_t *wl, int respb, int iterations,
+                                  size_t *replies, double *replies_per_sec) {
+    respb_reply_t nodes[256];
+    size_t count = 0;
+    uint64_t checksum = 0;
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    for (int it = 0; it < iterations; it++) {
+        size_t pos = 0, nnodes;
+        while (pos < wl->size) {
+            int result = respb
+                ? respb_reply_parse(wl->data, wl->size, &pos, NULL, nodes, 256, &nnodes)
+                : respb_resp_reply_parse(wl->data, wl->size, &pos, nodes, 256, &nnodes);
+            if (result != 1 || nnodes > 256) return 0;
+            checksum += nnodes + nodes[nnodes - 1].len;
+            count++;
+        }
+    }
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    if (checksum == 0) fprintf(stderr, "Reply decoder produced no nodes\n");
+    
+    double seconds = elapsed_ns / 1000000000.0;
+    *replies = count / (size_t)iterations;
+    *replies_per_sec = seconds > 0 ? count / seconds : 0.0;
+    return 1;
+}
+
+static int run_reply_benchmarks(benchmark_config_t *config) {
+    const size_t target = 4 * 1024 * 1024;
+    workload_t *wls[REPLY_KIND_COUNT][2] = {{NULL}};
+    int ok = 1;
+    for (int k = 0; ok && k < REPLY_KIND_COUNT; k++) {
+        for (int respb = 0; ok && respb <= 1; respb++) {
+            wls[k][respb] = workload_generate_replies(target, (reply_kind_t)k, respb);
+            ok = wls[k][respb] != NULL;
+        }
+    }
+    
+    printf("\n=== Reply Decoding (%d passes over %zu KB per protocol) ===\n\n",
+           config->iterations, target / 1024);
+    printf("  %-8s %9s %9s %14s %14s %9s\n", "Reply", "RESP B/r", "RESPB B/r",
+           "RESP rep/s", "RESPB rep/s", "Speedup");
+    for (int k = 0; ok && k < REPLY_KIND_COUNT; k++) {
+        size_t replies[2];
+        double rps[2];
+        for (int respb = 0; ok && respb <= 1; respb++) {
+            ok = benchmark_reply_decode(wls[k][respb], respb, config->iterations,
+                                        &replies[respb], &rps[respb]);
+        }
+        if (!ok) {
+            fprintf(stderr, "Reply decoding failed on %s\n", workload_reply_kind_name((reply_kind_t)k));
+            break;
+        }
+        printf("  %-8s %9.1f %9.1f %13.2fM %13.2fM %8.2fx\n",
+               workload_reply_kind_name((reply_kind_t)k),
+               (double)wls[k][0]->size / replies[0], (double)wls[k][1]->size / replies[1],
+               rps[0] / 1e6, rps[1] / 1e6, rps[0] > 0 ? rps[1] / rps[0] : 0.0);
+    }
+    
+    for (int k = 0; k < REPLY_KIND_COUNT; k++) {
+        if (wls[k][0]) workload_free(wls[k][0]);
+        if (wls[k][1]) workload_free(wls[k][1]);
+    }
+    return ok;
+}
+
+// Client read path with the hiredis reader: feed chunk-sized reads, pull
+// every complete reply as a redisReply tree and free it
+static int benchmark_client_hiredis(const workload_t *wl, int iterations, size_t chunk_size,
+                                    size_t *replies, double *replies_per_sec,
+                                    double *allocs_per_reply) {
+    redisReader *r = redisReaderCreate();
+    if (!r) return 0;
+    unsigned long long allocs = hiredis_alloc_count;
+    size_t count = 0;
+    uint64_t checksum = 0;
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    for (int it = 0; it < iterations; it++) {
+        for (size_t off = 0; off < wl->size; off += chunk_size) {
+            size_t n = wl->size - off < chunk_size ? wl->size - off : chunk_size;
+            if (redisReaderFeed(r, (const char *)wl->data + off, n) != REDIS_OK) {
+                redisReaderFree(r);
+                return 0;
+            }
+            for (;;) {
+                void *reply;
+                if (redisReaderGetReply(r, &reply) != REDIS_OK) {
+                    redisReaderFree(r);
+                    return 0;
+                }
+                if (!reply) break;
+                checksum += ((redisReply *)reply)->type;
+                freeReplyObject(reply);
+                count++;
+            }
+        }
+    }
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    allocs = hiredis_alloc_count - allocs;
+    redisReaderFree(r);
+    if (checksum == 0) fprintf(stderr, "hiredis reader produced no replies\n");
+    
+    double seconds = elapsed_ns / 1000000000.0;
+    *replies = count / (size_t)iterations;
+    *replies_per_sec = seconds > 0 ? count / seconds : 0.0;
+    *allocs_per_reply = count ? (double)allocs / count : 0.0;
+    return 1;
+}
+
+// The same read path for RESPB: append each read to a receive buffer,
+// decode complete reply frames into a reused node array, and move the
+// partial tail to the front. Strings are read in place, before the next read
+static int benchmark_client_respb(const workload_t *wl, int iterations, size_t chunk_size,
+                                  size_t *replies, double *replies_per_sec,
+                                  double *allocs_per_reply) {
+    respb_reply_t nodes[256];
+    uint8_t *buf = NULL;
+    size_t cap = 0, len = 0, count = 0, allocs = 0;
+    uint64_t checksum = 0;
+    benchmark_timer_t timer;
+    benchmark_timer_start(&timer);
+    for (int it = 0; it < iterations; it++) {
+        for (size_t off = 0; off < wl->size; off += chunk_size) {
+            size_t n = wl->size - off < chunk_size ? wl->size - off : chunk_size;
+            if (cap - len < n) {
+                size_t new_cap = (len + n) * 2;
+                uint8_t *new_buf = realloc(buf, new_cap);
+                if (!new_buf) {
+                    free(buf);
+                    return 0;
+                }
+                buf = new_buf;
+                cap = new_cap;
+                allocs++;
+            }
+            memcpy(buf + len, wl->data + off, n);
+            len += n;
+            
+            size_t pos = 0, nnodes;
+            int result;
+            while ((result = respb_reply_parse(buf, len, &pos, NULL, nodes, 256, &nnodes)) == 1) {
+                if (nnodes > 256) break;
+                checksum += nodes[0].type + nodes[nnodes - 1].len;
+                count++;
+            }
+            if (result != 0) {
+                free(buf);
+                return 0;
+            }
+            memmove(buf, buf + pos, len - pos);
+            len -= pos;
+        }
+    }
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    free(buf);
+    if (checksum == 0) fprintf(stderr, "RESPB reply decoder produced no replies\n");
+    
+    double seconds = elapsed_ns / 1000000000.0;
+    *replies = count / (size_t)iterations;
+    *replies_per_sec = seconds > 0 ? count / seconds : 0.0;
+    *allocs_per_reply = count ? (double)allocs / count : 0.0;
+    return 1;
+}
+
+static int run_client_benchmarks(benchmark_config_t *config) {
+    const size_t target = 4 * 1024 * 1024;
+    workload_t *wls[REPLY_KIND_COUNT][2] = {{NULL}};
+    int ok = 1;
+    for (int k = 0; ok && k < REPLY_KIND_COUNT; k++) {
+        for (int respb = 0; ok && respb <= 1; respb++) {
+            wls[k][respb] = workload_generate_replies(target, (reply_kind_t)k, respb);
+            ok = wls[k][respb] != NULL;
+        }
+    }
+    
+    printf("\n=== Client Reply Reading (%d passes over %zu KB, %zu-byte reads) ===\n\n",
+           config->iterations, target / 1024, config->chunk_size);
+    printf("  %-8s %14s %12s %14s %12s %9s\n", "Reply", "hiredis rep/s", "allocs/rep",
+           "RESPB rep/s", "allocs/rep", "Speedup");
+    for (int k = 0; ok && k < REPLY_KIND_COUNT; k++) {
+        size_t replies[2];
+        double rps[2], allocs[2];
+        ok = benchmark_client_hiredis(wls[k][0], config->iterations, config->chunk_size,
+                                      &replies[0], &rps[0], &allocs[0]) &&
+             benchmark_client_respb(wls[k][1], config->iterations, config->chunk_size,
+                                    &replies[1], &rps[1], &allocs[1]);
+        if (!ok) {
+            fprintf(stderr, "Client reply reading failed on %s\n",
+                    workload_reply_kind_name((reply_kind_t)k));
+            break;
+        }
+        printf("  %-8s %13.2fM %12.1f %13.2fM %12.4f %8.2fx\n",
+               workload_reply_kind_name((reply_kind_t)k), rps[0] / 1e6, allocs[0],
+               rps[1] / 1e6, allocs[1], rps[0] > 0 ? rps[1] / rps[0] : 0.0);
+    }
+    
+    for (int k = 0; k < REPLY_KIND_COUNT; k++) {
+        if (wls[k][0]) workload_free(wls[k][0]);
+        if (wls[k][1]) workload_free(wls[k][1]);
+    }
+    return ok;
+}
+
+// Re-encode every frame of a fixed-width RESPB workload with varint lengths.
+// Frames the schema path cannot rebuild from their strings (EVAL, FCALL,
+// BITFIELD) are counted in *skipped and left out of both outputs, so fixed
+// and varint workloads hold the same commands
+static int varint_workloads(const workload_t *src, workload_t *fixed, workload_t *varint,
+                            size_t *skipped) {
+    size_t cap = src->size * 2;
+    fixed->data = malloc(src->size);
+    varint->data = malloc(cap);
+    fixed->size = varint->size = 0;
+    fixed->current_pos = varint->current_pos = 0;
+    *skipped = 0;
+    if (!fixed->data || !varint->data) return 0;
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, src->data, src->size);
+    respb_command_t cmd;
+    while (parser.pos < src->size) {
+        size_t start = parser.pos;
+        if (respb_parse_command_table(&parser, &cmd) != 1) return 0;
+        size_t n = respb_serialize_command_flags(varint->data + varint->size,
+                                                 cap - varint->size, &cmd, RESPB_FLAG_VARINT);
+        if (n == 0) {
+            (*skipped)++;
+            continue;
+        }
+        varint->size += n;
+        memcpy(fixed->data + fixed->size, src->data + start, parser.pos - start);
+        fixed->size += parser.pos - start;
+    }
+    return 1;
+}
+
+static int parse_command_varint(respb_parser_t *parser, respb_command_t *cmd) {
+    parser->flags = RESPB_FLAG_VARINT;
+    return respb_parse_command(parser, cmd);
+}
+
+// Fixed-width frames of the -m size command mix, repeated up to target bytes
+static workload_t *pipeline_mix_workload(size_t target) {
+    static uint8_t data[4096];
+    memset(data, 'x', sizeof(data));
+    const size_t ncmds = 1000;
+    respb_command_t *cmds = malloc(ncmds * sizeof(*cmds));
+    workload_t *wl = malloc(sizeof(*wl));
+    uint8_t *buf = malloc(target);
+    if (!cmds || !wl || !buf) {
+        free(cmds);
+        free(wl);
+        free(buf);
+        return NULL;
+    }
+    build_pipeline_commands(cmds, ncmds, data);
+    wl->data = buf;
+    wl->size = 0;
+    wl->current_pos = 0;
+    for (size_t i = 0;; i = (i + 1) % ncmds) {
+        size_t n = respb_serialize_command(buf + wl->size, target - wl->size, &cmds[i]);
+        if (n == 0) break;
+        wl->size += n;
+    }
+    free(cmds);
+    return wl;
+}
+
+static int run_varint_benchmarks(benchmark_config_t *config) {
+    static const char *names[] = {"mixed", "mget-24", "mset-24", "modules", "pipeline"};
+    static const uint32_t modules[4] = {0x00000000, 0x00000001, 0x00010000, 0x00020001};
+    const size_t nworkloads = sizeof(names) / sizeof(names[0]);
+    const size_t target = 8 * 1024 * 1024;
+    double bytes[5][2], tput[5][3];
+    
+    for (size_t w = 0; w < nworkloads; w++) {
+        workload_t *src;
+        switch (w) {
+            case 0: src = workload_generate_passthrough(target, 0); break;
+            case 1: src = workload_generate_multikey(target, RESPB_OP_MGET, 24, 1); break;
+            case 2: src = workload_generate_multikey(target, RESPB_OP_MSET, 24, 1); break;
+            case 3: src = workload_generate_modules(target, modules); break;
+            default: src = pipeline_mix_workload(target); break;
+        }
+        if (!src) return 0;
+        workload_t fixed, varint;
+        size_t skipped;
+        int ok = varint_workloads(src, &fixed, &varint, &skipped);
+        workload_free(src);
+        
+        // Switch and table decoders on fixed widths, table decoder on varints
+        benchmark_metrics_t metrics;
+        respb_parse_fn parsers[3] = {respb_parse_command, respb_parse_command_table,
+                                     parse_command_varint};
+        for (int d = 0; ok && d < 3; d++) {
+            workload_t *wl = d < 2 ? &fixed : &varint;
+            ok = benchmark_respb_parsing(wl, &metrics, config->iterations, 0, parsers[d]) &&
+                 metrics.commands_processed > 0;
+            if (!ok) break;
+            tput[w][d] = metrics_throughput(&metrics);
+            bytes[w][d < 2 ? 0 : 1] = (double)wl->size * config->iterations /
+                                      metrics.commands_processed;
+        }
+        free(fixed.data);
+        free(varint.data);
+        if (!ok) {
+            fprintf(stderr, "Varint benchmark failed on the %s workload\n", names[w]);
+            return 0;
+        }
+        if (skipped) printf("  %s: %zu frames without a varint encoding left out\n", names[w], skipped);
+    }
+    
+    printf("\n=== Varint Lengths (RESPB_FLAG_VARINT) ===\n\n");
+    printf("  %-8s %10s %10s %8s %12s %12s %12s %9s\n", "Workload", "Fixed B/c", "Varint B/c",
+           "Size", "Switch c/s", "Table c/s", "Varint c/s", "vs table");
+    for (size_t w = 0; w < nworkloads; w++) {
+        printf("  %-8s %10.1f %10.1f %7.1f%% %11.2fM %11.2fM %11.2fM %8.2fx\n", names[w],
+               bytes[w][0], bytes[w][1], 100.0 * (bytes[w][1] - bytes[w][0]) / bytes[w][0],
+               tput[w][0] / 1e6, tput[w][1] / 1e6, tput[w][2] / 1e6,
+               tput[w][1] > 0 ? tput[w][2] / tput[w][1] : 0.0);
+    }
+    return 1;
+}
+
+// JSON-like documents (an array of small records) or random bytes
+static void fill_compress_value(uint8_t *value, size_t len, uint32_t seed, int random) {
+    size_t pos = 0;
+    if (random) {
+        for (; pos < len; pos++) {
+            seed = seed * 1103515245 + 12345;
+            value[pos] = (uint8_t)(seed >> 16);
+        }
+        return;
+    }
+    char record[160];
+    value[pos++] = '[';
+    while (pos < len) {
+        seed = seed * 1103515245 + 12345;
+        int n = snprintf(record, sizeof(record),
+                         "{\"id\":%u,\"user\":\"user%05u\",\"active\":%s,\"score\":%u.%02u,"
+                         "\"tags\":[\"tag%u\",\"tag%u\"]},",
+                         seed >> 8, (seed >> 4) % 100000, seed & 1 ? "true" : "false",
+                         (seed >> 12) % 1000, (seed >> 20) % 100, (seed >> 3) % 32, (seed >> 9) % 32);
+        size_t copy = (size_t)n < len - pos ? (size_t)n : len - pos;
+        memcpy(value + pos, record, copy);
+        pos += copy;
+    }
+    value[len - 1] = ']';
+}
+
+static uint8_t compress_inflate_buf[128 * 1024];
+
+static int parse_command_inflate(respb_parser_t *parser, respb_command_t *cmd) {
+    parser->inflate_buf = compress_inflate_buf;
+    parser->inflate_cap = sizeof(compress_inflate_buf);
+    return respb_parse_command(parser, cmd);
+}
+
+// Encode ncmds commands into buf back to back, with c or uncompressed when c
+// is NULL. Returns the stream size, 0 on failure
+static size_t encode_compress_stream(respb_compressor_t *c, uint8_t *buf, size_t buf_len,
+                                     const respb_command_t *cmds, size_t ncmds) {
+    size_t size = 0;
+    for (size_t i = 0; i < ncmds; i++) {
+        size_t n = c ? respb_serialize_compressed(c, buf + size, buf_len - size, &cmds[i], 0)
+                     : respb_serialize_command(buf + size, buf_len - size, &cmds[i]);
+        if (n == 0) return 0;
+        size += n;
+    }
+    return size;
+}
+
+static int run_compress_benchmarks(benchmark_config_t *config) {
+    static const size_t sizes[] = {256, 1024, 4096, 16384, 65536, 4096};
+    static const int accelerations[] = {1, 4, 16};
+    const size_t nsizes = sizeof(sizes) / sizeof(sizes[0]);
+    const size_t nvalues = 16;
+    const size_t target = 8 * 1024 * 1024;
+    
+    printf("\n=== Compressed Frames (0xF001, LZ4 block) ===\n\n");
+    printf("  JSON.SET with JSON-like values (last row: random bytes), threshold 0\n");
+    printf("  MB/s counts uncompressed frame bytes; break-even is the link speed below\n");
+    printf("  which encode + decode CPU costs less than the transfer time saved\n\n");
+    printf("  %-10s %5s %10s %7s %10s %10s %12s\n", "Value", "Accel", "Wire B/c", "Saved",
+           "Enc MB/s", "Dec MB/s", "Break-even");
+    
+    for (size_t s = 0; s < nsizes; s++) {
+        size_t size = sizes[s];
+        int random = s == nsizes - 1;
+        size_t ncmds = target / size;
+        uint8_t *values = malloc(nvalues * size);
+        uint8_t *keys = malloc(ncmds * 16);
+        respb_command_t *cmds = malloc(ncmds * sizeof(*cmds));
+        size_t buf_len = ncmds * (size + 64);
+        uint8_t *buf = malloc(buf_len);
+        if (!values || !keys || !cmds || !buf) {
+            free(values);
+            free(keys);
+            free(cmds);
+            free(buf);
+            return 0;
+        }
+        for (size_t v = 0; v < nvalues; v++) {
+            fill_compress_value(values + v * size, size, (uint32_t)(v * 7919 + size), random);
+        }
+        for (size_t i = 0; i < ncmds; i++) {
+            respb_command_t *cmd = &cmds[i];
+            memset(cmd, 0, offsetof(respb_command_t, args));
+            memset(&cmd->view, 0, sizeof(cmd->view));
+            cmd->opcode = RESPB_OP_MODULE;
+            cmd->module_id = RESPB_MODULE_JSON;  // JSON.SET key $ value
+            cmd->command_id = 0x0000;
+            cmd->module_subcommand = (uint32_t)RESPB_MODULE_JSON << 16;
+            cmd->argc = 3;
+            snprintf((char *)keys + i * 16, 16, "doc:%08zu", i);
+            cmd->args[0].data = keys + i * 16;
+            cmd->args[0].len = 12;
+            cmd->args[1].data = (const uint8_t *)"$";
+            cmd->args[1].len = 1;
+            cmd->args[2].data = values + (i % nvalues) * size;
+            cmd->args[2].len = size;
+        }
+        
+        // Row per acceleration, after the uncompressed baseline (accel 0)
+        double raw_bytes = 0, raw_enc_ns = 0, raw_dec_ns = 0;
+        int ok = 1;
+        for (size_t a = 0; ok && a <= sizeof(accelerations) / sizeof(accelerations[0]); a++) {
+            respb_compressor_t c;
+            respb_compressor_init(&c, 0, a ? accelerations[a - 1] : 0);
+            size_t stream = 0;
+            benchmark_timer_t timer;
+            benchmark_timer_start(&timer);
+            for (int iter = 0; iter < config->iterations; iter++) {
+                stream = encode_compress_stream(a ? &c : NULL, buf, buf_len, cmds, ncmds);
+            }
+            double enc_ns = (double)benchmark_timer_elapsed_ns(&timer) / config->iterations / ncmds;
+            respb_compressor_free(&c);
+            
+            workload_t wl = {buf, stream, 0};
+            benchmark_metrics_t metrics;
+            ok = stream > 0 &&
+                 benchmark_respb_parsing(&wl, &metrics, config->iterations, 0, parse_command_inflate) &&
+                 metrics.commands_processed == ncmds * (uint64_t)config->iterations;
+            if (!ok) break;
+            double dec_ns = 1e9 / metrics_throughput(&metrics);
+            double bytes = (double)stream / ncmds;
             
-            if (sample_latency && metrics->latency_sample_count < MAX_LATENCY_SAMPLES) {
-                clock_gettime(CLOCK_MONOTONIC, &cmd_end);
-                uint64_t latency_ns = (cmd_end.tv_sec - cmd_start.tv_sec) * 1000000000ULL +
-                                     (cmd_end.tv_nsec - cmd_start.tv_nsec);
-                benchmark_record_latency(metrics, latency_ns);
+            if (a == 0) {
+                raw_bytes = bytes;
+                raw_enc_ns = enc_ns;
+                raw_dec_ns = dec_ns;
+            }
+            char label[16], accel[8], breakeven[16];
+            snprintf(label, sizeof(label), "%zu%s", size, random ? " rand" : "");
+            snprintf(accel, sizeof(accel), a ? "%d" : "-", a ? accelerations[a - 1] : 0);
+            double extra_ns = enc_ns + dec_ns - raw_enc_ns - raw_dec_ns;
+            if (a == 0 || bytes >= raw_bytes) {
+                snprintf(breakeven, sizeof(breakeven), "-");
+            } else if (extra_ns <= 0) {
+                snprintf(breakeven, sizeof(breakeven), "any");
+            } else {
+                snprintf(breakeven, sizeof(breakeven), "%.2f Gb/s",
+                         (raw_bytes - bytes) * 8 / extra_ns);
+            }
+            printf("  %-10s %5s %10.1f %6.1f%% %10.0f %10.0f %12s\n", label, accel, bytes,
+                   100.0 * (raw_bytes - bytes) / raw_bytes, raw_bytes / enc_ns * 1e3,
+                   raw_bytes / dec_ns * 1e3, breakeven);
+        }
+        free(values);
+        free(keys);
+        free(cmds);
+        free(buf);
+        if (!ok) {
+            fprintf(stderr, "Compression benchmark failed on %zu-byte values\n", size);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Key indices drawn from a Zipf(s) distribution over nkeys ranks (s = 0 is
+// uniform), by binary search over the cumulative weights
+static int zipf_sample(uint32_t *out, size_t count, size_t nkeys, double s, uint32_t seed) {
+    double *cdf = malloc(nkeys * sizeof(*cdf));
+    if (!cdf) return 0;
+    double total = 0;
+    for (size_t k = 0; k < nkeys; k++) {
+        total += 1.0 / pow((double)(k + 1), s);
+        cdf[k] = total;
+    }
+    for (size_t i = 0; i < count; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t hi = seed >> 8;
+        seed = seed * 1103515245 + 12345;
+        double u = ((double)hi * 65536.0 + (seed >> 16)) / (16777216.0 * 65536.0) * total;
+        size_t lo = 0, top = nkeys - 1;
+        while (lo < top) {
+            size_t mid = (lo + top) / 2;
+            if (cdf[mid] < u) lo = mid + 1;
+            else top = mid;
+        }
+        out[i] = (uint32_t)lo;
+    }
+    free(cdf);
+    return 1;
+}
+
+static respb_keydict_t *bench_keydict;
+
+static int parse_command_keydict(respb_parser_t *parser, respb_command_t *cmd) {
+    parser->flags = RESPB_FLAG_KEYDICT;
+    parser->keydict = bench_keydict;
+    return respb_parse_command(parser, cmd);
+}
+
+// Encode cmds with key IDs: a key not yet in d is bound (and a bind frame
+// sent ahead of the command) while IDs are left. Returns the stream size
+static size_t encode_keydict_stream(respb_keydict_t *d, uint8_t *buf, size_t buf_len,
+                                    const respb_command_t *cmds, size_t ncmds, size_t *refs) {
+    size_t size = 0;
+    *refs = 0;
+    respb_keydict_reset(d);
+    for (size_t i = 0; i < ncmds; i++) {
+        const respb_arg_t *key = &cmds[i].args[0];
+        int id = respb_keydict_find(d, key->data, key->len);
+        if (id < 0 && d->count < d->capacity) {
+            id = (int)d->count;
+            size_t n = respb_serialize_key_bind(buf + size, buf_len - size, cmds[i].mux_id,
+                                                (uint16_t)id, key->data, key->len);
+            if (n == 0 || respb_keydict_bind(d, (uint32_t)id, key->data, key->len) != 1) return 0;
+            size += n;
+        } else if (id >= 0) {
+            (*refs)++;
+        }
+        size_t n = respb_serialize_command_dict(buf + size, buf_len - size, &cmds[i], d);
+        if (n == 0) return 0;
+        size += n;
+    }
+    return size;
+}
+
+static int run_keydict_benchmarks(benchmark_config_t *config) {
+    static const double skews[] = {0.0, 0.8, 0.99, 1.2};
+    static const uint32_t capacities[] = {4096, RESPB_KEYDICT_MAX_IDS};
+    const size_t nkeys = 100000, ncmds = 500000;
+    const size_t buf_len = ncmds * 96;
+    
+    // Mendeley-style keys: "real:geo:" and a 19-digit id, 28 bytes
+    char *keys = malloc(nkeys * 32);
+    uint32_t *picks = malloc(ncmds * sizeof(*picks));
+    respb_command_t *cmds = malloc(ncmds * sizeof(*cmds));
+    uint8_t *buf = malloc(buf_len);
+    respb_keydict_t sender, receiver;
+    int ok = keys && picks && cmds && buf &&
+             respb_keydict_init(&sender, RESPB_KEYDICT_MAX_IDS, nkeys * 32) &&
+             respb_keydict_init(&receiver, RESPB_KEYDICT_MAX_IDS, nkeys * 32);
+    for (size_t k = 0; ok && k < nkeys; k++) {
+        snprintf(keys + k * 32, 32, "real:geo:%019llu", 1020770485687275522ULL + k * 7919ULL);
+    }
+    
+    printf("\n=== Key Dictionary (RESPB_FLAG_KEYDICT) ===\n\n");
+    printf("  %zu keys of 28 bytes, %zu GET/SET commands; keys bound on first use\n\n", nkeys, ncmds);
+    printf("  %-5s %6s %9s %9s %7s %7s %11s %11s %11s %11s\n", "Zipf", "IDs", "Plain B/c",
+           "Dict B/c", "Saved", "Refs", "Plain enc", "Dict enc", "Plain dec", "Dict dec");
+    for (size_t z = 0; ok && z < sizeof(skews) / sizeof(skews[0]); z++) {
+        ok = zipf_sample(picks, ncmds, nkeys, skews[z], 4242);
+        for (size_t i = 0; ok && i < ncmds; i++) {
+            respb_command_t *cmd = &cmds[i];
+            memset(cmd, 0, offsetof(respb_command_t, args));
+            memset(&cmd->view, 0, sizeof(cmd->view));
+            cmd->opcode = i % 10 < 7 ? RESPB_OP_GET : RESPB_OP_SET;
+            cmd->argc = cmd->opcode == RESPB_OP_GET ? 1 : 2;
+            cmd->args[0].data = (const uint8_t *)keys + picks[i] * 32;
+            cmd->args[0].len = 28;
+            cmd->args[1].data = (const uint8_t *)"{\"lat\":51.5072,\"lon\":-0.1276}";
+            cmd->args[1].len = 31;
+        }
+        
+        // Plain stream and its decode rate, shared by both dictionary sizes
+        benchmark_timer_t timer;
+        size_t plain = 0;
+        benchmark_timer_start(&timer);
+        for (int iter = 0; ok && iter < config->iterations; iter++) {
+            plain = 0;
+            for (size_t i = 0; i < ncmds; i++) {
+                plain += respb_serialize_command(buf + plain, buf_len - plain, &cmds[i]);
+            }
+        }
+        double plain_enc = (double)ncmds * config->iterations * 1e9 /
+                           benchmark_timer_elapsed_ns(&timer);
+        workload_t wl = {buf, plain, 0};
+        benchmark_metrics_t metrics;
+        ok = ok && benchmark_respb_parsing(&wl, &metrics, config->iterations, 0,
+                                           respb_parse_command_table) &&
+             metrics.commands_processed == ncmds * (uint64_t)config->iterations;
+        double plain_dec = ok ? metrics_throughput(&metrics) : 0;
+        
+        for (size_t c = 0; ok && c < sizeof(capacities) / sizeof(capacities[0]); c++) {
+            sender.capacity = capacities[c];
+            size_t stream = 0, refs = 0;
+            benchmark_timer_start(&timer);
+            for (int iter = 0; ok && iter < config->iterations; iter++) {
+                stream = encode_keydict_stream(&sender, buf, buf_len, cmds, ncmds, &refs);
+                ok = stream > 0;
             }
+            double dict_enc = (double)ncmds * config->iterations * 1e9 /
+                              benchmark_timer_elapsed_ns(&timer);
             
-            if (result == 1) {
-                metrics->commands_processed++;
-                size_t bytes_consumed = parser.pos;
-                metrics->bytes_processed += bytes_consumed;
-                wl->current_pos += bytes_consumed;
-            } else if (result == 0) {
-                // Incomplete command - check if we're at end of buffer
-                if (parser.pos >= parser.buffer_len || wl->current_pos + parser.pos >= wl->size) {
-                    // End of workload
-                    break;
+            // Bind frames are counted by the parser; report commands per second
+            size_t frames = ncmds + sender.count;
+            respb_keydict_reset(&receiver);
+            bench_keydict = &receiver;
+            wl = (workload_t){buf, stream, 0};
+            ok = ok && benchmark_respb_parsing(&wl, &metrics, config->iterations, 0,
+                                               parse_command_keydict) &&
+                 metrics.commands_processed == frames * (uint64_t)config->iterations;
+            if (!ok) break;
+            double dict_dec = metrics_throughput(&metrics) * ncmds / frames;
+            printf("  %-5.2f %6u %9.1f %9.1f %6.1f%% %6.1f%% %10.2fM %10.2fM %10.2fM %10.2fM\n",
+                   skews[z], capacities[c], (double)plain / ncmds, (double)stream / ncmds,
+                   100.0 * ((double)plain - stream) / plain, 100.0 * refs / ncmds,
+                   plain_enc / 1e6, dict_enc / 1e6, plain_dec / 1e6, dict_dec / 1e6);
+        }
+    }
+    
+    if (keys && picks && cmds && buf) {
+        sender.capacity = RESPB_KEYDICT_MAX_IDS;
+        respb_keydict_free(&sender);
+        respb_keydict_free(&receiver);
+    }
+    free(keys);
+    free(picks);
+    free(cmds);
+    free(buf);
+    if (!ok) fprintf(stderr, "Key dictionary benchmark failed\n");
+    return ok;
+}
+
+// One new connection: handle its first read, which holds the handshake (if
+// any) and the first command. Returns 1 if the command was parsed
+typedef int (*connection_fn)(const uint8_t *data, size_t len);
+
+static int resp_connection(const uint8_t *data, size_t len) {
+    valkey_client client;
+    valkey_client_init(&client, data, len);
+    int result = valkey_parse_command(&client);
+    valkey_client_free(&client);
+    return result == 1;
+}
+
+static int resp_detect_connection(const uint8_t *data, size_t len) {
+    respb_handshake_t hs;
+    uint8_t reply[64];
+    size_t consumed, reply_len;
+    respb_handshake_init(&hs, RESPB_FLAGS_SUPPORTED);
+    if (respb_handshake_feed(&hs, data, len, &consumed, reply, &reply_len) != 1 ||
+        hs.state != RESPB_HS_RESP) {
+        return 0;
+    }
+    return resp_connection(data + consumed, len - consumed);
+}
+
+static int respb_connection(const uint8_t *data, size_t len) {
+    respb_parser_t parser;
+    respb_command_t cmd;
+    respb_parser_init(&parser, data, len);
+    return respb_parse_command(&parser, &cmd) == 1;
+}
+
+static int respb_upgrade_connection(const uint8_t *data, size_t len) {
+    respb_handshake_t hs;
+    respb_parser_t parser;
+    respb_command_t cmd;
+    uint8_t reply[64];
+    size_t consumed, reply_len;
+    respb_handshake_init(&hs, RESPB_FLAGS_SUPPORTED);
+    if (respb_handshake_feed(&hs, data, len, &consumed, reply, &reply_len) != 1 ||
+        reply_len != RESPB_HANDSHAKE_SIZE) {
+        return 0;
+    }
+    respb_parser_init(&parser, data + consumed, len - consumed);
+    respb_handshake_apply(&hs, &parser);
+    return respb_parse_command(&parser, &cmd) == 1;
+}
+
+// Worst case: the hello arrives one byte per read
+static int respb_split_upgrade_connection(const uint8_t *data, size_t len) {
+    respb_handshake_t hs;
+    respb_parser_t parser;
+    respb_command_t cmd;
+    uint8_t reply[64];
+    size_t pos = 0, consumed, reply_len;
+    int result = 0;
+    respb_handshake_init(&hs, RESPB_FLAGS_SUPPORTED);
+    while (result == 0 && pos < len) {
+        result = respb_handshake_feed(&hs, data + pos, 1, &consumed, reply, &reply_len);
+        pos += consumed;
+    }
+    if (result != 1) return 0;
+    respb_parser_init(&parser, data + pos, len - pos);
+    respb_handshake_apply(&hs, &parser);
+    return respb_parse_command(&parser, &cmd) == 1;
+}
+
+// Client side: write the hello, read the acknowledgment
+static int client_hello_connection(const uint8_t *data, size_t len) {
+    uint8_t hello[RESPB_HANDSHAKE_SIZE], flags;
+    respb_write_handshake(hello, RESPB_VERSION, RESPB_FLAG_COMPRESS);
+    return hello[3] == data[3] && respb_read_handshake_ack(data, len, &flags) == 1;
+}
+
+// Nanoseconds per connection
+static double benchmark_connections(connection_fn fn, const uint8_t *data, size_t len,
+                                    size_t rounds) {
+    benchmark_timer_t timer;
+    size_t parsed = 0;
+    benchmark_timer_start(&timer);
+    for (size_t r = 0; r < rounds; r++) parsed += (size_t)fn(data, len);
+    uint64_t elapsed_ns = benchmark_timer_elapsed_ns(&timer);
+    if (parsed != rounds) {
+        fprintf(stderr, "Connection setup failed\n");
+        return -1.0;
+    }
+    return (double)elapsed_ns / (double)rounds;
+}
+
+static int run_handshake_benchmarks(benchmark_config_t *config) {
+    // First read of each connection: GET user:1000, after the hello for RESPB
+    static const char resp[] = "*2\r\n$3\r\nGET\r\n$9\r\nuser:1000\r\n";
+    uint8_t respb[64], upgrade[64], ack[RESPB_HANDSHAKE_SIZE];
+    respb_command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_GET;
+    cmd.argc = 1;
+    cmd.args[0].data = (const uint8_t *)"user:1000";
+    cmd.args[0].len = 9;
+    size_t respb_len = respb_serialize_command(respb, sizeof(respb), &cmd);
+    size_t upgrade_len = respb_write_handshake(upgrade, RESPB_VERSION, RESPB_FLAG_COMPRESS);
+    memcpy(upgrade + upgrade_len, respb, respb_len);
+    upgrade_len += respb_len;
+    respb_write_handshake(ack, RESPB_VERSION, RESPB_FLAG_COMPRESS);
+    
+    const struct {
+        const char *label;
+        connection_fn fn;
+        const uint8_t *data;
+        size_t len;
+        int baseline;           // Row the overhead is measured against
+    } paths[] = {
+        {"RESP command", resp_connection, (const uint8_t *)resp, sizeof(resp) - 1, -1},
+        {"RESP detect + command", resp_detect_connection, (const uint8_t *)resp, sizeof(resp) - 1, 0},
+        {"RESPB command", respb_connection, respb, respb_len, -1},
+        {"RESPB hello + command", respb_upgrade_connection, upgrade, upgrade_len, 2},
+        {"RESPB 1-byte reads + command", respb_split_upgrade_connection, upgrade, upgrade_len, 2},
+        {"Client hello + ack", client_hello_connection, ack, sizeof(ack), -1},
+    };
+    const size_t npaths = sizeof(paths) / sizeof(paths[0]);
+    size_t rounds = (size_t)config->iterations * 100000;
+    double ns[sizeof(paths) / sizeof(paths[0])];
+    
+    printf("\n=== Protocol Detection and Handshake (%zu connections per path) ===\n\n", rounds);
+    printf("  %-30s %10s %10s\n", "First read", "ns/conn", "Overhead");
+    for (size_t i = 0; i < npaths; i++) {
+        ns[i] = benchmark_connections(paths[i].fn, paths[i].data, paths[i].len, rounds);
+        if (ns[i] < 0) return 0;
+        if (paths[i].baseline >= 0) {
+            printf("  %-30s %10.1f %+9.1f\n", paths[i].label, ns[i], ns[i] - ns[paths[i].baseline]);
+        } else {
+            printf("  %-30s %10.1f %10s\n", paths[i].label, ns[i], "-");
+        }
+    }
+    printf("\n  Wire: %d B hello + %d B ack; the first command follows the hello\n"
+           "  without waiting, so the upgrade adds no round trip\n",
+           RESPB_HANDSHAKE_SIZE, RESPB_HANDSHAKE_SIZE);
+    return 1;
+}
+
+// Append argv[0..argc) to buf as one RESP command
+static size_t append_resp(uint8_t *buf, size_t pos, size_t argc, const char **argv) {
+    pos += (size_t)sprintf((char *)buf + pos, "*%zu\r\n", argc);
+    for (size_t i = 0; i < argc; i++) {
+        size_t len = strlen(argv[i]);
+        pos += (size_t)sprintf((char *)buf + pos, "$%zu\r\n", len);
+        memcpy(buf + pos, argv[i], len);
+        memcpy(buf + pos + len, "\r\n", 2);
+        pos += len + 2;
+    }
+    return pos;
+}
+
+// An AOF like the Mendeley load: mostly SET of geo JSON values, with some
+// expiries, counters, hashes, ZADD and EXPIRE
+static size_t build_aof_workload(uint8_t *buf, size_t target) {
+    const char *select[] = {"SELECT", "0"};
+    size_t pos = append_resp(buf, 0, 2, select);
+    uint32_t seed = 99;
+    char key[40], value[64], num[24];
+    for (size_t i = 0; pos < target; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t r = (seed >> 16) % 100;
+        snprintf(key, sizeof(key), "real:geo:%019llu", 1020770485687275522ULL + i * 7919ULL);
+        snprintf(value, sizeof(value), "{\"lat\":%.6f,\"lon\":%.6f}",
+                 (double)(seed % 180000) / 1000.0 - 90.0, (double)(seed % 360000) / 1000.0 - 180.0);
+        snprintf(num, sizeof(num), "%u", seed % 10 + 1);
+        if (r < 85) {
+            const char *argv[] = {"SET", key, value};
+            pos = append_resp(buf, pos, 3, argv);
+        } else if (r < 90) {
+            const char *argv[] = {"SET", key, "v", "EX", "60"};
+            pos = append_resp(buf, pos, 5, argv);
+        } else if (r < 93) {
+            const char *argv[] = {"INCRBY", "ctr:7", num};
+            pos = append_resp(buf, pos, 3, argv);
+        } else if (r < 96) {
+            const char *argv[] = {"HSET", key, "name", "x*\r\n*2", "age", num};
+            pos = append_resp(buf, pos, 6, argv);
+        } else if (r < 98) {
+            const char *argv[] = {"ZADD", "lb", num, key};
+            pos = append_resp(buf, pos, 4, argv);
+        } else {
+            const char *argv[] = {"EXPIRE", key, "3600"};
+            pos = append_resp(buf, pos, 3, argv);
+        }
+    }
+    return pos;
+}
+
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t cap;
+} transcode_sink_t;
+
+static int transcode_sink_write(void *ctx, const uint8_t *data, size_t len) {
+    transcode_sink_t *sink = ctx;
+    if (len > sink->cap - sink->len) return 0;
+    memcpy(sink->buf + sink->len, data, len);
+    sink->len += len;
+    return 1;
+}
+
+static int run_transcode_benchmarks(benchmark_config_t *config) {
+    static const struct {
+        int threads;
+        size_t chunk;
+    } runs[] = {{1, 8 << 20}, {2, 8 << 20}, {4, 8 << 20}, {8, 8 << 20}, {1, 1 << 20}, {4, 1 << 20}};
+    const size_t target = 64 * 1024 * 1024;
+    uint8_t *aof = malloc(target + 256);
+    transcode_sink_t sink = {malloc(target + target / 2), 0, target + target / 2};
+    if (!aof || !sink.buf) {
+        free(aof);
+        free(sink.buf);
+        return 0;
+    }
+    size_t len = build_aof_workload(aof, target);
+    
+    // Untimed pass to fault in the output pages
+    respb_transcode_stats_t stats;
+    int ok = respb_transcode_parallel(aof, len, 1, 0, transcode_sink_write, &sink, &stats) == 1;
+    
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    printf("\n=== RESP -> RESPB Transcoder (%.1f MB AOF, %ld CPUs online) ===\n\n",
+           len / 1048576.0, cpus);
+    printf("  %-8s %6s %12s %10s %8s %6s %8s\n", "Threads", "Chunk", "Commands/s", "MB/s",
+           "Passthru", "Redone", "Speedup");
+    double base = 0;
+    for (size_t r = 0; ok && r < sizeof(runs) / sizeof(runs[0]); r++) {
+        benchmark_timer_t timer;
+        benchmark_timer_start(&timer);
+        for (int iter = 0; ok && iter < config->iterations; iter++) {
+            sink.len = 0;
+            ok = respb_transcode_parallel(aof, len, runs[r].threads, runs[r].chunk,
+                                          transcode_sink_write, &sink, &stats) == 1;
+        }
+        if (!ok) break;
+        double seconds = benchmark_timer_elapsed_ns(&timer) / 1e9 / config->iterations;
+        double cps = stats.commands / seconds;
+        if (r == 0) base = cps;
+        printf("  %-8d %5zuM %11.2fM %10.0f %7.1f%% %6u %7.2fx\n", runs[r].threads,
+               runs[r].chunk >> 20, cps / 1e6, len / 1048576.0 / seconds,
+               100.0 * stats.passthrough / stats.commands, stats.resplits, cps / base);
+    }
+    if (ok) {
+        printf("\n  %llu commands, %.1f MB RESP -> %.1f MB RESPB (%.1f%% smaller)\n",
+               (unsigned long long)stats.commands, len / 1048576.0, sink.len / 1048576.0,
+               100.0 * (1.0 - (double)sink.len / len));
+    }
+    free(aof);
+    free(sink.buf);
+    if (!ok) fprintf(stderr, "Transcoding failed at byte %zu\n", stats.error_pos);
+    return ok;
+}
+
+// Parse every frame of respb[0..len) and write it back as RESP into out, or
+// as iovecs whose bytes are only counted. Returns the RESP size, 0 if a frame
+// has no RESP form or out is too small
+static size_t respb_stream_to_resp(const uint8_t *respb, size_t len, uint8_t *out, size_t cap,
+                                   int iov) {
+    static uint8_t scratch[4096];
+    struct iovec vec[RESPB_MAX_ARGS * 2 + 8];
+    respb_parser_t parser;
+    respb_command_t cmd;
+    size_t pos = 0;
+    respb_parser_init(&parser, respb, len);
+    while (parser.pos < len) {
+        if (respb_parse_command(&parser, &cmd) != 1) return 0;
+        size_t n, iovcnt;
+        int result = iov ? respb_to_resp_iov(scratch, sizeof(scratch), vec, sizeof(vec) / sizeof(vec[0]),
+                                             &iovcnt, &cmd, 0, &n)
+                         : respb_to_resp(out + pos, cap - pos, &cmd, 0, &n);
+        if (result != 1) return 0;
+        pos += n;
+    }
+    return pos;
+}
+
+static int run_roundtrip_benchmarks(benchmark_config_t *config) {
+    static const char *names[] = {"small", "medium", "large", "mixed", "aof"};
+    static const workload_type_t types[] = {WORKLOAD_SMALL_KEYS, WORKLOAD_MEDIUM_KEYS,
+                                            WORKLOAD_LARGE_VALUES, WORKLOAD_MIXED};
+    const size_t nworkloads = sizeof(names) / sizeof(names[0]);
+    const size_t target = 32 * 1024 * 1024;
+    double rates[5][3];
+    uint64_t commands[5];
+    size_t sizes[5][2];
+    int identical[5];
+    uint8_t *respb = malloc(target + target / 2), *back = malloc(target + 256);
+    int ok = respb && back;
+    
+    for (size_t w = 0; ok && w < nworkloads; w++) {
+        workload_t *wl;
+        if (w < 4) {
+            wl = workload_generate_synthetic(target, types[w]);
+        } else {
+            wl = malloc(sizeof(*wl));
+            if (wl) wl->data = malloc(target + 256);
+            if (wl && wl->data) wl->size = build_aof_workload(wl->data, target);
+        }
+        if (!wl || !wl->data) {
+            free(wl);
+            ok = 0;
+            break;
+        }
+        
+        // RESP -> RESPB on one thread, then RESPB -> RESP into a buffer and
+        // as iovecs. Each pass runs once untimed first
+        transcode_sink_t sink = {respb, 0, target + target / 2};
+        respb_transcode_stats_t stats;
+        size_t resp_len = 0;
+        for (int stage = 0; ok && stage < 3; stage++) {
+            benchmark_timer_t timer;
+            for (int iter = -1; ok && iter < config->iterations; iter++) {
+                if (iter == 0) benchmark_timer_start(&timer);
+                if (stage == 0) {
+                    sink.len = 0;
+                    ok = respb_transcode_parallel(wl->data, wl->size, 1, wl->size, transcode_sink_write,
+                                                  &sink, &stats) == 1;
+                } else {
+                    resp_len = respb_stream_to_resp(respb, sink.len, back, target + 256, stage == 2);
+                    ok = resp_len > 0;
+                }
+                if (ok && iter == config->iterations - 1) {
+                    rates[w][stage] = stats.commands * (double)config->iterations /
+                                      (benchmark_timer_elapsed_ns(&timer) / 1e9);
                 }
-                fprintf(stderr, "RESPB incomplete command at position %zu, parser pos %zu, buffer len %zu, opcode 0x%04X\n",
-                       wl->current_pos, parser.pos, parser.buffer_len, cmd.opcode);
-                fflush(stderr);
-                break;
-            } else {
-                // Error
-                fprintf(stderr, "RESPB parse error at position %zu, opcode 0x%04X, parser pos %zu, buffer len %zu\n",
-                       wl->current_pos, cmd.opcode, parser.pos, parser.buffer_len);
-                fflush(stderr);
-                return 0;
             }
         }
+        commands[w] = stats.commands;
+        sizes[w][0] = wl->size;
+        sizes[w][1] = sink.len;
+        identical[w] = ok && resp_len == wl->size && memcmp(back, wl->data, wl->size) == 0;
+        if (!ok) fprintf(stderr, "Round trip failed on the %s workload\n", names[w]);
+        workload_free(wl);
     }
     
-    benchmark_timer_stop(&timer, metrics);
-    benchmark_compute_percentiles(metrics);
+    if (ok) {
+        printf("\n=== RESP -> RESPB -> RESP (single thread) ===\n\n");
+        printf("  %-8s %10s %8s %8s %12s %12s %12s %12s %9s\n", "Workload", "Commands", "RESP MB",
+               "RESPB MB", "To RESPB/s", "To RESP/s", "Iovec/s", "Round/s", "Identical");
+        for (size_t w = 0; w < nworkloads; w++) {
+            double round = 1.0 / (1.0 / rates[w][0] + 1.0 / rates[w][1]);
+            printf("  %-8s %10llu %8.1f %8.1f %11.2fM %11.2fM %11.2fM %11.2fM %9s\n", names[w],
+                   (unsigned long long)commands[w], sizes[w][0] / 1048576.0, sizes[w][1] / 1048576.0,
+                   rates[w][0] / 1e6, rates[w][1] / 1e6, rates[w][2] / 1e6, round / 1e6,
+                   identical[w] ? "yes" : "NO");
+        }
+    }
+    free(respb);
+    free(back);
+    return ok;
+}
+
+// Stands in for the keyspace: reads each command's opcode and first argument
+static int aof_touch_apply(void *ctx, const respb_command_t *cmds, size_t count) {
+    uint64_t *sum = ctx;
+    for (size_t i = 0; i < count; i++) {
+        *sum += cmds[i].opcode;
+        if (cmds[i].argc > 0 && cmds[i].args[0].len > 0) *sum += cmds[i].args[0].data[0];
+    }
+    return 1;
+}
+
+static int run_aof_benchmarks(benchmark_config_t *config) {
+    static const int threads[] = {1, 2, 4, 8};
+    const size_t target = 64 * 1024 * 1024;
+    workload_t wl = {malloc(target + 256), 0, 0};
+    transcode_sink_t sink = {malloc(target + target / 2), 0, target + target / 2};
+    int ok = wl.data && sink.buf;
+    
+    respb_transcode_stats_t tstats;
+    if (ok) {
+        wl.size = build_aof_workload(wl.data, target);
+        ok = respb_transcode_parallel(wl.data, wl.size, 1, 0, transcode_sink_write, &sink,
+                                      &tstats) == 1;
+    }
+    
+    // The Valkey replay of the same commands as RESP
+    benchmark_metrics_t resp;
+    if (ok) ok = benchmark_resp_parsing(&wl, &resp, config->iterations, 0);
+    
+    if (ok) {
+        double resp_seconds = resp.total_time_ns / 1e9 / config->iterations;
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        printf("\n=== AOF Load (%.1f MB RESP, %.1f MB RESPB, %llu commands, %ld CPUs online) ===\n\n",
+               wl.size / 1048576.0, sink.len / 1048576.0, (unsigned long long)tstats.commands, cpus);
+        printf("  %-24s %10s %12s %8s\n", "Loader", "Load ms", "Commands/s", "Speedup");
+        printf("  %-24s %10.1f %11.2fM %7.2fx\n", "RESP valkey_parse_command", resp_seconds * 1e3,
+               tstats.commands / resp_seconds / 1e6, 1.0);
+    }
+    uint64_t sum = 0;
+    respb_aof_stats_t stats;
+    for (size_t t = 0; ok && t < sizeof(threads) / sizeof(threads[0]); t++) {
+        benchmark_timer_t timer;
+        for (int iter = -1; ok && iter < config->iterations; iter++) {
+            if (iter == 0) benchmark_timer_start(&timer);
+            ok = respb_aof_load(sink.buf, sink.len, threads[t], aof_touch_apply, &sum, &stats) == 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "AOF load failed at byte %zu\n", stats.error_pos);
+            break;
+        }
+        double seconds = benchmark_timer_elapsed_ns(&timer) / 1e9 / config->iterations;
+        double resp_seconds = resp.total_time_ns / 1e9 / config->iterations;
+        char label[32];
+        snprintf(label, sizeof(label), "RESPB %d thread%s", threads[t], threads[t] > 1 ? "s" : "");
+        printf("  %-24s %10.1f %11.2fM %7.2fx\n", label, seconds * 1e3,
+               stats.commands / seconds / 1e6, resp_seconds / seconds);
+    }
+    if (ok) printf("\n  %llu batches of up to %d frames (checksum %llu)\n",
+                   (unsigned long long)stats.batches, RESPB_AOF_BATCH, (unsigned long long)sum);
+    free(wl.data);
+    free(sink.buf);
+    return ok;
+}
+
+typedef struct {
+    transcode_sink_t sink;
+    respb_index_t *index;
+} indexed_sink_t;
+
+static int indexed_sink_write(void *ctx, const uint8_t *data, size_t len) {
+    indexed_sink_t *s = ctx;
+    return respb_index_append(s->index, data, len) == 1 && transcode_sink_write(&s->sink, data, len);
+}
+
+static size_t walk_frames(const uint8_t *data, size_t len, uint64_t count) {
+    size_t pos = 0, frame_len;
+    for (uint64_t i = 0; i < count && respb_frame_length(data + pos, len - pos, &frame_len) == 1; i++) {
+        pos += frame_len;
+    }
+    return pos;
+}
+
+static int run_index_benchmarks(benchmark_config_t *config) {
+    static const uint32_t intervals[] = {256, 4096, 65536};
+    const size_t target = 64 * 1024 * 1024, copies = 36;
+    const char *path = "/tmp/respb_index_bench.respb", *index_path = "/tmp/respb_index_bench.idx";
+    uint8_t *aof = malloc(target + 256);
+    indexed_sink_t out = {{malloc(target + target / 2), 0, target + target / 2}, NULL};
+    respb_index_t idx;
+    respb_index_init(&idx, 0);
+    int ok = aof && out.sink.buf;
+    
+    // Index written during transcoding: cost on top of the transcoder
+    double plain_s = 0, indexed_s = 0;
+    size_t aof_len = ok ? build_aof_workload(aof, target) : 0;
+    for (int indexed = 0; ok && indexed < 2; indexed++) {
+        benchmark_timer_t timer;
+        for (int iter = -1; ok && iter < config->iterations; iter++) {
+            if (iter == 0) benchmark_timer_start(&timer);
+            respb_index_free(&idx);
+            out.sink.len = 0;
+            out.index = &idx;
+            ok = respb_transcode_parallel(aof, aof_len, 1, 0,
+                                          indexed ? indexed_sink_write : transcode_sink_write,
+                                          indexed ? (void *)&out : (void *)&out.sink, NULL) == 1;
+        }
+        double seconds = benchmark_timer_elapsed_ns(&timer) / 1e9 / config->iterations;
+        if (indexed) {
+            indexed_s = seconds;
+        } else {
+            plain_s = seconds;
+        }
+    }
+    
+    // A multi-GB file: the transcoded AOF appended copies times, indexed as
+    // each block is appended
+    FILE *f = ok ? fopen(path, "wb") : NULL;
+    ok = f != NULL;
+    respb_index_free(&idx);
+    for (size_t i = 0; ok && i < copies; i++) {
+        ok = fwrite(out.sink.buf, 1, out.sink.len, f) == out.sink.len &&
+             respb_index_append(&idx, out.sink.buf, out.sink.len) == 1;
+    }
+    if (f && fclose(f) != 0) ok = 0;
+    size_t len = idx.bytes;
+    uint64_t commands = idx.commands;
+    const uint8_t *data = MAP_FAILED;
+    if (ok) {
+        int fd = open(path, O_RDONLY);
+        if (fd >= 0) {
+            data = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+            close(fd);
+        }
+        ok = data != MAP_FAILED;
+    }
+    
+    if (ok) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        printf("\n=== RESPB Frame Index (%.2f GB, %llu commands, %ld CPUs online) ===\n\n",
+               len / 1073741824.0, (unsigned long long)commands, cpus);
+        printf("  Transcoding %.0f MB: %.1f ms, %.1f ms with the index (%+.1f%%)\n\n",
+               aof_len / 1048576.0, plain_s * 1e3, indexed_s * 1e3,
+               100.0 * (indexed_s - plain_s) / plain_s);
+        
+        // Full walk of the frame lengths, the floor for building an index
+        benchmark_timer_t timer;
+        benchmark_timer_start(&timer);
+        size_t walked = walk_frames(data, len, commands);
+        double walk_s = benchmark_timer_elapsed_ns(&timer) / 1e9;
+        ok = walked == len;
+        printf("  Frame walk: %.0f ms (%.2f GB/s)\n\n", walk_s * 1e3, len / 1073741824.0 / walk_s);
+        printf("  %-9s %9s %10s %10s %12s %10s\n", "Interval", "Points", "Index KB", "Build ms",
+               "Build GB/s", "Seek us");
+    }
+    const size_t seeks = 10000;
+    for (size_t r = 0; ok && r < sizeof(intervals) / sizeof(intervals[0]); r++) {
+        respb_index_free(&idx);
+        respb_index_init(&idx, intervals[r]);
+        benchmark_timer_t timer;
+        benchmark_timer_start(&timer);
+        ok = respb_index_append(&idx, data, len) == 1 && respb_index_save(&idx, index_path) == 1;
+        double build_s = benchmark_timer_elapsed_ns(&timer) / 1e9;
+        struct stat st;
+        ok = ok && stat(index_path, &st) == 0;
+        
+        uint32_t seed = 7;
+        size_t offset;
+        benchmark_timer_start(&timer);
+        for (size_t i = 0; ok && i < seeks; i++) {
+            seed = seed * 1103515245 + 12345;
+            uint64_t ordinal = ((uint64_t)seed << 16 ^ seed >> 8) % commands;
+            ok = respb_index_seek(&idx, data, len, ordinal, &offset) == 1;
+        }
+        double seek_us = benchmark_timer_elapsed_ns(&timer) / 1e3 / seeks;
+        if (ok) {
+            printf("  %-9u %9zu %10.1f %10.1f %12.2f %10.2f\n", intervals[r], idx.npoints,
+                   st.st_size / 1024.0, build_s * 1e3, len / 1073741824.0 / build_s, seek_us);
+        }
+    }
+    
+    // Without an index a seek walks from the start
+    if (ok) {
+        uint32_t seed = 7;
+        const int walks = 5;
+        benchmark_timer_t timer;
+        benchmark_timer_start(&timer);
+        for (int i = 0; ok && i < walks; i++) {
+            seed = seed * 1103515245 + 12345;
+            uint64_t ordinal = ((uint64_t)seed << 16 ^ seed >> 8) % commands;
+            ok = walk_frames(data, len, ordinal) > 0;
+        }
+        printf("  %-9s %9s %10s %10s %12s %10.0f\n", "none", "-", "-", "-", "-",
+               benchmark_timer_elapsed_ns(&timer) / 1e3 / walks);
+        
+        uint64_t cuts[9];
+        size_t n = respb_index_split(&idx, 8, cuts);
+        uint64_t largest = 0;
+        for (size_t i = 0; i < n; i++) {
+            if (cuts[i + 1] - cuts[i] > largest) largest = cuts[i + 1] - cuts[i];
+        }
+        printf("\n  8-way split: %zu ranges, largest %.1f MB (even: %.1f MB)\n", n,
+               largest / 1048576.0, len / 8 / 1048576.0);
+    }
+    
+    if (data != MAP_FAILED) munmap((void *)data, len);
+    remove(path);
+    remove(index_path);
+    respb_index_free(&idx);
+    free(aof);
+    free(out.sink.buf);
+    if (!ok) fprintf(stderr, "Index benchmark failed\n");
+    return ok;
+}
+
+// An AOF of a long-running instance: nkeys keys written over and over by
+// SET, SET EX, INCRBY, EXPIRE, DEL and HSET, with a RENAME, which the
+// compaction keeps as a fence, every fence_every commands (0 for none)
+static size_t build_overwrite_workload(uint8_t *buf, size_t target, uint32_t nkeys,
+                                       uint32_t fence_every) {
+    const char *select[] = {"SELECT", "0"};
+    size_t pos = append_resp(buf, 0, 2, select);
+    uint32_t seed = 42;
+    char key[32], other[32], value[40], num[24];
+    for (uint32_t i = 1; pos < target; i++) {
+        seed = seed * 1103515245 + 12345;
+        uint32_t r = (seed >> 8) % 1000, k = (seed ^ seed >> 15) * 2654435761u % nkeys;
+        snprintf(key, sizeof(key), "key:%08u", k);
+        snprintf(num, sizeof(num), "%u", seed % 100 + 1);
+        if (fence_every && i % fence_every == 0) {
+            snprintf(other, sizeof(other), "key:%08u", (k + 1) % nkeys);
+            const char *argv[] = {"RENAME", key, other};
+            pos = append_resp(buf, pos, 3, argv);
+        } else if (r < 500) {
+            snprintf(value, sizeof(value), "value:%08u:%016u", k, seed);
+            const char *argv[] = {"SET", key, value};
+            pos = append_resp(buf, pos, 3, argv);
+        } else if (r < 600) {
+            const char *argv[] = {"SET", key, "v", "EX", "60"};
+            pos = append_resp(buf, pos, 5, argv);
+        } else if (r < 750) {
+            snprintf(key, sizeof(key), "ctr:%08u", k / 10);
+            const char *argv[] = {"INCRBY", key, num};
+            pos = append_resp(buf, pos, 3, argv);
+        } else if (r < 850) {
+            const char *argv[] = {"EXPIRE", key, "3600"};
+            pos = append_resp(buf, pos, 3, argv);
+        } else if (r < 900) {
+            const char *argv[] = {"DEL", key};
+            pos = append_resp(buf, pos, 2, argv);
+        } else {
+            snprintf(key, sizeof(key), "hash:%08u", k / 10);
+            const char *argv[] = {"HSET", key, "field", num};
+            pos = append_resp(buf, pos, 4, argv);
+        }
+    }
+    return pos;
+}
+
+static int run_compact_benchmarks(benchmark_config_t *config) {
+    static const struct {
+        uint32_t keys;
+        uint32_t fence_every;
+    } runs[] = {{10000, 0}, {100000, 0}, {1000000, 0}, {100000, 10000}};
+    const size_t target = 64 * 1024 * 1024;
+    uint8_t *aof = malloc(target + 256);
+    transcode_sink_t in = {malloc(target + target / 2), 0, target + target / 2};
+    transcode_sink_t out = {malloc(target + target / 2), 0, target + target / 2};
+    int ok = aof && in.buf && out.buf;
+    
+    if (ok) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        printf("\n=== AOF Compaction (%.0f MB RESP per key space, %ld CPUs online) ===\n\n",
+               target / 1048576.0, cpus);
+        printf("  %-8s %7s %9s %9s %8s %8s %10s %8s %9s %10s %10s %8s\n", "Keys", "Fences", "Commands", "Kept",
+               "In MB", "Out MB", "Rewrite ms", "MB/s", "Table MB", "Replay ms", "After ms", "Speedup");
+    }
+    for (size_t k = 0; ok && k < sizeof(runs) / sizeof(runs[0]); k++) {
+        size_t aof_len = build_overwrite_workload(aof, target, runs[k].keys, runs[k].fence_every);
+        in.len = 0;
+        ok = respb_transcode_parallel(aof, aof_len, 1, 0, transcode_sink_write, &in, NULL) == 1;
+        
+        respb_compact_stats_t stats;
+        benchmark_timer_t timer;
+        for (int iter = -1; ok && iter < config->iterations; iter++) {
+            if (iter == 0) benchmark_timer_start(&timer);
+            out.len = 0;
+            ok = respb_compact(in.buf, in.len, transcode_sink_write, &out, &stats) == 1;
+        }
+        double rewrite_s = ok ? benchmark_timer_elapsed_ns(&timer) / 1e9 / config->iterations : 0;
+        
+        // Replay of the original and the compacted AOF by one loader thread
+        double replay_s[2] = {0, 0};
+        uint64_t sum = 0;
+        for (int compacted = 0; ok && compacted < 2; compacted++) {
+            const transcode_sink_t *file = compacted ? &out : &in;
+            for (int iter = -1; ok && iter < config->iterations; iter++) {
+                if (iter == 0) benchmark_timer_start(&timer);
+                ok = respb_aof_load(file->buf, file->len, 1, aof_touch_apply, &sum, NULL) == 1;
+            }
+            replay_s[compacted] = benchmark_timer_elapsed_ns(&timer) / 1e9 / config->iterations;
+        }
+        if (ok) {
+            printf("  %-8u %7llu %9llu %9llu %8.1f %8.1f %10.1f %8.0f %9.2f %10.1f %10.1f %7.2fx\n",
+                   runs[k].keys, (unsigned long long)stats.fences, (unsigned long long)stats.commands,
+                   (unsigned long long)stats.kept,
+                   stats.in_bytes / 1048576.0, stats.out_bytes / 1048576.0, rewrite_s * 1e3,
+                   stats.in_bytes / 1048576.0 / rewrite_s, stats.memory / 1048576.0,
+                   replay_s[0] * 1e3, replay_s[1] * 1e3, replay_s[0] / replay_s[1]);
+        }
+    }
+    
+    free(aof);
+    free(in.buf);
+    free(out.buf);
+    if (!ok) fprintf(stderr, "Compaction benchmark failed\n");
+    return ok;
+}
+
+static int run_stream_benchmarks(benchmark_config_t *config, workload_t *resp_workload,
+                                 workload_t *respb_workload) {
+    if (resp_workload && config->bench_resp) {
+        printf("Running RESP stream benchmark (%zu-byte chunks)...\n", config->chunk_size);
+        if (!benchmark_resp_stream(resp_workload, &config->resp_metrics,
+                                   config->iterations, config->chunk_size)) {
+            fprintf(stderr, "RESP stream benchmark failed\n");
+            return 0;
+        }
+        benchmark_print_metrics(&config->resp_metrics, "RESP (stream)");
+    }
+    
+    if (respb_workload && config->bench_respb && respb_workload != resp_workload) {
+        printf("Running RESPB stream benchmark (%zu-byte chunks)...\n", config->chunk_size);
+        if (!benchmark_respb_stream(respb_workload, &config->respb_metrics,
+                                    config->iterations, config->chunk_size)) {
+            fprintf(stderr, "RESPB stream benchmark failed\n");
+            return 0;
+        }
+        benchmark_print_metrics(&config->respb_metrics, "RESPB (stream)");
+    }
     
+    if (config->bench_resp && config->bench_respb && respb_workload != resp_workload) {
+        benchmark_print_comparison(&config->resp_metrics, &config->respb_metrics);
+    }
     return 1;
 }
 
+
+static void print_decoder_comparison(const benchmark_metrics_t *switch_metrics,
+                                     const benchmark_metrics_t *table_metrics) {
+    double switch_tput = metrics_throughput(switch_metrics);
+    double table_tput = metrics_throughput(table_metrics);
+    
+    printf("\n=== RESPB Decoder Comparison ===\n\n");
+    printf("Throughput:\n");
+    printf("  Switch:              %.0f commands/sec\n", switch_tput);
+    printf("  Table-driven:        %.0f commands/sec\n", table_tput);
+    if (switch_tput > 0) {
+        printf("  Table/switch:        %.2fx\n", table_tput / switch_tput);
+    }
+    printf("\nCommands decoded:\n");
+    printf("  Switch:              %llu\n", (unsigned long long)switch_metrics->commands_processed);
+    printf("  Table-driven:        %llu\n", (unsigned long long)table_metrics->commands_processed);
+    printf("\nCode size:\n");
+    printf("  Schema tables:       %zu bytes (%zu commands, %zu fields)\n",
+           respb_schema_table_size(), respb_schema_count, respb_schema_field_count);
+    printf("  Decoder .text:       see 'make code-size'\n");
+}
+
 int run_benchmark(benchmark_config_t *config) {
     printf("\n=== Protocol Benchmark Suite ===\n");
     printf("Configuration:\n");
@@ -162,6 +2669,72 @@ int run_benchmark(benchmark_config_t *config) {
            "Mixed");
     printf("\n");
     
+    // MSET scaling, the iterator, passthrough and module comparisons, the
+    // name lookups, the serializers, the reply benchmarks, the varint,
+    // compression and key dictionary comparisons, and the handshake,
+    // transcoder, AOF, index and compaction benchmarks generate their own
+    // workloads
+    if (config->mode == BENCH_MODE_MSET) {
+        return run_mset_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_ITER) {
+        return run_iter_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_PASSTHROUGH) {
+        return run_passthrough_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_MODULES) {
+        return run_module_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_NAMES) {
+        return run_name_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_SERIALIZE) {
+        return run_serialize_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_IOV) {
+        return run_iov_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_SIZE) {
+        return run_size_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_PIPELINE) {
+        return run_pipeline_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_REPLY) {
+        return run_reply_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_CLIENT) {
+        return run_client_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_VARINT) {
+        return run_varint_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_COMPRESS) {
+        return run_compress_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_KEYDICT) {
+        return run_keydict_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_HANDSHAKE) {
+        return run_handshake_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_TRANSCODE) {
+        return run_transcode_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_ROUNDTRIP) {
+        return run_roundtrip_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_AOF) {
+        return run_aof_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_INDEX) {
+        return run_index_benchmarks(config);
+    }
+    if (config->mode == BENCH_MODE_COMPACT) {
+        return run_compact_benchmarks(config);
+    }
+    
     // Load or generate workloads
     workload_t *resp_workload = NULL;
     workload_t *respb_workload = NULL;
@@ -198,6 +2771,14 @@ int run_benchmark(benchmark_config_t *config) {
         respb_workload = resp_workload; // Shared for now
     }
     
+    // Chunked (recv-sized) feeding replaces the whole-buffer runs
+    if (config->mode == BENCH_MODE_STREAM) {
+        int ok = run_stream_benchmarks(config, resp_workload, respb_workload);
+        workload_free(resp_workload);
+        if (respb_workload != resp_workload) workload_free(respb_workload);
+        return ok;
+    }
+    
     // Run RESP benchmark
     if (resp_workload && config->bench_resp) {
         printf("Running RESP benchmark...\n");
@@ -216,12 +2797,16 @@ int run_benchmark(benchmark_config_t *config) {
     }
     
     // Run RESPB benchmark
-    if (respb_workload && config->bench_respb && respb_workload != resp_workload) {
+    int run_switch = config->respb_decoder != RESPB_DECODER_TABLE;
+    int run_table = config->respb_decoder != RESPB_DECODER_SWITCH;
+    
+    if (respb_workload && config->bench_respb && respb_workload != resp_workload && run_switch) {
         printf("Running RESPB benchmark...\n");
         benchmark_metrics_t respb_metrics;
         
         if (!benchmark_respb_parsing(respb_workload, &respb_metrics,
-                                    config->iterations, config->sample_latency)) {
+                                    config->iterations, config->sample_latency,
+                                    respb_parse_command)) {
             fprintf(stderr, "RESPB benchmark failed\n");
             workload_free(resp_workload);
             if (respb_workload != resp_workload) workload_free(respb_workload);
@@ -232,6 +2817,80 @@ int run_benchmark(benchmark_config_t *config) {
         config->respb_metrics = respb_metrics;
     }
     
+    if (respb_workload && config->bench_respb && respb_workload != resp_workload && run_table) {
+        printf("Running RESPB table-driven decoder benchmark...\n");
+        benchmark_metrics_t table_metrics;
+        
+        if (!benchmark_respb_parsing(respb_workload, &table_metrics,
+                                    config->iterations, config->sample_latency,
+                                    respb_parse_command_table)) {
+            fprintf(stderr, "RESPB table-driven benchmark failed\n");
+            workload_free(resp_workload);
+            if (respb_workload != resp_workload) workload_free(respb_workload);
+            return 0;
+        }
+        
+        benchmark_print_metrics(&table_metrics, "RESPB (table-driven)");
+        printf("Schema tables:         %zu commands, %zu fields, %zu bytes\n",
+               respb_schema_count, respb_schema_field_count, respb_schema_table_size());
+        config->respb_table_metrics = table_metrics;
+        if (!run_switch) config->respb_metrics = table_metrics;
+    }
+    
+    // Batch decoding of the same RESPB workload
+    if (config->mode == BENCH_MODE_BATCH && respb_workload && config->bench_respb &&
+        respb_workload != resp_workload) {
+        printf("Running RESPB batch benchmark (%zu frames per call)...\n", config->batch_size);
+        benchmark_metrics_t batch_metrics;
+        
+        if (!benchmark_respb_batch(respb_workload, &batch_metrics,
+                                   config->iterations, config->batch_size)) {
+            fprintf(stderr, "RESPB batch benchmark failed\n");
+            workload_free(resp_workload);
+            if (respb_workload != resp_workload) workload_free(respb_workload);
+            return 0;
+        }
+        
+        benchmark_print_metrics(&batch_metrics, "RESPB (batch)");
+        double frame_tput = metrics_throughput(&config->respb_metrics);
+        double batch_tput = metrics_throughput(&batch_metrics);
+        printf("Batch vs per-frame (%s): %.2fx\n",
+               run_switch ? "switch" : "table-driven",
+               frame_tput > 0 ? batch_tput / frame_tput : 0.0);
+    }
+    
+    // Skip-scan (frame length only) over the same RESPB workload
+    if (config->mode == BENCH_MODE_SKIP && respb_workload && config->bench_respb &&
+        respb_workload != resp_workload) {
+        printf("Running RESPB skip-scan benchmark...\n");
+        benchmark_metrics_t skip_metrics;
+        
+        if (!benchmark_respb_skip(respb_workload, &skip_metrics, config->iterations)) {
+            fprintf(stderr, "RESPB skip-scan benchmark failed\n");
+            workload_free(resp_workload);
+            if (respb_workload != resp_workload) workload_free(respb_workload);
+            return 0;
+        }
+        
+        benchmark_print_metrics(&skip_metrics, "RESPB (skip-scan)");
+        double skip_tput = metrics_throughput(&skip_metrics);
+        if (run_switch) {
+            double parse_tput = metrics_throughput(&config->respb_metrics);
+            printf("Skip-scan vs full parse (switch):       %.2fx\n",
+                   parse_tput > 0 ? skip_tput / parse_tput : 0.0);
+        }
+        if (run_table) {
+            double parse_tput = metrics_throughput(&config->respb_table_metrics);
+            printf("Skip-scan vs full parse (table-driven): %.2fx\n",
+                   parse_tput > 0 ? skip_tput / parse_tput : 0.0);
+        }
+    }
+    
+    // Switch vs table-driven decoder
+    if (config->bench_respb && respb_workload != resp_workload && run_switch && run_table) {
+        print_decoder_comparison(&config->respb_metrics, &config->respb_table_metrics);
+    }
+    
     // Print comparison if both were run
     if (config->bench_resp && config->bench_respb && respb_workload != resp_workload) {
         benchmark_print_comparison(&config->resp_metrics, &config->respb_metrics);
@@ -259,10 +2918,61 @@ void print_usage(const char *prog_name) {
     printf("                   large   - Large values (SET)\n");
     printf("                   mixed   - Mixed commands\n");
     printf("  -p PROTOCOL    Benchmark only this protocol (resp|respb|both)\n");
+    printf("  -d DECODER     RESPB decoder (switch|table|both, default: switch)\n");
+    printf("  -m MODE        Benchmark mode:\n");
+    printf("                   parse   - One parse call per frame (default)\n");
+    printf("                   batch   - Also decode with respb_parse_batch()\n");
+    printf("                   stream  - Feed both protocols in recv()-sized chunks\n");
+    printf("                   mset    - MSET with 10, 100, 1k and 10k keys\n");
+    printf("                   iter    - Argument iterator vs full parse (MGET/MSET/SADD)\n");
+    printf("                   skip    - Also size frames with respb_peek_frame() (proxy routing)\n");
+    printf("                   passthrough - RESP passthrough shares, sds copy vs borrowed decode\n");
+    printf("                   modules - Core vs generated vs runtime-registered module commands\n");
+    printf("                   names   - Command name lookup: perfect hash vs strcasecmp vs dict\n");
+    printf("                   serialize - Schema encoder throughput per command category\n");
+    printf("                   iov     - Scatter/gather vs memcpy serializer on large values\n");
+    printf("                   size    - Exact-size vs grow-and-retry pipeline buffers\n");
+    printf("                   pipeline - Pipeline builder throughput at depths 1 to 10k\n");
+    printf("                   reply   - Reply decoding per reply shape, RESPB vs RESP\n");
+    printf("                   client  - Client reply reading: hiredis reader vs RESPB decoder\n");
+    printf("                   varint  - Wire size and decode cost of varint lengths\n");
+    printf("                   compress - LZ4 frame compression: bandwidth saved vs CPU\n");
+    printf("                   keydict - Key IDs on Zipfian keys: wire size and decode cost\n");
+    printf("                   handshake - Per-connection cost of protocol detection and upgrade\n");
+    printf("                   transcode - RESP -> RESPB transcoder throughput by thread count\n");
+    printf("                   roundtrip - RESP -> RESPB -> RESP transcoding per workload type\n");
+    printf("                   aof       - Parallel RESPB AOF load vs RESP replay\n");
+    printf("                   index     - Frame index build cost and seek latency (2 GB file)\n");
+    printf("                   compact   - AOF compaction throughput and replay-time reduction\n");
+    printf("  -n N           Frames per batch in batch mode (default: 256)\n");
+    printf("  -c BYTES       Chunk size in stream and client modes (default: 16384)\n");
     printf("  -h             Show this help\n");
     printf("\nExamples:\n");
     printf("  %s -w mixed -i 100\n", prog_name);
     printf("  %s -r data/workload_resp.bin -b data/workload_respb.bin -i 50 -l\n", prog_name);
+    printf("  %s -b data/workload_mixed_respb.bin -p respb -d both\n", prog_name);
+    printf("  %s -b data/workload_mixed_respb.bin -p respb -m batch -n 512\n", prog_name);
+    printf("  %s -r data/workload_large_resp.bin -b data/workload_large_respb.bin -m stream -c 1460\n", prog_name);
+    printf("  %s -m mset -p both\n", prog_name);
+    printf("  %s -b data/workload_mixed_respb.bin -p respb -m skip\n", prog_name);
+    printf("  %s -m passthrough -i 20\n", prog_name);
+    printf("  %s -m modules -i 20\n", prog_name);
+    printf("  %s -m names\n", prog_name);
+    printf("  %s -m serialize\n", prog_name);
+    printf("  %s -m iov -i 5\n", prog_name);
+    printf("  %s -m size\n", prog_name);
+    printf("  %s -m pipeline\n", prog_name);
+    printf("  %s -m reply\n", prog_name);
+    printf("  %s -m client -c 1460\n", prog_name);
+    printf("  %s -m varint\n", prog_name);
+    printf("  %s -m compress -i 5\n", prog_name);
+    printf("  %s -m keydict\n", prog_name);
+    printf("  %s -m handshake\n", prog_name);
+    printf("  %s -m transcode -i 3\n", prog_name);
+    printf("  %s -m roundtrip -i 5\n", prog_name);
+    printf("  %s -m aof -i 3\n", prog_name);
+    printf("  %s -m index\n", prog_name);
+    printf("  %s -m compact -i 3\n", prog_name);
     printf("\n");
 }
 
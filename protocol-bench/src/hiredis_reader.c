@@ -0,0 +1,638 @@
+/*
+ * hiredis Reply Reader - Extracted from hiredis read.c and hiredis.c
+ *
+ * The reply reader client libraries are built on, with minimal adaptations
+ * for the benchmark environment: RESP2 types only, a fixed task stack (as
+ * in hiredis before 1.0), a plain growable buffer in place of sds, and the
+ * default reply object functions compiled in.
+ *
+ * Original source: hiredis/read.c:redisReaderGetReply(),
+ *                  hiredis/hiredis.c:createStringObject() and friends
+ */
+
+#include "hiredis_reader.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <limits.h>
+#include <assert.h>
+
+/* ==================== Memory Allocation Shims ==================== */
+
+unsigned long long hiredis_alloc_count = 0;
+unsigned long long hiredis_free_count = 0;
+
+static inline void *hi_malloc(size_t size) {
+    hiredis_alloc_count++;
+    return malloc(size);
+}
+
+static inline void *hi_calloc(size_t nmemb, size_t size) {
+    hiredis_alloc_count++;
+    return calloc(nmemb, size);
+}
+
+static inline void *hi_realloc(void *ptr, size_t size) {
+    hiredis_alloc_count++;
+    return realloc(ptr, size);
+}
+
+static inline void hi_free(void *ptr) {
+    if (ptr == NULL) return;
+    hiredis_free_count++;
+    free(ptr);
+}
+
+/* ==================== Reply Objects (hiredis.c) ==================== */
+
+static redisReply *createReplyObject(int type) {
+    redisReply *r = hi_calloc(1, sizeof(*r));
+    if (r == NULL) return NULL;
+
+    r->type = type;
+    return r;
+}
+
+void freeReplyObject(void *reply) {
+    redisReply *r = reply;
+    size_t j;
+
+    if (r == NULL) return;
+
+    switch (r->type) {
+    case REDIS_REPLY_INTEGER:
+    case REDIS_REPLY_NIL:
+        break; /* Nothing to free */
+    case REDIS_REPLY_ARRAY:
+        if (r->element != NULL) {
+            for (j = 0; j < r->elements; j++)
+                freeReplyObject(r->element[j]);
+            hi_free(r->element);
+        }
+        break;
+    case REDIS_REPLY_ERROR:
+    case REDIS_REPLY_STATUS:
+    case REDIS_REPLY_STRING:
+        hi_free(r->str);
+        break;
+    }
+    hi_free(r);
+}
+
+static void *createStringObject(const redisReadTask *task, char *str, size_t len) {
+    redisReply *r, *parent;
+    char *buf;
+
+    r = createReplyObject(task->type);
+    if (r == NULL) return NULL;
+
+    buf = hi_malloc(len + 1);
+    if (buf == NULL) {
+        freeReplyObject(r);
+        return NULL;
+    }
+
+    /* Copy string value */
+    memcpy(buf, str, len);
+    buf[len] = '\0';
+    r->str = buf;
+    r->len = len;
+
+    if (task->parent) {
+        parent = task->parent->obj;
+        parent->element[task->idx] = r;
+    }
+    return r;
+}
+
+static void *createArrayObject(const redisReadTask *task, size_t elements) {
+    redisReply *r, *parent;
+
+    r = createReplyObject(task->type);
+    if (r == NULL) return NULL;
+
+    if (elements > 0) {
+        r->element = hi_calloc(elements, sizeof(redisReply *));
+        if (r->element == NULL) {
+            freeReplyObject(r);
+            return NULL;
+        }
+    }
+
+    r->elements = elements;
+
+    if (task->parent) {
+        parent = task->parent->obj;
+        parent->element[task->idx] = r;
+    }
+    return r;
+}
+
+static void *createIntegerObject(const redisReadTask *task, long long value) {
+    redisReply *r, *parent;
+
+    r = createReplyObject(REDIS_REPLY_INTEGER);
+    if (r == NULL) return NULL;
+
+    r->integer = value;
+
+    if (task->parent) {
+        parent = task->parent->obj;
+        parent->element[task->idx] = r;
+    }
+    return r;
+}
+
+static void *createNilObject(const redisReadTask *task) {
+    redisReply *r, *parent;
+
+    r = createReplyObject(REDIS_REPLY_NIL);
+    if (r == NULL) return NULL;
+
+    if (task->parent) {
+        parent = task->parent->obj;
+        parent->element[task->idx] = r;
+    }
+    return r;
+}
+
+/* ==================== Reader (read.c) ==================== */
+
+static void __redisReaderSetError(redisReader *r, int type, const char *str) {
+    size_t len;
+
+    if (r->reply != NULL) {
+        freeReplyObject(r->reply);
+        r->reply = NULL;
+    }
+
+    /* Clear input buffer on errors. */
+    r->pos = r->len = 0;
+
+    /* Reset task stack. */
+    r->ridx = -1;
+
+    /* Set error. */
+    r->err = type;
+    len = strlen(str);
+    len = len < (sizeof(r->errstr) - 1) ? len : (sizeof(r->errstr) - 1);
+    memcpy(r->errstr, str, len);
+    r->errstr[len] = '\0';
+}
+
+static void __redisReaderSetErrorProtocolByte(redisReader *r, char byte) {
+    char buf[64];
+
+    snprintf(buf, sizeof(buf), "Protocol error, got \"%c\" as reply type byte", byte);
+    __redisReaderSetError(r, REDIS_ERR_PROTOCOL, buf);
+}
+
+static void __redisReaderSetErrorOOM(redisReader *r) {
+    __redisReaderSetError(r, REDIS_ERR_OOM, "Out of memory");
+}
+
+static char *readBytes(redisReader *r, unsigned int bytes) {
+    char *p;
+    if (r->len - r->pos >= bytes) {
+        p = r->buf + r->pos;
+        r->pos += bytes;
+        return p;
+    }
+    return NULL;
+}
+
+/* Find pointer to \r\n. */
+static char *seekNewline(char *s, size_t len) {
+    char *ret;
+
+    /* We cannot match with fewer than 2 bytes */
+    if (len < 2) return NULL;
+
+    /* Search up to len - 1 characters */
+    len--;
+
+    /* Look for the \r */
+    while ((ret = memchr(s, '\r', len)) != NULL) {
+        if (ret[1] == '\n') {
+            /* Found. */
+            break;
+        }
+        /* Continue searching. */
+        ret++;
+        len -= ret - s;
+        s = ret;
+    }
+
+    return ret;
+}
+
+/* Convert a string into a long long. Returns REDIS_OK if the string could be
+ * parsed into a (non-overflowing) signed long long, REDIS_ERR otherwise. */
+static int string2ll(const char *s, size_t slen, long long *value) {
+    const char *p = s;
+    size_t plen = 0;
+    int negative = 0;
+    unsigned long long v;
+
+    if (plen == slen) return REDIS_ERR;
+
+    /* Special case: first and only digit is 0. */
+    if (slen == 1 && p[0] == '0') {
+        if (value != NULL) *value = 0;
+        return REDIS_OK;
+    }
+
+    if (p[0] == '-') {
+        negative = 1;
+        p++;
+        plen++;
+
+        /* Abort on only a negative sign. */
+        if (plen == slen) return REDIS_ERR;
+    }
+
+    /* First digit should be 1-9, otherwise the string should just be 0. */
+    if (p[0] >= '1' && p[0] <= '9') {
+        v = p[0] - '0';
+        p++;
+        plen++;
+    } else if (p[0] == '0' && slen == 1) {
+        *value = 0;
+        return REDIS_OK;
+    } else {
+        return REDIS_ERR;
+    }
+
+    while (plen < slen && p[0] >= '0' && p[0] <= '9') {
+        if (v > (ULLONG_MAX / 10)) /* Overflow. */
+            return REDIS_ERR;
+        v *= 10;
+
+        if (v > (ULLONG_MAX - (p[0] - '0'))) /* Overflow. */
+            return REDIS_ERR;
+        v += p[0] - '0';
+
+        p++;
+        plen++;
+    }
+
+    /* Return if not all bytes were used. */
+    if (plen < slen) return REDIS_ERR;
+
+    if (negative) {
+        if (v > ((unsigned long long)(-(LLONG_MIN + 1)) + 1)) /* Overflow. */
+            return REDIS_ERR;
+        if (value != NULL) *value = -v;
+    } else {
+        if (v > LLONG_MAX) /* Overflow. */
+            return REDIS_ERR;
+        if (value != NULL) *value = v;
+    }
+    return REDIS_OK;
+}
+
+static char *readLine(redisReader *r, int *_len) {
+    char *p, *s;
+    int len;
+
+    p = r->buf + r->pos;
+    s = seekNewline(p, (r->len - r->pos));
+    if (s != NULL) {
+        len = s - (r->buf + r->pos);
+        r->pos += len + 2; /* skip \r\n */
+        if (_len) *_len = len;
+        return p;
+    }
+    return NULL;
+}
+
+static void moveToNextTask(redisReader *r) {
+    redisReadTask *cur, *prv;
+    while (r->ridx >= 0) {
+        /* Return a.s.a.p. when the stack is now empty. */
+        if (r->ridx == 0) {
+            r->ridx--;
+            return;
+        }
+
+        cur = &r->task[r->ridx];
+        prv = &r->task[r->ridx - 1];
+        assert(prv->type == REDIS_REPLY_ARRAY);
+        if (cur->idx == prv->elements - 1) {
+            r->ridx--;
+        } else {
+            /* Reset the type because the next item can be anything */
+            assert(cur->idx < prv->elements);
+            cur->type = -1;
+            cur->elements = -1;
+            cur->idx++;
+            return;
+        }
+    }
+}
+
+static int processLineItem(redisReader *r) {
+    redisReadTask *cur = &r->task[r->ridx];
+    void *obj;
+    char *p;
+    int len;
+
+    if ((p = readLine(r, &len)) != NULL) {
+        if (cur->type == REDIS_REPLY_INTEGER) {
+            long long v;
+
+            if (string2ll(p, len, &v) == REDIS_ERR) {
+                __redisReaderSetError(r, REDIS_ERR_PROTOCOL, "Bad integer value");
+                return REDIS_ERR;
+            }
+
+            obj = createIntegerObject(cur, v);
+        } else {
+            /* Type will be error or status. */
+            obj = createStringObject(cur, p, len);
+        }
+
+        if (obj == NULL) {
+            __redisReaderSetErrorOOM(r);
+            return REDIS_ERR;
+        }
+
+        /* Set reply if this is the root object. */
+        if (r->ridx == 0) r->reply = obj;
+        moveToNextTask(r);
+        return REDIS_OK;
+    }
+
+    return REDIS_ERR;
+}
+
+static int processBulkItem(redisReader *r) {
+    redisReadTask *cur = &r->task[r->ridx];
+    void *obj = NULL;
+    char *p, *s;
+    long long len;
+    unsigned long bytelen;
+    int success = 0;
+
+    p = r->buf + r->pos;
+    s = seekNewline(p, r->len - r->pos);
+    if (s != NULL) {
+        p = r->buf + r->pos;
+        bytelen = s - (r->buf + r->pos) + 2; /* include \r\n */
+
+        if (string2ll(p, bytelen - 2, &len) == REDIS_ERR) {
+            __redisReaderSetError(r, REDIS_ERR_PROTOCOL, "Bad bulk string length");
+            return REDIS_ERR;
+        }
+
+        if (len < -1) {
+            __redisReaderSetError(r, REDIS_ERR_PROTOCOL, "Bulk string length out of range");
+            return REDIS_ERR;
+        }
+
+        if (len == -1) {
+            /* The nil object can always be created. */
+            obj = createNilObject(cur);
+            success = 1;
+        } else {
+            /* Only continue when the buffer contains the entire bulk item. */
+            bytelen += len + 2; /* include \r\n */
+            if (r->pos + bytelen <= r->len) {
+                obj = createStringObject(cur, s + 2, len);
+                success = 1;
+            }
+        }
+
+        /* Proceed when obj was created. */
+        if (success) {
+            if (obj == NULL) {
+                __redisReaderSetErrorOOM(r);
+                return REDIS_ERR;
+            }
+
+            r->pos += bytelen;
+
+            /* Set reply if this is the root object. */
+            if (r->ridx == 0) r->reply = obj;
+            moveToNextTask(r);
+            return REDIS_OK;
+        }
+    }
+
+    return REDIS_ERR;
+}
+
+static int processMultiBulkItem(redisReader *r) {
+    redisReadTask *cur = &r->task[r->ridx];
+    void *obj;
+    char *p;
+    long long elements;
+    int root = 0, len;
+
+    /* Set error for nested multi bulks with depth > 7 */
+    if (r->ridx == REDIS_READER_STACK_SIZE - 1) {
+        __redisReaderSetError(r, REDIS_ERR_PROTOCOL,
+                              "No support for nested multi bulk replies with depth > 7");
+        return REDIS_ERR;
+    }
+
+    if ((p = readLine(r, &len)) != NULL) {
+        if (string2ll(p, len, &elements) == REDIS_ERR) {
+            __redisReaderSetError(r, REDIS_ERR_PROTOCOL, "Bad multi-bulk length");
+            return REDIS_ERR;
+        }
+
+        root = (r->ridx == 0);
+
+        if (elements < -1 || elements > INT_MAX) {
+            __redisReaderSetError(r, REDIS_ERR_PROTOCOL, "Multi-bulk length out of range");
+            return REDIS_ERR;
+        }
+
+        if (elements == -1) {
+            obj = createNilObject(cur);
+
+            if (obj == NULL) {
+                __redisReaderSetErrorOOM(r);
+                return REDIS_ERR;
+            }
+
+            moveToNextTask(r);
+        } else {
+            obj = createArrayObject(cur, elements);
+
+            if (obj == NULL) {
+                __redisReaderSetErrorOOM(r);
+                return REDIS_ERR;
+            }
+
+            /* Modify task stack when there are more than 0 elements. */
+            if (elements > 0) {
+                cur->elements = elements;
+                cur->obj = obj;
+                r->ridx++;
+                r->task[r->ridx].type = -1;
+                r->task[r->ridx].elements = -1;
+                r->task[r->ridx].idx = 0;
+                r->task[r->ridx].obj = NULL;
+                r->task[r->ridx].parent = cur;
+            } else {
+                moveToNextTask(r);
+            }
+        }
+
+        /* Set reply if this is the root object. */
+        if (root) r->reply = obj;
+        return REDIS_OK;
+    }
+
+    return REDIS_ERR;
+}
+
+static int processItem(redisReader *r) {
+    redisReadTask *cur = &r->task[r->ridx];
+    char *p;
+
+    /* check if we need to read type */
+    if (cur->type < 0) {
+        if ((p = readBytes(r, 1)) != NULL) {
+            switch (p[0]) {
+            case '-':
+                cur->type = REDIS_REPLY_ERROR;
+                break;
+            case '+':
+                cur->type = REDIS_REPLY_STATUS;
+                break;
+            case ':':
+                cur->type = REDIS_REPLY_INTEGER;
+                break;
+            case '$':
+                cur->type = REDIS_REPLY_STRING;
+                break;
+            case '*':
+                cur->type = REDIS_REPLY_ARRAY;
+                break;
+            default:
+                __redisReaderSetErrorProtocolByte(r, *p);
+                return REDIS_ERR;
+            }
+        } else {
+            /* could not consume 1 byte */
+            return REDIS_ERR;
+        }
+    }
+
+    /* process typed item */
+    switch (cur->type) {
+    case REDIS_REPLY_ERROR:
+    case REDIS_REPLY_STATUS:
+    case REDIS_REPLY_INTEGER:
+        return processLineItem(r);
+    case REDIS_REPLY_STRING:
+        return processBulkItem(r);
+    case REDIS_REPLY_ARRAY:
+        return processMultiBulkItem(r);
+    default:
+        assert(NULL);
+        return REDIS_ERR; /* Avoid warning. */
+    }
+}
+
+redisReader *redisReaderCreate(void) {
+    redisReader *r = hi_calloc(1, sizeof(redisReader));
+    if (r == NULL) return NULL;
+
+    r->maxbuf = REDIS_READER_MAX_BUF;
+    r->ridx = -1;
+    return r;
+}
+
+void redisReaderFree(redisReader *r) {
+    if (r == NULL) return;
+
+    if (r->reply != NULL) freeReplyObject(r->reply);
+
+    hi_free(r->buf);
+    hi_free(r);
+}
+
+int redisReaderFeed(redisReader *r, const char *buf, size_t len) {
+    /* Return early when this reader is in an erroneous state. */
+    if (r->err) return REDIS_ERR;
+
+    /* Copy the provided buffer. */
+    if (buf != NULL && len >= 1) {
+        /* Destroy internal buffer when it is empty and is quite large. */
+        if (r->len == 0 && r->maxbuf != 0 && r->buf_alloc > r->maxbuf) {
+            hi_free(r->buf);
+            r->buf = NULL;
+            r->buf_alloc = 0;
+            r->pos = 0;
+        }
+
+        /* sdscatlen(): greedy growth, doubling up to 1 MB */
+        if (r->buf_alloc - r->len < len) {
+            size_t newlen = r->len + len;
+            newlen = newlen < 1024 * 1024 ? newlen * 2 : newlen + 1024 * 1024;
+            char *newbuf = hi_realloc(r->buf, newlen + 1);
+            if (newbuf == NULL) {
+                __redisReaderSetErrorOOM(r);
+                return REDIS_ERR;
+            }
+            r->buf = newbuf;
+            r->buf_alloc = newlen;
+        }
+        memcpy(r->buf + r->len, buf, len);
+        r->len += len;
+        r->buf[r->len] = '\0';
+    }
+
+    return REDIS_OK;
+}
+
+int redisReaderGetReply(redisReader *r, void **reply) {
+    /* Default target pointer to NULL. */
+    if (reply != NULL) *reply = NULL;
+
+    /* Return early when this reader is in an erroneous state. */
+    if (r->err) return REDIS_ERR;
+
+    /* When the buffer is empty, there will never be a reply. */
+    if (r->len == 0) return REDIS_OK;
+
+    /* Set first item to process when the stack is empty. */
+    if (r->ridx == -1) {
+        r->task[0].type = -1;
+        r->task[0].elements = -1;
+        r->task[0].idx = -1;
+        r->task[0].obj = NULL;
+        r->task[0].parent = NULL;
+        r->ridx = 0;
+    }
+
+    /* Process items in reply. */
+    while (r->ridx >= 0)
+        if (processItem(r) != REDIS_OK) break;
+
+    /* Return ASAP when an error occurred. */
+    if (r->err) return REDIS_ERR;
+
+    /* Discard part of the buffer when we've consumed at least 1k. */
+    if (r->pos >= 1024) {
+        memmove(r->buf, r->buf + r->pos, r->len - r->pos);
+        r->len -= r->pos;
+        r->pos = 0;
+        r->buf[r->len] = '\0';
+    }
+
+    /* Emit a reply when there is one. */
+    if (r->ridx == -1) {
+        if (reply != NULL) {
+            *reply = r->reply;
+        } else if (r->reply != NULL) {
+            freeReplyObject(r->reply);
+        }
+        r->reply = NULL;
+    }
+    return REDIS_OK;
+}
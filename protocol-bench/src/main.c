@@ -18,12 +18,16 @@ int main(int argc, char **argv) {
         .bench_resp = 1,
         .bench_respb = 0, // Only RESP for now since we need converted workloads
         .workload_type = WORKLOAD_MIXED,
+        .respb_decoder = RESPB_DECODER_SWITCH,
+        .mode = BENCH_MODE_PARSE,
+        .batch_size = 256,
+        .chunk_size = 16384,
         .resp_workload_file = NULL,
         .respb_workload_file = NULL
     };
     
     int opt;
-    while ((opt = getopt(argc, argv, "r:b:i:lw:p:h")) != -1) {
+    while ((opt = getopt(argc, argv, "r:b:i:lw:p:d:m:n:c:h")) != -1) {
         switch (opt) {
             case 'r':
                 config.resp_workload_file = optarg;
@@ -72,6 +76,86 @@ int main(int argc, char **argv) {
                     return 1;
                 }
                 break;
+            case 'd':
+                if (strcmp(optarg, "switch") == 0) {
+                    config.respb_decoder = RESPB_DECODER_SWITCH;
+                } else if (strcmp(optarg, "table") == 0) {
+                    config.respb_decoder = RESPB_DECODER_TABLE;
+                } else if (strcmp(optarg, "both") == 0) {
+                    config.respb_decoder = RESPB_DECODER_BOTH;
+                } else {
+                    fprintf(stderr, "Invalid decoder: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'm':
+                if (strcmp(optarg, "parse") == 0) {
+                    config.mode = BENCH_MODE_PARSE;
+                } else if (strcmp(optarg, "batch") == 0) {
+                    config.mode = BENCH_MODE_BATCH;
+                } else if (strcmp(optarg, "stream") == 0) {
+                    config.mode = BENCH_MODE_STREAM;
+                } else if (strcmp(optarg, "mset") == 0) {
+                    config.mode = BENCH_MODE_MSET;
+                } else if (strcmp(optarg, "iter") == 0) {
+                    config.mode = BENCH_MODE_ITER;
+                } else if (strcmp(optarg, "skip") == 0) {
+                    config.mode = BENCH_MODE_SKIP;
+                } else if (strcmp(optarg, "passthrough") == 0) {
+                    config.mode = BENCH_MODE_PASSTHROUGH;
+                } else if (strcmp(optarg, "modules") == 0) {
+                    config.mode = BENCH_MODE_MODULES;
+                } else if (strcmp(optarg, "names") == 0) {
+                    config.mode = BENCH_MODE_NAMES;
+                } else if (strcmp(optarg, "serialize") == 0) {
+                    config.mode = BENCH_MODE_SERIALIZE;
+                } else if (strcmp(optarg, "iov") == 0) {
+                    config.mode = BENCH_MODE_IOV;
+                } else if (strcmp(optarg, "size") == 0) {
+                    config.mode = BENCH_MODE_SIZE;
+                } else if (strcmp(optarg, "pipeline") == 0) {
+                    config.mode = BENCH_MODE_PIPELINE;
+                } else if (strcmp(optarg, "reply") == 0) {
+                    config.mode = BENCH_MODE_REPLY;
+                } else if (strcmp(optarg, "client") == 0) {
+                    config.mode = BENCH_MODE_CLIENT;
+                } else if (strcmp(optarg, "varint") == 0) {
+                    config.mode = BENCH_MODE_VARINT;
+                } else if (strcmp(optarg, "compress") == 0) {
+                    config.mode = BENCH_MODE_COMPRESS;
+                } else if (strcmp(optarg, "keydict") == 0) {
+                    config.mode = BENCH_MODE_KEYDICT;
+                } else if (strcmp(optarg, "handshake") == 0) {
+                    config.mode = BENCH_MODE_HANDSHAKE;
+                } else if (strcmp(optarg, "transcode") == 0) {
+                    config.mode = BENCH_MODE_TRANSCODE;
+                } else if (strcmp(optarg, "roundtrip") == 0) {
+                    config.mode = BENCH_MODE_ROUNDTRIP;
+                } else if (strcmp(optarg, "aof") == 0) {
+                    config.mode = BENCH_MODE_AOF;
+                } else if (strcmp(optarg, "index") == 0) {
+                    config.mode = BENCH_MODE_INDEX;
+                } else if (strcmp(optarg, "compact") == 0) {
+                    config.mode = BENCH_MODE_COMPACT;
+                } else {
+                    fprintf(stderr, "Invalid mode: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'n':
+                config.batch_size = (size_t)atol(optarg);
+                if (config.batch_size == 0) {
+                    fprintf(stderr, "Invalid batch size: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'c':
+                config.chunk_size = (size_t)atol(optarg);
+                if (config.chunk_size == 0) {
+                    fprintf(stderr, "Invalid chunk size: %s\n", optarg);
+                    return 1;
+                }
+                break;
             case 'h':
                 print_usage(argv[0]);
                 return 0;
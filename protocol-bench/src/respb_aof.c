@@ -0,0 +1,254 @@
+/*
+ * RESPB AOF Loader
+ * Boundary pre-scan with respb_frame_length(), per-thread decode of
+ * RESPB_AOF_BATCH-frame ranges, and an ordered hand-off to one applier
+ */
+
+#include "respb_aof.h"
+#include "respb_frame.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* One decoded batch waiting for the applier */
+typedef struct {
+    respb_command_t cmds[RESPB_AOF_BATCH];
+    size_t count;
+    size_t batch;           /* Batch held, once ready */
+    int ready;
+    int result;             /* 1, or -1 with the frame at error_pos bad */
+    size_t error_pos;
+} slot_t;
+
+/* Shared between the workers and the applier; slot b % nslots holds batch
+ * b, and is free again once the applier is done with batch b - nslots */
+typedef struct {
+    const uint8_t *data;
+    const size_t *cuts;     /* Batch b is data[cuts[b]..cuts[b + 1]) */
+    size_t nbatches;
+    slot_t *slots;
+    size_t nslots;
+    size_t next;            /* Next batch to decode */
+    size_t applied;         /* Batches the applier is done with */
+    int stop;
+    pthread_mutex_t lock;
+    pthread_cond_t slot_free;
+    pthread_cond_t batch_ready;
+} loader_t;
+
+/* Walk the frame lengths and cut a batch every RESPB_AOF_BATCH frames.
+ * Sets *cuts_out to nbatches + 1 offsets and *end to where the walk
+ * stopped. Returns 1 if it reached len, -1 at a bad or cut-short frame, 0
+ * if out of memory */
+static int scan_frames(const uint8_t *data, size_t len, size_t **cuts_out, size_t *nbatches,
+                       size_t *end) {
+    size_t cap = len / (RESPB_AOF_BATCH * 16) + 2, n = 1, frames = 0, pos = 0;
+    size_t *cuts = malloc(cap * sizeof(*cuts));
+    int result = 1;
+    if (!cuts) return 0;
+    cuts[0] = 0;
+    while (pos < len) {
+        size_t frame_len;
+        if (respb_frame_length(data + pos, len - pos, &frame_len) != 1) {
+            result = -1;
+            break;
+        }
+        pos += frame_len;
+        if (++frames < RESPB_AOF_BATCH && pos < len) continue;
+        if (n == cap) {
+            size_t *grown = realloc(cuts, cap * 2 * sizeof(*cuts));
+            if (!grown) {
+                free(cuts);
+                return 0;
+            }
+            cuts = grown;
+            cap *= 2;
+        }
+        cuts[n++] = pos;
+        frames = 0;
+    }
+    /* Frames before a bad one still form a last batch */
+    if (frames) {
+        if (n == cap) {
+            size_t *grown = realloc(cuts, (cap + 1) * sizeof(*cuts));
+            if (!grown) {
+                free(cuts);
+                return 0;
+            }
+            cuts = grown;
+        }
+        cuts[n++] = pos;
+    }
+    *cuts_out = cuts;
+    *nbatches = n - 1;
+    *end = pos;
+    return result;
+}
+
+static void decode_batch(const uint8_t *data, size_t start, size_t end, slot_t *s) {
+    respb_parser_t parser;
+    respb_parser_init(&parser, data + start, end - start);
+    s->count = 0;
+    s->result = 1;
+    while (parser.pos < parser.buffer_len) {
+        /* Lengths agreed with the scan, so a failure here is a frame the
+         * parser rejects (compressed, key bind, malformed fields). The
+         * parser may have moved past its header */
+        size_t frame_start = parser.pos;
+        if (s->count == RESPB_AOF_BATCH || respb_parse_command(&parser, &s->cmds[s->count]) != 1) {
+            s->result = -1;
+            s->error_pos = start + frame_start;
+            return;
+        }
+        s->count++;
+    }
+}
+
+static void *decode_worker(void *arg) {
+    loader_t *l = arg;
+    pthread_mutex_lock(&l->lock);
+    for (;;) {
+        while (!l->stop && l->next < l->nbatches && l->next - l->applied >= l->nslots) {
+            pthread_cond_wait(&l->slot_free, &l->lock);
+        }
+        if (l->stop || l->next == l->nbatches) break;
+        size_t b = l->next++;
+        slot_t *s = &l->slots[b % l->nslots];
+        pthread_mutex_unlock(&l->lock);
+
+        decode_batch(l->data, l->cuts[b], l->cuts[b + 1], s);
+
+        pthread_mutex_lock(&l->lock);
+        s->batch = b;
+        s->ready = 1;
+        pthread_cond_broadcast(&l->batch_ready);
+    }
+    pthread_mutex_unlock(&l->lock);
+    return NULL;
+}
+
+/* Hand one decoded batch to apply. Returns 1, 0 if apply stopped, -1 if
+ * the batch holds a bad frame (the frames before it applied) */
+static int apply_batch(const slot_t *s, size_t end, respb_aof_apply_fn apply, void *ctx,
+                       respb_aof_stats_t *stats) {
+    if (s->count && !apply(ctx, s->cmds, s->count)) return 0;
+    stats->commands += s->count;
+    stats->batches++;
+    if (s->result != 1) {
+        stats->bytes = s->error_pos;
+        stats->error_pos = s->error_pos;
+        return -1;
+    }
+    stats->bytes = end;
+    return 1;
+}
+
+int respb_aof_load(const uint8_t *data, size_t len, int nthreads,
+                   respb_aof_apply_fn apply, void *ctx, respb_aof_stats_t *stats) {
+    respb_aof_stats_t local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > RESPB_AOF_MAX_THREADS) nthreads = RESPB_AOF_MAX_THREADS;
+
+    size_t *cuts, nbatches, scanned;
+    int scan = scan_frames(data, len, &cuts, &nbatches, &scanned);
+    if (scan == 0) return 0;
+
+    loader_t l;
+    memset(&l, 0, sizeof(l));
+    l.data = data;
+    l.cuts = cuts;
+    l.nbatches = nbatches;
+    l.nslots = nthreads == 1 ? 1 : (size_t)nthreads * RESPB_AOF_AHEAD;
+    if (l.nslots > nbatches) l.nslots = nbatches ? nbatches : 1;
+    l.slots = malloc(l.nslots * sizeof(*l.slots));
+    if (!l.slots) {
+        free(cuts);
+        return 0;
+    }
+
+    int result = 1;
+    if (nthreads == 1 || nbatches <= 1) {
+        /* Decode and apply in turn on this thread */
+        for (size_t b = 0; b < nbatches && result == 1; b++) {
+            decode_batch(data, cuts[b], cuts[b + 1], &l.slots[0]);
+            result = apply_batch(&l.slots[0], cuts[b + 1], apply, ctx, stats);
+        }
+    } else {
+        pthread_t threads[RESPB_AOF_MAX_THREADS];
+        int started = 0;
+        pthread_mutex_init(&l.lock, NULL);
+        pthread_cond_init(&l.slot_free, NULL);
+        pthread_cond_init(&l.batch_ready, NULL);
+        for (size_t i = 0; i < l.nslots; i++) l.slots[i].ready = 0;
+        for (; started < nthreads; started++) {
+            if (pthread_create(&threads[started], NULL, decode_worker, &l) != 0) break;
+        }
+        if (started == 0) result = 0;
+
+        for (size_t b = 0; b < nbatches && result == 1; b++) {
+            slot_t *s = &l.slots[b % l.nslots];
+            pthread_mutex_lock(&l.lock);
+            while (!(s->ready && s->batch == b)) pthread_cond_wait(&l.batch_ready, &l.lock);
+            pthread_mutex_unlock(&l.lock);
+
+            result = apply_batch(s, cuts[b + 1], apply, ctx, stats);
+
+            pthread_mutex_lock(&l.lock);
+            s->ready = 0;
+            l.applied++;
+            pthread_cond_broadcast(&l.slot_free);
+            pthread_mutex_unlock(&l.lock);
+        }
+
+        pthread_mutex_lock(&l.lock);
+        l.stop = 1;
+        pthread_cond_broadcast(&l.slot_free);
+        pthread_mutex_unlock(&l.lock);
+        for (int i = 0; i < started; i++) pthread_join(threads[i], NULL);
+        pthread_cond_destroy(&l.batch_ready);
+        pthread_cond_destroy(&l.slot_free);
+        pthread_mutex_destroy(&l.lock);
+    }
+
+    /* Every batch applied, but the scan stopped short of the end */
+    if (result == 1 && scan == -1) {
+        stats->error_pos = scanned;
+        result = -1;
+    }
+    free(l.slots);
+    free(cuts);
+    return result;
+}
+
+int respb_aof_load_file(const char *path, int nthreads, respb_aof_apply_fn apply, void *ctx,
+                        respb_aof_stats_t *stats) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+    size_t len = (size_t)st.st_size;
+    const uint8_t *data = NULL;
+    if (len > 0) {
+        void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+        data = map;
+        madvise(map, len, MADV_SEQUENTIAL);
+    }
+    close(fd);
+    int result = respb_aof_load(data, len, nthreads, apply, ctx, stats);
+    if (data) munmap((void *)data, len);
+    return result;
+}
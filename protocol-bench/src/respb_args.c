@@ -0,0 +1,168 @@
+/*
+ * RESPB Argument Arena
+ * Decodes frames of any size into compact commands whose large argument
+ * vectors come from a reusable arena instead of a fixed array or malloc
+ */
+
+#include "respb_args.h"
+#include "respb_schema.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static respb_arena_block_t *arena_block_new(size_t capacity, respb_arena_block_t *prev) {
+    respb_arena_block_t *block = malloc(sizeof(*block) + capacity * sizeof(respb_arg_t));
+    if (!block) return NULL;
+    block->prev = prev;
+    block->used = 0;
+    block->capacity = capacity;
+    return block;
+}
+
+int respb_arena_init(respb_arena_t *arena, size_t initial_args) {
+    arena->head = NULL;
+    arena->total = 0;
+    if (initial_args == 0) initial_args = RESPB_ARENA_DEFAULT;
+    arena->head = arena_block_new(initial_args, NULL);
+    if (!arena->head) return 0;
+    arena->total = initial_args;
+    return 1;
+}
+
+respb_arg_t *respb_arena_alloc(respb_arena_t *arena, size_t n) {
+    respb_arena_block_t *block = arena->head;
+    if (block && n <= block->capacity - block->used) {
+        respb_arg_t *args = block->args + block->used;
+        block->used += n;
+        return args;
+    }
+
+    /* Keep the current block (its spans are still live) and chain a new one */
+    size_t capacity = arena->total > n ? arena->total : n;
+    if (capacity < RESPB_ARENA_DEFAULT) capacity = RESPB_ARENA_DEFAULT;
+    block = arena_block_new(capacity, block);
+    if (!block) return NULL;
+    arena->head = block;
+    arena->total += capacity;
+    block->used = n;
+    return block->args;
+}
+
+void respb_arena_reset(respb_arena_t *arena) {
+    respb_arena_block_t *block = arena->head;
+    if (!block) return;
+    if (!block->prev) {
+        block->used = 0;
+        return;
+    }
+
+    /* Fold the chain into one block sized to the high-water mark */
+    size_t total = arena->total;
+    respb_arena_free(arena);
+    arena->head = arena_block_new(total, NULL);
+    if (arena->head) arena->total = total;
+}
+
+void respb_arena_free(respb_arena_t *arena) {
+    respb_arena_block_t *block = arena->head;
+    while (block) {
+        respb_arena_block_t *prev = block->prev;
+        free(block);
+        block = prev;
+    }
+    arena->head = NULL;
+    arena->total = 0;
+}
+
+int respb_parse_compact(respb_parser_t *parser, respb_cmd_t *cmd, respb_arena_t *arena) {
+    const uint8_t *buf = parser->buffer;
+    size_t len = parser->buffer_len;
+    size_t pos = parser->pos;
+
+    /* Fixed-width prefixes only; varint lengths and key references are
+     * decoded by respb_parse_command() */
+    if (parser->flags & (RESPB_FLAG_VARINT | RESPB_FLAG_KEYDICT)) {
+        fprintf(stderr, "RESPB Parser: Compact decoder does not support flags 0x%02X\n",
+                parser->flags);
+        return -1;
+    }
+
+    /* Header: [2B opcode][2B mux_id] */
+    if (len < 4 || pos > len - 4) return 0;
+    cmd->opcode = respb_read_u16(buf + pos);
+    cmd->mux_id = respb_read_u16(buf + pos + 2);
+    cmd->module_subcommand = 0;
+    pos += 4;
+    cmd->raw_payload = buf + pos;
+    size_t payload_start = pos;
+
+    const respb_schema_t *schema;
+    if (cmd->opcode == RESPB_OP_MODULE) {
+        if (4 > len - pos) return 0;
+        cmd->module_subcommand = respb_read_u32(buf + pos);
+        pos += 4;
+        schema = respb_schema_lookup_module(cmd->module_subcommand >> 16,
+                                            cmd->module_subcommand & 0xFFFF);
+        if (!schema) {
+            fprintf(stderr, "RESPB Parser: Unknown module command 0x%08X at position %zu\n",
+                    cmd->module_subcommand, parser->pos);
+            return -1;
+        }
+    } else if (cmd->opcode == RESPB_OP_RESP_PASSTHROUGH) {
+        /* The RESP text becomes the single arg span */
+        if (4 > len - pos) return 0;
+        uint32_t resp_length = respb_read_u32(buf + pos);
+        pos += 4;
+        if (resp_length > len - pos) return 0;
+        cmd->u.inline_args[0].data = buf + pos;
+        cmd->u.inline_args[0].len = resp_length;
+        cmd->argc = 1;
+        pos += resp_length;
+        cmd->raw_payload_len = (uint32_t)(pos - payload_start);
+        parser->pos = pos;
+        return 1;
+    } else {
+        schema = respb_schema_lookup(cmd->opcode);
+        if (!schema) {
+            fprintf(stderr, "RESPB Parser: Unknown opcode 0x%04X at position %zu\n",
+                    cmd->opcode, parser->pos);
+            return -1;
+        }
+    }
+
+    /* Decode straight into the free tail of the arena; small frames are
+     * copied inline and leave the arena untouched */
+    respb_arena_block_t *block = arena->head;
+    respb_arg_t *dst = block ? block->args + block->used : NULL;
+    size_t avail = block ? block->capacity - block->used : 0;
+    size_t fields_start = pos;
+    size_t argc;
+
+    int result = respb_schema_decode(schema, buf, len, &pos, dst, avail, &argc);
+    if (result != 1) return result;
+
+    if (argc <= RESPB_INLINE_ARGS) {
+        if (argc <= avail) {
+            memcpy(cmd->u.inline_args, dst, argc * sizeof(respb_arg_t));
+        } else {
+            pos = fields_start;
+            respb_schema_decode(schema, buf, len, &pos, cmd->u.inline_args,
+                                RESPB_INLINE_ARGS, &argc);
+        }
+    } else if (argc <= avail) {
+        block->used += argc;
+        cmd->u.spill = dst;
+    } else {
+        /* Larger than anything seen since the last reset: grow once and redo */
+        dst = respb_arena_alloc(arena, argc);
+        if (!dst) return -1;
+        pos = fields_start;
+        respb_schema_decode(schema, buf, len, &pos, dst, argc, &argc);
+        cmd->u.spill = dst;
+    }
+
+    cmd->argc = (uint32_t)argc;
+    cmd->raw_payload_len = (uint32_t)(pos - payload_start);
+    parser->pos = pos;
+    return 1;
+}
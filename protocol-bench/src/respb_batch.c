@@ -0,0 +1,140 @@
+/*
+ * RESPB Batch Parser
+ * Drains a buffer of pipelined frames into flat, cache-line-aligned arrays
+ * using the schema tables, without a respb_command_t per frame
+ */
+
+#include "respb_batch.h"
+#include "respb_schema.h"
+#include <stdlib.h>
+#include <string.h>
+
+static size_t align_line(size_t n) {
+    return (n + RESPB_CACHE_LINE - 1) & ~(size_t)(RESPB_CACHE_LINE - 1);
+}
+
+int respb_batch_init(respb_batch_t *batch, size_t max_frames, size_t max_args) {
+    memset(batch, 0, sizeof(*batch));
+    if (max_frames == 0 || max_args == 0) return 0;
+
+    size_t op_size = align_line(max_frames * sizeof(uint16_t));
+    size_t sub_size = align_line(max_frames * sizeof(uint32_t));
+    size_t off_size = align_line((max_frames + 1) * sizeof(uint32_t));
+    size_t arg_size = align_line(max_args * sizeof(respb_arg_t));
+    size_t total = 2 * op_size + sub_size + 2 * off_size + arg_size;
+
+    uint8_t *block = aligned_alloc(RESPB_CACHE_LINE, total);
+    if (!block) return 0;
+
+    batch->block = block;
+    batch->opcodes = (uint16_t *)block;
+    block += op_size;
+    batch->mux_ids = (uint16_t *)block;
+    block += op_size;
+    batch->subcommands = (uint32_t *)block;
+    block += sub_size;
+    batch->frame_offsets = (uint32_t *)block;
+    block += off_size;
+    batch->arg_first = (uint32_t *)block;
+    block += off_size;
+    batch->args = (respb_arg_t *)block;
+    batch->frame_capacity = max_frames;
+    batch->arg_capacity = max_args;
+    return 1;
+}
+
+void respb_batch_free(respb_batch_t *batch) {
+    free(batch->block);
+    memset(batch, 0, sizeof(*batch));
+}
+
+size_t respb_parse_batch(const uint8_t *buf, size_t len, respb_batch_t *out, size_t max) {
+    if (max > out->frame_capacity) max = out->frame_capacity;
+    if (len > UINT32_MAX) len = UINT32_MAX;
+
+    size_t pos = 0;
+    size_t count = 0;
+    size_t nargs = 0;
+    int status = 1;
+
+    while (count < max && pos < len) {
+        size_t frame = pos;
+        if (len - pos < 4) {
+            status = 0;
+            break;
+        }
+        uint16_t opcode = respb_read_u16(buf + pos);
+        uint16_t mux_id = respb_read_u16(buf + pos + 2);
+        uint32_t subcommand = 0;
+        size_t argc;
+        pos += 4;
+
+        if (opcode == RESPB_OP_RESP_PASSTHROUGH) {
+            /* The RESP text becomes the frame's single arg span */
+            uint32_t resp_length = len - pos >= 4 ? respb_read_u32(buf + pos) : 0;
+            if (len - pos < 4 || resp_length > len - pos - 4) {
+                status = 0;
+                pos = frame;
+                break;
+            }
+            if (nargs == out->arg_capacity) {
+                if (count == 0) status = -2;
+                pos = frame;
+                break;
+            }
+            out->args[nargs].data = buf + pos + 4;
+            out->args[nargs].len = resp_length;
+            argc = 1;
+            pos += 4 + resp_length;
+        } else {
+            const respb_schema_t *schema;
+            if (opcode == RESPB_OP_MODULE) {
+                if (len - pos < 4) {
+                    status = 0;
+                    pos = frame;
+                    break;
+                }
+                subcommand = respb_read_u32(buf + pos);
+                pos += 4;
+                schema = respb_schema_lookup_module(subcommand >> 16, subcommand & 0xFFFF);
+            } else {
+                schema = respb_schema_lookup(opcode);
+            }
+            if (!schema) {
+                status = -1;
+                pos = frame;
+                break;
+            }
+
+            int result = respb_schema_decode(schema, buf, len, &pos, out->args + nargs,
+                                             out->arg_capacity - nargs, &argc);
+            if (result != 1) {
+                status = result;
+                pos = frame;
+                break;
+            }
+            if (argc > out->arg_capacity - nargs) {
+                /* Out of arg space: leave this frame for the next call, or
+                 * report it if it would not fit in an empty batch either */
+                if (count == 0) status = -2;
+                pos = frame;
+                break;
+            }
+        }
+
+        out->opcodes[count] = opcode;
+        out->mux_ids[count] = mux_id;
+        out->subcommands[count] = subcommand;
+        out->frame_offsets[count] = (uint32_t)frame;
+        out->arg_first[count] = (uint32_t)nargs;
+        nargs += argc;
+        count++;
+    }
+
+    out->frame_offsets[count] = (uint32_t)pos;
+    out->arg_first[count] = (uint32_t)nargs;
+    out->count = count;
+    out->consumed = pos;
+    out->status = status;
+    return count;
+}
@@ -0,0 +1,340 @@
+/*
+ * RESPB AOF Compaction
+ * Pass 1 records each key's last overwrite between fences in an
+ * open-addressing table of offsets into the input; pass 2 writes the frames
+ * it does not supersede, coalescing runs of kept frames into single writes
+ */
+
+#include "respb_compact.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* SET flag bits (see respb_transcode.c) */
+#define SET_FLAG_NX     0x01
+#define SET_FLAG_XX     0x02
+
+/* How a frame relates to the keys it names */
+enum {
+    KIND_FENCE,         /* May touch any key: kept, and nothing drops across it */
+    KIND_NEUTRAL,       /* MULTI, EXEC: no key */
+    KIND_SELECT,
+    KIND_WRITE,         /* Overwrites args[0] whatever it held */
+    KIND_DELETE,        /* Deletes every key in args */
+    KIND_UPDATE         /* Changes args[0] based on what it held */
+};
+
+static int frame_kind(const respb_command_t *cmd) {
+    switch (cmd->opcode) {
+        case RESPB_OP_SET:
+            return cmd->view.set.flags & (SET_FLAG_NX | SET_FLAG_XX) ? KIND_UPDATE : KIND_WRITE;
+        case RESPB_OP_SETEX:
+        case RESPB_OP_PSETEX:
+            return KIND_WRITE;
+        case RESPB_OP_DEL:
+        case RESPB_OP_UNLINK:
+        case RESPB_OP_GETDEL:
+            return KIND_DELETE;
+        case RESPB_OP_MULTI:
+        case RESPB_OP_EXEC:
+            return KIND_NEUTRAL;
+        case RESPB_OP_SELECT:
+            return KIND_SELECT;
+        /* Commands whose only key is their first field */
+        case RESPB_OP_APPEND: case RESPB_OP_DECR: case RESPB_OP_DECRBY: case RESPB_OP_GETEX:
+        case RESPB_OP_GETSET: case RESPB_OP_INCR: case RESPB_OP_INCRBY: case RESPB_OP_INCRBYFLOAT:
+        case RESPB_OP_SETNX: case RESPB_OP_SETRANGE: case RESPB_OP_SETBIT:
+        case RESPB_OP_LPUSH: case RESPB_OP_RPUSH: case RESPB_OP_LPOP: case RESPB_OP_RPOP:
+        case RESPB_OP_LSET: case RESPB_OP_LREM: case RESPB_OP_LTRIM: case RESPB_OP_LINSERT:
+        case RESPB_OP_LPUSHX: case RESPB_OP_RPUSHX:
+        case RESPB_OP_SADD: case RESPB_OP_SREM: case RESPB_OP_SPOP:
+        case RESPB_OP_ZADD: case RESPB_OP_ZREM: case RESPB_OP_ZINCRBY: case RESPB_OP_ZREMRANGEBYRANK:
+        case RESPB_OP_ZREMRANGEBYSCORE: case RESPB_OP_ZREMRANGEBYLEX: case RESPB_OP_ZPOPMIN:
+        case RESPB_OP_ZPOPMAX:
+        case RESPB_OP_HSET: case RESPB_OP_HMSET: case RESPB_OP_HDEL: case RESPB_OP_HINCRBY:
+        case RESPB_OP_HINCRBYFLOAT: case RESPB_OP_HSETNX: case RESPB_OP_HEXPIRE:
+        case RESPB_OP_HPEXPIRE: case RESPB_OP_HEXPIREAT: case RESPB_OP_HPEXPIREAT:
+        case RESPB_OP_HPERSIST: case RESPB_OP_HSETEX: case RESPB_OP_HGETEX:
+        case RESPB_OP_PFADD: case RESPB_OP_GEOADD: case RESPB_OP_XADD: case RESPB_OP_XDEL:
+        case RESPB_OP_XTRIM:
+        case RESPB_OP_EXPIRE: case RESPB_OP_EXPIREAT: case RESPB_OP_PEXPIRE: case RESPB_OP_PEXPIREAT:
+        case RESPB_OP_PERSIST:
+            return cmd->argc > 0 ? KIND_UPDATE : KIND_FENCE;
+        default:
+            return KIND_FENCE;
+    }
+}
+
+/* 32 bytes per key and segment (fences before it); the key itself stays
+ * in the input */
+typedef struct {
+    uint64_t key_off;
+    uint64_t last;          /* Offset of the key's last overwrite in the segment */
+    uint32_t key_len;
+    uint32_t hash;          /* 0 = empty slot */
+    uint32_t segment;
+    uint16_t db;
+    uint8_t emitted;        /* A kept frame has touched the key */
+} key_entry_t;
+
+typedef struct {
+    const uint8_t *data;
+    key_entry_t *slots;
+    size_t mask;
+    size_t count;
+} key_table_t;
+
+/* FNV-1a over the key, seeded with the database and segment */
+static uint32_t key_hash(const respb_arg_t *key, uint16_t db, uint32_t segment) {
+    uint32_t h = 2166136261u ^ db ^ segment * 0x9E3779B1u;
+    for (size_t i = 0; i < key->len; i++) h = (h ^ key->data[i]) * 16777619u;
+    return h ? h : 1;
+}
+
+/* The key's entry, or the empty slot where it would go */
+static key_entry_t *table_find(const key_table_t *t, const respb_arg_t *key, uint16_t db,
+                               uint32_t segment, uint32_t h) {
+    for (size_t i = h & t->mask;; i = (i + 1) & t->mask) {
+        key_entry_t *e = &t->slots[i];
+        if (e->hash == 0) return e;
+        if (e->hash == h && e->db == db && e->segment == segment && e->key_len == key->len &&
+            memcmp(t->data + e->key_off, key->data, key->len) == 0) {
+            return e;
+        }
+    }
+}
+
+static int table_grow(key_table_t *t) {
+    size_t cap = (t->mask + 1) * 2;
+    key_entry_t *slots = calloc(cap, sizeof(*slots));
+    if (!slots) return 0;
+    for (size_t i = 0; i <= t->mask; i++) {
+        const key_entry_t *e = &t->slots[i];
+        if (e->hash == 0) continue;
+        size_t j = e->hash & (cap - 1);
+        while (slots[j].hash) j = (j + 1) & (cap - 1);
+        slots[j] = *e;
+    }
+    free(t->slots);
+    t->slots = slots;
+    t->mask = cap - 1;
+    return 1;
+}
+
+static int record_overwrite(key_table_t *t, const respb_arg_t *key, uint16_t db,
+                            uint32_t segment, uint64_t pos) {
+    if ((t->count + 1) * 4 > (t->mask + 1) * 3 && !table_grow(t)) return 0;
+    uint32_t h = key_hash(key, db, segment);
+    key_entry_t *e = table_find(t, key, db, segment, h);
+    if (e->hash == 0) {
+        e->hash = h;
+        e->db = db;
+        e->segment = segment;
+        e->key_off = (uint64_t)(key->data - t->data);
+        e->key_len = (uint32_t)key->len;
+        t->count++;
+    }
+    e->last = pos;
+    return 1;
+}
+
+static key_entry_t *table_lookup(const key_table_t *t, const respb_arg_t *key, uint16_t db,
+                                 uint32_t segment) {
+    key_entry_t *e = table_find(t, key, db, segment, key_hash(key, db, segment));
+    return e->hash ? e : NULL;
+}
+
+/* Output: runs of adjacent kept frames go out in one write */
+typedef struct {
+    const uint8_t *data;
+    size_t start;
+    size_t end;
+    respb_compact_write_fn write;
+    void *ctx;
+    respb_compact_stats_t *stats;
+} run_writer_t;
+
+static int run_flush(run_writer_t *w) {
+    if (w->end > w->start && !w->write(w->ctx, w->data + w->start, w->end - w->start)) return 0;
+    w->stats->out_bytes += w->end - w->start;
+    w->start = w->end;
+    return 1;
+}
+
+static int run_emit(run_writer_t *w, size_t pos, size_t end) {
+    w->stats->kept++;
+    if (pos != w->end) {
+        if (!run_flush(w)) return 0;
+        w->start = pos;
+    }
+    w->end = end;
+    return 1;
+}
+
+static int scan_overwrites(const uint8_t *data, size_t len, key_table_t *keys,
+                           respb_compact_stats_t *stats) {
+    respb_parser_t parser;
+    respb_command_t cmd;
+    uint32_t segment = 0;
+    uint16_t db = 0;
+    respb_parser_init(&parser, data, len);
+    while (parser.pos < len) {
+        size_t pos = parser.pos;
+        if (respb_parse_command(&parser, &cmd) != 1) {
+            stats->error_pos = pos;
+            return -1;
+        }
+        stats->commands++;
+        switch (frame_kind(&cmd)) {
+            case KIND_SELECT:
+                db = respb_read_u16(cmd.raw_payload);
+                break;
+            case KIND_WRITE:
+                if (!record_overwrite(keys, &cmd.args[0], db, segment, pos)) return 0;
+                break;
+            case KIND_DELETE:
+                for (size_t i = 0; i < cmd.argc; i++) {
+                    if (!record_overwrite(keys, &cmd.args[i], db, segment, pos)) return 0;
+                }
+                break;
+            case KIND_FENCE:
+                segment++;
+                stats->fences++;
+                break;
+        }
+    }
+    return 1;
+}
+
+int respb_compact(const uint8_t *data, size_t len, respb_compact_write_fn write, void *ctx,
+                  respb_compact_stats_t *stats) {
+    respb_compact_stats_t local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    stats->in_bytes = len;
+
+    key_table_t keys = {data, calloc(1024, sizeof(key_entry_t)), 1023, 0};
+    if (!keys.slots) return 0;
+    int result = scan_overwrites(data, len, &keys, stats);
+    stats->keys = keys.count;
+    stats->memory = (keys.mask + 1) * sizeof(key_entry_t);
+
+    respb_parser_t parser;
+    respb_command_t cmd;
+    run_writer_t out = {data, 0, 0, write, ctx, stats};
+    size_t select_pos = 0, select_end = 0, multi_pos = 0, multi_end = 0;
+    uint32_t segment = 0;
+    uint16_t db = 0, out_db = 0;
+    int in_multi = 0;
+    respb_parser_init(&parser, data, result == 1 ? len : 0);
+    while (parser.pos < parser.buffer_len && result == 1) {
+        size_t pos = parser.pos;
+        respb_parse_command(&parser, &cmd);
+        /* A frame is superseded by an overwrite after it in its segment */
+        key_entry_t *e;
+        int kind = frame_kind(&cmd), keep = 1;
+        switch (kind) {
+            case KIND_FENCE:
+                segment++;
+                break;
+            case KIND_SELECT:
+                db = respb_read_u16(cmd.raw_payload);
+                select_pos = pos;
+                select_end = parser.pos;
+                keep = 0;
+                break;
+            case KIND_NEUTRAL:
+                /* MULTI waits for a kept frame; an empty MULTI/EXEC is dropped */
+                if (cmd.opcode == RESPB_OP_MULTI) {
+                    in_multi = 1;
+                    multi_pos = pos;
+                    multi_end = parser.pos;
+                    keep = 0;
+                } else if (in_multi) {
+                    in_multi = 0;
+                    keep = 0;
+                }
+                break;
+            case KIND_WRITE:
+            case KIND_UPDATE:
+                e = table_lookup(&keys, &cmd.args[0], db, segment);
+                if (e && e->last > pos) {
+                    keep = 0;
+                } else if (e) {
+                    e->emitted = 1;
+                }
+                break;
+            case KIND_DELETE:
+                /* Needed for a key it overwrites last, unless nothing kept
+                 * has given the key a value: no frame of its own, no fence */
+                keep = 0;
+                for (size_t i = 0; i < cmd.argc && !keep; i++) {
+                    e = table_lookup(&keys, &cmd.args[i], db, segment);
+                    if (e->last > pos) continue;
+                    keep = e->emitted || segment > 0;
+                }
+                break;
+        }
+        if (!keep) continue;
+        if (in_multi) {
+            in_multi = 0;
+            if (!run_emit(&out, multi_pos, multi_end)) result = 0;
+        }
+        if (kind != KIND_NEUTRAL && db != out_db) {
+            out_db = db;
+            if (!run_emit(&out, select_pos, select_end)) result = 0;
+        }
+        if (!run_emit(&out, pos, parser.pos)) result = 0;
+    }
+    if (result == 1 && !run_flush(&out)) result = 0;
+    free(keys.slots);
+    return result;
+}
+
+typedef struct {
+    FILE *out;
+    respb_index_t *index;
+} file_sink_t;
+
+static int write_file(void *ctx, const uint8_t *data, size_t len) {
+    file_sink_t *sink = ctx;
+    if (sink->index && respb_index_append(sink->index, data, len) != 1) return 0;
+    return fwrite(data, 1, len, sink->out) == len;
+}
+
+int respb_compact_file(const char *in_path, const char *out_path, respb_index_t *index,
+                       respb_compact_stats_t *stats) {
+    int fd = open(in_path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+    size_t len = (size_t)st.st_size;
+    const uint8_t *data = NULL;
+    if (len > 0) {
+        void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+        data = map;
+    }
+    close(fd);
+
+    file_sink_t sink = {fopen(out_path, "wb"), index};
+    int result = 0;
+    if (sink.out) {
+        setvbuf(sink.out, NULL, _IOFBF, 1 << 20);
+        result = respb_compact(data, len, write_file, &sink, stats);
+        if (fclose(sink.out) != 0 && result == 1) result = 0;
+    }
+    if (data) munmap((void *)data, len);
+    return result;
+}
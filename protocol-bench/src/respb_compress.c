@@ -0,0 +1,240 @@
+/*
+ * RESPB Frame Compression
+ * LZ4 block codec (the reference fast compressor with its acceleration
+ * step, and a bounds-checked decoder) and the 0xF001 frame wrapper
+ */
+
+#include "respb_compress.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LZ4_MIN_MATCH       4
+#define LZ4_MFLIMIT         12      /* A match starts at least this far from the end */
+#define LZ4_LAST_LITERALS   5       /* The block ends with this many literals */
+#define LZ4_MAX_OFFSET      65535
+#define LZ4_SKIP_TRIGGER    6       /* Step grows by one every 64 misses */
+
+static inline uint32_t read32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint32_t lz4_hash(uint32_t v) {
+    return (v * 2654435761u) >> (32 - RESPB_LZ4_HASH_LOG);
+}
+
+/* Length beyond the 4-bit token field: 255 bytes while they last */
+static uint8_t *write_length(uint8_t *op, size_t len) {
+    while (len >= 255) {
+        *op++ = 255;
+        len -= 255;
+    }
+    *op++ = (uint8_t)len;
+    return op;
+}
+
+/* Token, literal length and literals of one sequence. Returns NULL if the
+ * sequence plus reserve bytes does not fit */
+static uint8_t *write_literals(uint8_t *op, const uint8_t *oend, const uint8_t *lit,
+                               size_t lit_len, size_t reserve) {
+    if ((size_t)(oend - op) < 1 + lit_len / 255 + 1 + lit_len + reserve) return NULL;
+    if (lit_len >= 15) {
+        *op++ = 15 << 4;
+        op = write_length(op, lit_len - 15);
+    } else {
+        *op++ = (uint8_t)(lit_len << 4);
+    }
+    memcpy(op, lit, lit_len);
+    return op + lit_len;
+}
+
+size_t respb_lz4_compress(const uint8_t *src, size_t len, uint8_t *dst, size_t cap,
+                          uint32_t *table, int acceleration) {
+    const uint8_t *ip = src, *anchor = src, *end = src + len;
+    uint8_t *op = dst, *oend = dst + cap;
+    if (acceleration < 1) acceleration = 1;
+
+    if (len > LZ4_MFLIMIT) {
+        const uint8_t *mflimit = end - LZ4_MFLIMIT;
+        const uint8_t *matchlimit = end - LZ4_LAST_LITERALS;
+        memset(table, 0, sizeof(uint32_t) << RESPB_LZ4_HASH_LOG);
+        ip++;
+
+        for (;;) {
+            /* Find a 4-byte match; the step grows with every miss */
+            const uint8_t *ref = NULL;
+            unsigned attempts = (unsigned)acceleration << LZ4_SKIP_TRIGGER;
+            while (ip <= mflimit) {
+                uint32_t h = lz4_hash(read32(ip));
+                ref = src + table[h];
+                table[h] = (uint32_t)(ip - src);
+                if (ip - ref <= LZ4_MAX_OFFSET && read32(ref) == read32(ip)) break;
+                ip += attempts++ >> LZ4_SKIP_TRIGGER;
+            }
+            if (ip > mflimit) break;
+
+            /* Extend backwards over pending literals, then forwards */
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const uint8_t *p = ip + LZ4_MIN_MATCH, *r = ref + LZ4_MIN_MATCH;
+            while (p < matchlimit && *p == *r) {
+                p++;
+                r++;
+            }
+            size_t match_len = (size_t)(p - ip) - LZ4_MIN_MATCH;
+
+            /* Reserve the offset and the match length bytes */
+            uint8_t *token = op;
+            op = write_literals(op, oend, anchor, (size_t)(ip - anchor), 2 + match_len / 255 + 1);
+            if (!op) return 0;
+            size_t offset = (size_t)(ip - ref);
+            *op++ = (uint8_t)offset;
+            *op++ = (uint8_t)(offset >> 8);
+            if (match_len >= 15) {
+                *token |= 15;
+                op = write_length(op, match_len - 15);
+            } else {
+                *token |= (uint8_t)match_len;
+            }
+
+            ip = anchor = p;
+            if (ip > mflimit) break;
+            table[lz4_hash(read32(ip - 2))] = (uint32_t)(ip - 2 - src);
+        }
+    }
+
+    op = write_literals(op, oend, anchor, (size_t)(end - anchor), 0);
+    return op ? (size_t)(op - dst) : 0;
+}
+
+/* Add 255-terminated length bytes to *len. Returns 0 past the input end */
+static int read_length(const uint8_t **ip, const uint8_t *iend, size_t *len) {
+    uint8_t b;
+    do {
+        if (*ip == iend) return 0;
+        b = *(*ip)++;
+        *len += b;
+    } while (b == 255);
+    return 1;
+}
+
+int respb_lz4_decompress(const uint8_t *src, size_t len, uint8_t *dst, size_t raw_len) {
+    const uint8_t *ip = src, *iend = src + len;
+    uint8_t *op = dst, *oend = dst + raw_len;
+
+    while (ip < iend) {
+        uint8_t token = *ip++;
+        size_t lit_len = token >> 4;
+        if (lit_len == 15 && !read_length(&ip, iend, &lit_len)) return -1;
+        if (lit_len > (size_t)(iend - ip) || lit_len > (size_t)(oend - op)) return -1;
+        /* Short runs: one fixed 16-byte copy when both sides have room */
+        if (lit_len <= 16 && iend - ip >= 16 && oend - op >= 16) {
+            memcpy(op, ip, 16);
+        } else {
+            memcpy(op, ip, lit_len);
+        }
+        op += lit_len;
+        ip += lit_len;
+        if (ip == iend) break;      /* Last sequence: literals only */
+
+        if (iend - ip < 2) return -1;
+        size_t offset = ip[0] | (size_t)ip[1] << 8;
+        ip += 2;
+        if (offset == 0 || offset > (size_t)(op - dst)) return -1;
+        size_t match_len = token & 15;
+        if (match_len == 15 && !read_length(&ip, iend, &match_len)) return -1;
+        match_len += LZ4_MIN_MATCH;
+        if (match_len > (size_t)(oend - op)) return -1;
+
+        /* 8-byte steps may write past the match but stay inside dst; an
+         * offset below 8 overlaps the bytes being written, so go bytewise */
+        const uint8_t *ref = op - offset;
+        if (offset >= 8 && (size_t)(oend - op) >= match_len + 8) {
+            for (size_t i = 0; i < match_len; i += 8) memcpy(op + i, ref + i, 8);
+            op += match_len;
+        } else {
+            while (match_len--) *op++ = *ref++;
+        }
+    }
+    return op == oend ? 1 : -1;
+}
+
+void respb_compressor_init(respb_compressor_t *c, size_t threshold, int acceleration) {
+    c->threshold = threshold;
+    c->acceleration = acceleration;
+    c->scratch = NULL;
+    c->scratch_cap = 0;
+}
+
+void respb_compressor_free(respb_compressor_t *c) {
+    free(c->scratch);
+    c->scratch = NULL;
+    c->scratch_cap = 0;
+}
+
+size_t respb_compress_frame(respb_compressor_t *c, uint8_t *buf, size_t buf_len,
+                            const uint8_t *frame, size_t frame_len) {
+    if (frame_len >= c->threshold && frame_len > RESPB_COMPRESSED_HEADER_SIZE &&
+        frame_len <= UINT32_MAX && buf_len > RESPB_COMPRESSED_HEADER_SIZE) {
+        /* Only keep the block if the whole frame ends up smaller */
+        size_t cap = frame_len - RESPB_COMPRESSED_HEADER_SIZE - 1;
+        if (cap > buf_len - RESPB_COMPRESSED_HEADER_SIZE) cap = buf_len - RESPB_COMPRESSED_HEADER_SIZE;
+        size_t n = respb_lz4_compress(frame, frame_len, buf + RESPB_COMPRESSED_HEADER_SIZE, cap,
+                                      c->table, c->acceleration);
+        if (n > 0) {
+            respb_serialize_header(buf, RESPB_OP_COMPRESSED, respb_read_u16(frame + 2));
+            respb_write_u32(buf + 4, (uint32_t)frame_len);
+            respb_write_u32(buf + 8, (uint32_t)n);
+            return RESPB_COMPRESSED_HEADER_SIZE + n;
+        }
+    }
+    if (frame_len > buf_len) return 0;
+    memcpy(buf, frame, frame_len);
+    return frame_len;
+}
+
+size_t respb_serialize_compressed(respb_compressor_t *c, uint8_t *buf, size_t buf_len,
+                                  const respb_command_t *cmd, uint8_t flags) {
+    /* The uncompressed frame has to fit buf_len anyway, for the fallback */
+    if (c->scratch_cap < buf_len) {
+        uint8_t *scratch = realloc(c->scratch, buf_len);
+        if (!scratch) return 0;
+        c->scratch = scratch;
+        c->scratch_cap = buf_len;
+    }
+    size_t n = respb_serialize_command_flags(c->scratch, buf_len, cmd, flags);
+    if (n == 0) return 0;
+    return respb_compress_frame(c, buf, buf_len, c->scratch, n);
+}
+
+int respb_inflate_frame(respb_parser_t *parser, respb_parser_t *inner) {
+    const uint8_t *buf = parser->buffer + parser->pos;
+    size_t len = parser->buffer_len - parser->pos;
+    if (len < RESPB_COMPRESSED_HEADER_SIZE) return 0;
+    uint32_t raw_len = respb_read_u32(buf + 4);
+    uint32_t comp_len = respb_read_u32(buf + 8);
+    if (comp_len > len - RESPB_COMPRESSED_HEADER_SIZE) return 0;
+
+    if (!parser->inflate_buf || raw_len > parser->inflate_cap) {
+        fprintf(stderr, "RESPB Parser: No room to inflate a %u-byte frame at position %zu\n",
+                raw_len, parser->pos);
+        return -1;
+    }
+    if (raw_len < 4 ||
+        respb_lz4_decompress(buf + RESPB_COMPRESSED_HEADER_SIZE, comp_len,
+                             parser->inflate_buf, raw_len) != 1 ||
+        respb_read_u16(parser->inflate_buf + 2) != respb_read_u16(buf + 2)) {
+        return -1;
+    }
+
+    /* No inflate buffer: a compressed frame inside is rejected */
+    respb_parser_init(inner, parser->inflate_buf, raw_len);
+    inner->flags = parser->flags;
+    inner->keydict = parser->keydict;
+    parser->pos += RESPB_COMPRESSED_HEADER_SIZE + comp_len;
+    return 1;
+}
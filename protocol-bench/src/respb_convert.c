@@ -0,0 +1,115 @@
+/*
+ * respb-convert - RESP to RESPB file conversion
+ * Native counterpart of `respb_converter.py -i <aof> -o <respb>`
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "respb_transcode.h"
+
+static void print_usage(const char *prog_name) {
+    printf("Usage: %s [options] <input.aof> <output.respb>\n", prog_name);
+    printf("\nOptions:\n");
+    printf("  -t N           Threads (default: online CPUs)\n");
+    printf("  -c MB          Chunk size per thread (default: %d)\n",
+           RESPB_TRANSCODE_DEFAULT_CHUNK / (1024 * 1024));
+    printf("  -x FILE        Also write a frame index (checkpoint every %d commands)\n",
+           RESPB_INDEX_DEFAULT_INTERVAL);
+    printf("  -h             Show this help\n");
+    printf("\nCommands without a RESPB layout for their arguments are written as\n");
+    printf("RESP passthrough (0xFFFF) frames, so the output replays the same commands.\n");
+}
+
+int main(int argc, char **argv) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    size_t chunk_size = RESPB_TRANSCODE_DEFAULT_CHUNK;
+    const char *index_path = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "t:c:x:h")) != -1) {
+        switch (opt) {
+            case 't':
+                threads = atoi(optarg);
+                if (threads <= 0 || threads > RESPB_TRANSCODE_MAX_THREADS) {
+                    fprintf(stderr, "Invalid thread count: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'c':
+                if (atoi(optarg) <= 0) {
+                    fprintf(stderr, "Invalid chunk size: %s\n", optarg);
+                    return 1;
+                }
+                chunk_size = (size_t)atoi(optarg) * 1024 * 1024;
+                break;
+            case 'x':
+                index_path = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *in_path = argv[optind], *out_path = argv[optind + 1];
+    if (threads > RESPB_TRANSCODE_MAX_THREADS) threads = RESPB_TRANSCODE_MAX_THREADS;
+
+    respb_transcode_stats_t stats;
+    respb_index_t index;
+    respb_index_init(&index, 0);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result = respb_transcode_file(in_path, out_path, threads, chunk_size,
+                                      index_path ? &index : NULL, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (result == 0) {
+        fprintf(stderr, "ERROR: %s -> %s: %s\n", in_path, out_path, strerror(errno));
+        respb_index_free(&index);
+        return 1;
+    }
+    if (result < 0) {
+        fprintf(stderr, "ERROR: Malformed or truncated RESP command at byte %zu of %s\n",
+                stats.error_pos, in_path);
+        respb_index_free(&index);
+        return 1;
+    }
+    if (index_path && !respb_index_save(&index, index_path)) {
+        fprintf(stderr, "ERROR: %s: %s\n", index_path, strerror(errno));
+        respb_index_free(&index);
+        return 1;
+    }
+
+    printf("Input:              %s\n", in_path);
+    printf("Output:             %s\n", out_path);
+    printf("Threads:            %d (%u chunks, %u redone)\n", threads, stats.chunks, stats.resplits);
+    printf("Time elapsed:       %.3f seconds\n", elapsed);
+    printf("Commands processed: %llu (%.0f cmd/s)\n", (unsigned long long)stats.commands,
+           elapsed > 0 ? stats.commands / elapsed : 0.0);
+    printf("Passthrough frames: %llu\n", (unsigned long long)stats.passthrough);
+    printf("Total RESP size:    %llu bytes (%.2f MB)\n", (unsigned long long)stats.in_bytes,
+           stats.in_bytes / 1048576.0);
+    printf("Total RESPB size:   %llu bytes (%.2f MB)\n", (unsigned long long)stats.out_bytes,
+           stats.out_bytes / 1048576.0);
+    if (stats.in_bytes > 0) {
+        printf("Total savings:      %.1f%%\n",
+               100.0 * ((double)stats.in_bytes - (double)stats.out_bytes) / stats.in_bytes);
+    }
+    if (index_path) {
+        printf("Index:              %s (%zu checkpoints)\n", index_path, index.npoints);
+    }
+    respb_index_free(&index);
+    return 0;
+}
@@ -0,0 +1,80 @@
+/*
+ * RESPB Frame Scanner
+ * Skips over frames using the schema tables: string fields are stepped over
+ * by their length prefix and never stored
+ */
+
+#include "respb_frame.h"
+#include "respb_schema.h"
+
+int respb_peek_frame(const uint8_t *buf, size_t len, respb_frame_info_t *info) {
+    return respb_peek_frame_flags(buf, len, 0, info);
+}
+
+int respb_peek_frame_flags(const uint8_t *buf, size_t len, uint8_t flags,
+                           respb_frame_info_t *info) {
+    /* Header: [2B opcode][2B mux_id] */
+    if (len < 4) return 0;
+    uint16_t opcode = respb_read_u16(buf);
+    size_t pos = 4;
+    info->opcode = opcode;
+    info->mux_id = respb_read_u16(buf + 2);
+    info->module_subcommand = 0;
+
+    const respb_schema_t *schema;
+    if (opcode == RESPB_OP_RESP_PASSTHROUGH) {
+        /* [4B resp_length][RESP text], or a varint length */
+        uint32_t resp_length;
+        if (flags & RESPB_FLAG_VARINT) {
+            int used = respb_read_varint(buf + pos, len - pos, &resp_length);
+            if (used <= 0) return used;
+            pos += (size_t)used;
+        } else {
+            if (4 > len - pos) return 0;
+            resp_length = respb_read_u32(buf + pos);
+            pos += 4;
+        }
+        if (resp_length > len - pos) return 0;
+        info->length = pos + resp_length;
+        return 1;
+    } else if (opcode == RESPB_OP_KEY_BIND) {
+        /* [2B key ID][2B keylen][key] */
+        if (4 > len - pos) return 0;
+        uint16_t key_len = respb_read_u16(buf + pos + 2);
+        pos += 4;
+        if (key_len > len - pos) return 0;
+        info->length = pos + key_len;
+        return 1;
+    } else if (opcode == RESPB_OP_COMPRESSED) {
+        /* [4B raw_len][4B comp_len][block]: sized without inflating */
+        if (8 > len - pos) return 0;
+        uint32_t comp_len = respb_read_u32(buf + pos + 4);
+        pos += 8;
+        if (comp_len > len - pos) return 0;
+        info->length = pos + comp_len;
+        return 1;
+    } else if (opcode == RESPB_OP_MODULE) {
+        if (4 > len - pos) return 0;
+        uint32_t subcommand = respb_read_u32(buf + pos);
+        pos += 4;
+        info->module_subcommand = subcommand;
+        schema = respb_schema_lookup_module(subcommand >> 16, subcommand & 0xFFFF);
+    } else {
+        schema = respb_schema_lookup(opcode);
+    }
+    if (!schema) return -1;
+
+    /* max_args = 0: the decoder only walks the length prefixes and key IDs */
+    size_t argc;
+    int result = respb_schema_decode_flags(schema, flags, buf, len, &pos, NULL, 0, &argc);
+    if (result != 1) return result;
+    info->length = pos;
+    return 1;
+}
+
+int respb_frame_length(const uint8_t *buf, size_t len, size_t *frame_len) {
+    respb_frame_info_t info;
+    int result = respb_peek_frame(buf, len, &info);
+    if (result == 1) *frame_len = info.length;
+    return result;
+}
@@ -0,0 +1,92 @@
+/*
+ * RESPB Handshake
+ * Server-side detection and upgrade state machine, client-side hello and
+ * acknowledgment
+ */
+
+#include "respb_handshake.h"
+#include <string.h>
+
+void respb_handshake_init(respb_handshake_t *hs, uint8_t supported) {
+    memset(hs, 0, sizeof(*hs));
+    hs->supported = supported & RESPB_FLAGS_SUPPORTED;
+}
+
+static int refuse(respb_handshake_t *hs, uint8_t *reply, size_t *reply_len) {
+    hs->state = RESPB_HS_FAILED;
+    memcpy(reply, RESPB_HANDSHAKE_ERROR, sizeof(RESPB_HANDSHAKE_ERROR) - 1);
+    *reply_len = sizeof(RESPB_HANDSHAKE_ERROR) - 1;
+    return -1;
+}
+
+int respb_handshake_feed(respb_handshake_t *hs, const uint8_t *data, size_t len,
+                         size_t *consumed, uint8_t *reply, size_t *reply_len) {
+    *consumed = 0;
+    *reply_len = 0;
+    switch (hs->state) {
+        case RESPB_HS_RESP:
+        case RESPB_HS_RESPB:
+            return 1;
+        case RESPB_HS_FAILED:
+            return -1;
+        case RESPB_HS_DETECT:
+            if (len == 0) return 0;
+            if (data[0] != RESPB_MAGIC_0) {
+                hs->state = RESPB_HS_RESP;
+                return 1;
+            }
+            hs->state = RESPB_HS_HELLO;
+            break;
+        case RESPB_HS_HELLO:
+            break;
+    }
+
+    /* Usually the whole hello is in data; otherwise collect it in hs */
+    const uint8_t *hello = data;
+    if (hs->have > 0 || len < RESPB_HANDSHAKE_SIZE) {
+        size_t take = RESPB_HANDSHAKE_SIZE - hs->have;
+        if (take > len) take = len;
+        memcpy(hs->hello + hs->have, data, take);
+        hs->have += (uint8_t)take;
+        *consumed = take;
+        if (hs->have >= 2 && respb_detect_protocol(hs->hello, hs->have) != RESPB_PROTO_RESPB) {
+            return refuse(hs, reply, reply_len);
+        }
+        if (hs->have < RESPB_HANDSHAKE_SIZE) return 0;
+        hello = hs->hello;
+    } else {
+        if (hello[1] != RESPB_MAGIC_1) return refuse(hs, reply, reply_len);
+        *consumed = RESPB_HANDSHAKE_SIZE;
+    }
+
+    /* The client already encodes with every flag it asked for */
+    uint8_t flags = hello[3];
+    hs->version = hello[2];
+    if (hs->version != RESPB_VERSION || (flags & ~hs->supported & RESPB_FLAGS_ENCODING) ||
+        (flags & ~RESPB_FLAGS_SUPPORTED) ||
+        (flags & RESPB_FLAG_VARINT && flags & RESPB_FLAG_KEYDICT)) {
+        return refuse(hs, reply, reply_len);
+    }
+    hs->flags = flags & hs->supported;
+    hs->state = RESPB_HS_RESPB;
+    *reply_len = respb_write_handshake(reply, RESPB_VERSION, hs->flags);
+    return 1;
+}
+
+size_t respb_write_handshake(uint8_t *buf, uint8_t version, uint8_t flags) {
+    buf[0] = RESPB_MAGIC_0;
+    buf[1] = RESPB_MAGIC_1;
+    buf[2] = version;
+    buf[3] = flags;
+    return RESPB_HANDSHAKE_SIZE;
+}
+
+int respb_read_handshake_ack(const uint8_t *data, size_t len, uint8_t *flags) {
+    respb_protocol_t proto = respb_detect_protocol(data, len);
+    if (proto == RESPB_PROTO_UNKNOWN) return 0;
+    if (proto != RESPB_PROTO_RESPB) return -1;
+    if (len < RESPB_HANDSHAKE_SIZE) return 0;
+    if (data[2] != RESPB_VERSION) return -1;
+    *flags = data[3];
+    return 1;
+}
@@ -0,0 +1,274 @@
+/*
+ * RESPB Frame Index
+ * Checkpoints every interval frames while blocks are appended, with the
+ * open interval's histogram counted in a dense opcode table
+ */
+
+#include "respb_index.h"
+#include "respb_frame.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define INDEX_MAGIC         "RESPBIDX"
+#define INDEX_HEADER_SIZE   40
+#define INDEX_POINT_SIZE    20
+#define INDEX_COUNT_SIZE    6
+
+void respb_index_init(respb_index_t *idx, uint32_t interval) {
+    memset(idx, 0, sizeof(*idx));
+    idx->interval = interval ? interval : RESPB_INDEX_DEFAULT_INTERVAL;
+}
+
+void respb_index_free(respb_index_t *idx) {
+    free(idx->points);
+    free(idx->counts);
+    free(idx->pending);
+    free(idx->seen);
+    respb_index_init(idx, idx->interval);
+}
+
+static int grow(void **array, size_t *cap, size_t need, size_t size) {
+    if (need <= *cap) return 1;
+    size_t n = *cap ? *cap * 2 : 64;
+    while (n < need) n *= 2;
+    void *grown = realloc(*array, n * size);
+    if (!grown) return 0;
+    *array = grown;
+    *cap = n;
+    return 1;
+}
+
+/* Move the last interval's histogram into counts, closing it */
+static int close_interval(respb_index_t *idx) {
+    if (idx->npoints == 0) return 1;
+    if (!grow((void **)&idx->counts, &idx->counts_cap, idx->ncounts + idx->nseen,
+              sizeof(*idx->counts))) {
+        return 0;
+    }
+    respb_index_point_t *p = &idx->points[idx->npoints - 1];
+    p->hist = (uint32_t)idx->ncounts;
+    p->nhist = (uint32_t)idx->nseen;
+    for (size_t i = 0; i < idx->nseen; i++) {
+        uint16_t op = idx->seen[i];
+        idx->counts[idx->ncounts++] = (respb_index_count_t){op, idx->pending[op]};
+        idx->pending[op] = 0;
+    }
+    idx->nseen = 0;
+    return 1;
+}
+
+/* Open the last interval again: after a load, its counts are the tail of
+ * counts and move back to pending */
+static int open_interval(respb_index_t *idx) {
+    idx->pending = calloc(0x10000, sizeof(*idx->pending));
+    idx->seen = malloc(0x10000 * sizeof(*idx->seen));
+    if (!idx->pending || !idx->seen) {
+        free(idx->pending);
+        free(idx->seen);
+        idx->pending = NULL;
+        idx->seen = NULL;
+        return 0;
+    }
+    if (idx->npoints > 0) {
+        respb_index_point_t *p = &idx->points[idx->npoints - 1];
+        for (uint32_t i = 0; i < p->nhist; i++) {
+            const respb_index_count_t *c = &idx->counts[p->hist + i];
+            idx->pending[c->opcode] = c->count;
+            idx->seen[idx->nseen++] = c->opcode;
+        }
+        idx->ncounts = p->hist;
+        p->nhist = 0;
+    }
+    return 1;
+}
+
+int respb_index_append(respb_index_t *idx, const uint8_t *data, size_t len) {
+    if (!idx->pending && !open_interval(idx)) return 0;
+    size_t pos = 0;
+    while (pos < len) {
+        size_t frame_len;
+        if (respb_frame_length(data + pos, len - pos, &frame_len) != 1) return -1;
+        if (idx->commands % idx->interval == 0) {
+            if (!close_interval(idx) ||
+                !grow((void **)&idx->points, &idx->points_cap, idx->npoints + 1, sizeof(*idx->points))) {
+                return 0;
+            }
+            idx->points[idx->npoints++] = (respb_index_point_t){idx->commands, idx->bytes, 0, 0};
+        }
+        uint16_t op = respb_read_u16(data + pos);
+        if (idx->pending[op]++ == 0) idx->seen[idx->nseen++] = op;
+        idx->commands++;
+        idx->bytes += frame_len;
+        pos += frame_len;
+    }
+    return 1;
+}
+
+int respb_index_seek(const respb_index_t *idx, const uint8_t *data, size_t len,
+                     uint64_t ordinal, size_t *offset) {
+    /* Last checkpoint at or before ordinal */
+    uint64_t at = 0, pos = 0;
+    size_t lo = 0, hi = idx->npoints;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (idx->points[mid].ordinal <= ordinal) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo > 0) {
+        at = idx->points[lo - 1].ordinal;
+        pos = idx->points[lo - 1].offset;
+    }
+    if (pos > len) return 0;
+    for (; at < ordinal; at++) {
+        size_t frame_len;
+        int r = respb_frame_length(data + pos, len - pos, &frame_len);
+        if (r != 1) return r == 0 && pos == len ? 0 : -1;
+        pos += frame_len;
+    }
+    if (pos == len) return 0;
+    *offset = (size_t)pos;
+    return 1;
+}
+
+size_t respb_index_split(const respb_index_t *idx, size_t nparts, uint64_t *offsets) {
+    size_t n = 0, p = 0;
+    offsets[0] = 0;
+    if (idx->bytes == 0) return 0;
+    for (size_t k = 1; k < nparts; k++) {
+        /* Last checkpoint at or before the even cut */
+        uint64_t target = idx->bytes / nparts * k;
+        while (p + 1 < idx->npoints && idx->points[p + 1].offset <= target) p++;
+        if (p < idx->npoints && idx->points[p].offset > offsets[n]) offsets[++n] = idx->points[p].offset;
+    }
+    offsets[++n] = idx->bytes;
+    return n;
+}
+
+uint64_t respb_index_count(const respb_index_t *idx, uint16_t opcode, size_t first, size_t last) {
+    uint64_t total = 0;
+    if (last > idx->npoints) last = idx->npoints;
+    for (size_t i = first; i < last; i++) {
+        if (i == idx->npoints - 1 && idx->pending) {
+            total += idx->pending[opcode];
+            continue;
+        }
+        const respb_index_point_t *p = &idx->points[i];
+        for (uint32_t j = 0; j < p->nhist; j++) {
+            if (idx->counts[p->hist + j].opcode == opcode) total += idx->counts[p->hist + j].count;
+        }
+    }
+    return total;
+}
+
+static int write_index(const respb_index_t *idx, FILE *f) {
+    /* The open interval's counts follow the closed ones */
+    size_t open = idx->pending && idx->npoints > 0 ? idx->nseen : 0;
+    uint8_t buf[INDEX_HEADER_SIZE];
+    memcpy(buf, INDEX_MAGIC, 8);
+    respb_write_u32(buf + 8, RESPB_INDEX_VERSION);
+    respb_write_u32(buf + 12, idx->interval);
+    respb_write_u64(buf + 16, idx->commands);
+    respb_write_u64(buf + 24, idx->bytes);
+    respb_write_u32(buf + 32, (uint32_t)idx->npoints);
+    respb_write_u32(buf + 36, (uint32_t)(idx->ncounts + open));
+    if (fwrite(buf, 1, INDEX_HEADER_SIZE, f) != INDEX_HEADER_SIZE) return 0;
+    for (size_t i = 0; i < idx->npoints; i++) {
+        const respb_index_point_t *p = &idx->points[i];
+        respb_write_u64(buf, p->ordinal);
+        respb_write_u64(buf + 8, p->offset);
+        respb_write_u32(buf + 16, i == idx->npoints - 1 && open ? (uint32_t)open : p->nhist);
+        if (fwrite(buf, 1, INDEX_POINT_SIZE, f) != INDEX_POINT_SIZE) return 0;
+    }
+    for (size_t i = 0; i < idx->ncounts + open; i++) {
+        respb_index_count_t c = i < idx->ncounts
+            ? idx->counts[i]
+            : (respb_index_count_t){idx->seen[i - idx->ncounts], idx->pending[idx->seen[i - idx->ncounts]]};
+        respb_write_u16(buf, c.opcode);
+        respb_write_u32(buf + 2, c.count);
+        if (fwrite(buf, 1, INDEX_COUNT_SIZE, f) != INDEX_COUNT_SIZE) return 0;
+    }
+    return 1;
+}
+
+int respb_index_save(const respb_index_t *idx, const char *path) {
+    char tmp[4096];
+    if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) {
+        errno = ENAMETOOLONG;
+        return 0;
+    }
+    FILE *f = fopen(tmp, "wb");
+    if (!f) return 0;
+    int ok = write_index(idx, f);
+    if (fclose(f) != 0) ok = 0;
+    if (ok && rename(tmp, path) != 0) ok = 0;
+    if (!ok) {
+        int saved = errno;
+        remove(tmp);
+        errno = saved;
+    }
+    return ok;
+}
+
+int respb_index_load(respb_index_t *idx, const char *path) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return 0;
+    uint8_t buf[INDEX_HEADER_SIZE];
+    int result = -1;
+    respb_index_free(idx);
+    if (fread(buf, 1, INDEX_HEADER_SIZE, f) != INDEX_HEADER_SIZE ||
+        memcmp(buf, INDEX_MAGIC, 8) != 0 || respb_read_u32(buf + 8) != RESPB_INDEX_VERSION ||
+        respb_read_u32(buf + 12) == 0) {
+        goto done;
+    }
+    idx->interval = respb_read_u32(buf + 12);
+    idx->commands = respb_read_u64(buf + 16);
+    idx->bytes = respb_read_u64(buf + 24);
+    size_t npoints = respb_read_u32(buf + 32), ncounts = respb_read_u32(buf + 36);
+    if (npoints != (idx->commands + idx->interval - 1) / idx->interval) goto done;
+    if (!grow((void **)&idx->points, &idx->points_cap, npoints, sizeof(*idx->points)) ||
+        !grow((void **)&idx->counts, &idx->counts_cap, ncounts, sizeof(*idx->counts))) {
+        result = 0;
+        goto done;
+    }
+    /* Points must be checkpoints of one file, in order, and their counts
+     * must add up to the intervals they describe */
+    size_t hist = 0;
+    for (size_t i = 0; i < npoints; i++) {
+        if (fread(buf, 1, INDEX_POINT_SIZE, f) != INDEX_POINT_SIZE) goto done;
+        respb_index_point_t *p = &idx->points[i];
+        p->ordinal = respb_read_u64(buf);
+        p->offset = respb_read_u64(buf + 8);
+        p->nhist = respb_read_u32(buf + 16);
+        p->hist = (uint32_t)hist;
+        hist += p->nhist;
+        if (p->ordinal != (uint64_t)i * idx->interval || p->offset >= idx->bytes ||
+            (i > 0 && p->offset <= idx->points[i - 1].offset) || hist > ncounts) {
+            goto done;
+        }
+    }
+    if (hist != ncounts) goto done;
+    for (size_t i = 0; i < ncounts; i++) {
+        if (fread(buf, 1, INDEX_COUNT_SIZE, f) != INDEX_COUNT_SIZE) goto done;
+        idx->counts[i].opcode = respb_read_u16(buf);
+        idx->counts[i].count = respb_read_u32(buf + 2);
+    }
+    for (size_t i = 0; i < npoints; i++) {
+        uint64_t in_interval = (i + 1 < npoints ? idx->points[i + 1].ordinal : idx->commands) -
+                               idx->points[i].ordinal, sum = 0;
+        for (uint32_t j = 0; j < idx->points[i].nhist; j++) sum += idx->counts[idx->points[i].hist + j].count;
+        if (sum != in_interval) goto done;
+    }
+    idx->npoints = npoints;
+    idx->ncounts = ncounts;
+    result = 1;
+done:
+    if (result == -1 && ferror(f)) result = 0;
+    fclose(f);
+    if (result != 1) respb_index_free(idx);
+    return result;
+}
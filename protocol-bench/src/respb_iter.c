@@ -0,0 +1,184 @@
+/*
+ * RESPB Argument Iterator
+ * Decodes and bounds-checks fields on demand, so consumers that stop
+ * early never touch the rest of the frame
+ */
+
+#include "respb_iter.h"
+#include <string.h>
+
+int respb_arg_iter_init(respb_arg_iter_t *it, const uint8_t *buf, size_t len) {
+    /* Header: [2B opcode][2B mux_id] */
+    if (len < 4) return 0;
+    it->buf = buf;
+    it->opcode = respb_read_u16(buf);
+    it->mux_id = respb_read_u16(buf + 2);
+    it->module_subcommand = 0;
+    it->group_start = NULL;
+    it->group_end = NULL;
+    it->group_left = 0;
+    it->last_u8 = 0;
+    size_t pos = 4;
+
+    if (it->opcode == RESPB_OP_RESP_PASSTHROUGH) {
+        if (4 > len - pos) return 0;
+        uint32_t resp_length = respb_read_u32(buf + pos);
+        pos += 4;
+        if (resp_length > len - pos) return 0;
+        it->schema = NULL;
+        it->field = NULL;
+        it->fields_end = NULL;
+        it->pos = pos;
+        it->end = pos + resp_length;
+        return 1;
+    }
+
+    const respb_schema_t *schema;
+    if (it->opcode == RESPB_OP_MODULE) {
+        if (4 > len - pos) return 0;
+        it->module_subcommand = respb_read_u32(buf + pos);
+        pos += 4;
+        schema = respb_schema_lookup_module(it->module_subcommand >> 16,
+                                            it->module_subcommand & 0xFFFF);
+    } else {
+        schema = respb_schema_lookup(it->opcode);
+    }
+    if (!schema) return -1;
+
+    it->schema = schema;
+    it->field = schema->fields;
+    it->fields_end = it->field + schema->nfields;
+    it->pos = pos;
+    it->end = len;
+    return 1;
+}
+
+int respb_arg_iter_next(respb_arg_iter_t *it, respb_value_t *value) {
+    const uint8_t *buf = it->buf;
+    size_t pos = it->pos;
+    size_t avail = it->end - pos;
+
+    if (!it->schema) {
+        if (avail == 0) return 0;
+        value->kind = RESPB_FIELD_STR4;
+        value->str.data = buf + pos;
+        value->str.len = avail;
+        it->pos = it->end;
+        return 1;
+    }
+
+    /* Cursor state lives in locals and is written back once per field */
+    const respb_field_t *f = it->field;
+    const respb_field_t *end = it->fields_end;
+    int result = 0;
+
+/* Step past the current descriptor, looping back while a group has repeats left */
+#define ADVANCE() do { \
+    f++; \
+    if (f == it->group_end && --it->group_left) f = it->group_start; \
+} while (0)
+
+    while (f != end) {
+        switch (f->kind) {
+            case RESPB_FIELD_STR2: {
+                if (2 > avail) goto truncated;
+                uint16_t n = respb_read_u16(buf + pos);
+                if (n > avail - 2) goto truncated;
+                value->str.data = buf + pos + 2;
+                value->str.len = n;
+                pos += 2 + (size_t)n;
+                break;
+            }
+            case RESPB_FIELD_STR4: {
+                if (4 > avail) goto truncated;
+                uint32_t n = respb_read_u32(buf + pos);
+                if (n > avail - 4) goto truncated;
+                value->str.data = buf + pos + 4;
+                value->str.len = n;
+                pos += 4 + (size_t)n;
+                break;
+            }
+            case RESPB_FIELD_U8:
+                if (1 > avail) goto truncated;
+                it->last_u8 = buf[pos];
+                value->u = buf[pos];
+                pos += 1;
+                break;
+            case RESPB_FIELD_U16:
+                if (2 > avail) goto truncated;
+                value->u = respb_read_u16(buf + pos);
+                pos += 2;
+                break;
+            case RESPB_FIELD_I64:
+                if (8 > avail) goto truncated;
+                value->i = (int64_t)respb_read_u64(buf + pos);
+                pos += 8;
+                break;
+            case RESPB_FIELD_F64: {
+                if (8 > avail) goto truncated;
+                uint64_t bits = respb_read_u64(buf + pos);
+                memcpy(&value->f, &bits, sizeof(bits));
+                pos += 8;
+                break;
+            }
+            case RESPB_FIELD_GROUP: {
+                if (2 > avail) goto truncated;
+                uint16_t count = respb_read_u16(buf + pos);
+                pos += 2;
+                avail -= 2;
+                if (count == 0) {
+                    f += f->arg; /* land on the last body field */
+                    ADVANCE();
+                } else {
+                    it->group_start = f + 1;
+                    it->group_end = it->group_start + f->arg;
+                    it->group_left = count;
+                    f = it->group_start;
+                }
+                continue;
+            }
+            case RESPB_FIELD_OPT:
+                if (!(it->last_u8 & f->arg)) f++; /* skip the gated field */
+                ADVANCE();
+                continue;
+            default:
+                goto truncated;
+        }
+        value->kind = f->kind;
+        ADVANCE();
+        result = 1;
+        break;
+    }
+
+#undef ADVANCE
+
+    it->field = f;
+    it->pos = pos;
+    return result;
+
+truncated:
+    it->field = f;
+    it->pos = pos;
+    return -1;
+}
+
+int respb_arg_iter_next_str(respb_arg_iter_t *it, respb_arg_t *arg) {
+    respb_value_t value;
+    int result;
+    while ((result = respb_arg_iter_next(it, &value)) == 1) {
+        if (value.kind == RESPB_FIELD_STR2 || value.kind == RESPB_FIELD_STR4) {
+            *arg = value.str;
+            return 1;
+        }
+    }
+    return result;
+}
+
+int respb_arg_iter_finish(respb_arg_iter_t *it, size_t *frame_len) {
+    respb_value_t value;
+    int result;
+    while ((result = respb_arg_iter_next(it, &value)) == 1) {}
+    if (result < 0) return 0;
+    *frame_len = it->pos;
+    return 1;
+}
@@ -0,0 +1,139 @@
+/*
+ * RESPB Key Dictionary
+ * ID -> key arrays for the receiver, plus a linear-probing key -> ID index
+ * the sender uses to decide which keys go out as references
+ */
+
+#include "respb_keydict.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* FNV-1a; keys are case-sensitive, unlike command names */
+static uint32_t key_hash(const uint8_t *key, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) h = (h ^ key[i]) * 16777619u;
+    return h;
+}
+
+int respb_keydict_init(respb_keydict_t *d, uint32_t capacity, size_t max_bytes) {
+    if (capacity > RESPB_KEYDICT_MAX_IDS) capacity = RESPB_KEYDICT_MAX_IDS;
+    uint32_t slots = 16;
+    while (slots < capacity * 2) slots *= 2;
+    d->offsets = malloc(capacity * sizeof(*d->offsets));
+    d->lens = malloc(capacity * sizeof(*d->lens));
+    d->bytes = malloc(max_bytes ? max_bytes : 1);
+    d->slots = malloc(slots * sizeof(*d->slots));
+    d->capacity = capacity;
+    d->bytes_cap = max_bytes;
+    d->slot_mask = slots - 1;
+    if (!d->offsets || !d->lens || !d->bytes || !d->slots) {
+        respb_keydict_free(d);
+        return 0;
+    }
+    respb_keydict_reset(d);
+    return 1;
+}
+
+void respb_keydict_free(respb_keydict_t *d) {
+    free(d->offsets);
+    free(d->lens);
+    free(d->bytes);
+    free(d->slots);
+    memset(d, 0, sizeof(*d));
+}
+
+void respb_keydict_reset(respb_keydict_t *d) {
+    memset(d->offsets, 0xFF, d->capacity * sizeof(*d->offsets));
+    memset(d->slots, 0, ((size_t)d->slot_mask + 1) * sizeof(*d->slots));
+    d->count = 0;
+    d->bytes_used = 0;
+    d->bytes_live = 0;
+}
+
+static uint32_t id_hash(const respb_keydict_t *d, uint32_t id) {
+    return key_hash(d->bytes + d->offsets[id], d->lens[id]);
+}
+
+/* Drop id from the index, shifting later entries of its probe run back */
+static void index_remove(respb_keydict_t *d, uint32_t id) {
+    uint32_t i = id_hash(d, id) & d->slot_mask;
+    while (d->slots[i] != id + 1) i = (i + 1) & d->slot_mask;
+    for (uint32_t j = i;;) {
+        j = (j + 1) & d->slot_mask;
+        if (!d->slots[j]) break;
+        uint32_t home = id_hash(d, d->slots[j] - 1) & d->slot_mask;
+        /* Move j into the hole unless its home lies cyclically in (i, j] */
+        if ((j > i && (home <= i || home > j)) || (j < i && home <= i && home > j)) {
+            d->slots[i] = d->slots[j];
+            i = j;
+        }
+    }
+    d->slots[i] = 0;
+}
+
+/* Move the bound keys to fresh, leaving out the bytes of replaced ones */
+static void compact_bytes(respb_keydict_t *d, uint8_t *fresh) {
+    size_t used = 0;
+    for (uint32_t id = 0; id < d->capacity; id++) {
+        if (d->offsets[id] == UINT32_MAX) continue;
+        memcpy(fresh + used, d->bytes + d->offsets[id], d->lens[id]);
+        d->offsets[id] = (uint32_t)used;
+        used += d->lens[id];
+    }
+    free(d->bytes);
+    d->bytes = fresh;
+    d->bytes_used = used;
+}
+
+int respb_keydict_bind(respb_keydict_t *d, uint32_t id, const uint8_t *key, size_t len) {
+    if (id >= d->capacity || len > 0xFFFF) return -1;
+    int bound = d->offsets[id] != UINT32_MAX;
+    if (bound && d->lens[id] == len && memcmp(d->bytes + d->offsets[id], key, len) == 0) {
+        return 1;
+    }
+    size_t live = d->bytes_live - (bound ? d->lens[id] : 0);
+    if (len > d->bytes_cap - live) return -1;
+
+    /* Out of room at the end: compact, once the new buffer is certain */
+    uint8_t *fresh = NULL;
+    if (len > d->bytes_cap - d->bytes_used) {
+        fresh = malloc(d->bytes_cap);
+        if (!fresh) return -1;
+    }
+    if (bound) {
+        index_remove(d, id);
+        d->offsets[id] = UINT32_MAX;
+    } else {
+        d->count++;
+    }
+    if (fresh) compact_bytes(d, fresh);
+    memcpy(d->bytes + d->bytes_used, key, len);
+    d->offsets[id] = (uint32_t)d->bytes_used;
+    d->lens[id] = (uint16_t)len;
+    d->bytes_used += len;
+    d->bytes_live = live + len;
+
+    uint32_t i = key_hash(key, len) & d->slot_mask;
+    while (d->slots[i]) i = (i + 1) & d->slot_mask;
+    d->slots[i] = id + 1;
+    return 1;
+}
+
+int respb_keydict_find(const respb_keydict_t *d, const uint8_t *key, size_t len) {
+    if (d->count == 0) return -1;
+    for (uint32_t i = key_hash(key, len) & d->slot_mask; d->slots[i]; i = (i + 1) & d->slot_mask) {
+        uint32_t id = d->slots[i] - 1;
+        if (d->lens[id] == len && memcmp(d->bytes + d->offsets[id], key, len) == 0) return (int)id;
+    }
+    return -1;
+}
+
+size_t respb_serialize_key_bind(uint8_t *buf, size_t buf_len, uint16_t mux_id, uint16_t id,
+                                const uint8_t *key, size_t len) {
+    if (len > 0xFFFF || buf_len < 8 || len > buf_len - 8) return 0;
+    size_t pos = respb_serialize_header(buf, RESPB_OP_KEY_BIND, mux_id);
+    respb_write_u16(buf + pos, id);
+    respb_write_u16(buf + pos + 2, (uint16_t)len);
+    memcpy(buf + pos + 4, key, len);
+    return pos + 4 + len;
+}
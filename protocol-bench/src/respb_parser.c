@@ -5,6 +5,8 @@
  */
 
 #include "respb.h"
+#include "respb_schema.h"
+#include "respb_compress.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -52,10 +54,53 @@ static inline uint64_t read_u64_be(const uint8_t *buf) {
     (parser)->pos += len; \
 } while(0)
 
+/* Macros to read fixed-width numeric fields into cmd->view */
+#define READ_U8(parser, dst) do { \
+    CHECK_AVAIL(parser, 1); \
+    (dst) = (parser)->buffer[(parser)->pos]; \
+    (parser)->pos += 1; \
+} while(0)
+
+#define READ_U16(parser, dst) do { \
+    CHECK_AVAIL(parser, 2); \
+    (dst) = read_u16_be((parser)->buffer + (parser)->pos); \
+    (parser)->pos += 2; \
+} while(0)
+
+#define READ_I64(parser, dst) do { \
+    CHECK_AVAIL(parser, 8); \
+    (dst) = (int64_t)read_u64_be((parser)->buffer + (parser)->pos); \
+    (parser)->pos += 8; \
+} while(0)
+
+#define READ_F64(parser, dst) do { \
+    CHECK_AVAIL(parser, 8); \
+    (dst) = respb_read_f64((parser)->buffer + (parser)->pos); \
+    (parser)->pos += 8; \
+} while(0)
+
+/* Destination for repeated argument i: spans past RESPB_MAX_ARGS land in a
+ * scratch slot so the rest of the frame is still consumed */
+#define ARG_SLOT(cmd, i) \
+    ((size_t)(i) < RESPB_MAX_ARGS ? &(cmd)->args[i] : &overflow_arg)
+
+/* True while the registry still maps the command to its generated schema */
+static inline int is_generated_module_schema(const respb_command_t *cmd,
+                                             const respb_schema_t *schema) {
+    if (cmd->module_id >= RESPB_SCHEMA_MODULE_LIMIT) return 0;
+    const respb_schema_module_t *generated = &respb_schema_modules[cmd->module_id];
+    return cmd->command_id < generated->count &&
+           generated->commands[cmd->command_id] == schema;
+}
+
 void respb_parser_init(respb_parser_t *parser, const uint8_t *buf, size_t len) {
     parser->buffer = buf;
     parser->buffer_len = len;
     parser->pos = 0;
+    parser->flags = 0;
+    parser->inflate_buf = NULL;
+    parser->inflate_cap = 0;
+    parser->keydict = NULL;
 }
 
 int respb_parse_header(respb_parser_t *parser, uint16_t *opcode, uint16_t *mux_id) {
@@ -66,6 +111,14 @@ int respb_parse_header(respb_parser_t *parser, uint16_t *opcode, uint16_t *mux_i
 }
 
 int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
+    respb_arg_t overflow_arg;
+    
+    /* Varint lengths and key references are decoded by the schema
+     * interpreter only; the cases below assume plain fixed-width prefixes */
+    if (parser->flags & (RESPB_FLAG_VARINT | RESPB_FLAG_KEYDICT)) {
+        return respb_parse_command_table(parser, cmd);
+    }
+    
     /* Read header (minimum 4 bytes: opcode + mux_id) */
     CHECK_AVAIL(parser, 4);
     
@@ -93,8 +146,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_SET:      /* [2B keylen][key][4B vallen][value][1B flags][8B expiry] */
             READ_STRING_2B(parser, &cmd->args[0]); /* key */
             READ_STRING_4B(parser, &cmd->args[1]); /* value */
-            CHECK_AVAIL(parser, 9); /* flags + expiry */
-            parser->pos += 9;
+            READ_U8(parser, cmd->view.set.flags);
+            READ_I64(parser, cmd->view.set.expiry);
             cmd->argc = 2;
             break;
             
@@ -108,19 +161,16 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_INCRBY:   /* [2B keylen][key][8B increment] */
         case RESPB_OP_DECRBY:
             READ_STRING_2B(parser, &cmd->args[0]); /* key */
-            CHECK_AVAIL(parser, 8); /* integer */
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.incr.increment);
             cmd->argc = 1;
             break;
             
         case RESPB_OP_GETEX:    /* [2B keylen][key][1B flags][8B expiry?] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 1);
-            uint8_t flags = parser->buffer[parser->pos];
-            parser->pos += 1;
-            if (flags & 0x01) { /* Has expiry */
-                CHECK_AVAIL(parser, 8);
-                parser->pos += 8;
+            READ_U8(parser, cmd->view.set.flags);
+            cmd->view.set.expiry = 0;
+            if (cmd->view.set.flags & 0x01) { /* Has expiry */
+                READ_I64(parser, cmd->view.set.expiry);
             }
             cmd->argc = 1;
             break;
@@ -128,8 +178,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_GETRANGE: /* [2B keylen][key][8B start][8B end] */
         case RESPB_OP_SUBSTR:
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 16);
-            parser->pos += 16;
+            READ_I64(parser, cmd->view.range.start);
+            READ_I64(parser, cmd->view.range.stop);
             cmd->argc = 1;
             break;
             
@@ -141,8 +191,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_INCRBYFLOAT: /* [2B keylen][key][8B float] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_F64(parser, cmd->view.incrbyfloat.increment);
             cmd->argc = 1;
             break;
             
@@ -150,9 +199,9 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i * 2 + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i * 2]);
-                READ_STRING_4B(parser, &cmd->args[i * 2 + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i * 2));
+                READ_STRING_4B(parser, ARG_SLOT(cmd, i * 2 + 1));
             }
             cmd->argc = (count < RESPB_MAX_ARGS / 2 ? count * 2 : RESPB_MAX_ARGS);
             break;
@@ -161,16 +210,14 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_PSETEX:   /* [2B keylen][key][8B millis][4B vallen][value] */
         case RESPB_OP_SETEX:    /* [2B keylen][key][8B seconds][4B vallen][value] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.setex.ttl);
             READ_STRING_4B(parser, &cmd->args[1]);
             cmd->argc = 2;
             break;
             
         case RESPB_OP_SETRANGE: /* [2B keylen][key][8B offset][4B vallen][value] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.index.value);
             READ_STRING_4B(parser, &cmd->args[1]);
             cmd->argc = 2;
             break;
@@ -191,8 +238,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_EXPIRE:   /* [2B keylen][key][8B seconds][1B flags] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 9);
-            parser->pos += 9;
+            READ_I64(parser, cmd->view.expire.time);
+            READ_U8(parser, cmd->view.expire.flags);
             cmd->argc = 1;
             break;
             
@@ -203,8 +250,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
@@ -214,9 +261,9 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i * 2 + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i * 2]);     /* key */
-                READ_STRING_4B(parser, &cmd->args[i * 2 + 1]); /* value */
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i * 2));     /* key */
+                READ_STRING_4B(parser, ARG_SLOT(cmd, i * 2 + 1)); /* value */
             }
             cmd->argc = (count < RESPB_MAX_ARGS / 2 ? count * 2 : RESPB_MAX_ARGS);
             break;
@@ -230,8 +277,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -240,7 +287,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_LPOP:     /* [2B keylen][key][2B count?] */
         case RESPB_OP_RPOP:
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Optional count field - simplified, just parse key */
+            /* Optional count is not encoded */
             cmd->argc = 1;
             break;
             
@@ -251,39 +298,36 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_LRANGE: {  /* [2B keylen][key][8B start][8B stop] */
             READ_STRING_2B(parser, &cmd->args[0]); /* key */
-            CHECK_AVAIL(parser, 16); /* start + stop */
-            parser->pos += 16;
+            READ_I64(parser, cmd->view.range.start);
+            READ_I64(parser, cmd->view.range.stop);
             cmd->argc = 1;
             break;
         }
         
         case RESPB_OP_LINDEX:   /* [2B keylen][key][8B index] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.index.value);
             cmd->argc = 1;
             break;
             
         case RESPB_OP_LSET:     /* [2B keylen][key][8B index][2B elemlen][elem] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.index.value);
             READ_STRING_2B(parser, &cmd->args[1]);
             cmd->argc = 2;
             break;
             
         case RESPB_OP_LREM:     /* [2B keylen][key][8B count][2B elemlen][elem] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.index.value);
             READ_STRING_2B(parser, &cmd->args[1]);
             cmd->argc = 2;
             break;
             
         case RESPB_OP_LTRIM:    /* [2B keylen][key][8B start][8B stop] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 16);
-            parser->pos += 16;
+            READ_I64(parser, cmd->view.range.start);
+            READ_I64(parser, cmd->view.range.stop);
             cmd->argc = 1;
             break;
             
@@ -302,8 +346,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -326,27 +370,26 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_BRPOPLPUSH: /* [2B srclen][src][2B dstlen][dst][8B timeout] */
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.timeout.timeout);
             cmd->argc = 2;
             break;
             
         case RESPB_OP_BLMOVE:    /* [2B srclen][src][2B dstlen][dst][1B wherefrom][1B whereto][8B timeout] */
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
-            CHECK_AVAIL(parser, 10);
-            parser->pos += 10;
+            CHECK_AVAIL(parser, 2);
+            parser->pos += 2; /* wherefrom + whereto */
+            READ_I64(parser, cmd->view.timeout.timeout);
             cmd->argc = 2;
             break;
             
         case RESPB_OP_BLMPOP:    /* [8B timeout][2B numkeys]([2B keylen][key])...[1B left_right][2B count?] */
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8; /* timeout */
+            READ_I64(parser, cmd->view.timeout.timeout);
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             CHECK_AVAIL(parser, 1);
             parser->pos += 1;
@@ -357,8 +400,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             CHECK_AVAIL(parser, 1);
             parser->pos += 1;
@@ -369,7 +412,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_LPOS:     /* [2B keylen][key][2B elemlen][elem][8B rank?][2B count?][8B maxlen?] */
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
-            /* Optional fields - simplified */
+            /* Optional fields are not encoded */
             cmd->argc = 2;
             break;
             
@@ -378,11 +421,10 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.timeout.timeout);
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
         }
@@ -394,8 +436,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -406,8 +448,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -428,7 +470,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_SRANDMEMBER: /* [2B keylen][key][8B count?] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Optional count - simplified */
+            /* Optional count is not encoded */
             cmd->argc = 1;
             break;
             
@@ -439,8 +481,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
@@ -453,8 +495,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -469,9 +511,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_SSCAN:    /* [2B keylen][key][8B cursor][2B patternlen?][pattern?][8B count?] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
-            /* Optional fields - simplified */
+            READ_I64(parser, cmd->view.scan.cursor);
+            /* Optional pattern/count are not encoded */
             cmd->argc = 1;
             break;
             
@@ -480,8 +521,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -494,9 +535,9 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t npairs = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < npairs && i * 2 + 2 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i * 2 + 1]);     /* field */
-                READ_STRING_4B(parser, &cmd->args[i * 2 + 2]);     /* value */
+            for (uint16_t i = 0; i < npairs; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i * 2 + 1));     /* field */
+                READ_STRING_4B(parser, ARG_SLOT(cmd, i * 2 + 2));     /* value */
             }
             cmd->argc = 1 + (npairs < (RESPB_MAX_ARGS - 1) / 2 ? npairs * 2 : RESPB_MAX_ARGS - 1);
             break;
@@ -513,9 +554,9 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t npairs = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < npairs && i * 2 + 2 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i * 2 + 1]);
-                READ_STRING_4B(parser, &cmd->args[i * 2 + 2]);
+            for (uint16_t i = 0; i < npairs; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i * 2 + 1));
+                READ_STRING_4B(parser, ARG_SLOT(cmd, i * 2 + 2));
             }
             cmd->argc = 1 + (npairs < (RESPB_MAX_ARGS - 1) / 2 ? npairs * 2 : RESPB_MAX_ARGS - 1);
             break;
@@ -526,8 +567,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -538,8 +579,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -555,7 +596,9 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_HRANDFIELD: /* [2B keylen][key][2B count?][1B withvalues] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Optional fields - simplified */
+            /* Optional count is not encoded */
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* withvalues */
             cmd->argc = 1;
             break;
             
@@ -563,14 +606,19 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_HEXPIREAT:  /* [2B keylen][key][8B timestamp][1B flags][2B numfields]([2B fieldlen][field])... */
         case RESPB_OP_HPEXPIRE:   /* [2B keylen][key][8B millis][1B flags][2B numfields]([2B fieldlen][field])... */
         case RESPB_OP_HPEXPIREAT: /* [2B keylen][key][8B timestamp][1B flags][2B numfields]([2B fieldlen][field])... */
+        {
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 11);
-            parser->pos += 11; /* seconds/timestamp + flags + numfields */
-            if (parser->pos < parser->buffer_len) {
-                READ_STRING_2B(parser, &cmd->args[1]); /* first field */
+            READ_I64(parser, cmd->view.expire.time);
+            READ_U8(parser, cmd->view.expire.flags);
+            CHECK_AVAIL(parser, 2);
+            uint16_t numfields = read_u16_be(parser->buffer + parser->pos);
+            parser->pos += 2;
+            for (uint16_t i = 0; i < numfields; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
-            cmd->argc = 2;
+            cmd->argc = 1 + (numfields < RESPB_MAX_ARGS - 1 ? numfields : RESPB_MAX_ARGS - 1);
             break;
+        }
             
         case RESPB_OP_HEXPIRETIME: /* [2B keylen][key][2B numfields]([2B fieldlen][field])... */
         case RESPB_OP_HPEXPIRETIME:
@@ -581,41 +629,48 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t numfields = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numfields > 0 && numfields < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[1]); /* first field */
+            for (uint16_t i = 0; i < numfields; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
-            cmd->argc = numfields > 0 ? 2 : 1;
+            cmd->argc = 1 + (numfields < RESPB_MAX_ARGS - 1 ? numfields : RESPB_MAX_ARGS - 1);
             break;
         }
             
-        case RESPB_OP_HGETEX:     /* [2B keylen][key][1B flags][8B expiry?][2B numfields]([2B fieldlen][field])... */
+        case RESPB_OP_HGETEX: {   /* [2B keylen][key][1B flags][8B expiry?][2B numfields]([2B fieldlen][field])... */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 1);
-            parser->pos += 1; /* flags */
-            /* Optional expiry - simplified, skip 8 bytes if present */
+            READ_U8(parser, cmd->view.set.flags);
+            cmd->view.set.expiry = 0;
+            if (cmd->view.set.flags & 0x01) { /* Has expiry */
+                READ_I64(parser, cmd->view.set.expiry);
+            }
             CHECK_AVAIL(parser, 2);
-            uint16_t numfields2 = read_u16_be(parser->buffer + parser->pos);
+            uint16_t numfields = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numfields2 > 0 && numfields2 < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[1]); /* first field */
+            for (uint16_t i = 0; i < numfields; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
-            cmd->argc = numfields2 > 0 ? 2 : 1;
+            cmd->argc = 1 + (numfields < RESPB_MAX_ARGS - 1 ? numfields : RESPB_MAX_ARGS - 1);
             break;
+        }
             
-        case RESPB_OP_HSETEX:     /* [2B keylen][key][1B flags][8B expiry?][2B numfields]([2B fieldlen][field][4B vallen][value])... */
+        case RESPB_OP_HSETEX: {   /* [2B keylen][key][1B flags][8B expiry?][2B numfields]([2B fieldlen][field][4B vallen][value])... */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 1);
-            parser->pos += 1; /* flags */
-            /* Optional expiry - simplified, skip 8 bytes if present */
+            READ_U8(parser, cmd->view.set.flags);
+            cmd->view.set.expiry = 0;
+            if (cmd->view.set.flags & 0x01) { /* Has expiry */
+                READ_I64(parser, cmd->view.set.expiry);
+            }
             CHECK_AVAIL(parser, 2);
-            uint16_t numfields3 = read_u16_be(parser->buffer + parser->pos);
+            uint16_t numfields = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numfields3 > 0 && numfields3 < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[1]); /* first field */
-                READ_STRING_4B(parser, &cmd->args[2]); /* first value */
+            for (uint16_t i = 0; i < numfields; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, 1 + i * 2));
+                READ_STRING_4B(parser, ARG_SLOT(cmd, 2 + i * 2));
             }
-            cmd->argc = numfields3 > 0 ? 3 : 1;
+            size_t total = 1 + (size_t)numfields * 2;
+            cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
             break;
+        }
             
         case RESPB_OP_HEXISTS:  /* [2B keylen][key][2B fieldlen][field] */
         case RESPB_OP_HSTRLEN:
@@ -627,16 +682,14 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_HINCRBY:  /* [2B keylen][key][2B fieldlen][field][8B increment] */
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.incr.increment);
             cmd->argc = 2;
             break;
             
         case RESPB_OP_HINCRBYFLOAT: /* [2B keylen][key][2B fieldlen][field][8B float] */
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_F64(parser, cmd->view.incrbyfloat.increment);
             cmd->argc = 2;
             break;
             
@@ -649,29 +702,38 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_HSCAN:    /* [2B keylen][key][8B cursor][2B patternlen?][pattern?][8B count?][1B novalues] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
-            /* Optional fields - simplified */
+            READ_I64(parser, cmd->view.scan.cursor);
+            /* Optional pattern/count are not encoded */
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* novalues */
             cmd->argc = 1;
             break;
         
         /* ===== Sorted Set Operations (0x00C0-0x00FF) ===== */
         
-        case RESPB_OP_ZADD:     /* [2B keylen][key][1B flags][2B count]([8B score][2B memberlen][member])... */
+        case RESPB_OP_ZADD: {   /* [2B keylen][key][1B flags][2B count]([8B score][2B memberlen][member])... */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 3);
-            parser->pos += 3; /* flags + count */
-            /* Simplified - skip score/member pairs */
-            cmd->argc = 1;
+            READ_U8(parser, cmd->view.zadd.flags);
+            READ_U16(parser, cmd->view.zadd.count);
+            /* Members only; respb_zadd_score() reads each score where it sits */
+            uint16_t count = cmd->view.zadd.count;
+            for (uint16_t i = 0; i < count; i++) {
+                CHECK_AVAIL(parser, 8);
+                if (i < RESPB_MAX_ARGS - 1) cmd->view.zadd.at[i] = (uint32_t)(parser->pos - payload_start);
+                parser->pos += 8; /* score */
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
+            }
+            cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
+        }
             
         case RESPB_OP_ZREM: {   /* [2B keylen][key][2B count]([2B memberlen][member])... */
             READ_STRING_2B(parser, &cmd->args[0]);
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -686,16 +748,18 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_ZRANGE:   /* [2B keylen][key][8B start][8B stop][1B flags] */
         case RESPB_OP_ZREVRANGE:
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 17);
-            parser->pos += 17;
+            READ_I64(parser, cmd->view.range.start);
+            READ_I64(parser, cmd->view.range.stop);
+            READ_U8(parser, cmd->view.range.flags);
             cmd->argc = 1;
             break;
             
         case RESPB_OP_ZRANGEBYSCORE: /* [2B keylen][key][8B min][8B max][1B flags] */
         case RESPB_OP_ZREVRANGEBYSCORE:
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 17);
-            parser->pos += 17;
+            READ_F64(parser, cmd->view.score_range.min);
+            READ_F64(parser, cmd->view.score_range.max);
+            READ_U8(parser, cmd->view.score_range.flags);
             cmd->argc = 1;
             break;
             
@@ -704,7 +768,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
             READ_STRING_2B(parser, &cmd->args[2]);
-            /* Optional fields - simplified */
+            /* Optional fields are not encoded */
             cmd->argc = 3;
             break;
             
@@ -721,18 +785,19 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.timeout.timeout);
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
         }
             
         case RESPB_OP_ZRANDMEMBER: /* [2B keylen][key][2B count?][1B withscores] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Optional fields - simplified */
+            /* Optional count is not encoded */
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* withscores */
             cmd->argc = 1;
             break;
             
@@ -740,8 +805,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             CHECK_AVAIL(parser, 1);
             parser->pos += 1;
@@ -754,8 +819,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -766,8 +831,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             CHECK_AVAIL(parser, 1);
             parser->pos += 1;
@@ -781,8 +846,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             CHECK_AVAIL(parser, 1);
             parser->pos += 1;
@@ -792,9 +857,10 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_ZSCAN: /* [2B keylen][key][8B cursor][2B patternlen?][pattern?][8B count?][1B noscores] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
-            /* Optional fields - simplified */
+            READ_I64(parser, cmd->view.scan.cursor);
+            /* Optional pattern/count are not encoded */
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* noscores */
             cmd->argc = 1;
             break;
             
@@ -802,8 +868,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             CHECK_AVAIL(parser, 1);
             parser->pos += 1;
@@ -812,13 +878,12 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         }
             
         case RESPB_OP_BZMPOP: { /* [8B timeout][2B numkeys]([2B keylen][key])...[1B min_max][2B count?] */
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8; /* timeout */
+            READ_I64(parser, cmd->view.timeout.timeout);
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             CHECK_AVAIL(parser, 1);
             parser->pos += 1;
@@ -839,10 +904,10 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
-            /* Optional limit - simplified */
+            /* Optional limit is not encoded */
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
         }
@@ -855,17 +920,22 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             break;
             
         case RESPB_OP_ZCOUNT:   /* [2B keylen][key][8B min][8B max] */
-        case RESPB_OP_ZREMRANGEBYRANK:
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 16);
-            parser->pos += 16;
+            READ_F64(parser, cmd->view.score_range.min);
+            READ_F64(parser, cmd->view.score_range.max);
+            cmd->argc = 1;
+            break;
+            
+        case RESPB_OP_ZREMRANGEBYRANK: /* [2B keylen][key][8B start][8B stop] */
+            READ_STRING_2B(parser, &cmd->args[0]);
+            READ_I64(parser, cmd->view.range.start);
+            READ_I64(parser, cmd->view.range.stop);
             cmd->argc = 1;
             break;
             
         case RESPB_OP_ZINCRBY:  /* [2B keylen][key][8B increment][2B memberlen][member] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_F64(parser, cmd->view.incrbyfloat.increment);
             READ_STRING_2B(parser, &cmd->args[1]);
             cmd->argc = 2;
             break;
@@ -884,8 +954,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -893,15 +963,15 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_ZREMRANGEBYSCORE: /* [2B keylen][key][8B min][8B max] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 16);
-            parser->pos += 16;
+            READ_F64(parser, cmd->view.score_range.min);
+            READ_F64(parser, cmd->view.score_range.max);
             cmd->argc = 1;
             break;
             
         /* ===== Connection Management (0x0300-0x033F) ===== */
         
         case RESPB_OP_PING:     /* [2B msglen?][message?] */
-            /* Optional message - simplified */
+            /* Optional message is not encoded */
             cmd->argc = 0;
             break;
             
@@ -911,7 +981,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             break;
             
         case RESPB_OP_AUTH:     /* [2B userlen?][username?][2B passlen][password] */
-            /* Optional username - simplified, just read password */
+            /* Optional username is not encoded */
             READ_STRING_2B(parser, &cmd->args[0]);
             cmd->argc = 1;
             break;
@@ -930,14 +1000,14 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_HELLO:    /* [1B protover][2B userlen?][username?][2B passlen?][password?][2B clientnamelen?][clientname?] */
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* protocol version */
-            /* Optional fields - simplified */
+            /* Optional fields are not encoded */
             cmd->argc = 0;
             break;
             
         case RESPB_OP_CLIENT:   /* [1B subcommand][additional args...] */
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* subcommand */
-            /* Additional args - simplified */
+            /* The spec leaves additional args undefined */
             cmd->argc = 0;
             break;
         
@@ -945,7 +1015,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_CLUSTER:  /* [1B subcommand][additional args...] */
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* subcommand */
-            /* Additional args - simplified */
+            /* The spec leaves additional args undefined */
             cmd->argc = 0;
             break;
             
@@ -985,10 +1055,10 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (count > 0 && count < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[0]); /* first section */
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
-            cmd->argc = count > 0 ? 1 : 0;
+            cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
         }
             
@@ -1003,7 +1073,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_COMMANDLOG:
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* subcommand */
-            /* Additional args - simplified */
+            /* The spec leaves additional args undefined */
             cmd->argc = 0;
             break;
             
@@ -1026,17 +1096,17 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (count > 0 && count < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[0]); /* first arg */
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
-            cmd->argc = count > 0 ? 1 : 0;
+            cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
         }
             
         case RESPB_OP_FAILOVER:   /* [1B flags][2B hostlen?][host?][2B port?][8B timeout?] */
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* flags */
-            /* Optional fields - simplified */
+            /* Optional fields are not encoded */
             cmd->argc = 0;
             break;
             
@@ -1050,10 +1120,10 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (count > 0 && count < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[0]); /* first arg */
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
-            cmd->argc = count > 0 ? 1 : 0;
+            cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
         }
             
@@ -1079,8 +1149,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
@@ -1092,16 +1162,17 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < numkeys && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < numkeys; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             CHECK_AVAIL(parser, 2);
             uint16_t numargs = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numargs > 0 && numkeys + 1 < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[numkeys + 1]); /* first arg */
+            for (uint16_t i = 0; i < numargs; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, 1 + (size_t)numkeys + i));
             }
-            cmd->argc = (numkeys + (numargs > 0 ? 1 : 0) + 1) < RESPB_MAX_ARGS ? (numkeys + (numargs > 0 ? 1 : 0) + 1) : RESPB_MAX_ARGS;
+            size_t total = 1 + (size_t)numkeys + numargs;
+            cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
             break;
         }
             
@@ -1110,16 +1181,17 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < numkeys && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < numkeys; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             CHECK_AVAIL(parser, 2);
             uint16_t numargs = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numargs > 0 && numkeys + 1 < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[numkeys + 1]); /* first arg */
+            for (uint16_t i = 0; i < numargs; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, 1 + (size_t)numkeys + i));
             }
-            cmd->argc = (numkeys + (numargs > 0 ? 1 : 0) + 1) < RESPB_MAX_ARGS ? (numkeys + (numargs > 0 ? 1 : 0) + 1) : RESPB_MAX_ARGS;
+            size_t total = 1 + (size_t)numkeys + numargs;
+            cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
             break;
         }
             
@@ -1128,16 +1200,17 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < numkeys && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < numkeys; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             CHECK_AVAIL(parser, 2);
             uint16_t numargs = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numargs > 0 && numkeys + 1 < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[numkeys + 1]); /* first arg */
+            for (uint16_t i = 0; i < numargs; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, 1 + (size_t)numkeys + i));
             }
-            cmd->argc = (numkeys + (numargs > 0 ? 1 : 0) + 1) < RESPB_MAX_ARGS ? (numkeys + (numargs > 0 ? 1 : 0) + 1) : RESPB_MAX_ARGS;
+            size_t total = 1 + (size_t)numkeys + numargs;
+            cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
             break;
         }
             
@@ -1146,23 +1219,24 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < numkeys && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < numkeys; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             CHECK_AVAIL(parser, 2);
             uint16_t numargs = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numargs > 0 && numkeys + 1 < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[numkeys + 1]); /* first arg */
+            for (uint16_t i = 0; i < numargs; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, 1 + (size_t)numkeys + i));
             }
-            cmd->argc = (numkeys + (numargs > 0 ? 1 : 0) + 1) < RESPB_MAX_ARGS ? (numkeys + (numargs > 0 ? 1 : 0) + 1) : RESPB_MAX_ARGS;
+            size_t total = 1 + (size_t)numkeys + numargs;
+            cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
             break;
         }
             
         case RESPB_OP_SCRIPT:     /* [1B subcommand][additional args...] */
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* subcommand */
-            /* Additional args - simplified */
+            /* The spec leaves additional args undefined */
             cmd->argc = 0;
             break;
             
@@ -1171,16 +1245,17 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < numkeys && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < numkeys; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             CHECK_AVAIL(parser, 2);
             uint16_t numargs = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numargs > 0 && numkeys + 1 < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[numkeys + 1]); /* first arg */
+            for (uint16_t i = 0; i < numargs; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, 1 + (size_t)numkeys + i));
             }
-            cmd->argc = (numkeys + (numargs > 0 ? 1 : 0) + 1) < RESPB_MAX_ARGS ? (numkeys + (numargs > 0 ? 1 : 0) + 1) : RESPB_MAX_ARGS;
+            size_t total = 1 + (size_t)numkeys + numargs;
+            cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
             break;
         }
             
@@ -1189,23 +1264,24 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < numkeys && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < numkeys; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             CHECK_AVAIL(parser, 2);
             uint16_t numargs = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (numargs > 0 && numkeys + 1 < RESPB_MAX_ARGS) {
-                READ_STRING_2B(parser, &cmd->args[numkeys + 1]); /* first arg */
+            for (uint16_t i = 0; i < numargs; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, 1 + (size_t)numkeys + i));
             }
-            cmd->argc = (numkeys + (numargs > 0 ? 1 : 0) + 1) < RESPB_MAX_ARGS ? (numkeys + (numargs > 0 ? 1 : 0) + 1) : RESPB_MAX_ARGS;
+            size_t total = 1 + (size_t)numkeys + numargs;
+            cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
             break;
         }
             
         case RESPB_OP_FUNCTION:      /* [1B subcommand][additional args...] */
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* subcommand */
-            /* Additional args - simplified */
+            /* The spec leaves additional args undefined */
             cmd->argc = 0;
             break;
             
@@ -1225,8 +1301,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_PEXPIRE:
         case RESPB_OP_PEXPIREAT:
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 9);
-            parser->pos += 9;
+            READ_I64(parser, cmd->view.expire.time);
+            READ_U8(parser, cmd->view.expire.flags);
             cmd->argc = 1;
             break;
             
@@ -1242,9 +1318,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             break;
             
         case RESPB_OP_SCAN:    /* [8B cursor][2B patternlen?][pattern?][8B count?][2B typelen?][type?] */
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8; /* cursor */
-            /* Optional fields - simplified */
+            READ_I64(parser, cmd->view.scan.cursor);
+            /* Optional pattern/count/type are not encoded */
             cmd->argc = 0;
             break;
             
@@ -1288,7 +1363,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_SORT:     /* [2B keylen][key][...complex sorting options] */
         case RESPB_OP_SORT_RO:
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Complex options - simplified */
+            /* The spec leaves sort options undefined */
             cmd->argc = 1;
             break;
             
@@ -1296,8 +1371,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
@@ -1325,21 +1400,23 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         /* ===== Bitmap Operations (0x0140-0x015F) ===== */
         case RESPB_OP_SETBIT:   /* [2B keylen][key][8B offset][1B value] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 9);
-            parser->pos += 9;
+            READ_I64(parser, cmd->view.index.value);
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* value */
             cmd->argc = 1;
             break;
             
         case RESPB_OP_GETBIT:   /* [2B keylen][key][8B offset] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 8);
-            parser->pos += 8;
+            READ_I64(parser, cmd->view.index.value);
             cmd->argc = 1;
             break;
             
         case RESPB_OP_BITCOUNT: /* [2B keylen][key][8B start?][8B end?][1B unit] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Optional fields - simplified */
+            /* Optional start/end are not encoded */
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* unit */
             cmd->argc = 1;
             break;
             
@@ -1347,7 +1424,9 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             READ_STRING_2B(parser, &cmd->args[0]);
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* bit */
-            /* Optional fields - simplified */
+            /* Optional start/end are not encoded */
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* unit */
             cmd->argc = 1;
             break;
             
@@ -1358,19 +1437,25 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
         }
             
         case RESPB_OP_BITFIELD: /* [2B keylen][key][2B count]([1B op][2B args]...)... */
-        case RESPB_OP_BITFIELD_RO:
+        case RESPB_OP_BITFIELD_RO: {
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Complex nested structure - simplified */
+            CHECK_AVAIL(parser, 2);
+            uint16_t count = read_u16_be(parser->buffer + parser->pos);
+            parser->pos += 2;
+            /* Operations carry no string arguments */
+            CHECK_AVAIL(parser, (size_t)count * 3);
+            parser->pos += (size_t)count * 3;
             cmd->argc = 1;
             break;
+        }
         
         /* ===== HyperLogLog Operations (0x0160-0x017F) ===== */
         case RESPB_OP_PFADD: { /* [2B keylen][key][2B count]([2B elemlen][elem])... */
@@ -1378,8 +1463,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -1389,8 +1474,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
@@ -1401,8 +1486,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -1420,12 +1505,21 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         
         /* ===== Geospatial Operations (0x0180-0x01BF) ===== */
         case RESPB_OP_GEOADD:   /* [2B keylen][key][1B flags][2B count]([8B longitude][8B latitude][2B memberlen][member])... */
-            READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 3);
-            parser->pos += 3; /* flags + count */
-            /* Skip coordinate pairs - simplified, just store key */
-            cmd->argc = 1;
+        {
+            READ_STRING_2B(parser, &cmd->args[0]);
+            READ_U8(parser, cmd->view.zadd.flags);
+            READ_U16(parser, cmd->view.zadd.count);
+            /* Members only; respb_geoadd_coords() reads each pair where it sits */
+            uint16_t count = cmd->view.zadd.count;
+            for (uint16_t i = 0; i < count; i++) {
+                CHECK_AVAIL(parser, 16);
+                if (i < RESPB_MAX_ARGS - 1) cmd->view.zadd.at[i] = (uint32_t)(parser->pos - payload_start);
+                parser->pos += 16; /* longitude + latitude */
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
+            }
+            cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
+        }
             
         case RESPB_OP_GEODIST:  /* [2B keylen][key][2B mem1len][mem1][2B mem2len][mem2][1B unit] */
             READ_STRING_2B(parser, &cmd->args[0]);
@@ -1442,8 +1536,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i + 1]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
             cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
@@ -1452,8 +1546,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_GEORADIUS: /* [2B keylen][key][8B longitude][8B latitude][8B radius][1B unit][1B flags] */
         case RESPB_OP_GEORADIUS_RO:
             READ_STRING_2B(parser, &cmd->args[0]);
-            CHECK_AVAIL(parser, 18);
-            parser->pos += 18; /* coordinates + radius + unit + flags */
+            CHECK_AVAIL(parser, 26);
+            parser->pos += 26; /* coordinates + radius + unit + flags */
             cmd->argc = 1;
             break;
             
@@ -1468,18 +1562,14 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             
         case RESPB_OP_GEOSEARCH:   /* [2B keylen][key][...complex payload with flags] */
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Complex payload - simplified */
-            CHECK_AVAIL(parser, 1);
-            parser->pos += 1; /* flags */
+            /* The spec leaves the search payload undefined; stop after the key */
             cmd->argc = 1;
             break;
             
         case RESPB_OP_GEOSEARCHSTORE: /* [2B dstlen][dst][2B srclen][src][...complex payload with flags] */
             READ_STRING_2B(parser, &cmd->args[0]); /* dst */
             READ_STRING_2B(parser, &cmd->args[1]); /* src */
-            /* Complex payload - simplified */
-            CHECK_AVAIL(parser, 1);
-            parser->pos += 1; /* flags */
+            /* The spec leaves the search payload undefined; stop after the keys */
             cmd->argc = 2;
             break;
         
@@ -1490,11 +1580,12 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            /* Read first field-value pair */
-            if (count > 0) {
-                READ_STRING_2B(parser, &cmd->args[2]); /* field */
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, 2 + i * 2)); /* field */
+                READ_STRING_4B(parser, ARG_SLOT(cmd, 3 + i * 2)); /* value */
             }
-            cmd->argc = count > 0 ? 3 : 2;
+            size_t total = 2 + (size_t)count * 2;
+            cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
             break;
         }
             
@@ -1508,19 +1599,19 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
             READ_STRING_2B(parser, &cmd->args[2]);
-            /* Optional count - simplified */
+            /* Optional count is not encoded */
             cmd->argc = 3;
             break;
         }
             
         case RESPB_OP_XREAD: {  /* [8B count?][8B block?][2B numkeys]([2B keylen][key][2B idlen][id])... */
-            /* Optional count and block - simplified */
+            /* Optional count and block are not encoded */
             CHECK_AVAIL(parser, 2);
             uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < numkeys && i * 2 + 1 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i * 2]);     /* key */
-                READ_STRING_2B(parser, &cmd->args[i * 2 + 1]); /* id */
+            for (uint16_t i = 0; i < numkeys; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i * 2));     /* key */
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i * 2 + 1)); /* id */
             }
             cmd->argc = numkeys * 2 < RESPB_MAX_ARGS ? numkeys * 2 : RESPB_MAX_ARGS;
             break;
@@ -1529,13 +1620,15 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_XREADGROUP: { /* [2B grouplen][group][2B consumerlen][consumer][8B count?][8B block?][1B noack][2B numkeys]([2B keylen][key][2B idlen][id])... */
             READ_STRING_2B(parser, &cmd->args[0]); /* group */
             READ_STRING_2B(parser, &cmd->args[1]); /* consumer */
-            /* Optional count, block, noack - simplified */
+            /* Optional count and block are not encoded */
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* noack */
             CHECK_AVAIL(parser, 2);
             uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < numkeys && i * 2 + 2 < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i * 2 + 2]);     /* key */
-                READ_STRING_2B(parser, &cmd->args[i * 2 + 3]); /* id */
+            for (uint16_t i = 0; i < numkeys; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i * 2 + 2));     /* key */
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i * 2 + 3)); /* id */
             }
             cmd->argc = 2 + (numkeys * 2 < RESPB_MAX_ARGS - 2 ? numkeys * 2 : RESPB_MAX_ARGS - 2);
             break;
@@ -1546,10 +1639,10 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (count > 0) {
-                READ_STRING_2B(parser, &cmd->args[1]); /* first id */
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
             }
-            cmd->argc = count > 0 ? 2 : 1;
+            cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
             break;
         }
             
@@ -1566,17 +1659,17 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (count > 0) {
-                READ_STRING_2B(parser, &cmd->args[2]); /* first id */
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 2));
             }
-            cmd->argc = count > 0 ? 3 : 2;
+            cmd->argc = 2 + (count < RESPB_MAX_ARGS - 2 ? count : RESPB_MAX_ARGS - 2);
             break;
         }
             
         case RESPB_OP_XPENDING: /* [2B keylen][key][2B grouplen][group][8B idle?][2B startlen?][start?][2B endlen?][end?][8B count?][2B consumerlen?][consumer?] */
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
-            /* Optional fields - simplified */
+            /* Optional fields are not encoded */
             cmd->argc = 2;
             break;
             
@@ -1589,12 +1682,12 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            if (count > 0) {
-                READ_STRING_2B(parser, &cmd->args[3]); /* first id */
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i + 3));
             }
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* flags */
-            cmd->argc = count > 0 ? 4 : 3;
+            cmd->argc = 3 + (count < RESPB_MAX_ARGS - 3 ? count : RESPB_MAX_ARGS - 3);
             break;
         }
             
@@ -1605,7 +1698,9 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 8);
             parser->pos += 8; /* min_idle */
             READ_STRING_2B(parser, &cmd->args[3]); /* start */
-            /* Optional count and justid - simplified */
+            /* Optional count is not encoded */
+            CHECK_AVAIL(parser, 1);
+            parser->pos += 1; /* justid */
             cmd->argc = 4;
             break;
         }
@@ -1614,7 +1709,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* subcommand */
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Additional args - simplified */
+            /* The spec leaves additional args undefined */
             cmd->argc = 1;
             break;
             
@@ -1622,14 +1717,14 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* subcommand */
             READ_STRING_2B(parser, &cmd->args[0]);
-            /* Additional args - simplified */
+            /* The spec leaves additional args undefined */
             cmd->argc = 1;
             break;
             
         case RESPB_OP_XSETID:   /* [2B keylen][key][2B idlen][id][8B entries_added?][2B maxdeletlen?][maxdeleteid?] */
             READ_STRING_2B(parser, &cmd->args[0]);
             READ_STRING_2B(parser, &cmd->args[1]);
-            /* Optional fields - simplified */
+            /* Optional fields are not encoded */
             cmd->argc = 2;
             break;
         
@@ -1653,8 +1748,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
@@ -1665,8 +1760,8 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             CHECK_AVAIL(parser, 2);
             uint16_t count = read_u16_be(parser->buffer + parser->pos);
             parser->pos += 2;
-            for (uint16_t i = 0; i < count && i < RESPB_MAX_ARGS; i++) {
-                READ_STRING_2B(parser, &cmd->args[i]);
+            for (uint16_t i = 0; i < count; i++) {
+                READ_STRING_2B(parser, ARG_SLOT(cmd, i));
             }
             cmd->argc = count < RESPB_MAX_ARGS ? count : RESPB_MAX_ARGS;
             break;
@@ -1675,7 +1770,7 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
         case RESPB_OP_PUBSUB:  /* [1B subcommand][additional args...] */
             CHECK_AVAIL(parser, 1);
             parser->pos += 1; /* subcommand */
-            /* Additional args - simplified */
+            /* The spec leaves additional args undefined */
             cmd->argc = 0;
             break;
             
@@ -1691,69 +1786,214 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
             cmd->module_id = (cmd->module_subcommand >> 16) & 0xFFFF;
             cmd->command_id = cmd->module_subcommand & 0xFFFF;
             
-            /* Parse module-specific payloads */
-            if (cmd->module_id == RESPB_MODULE_JSON) {
+            const respb_schema_t *schema = respb_schema_lookup_module(cmd->module_id,
+                                                                      cmd->command_id);
+            if (!schema) {
+                fprintf(stderr, "RESPB Parser: Unknown module command 0x%08X at position %zu\n",
+                        cmd->module_subcommand, parser->pos - 8);
+                return -1;
+            }
+            
+            /* Registered modules decode through their schema; the generated
+             * JSON/BF/FT commands keep the hand-written cases below */
+            if (!is_generated_module_schema(cmd, schema)) {
+                size_t argc;
+                int result = respb_schema_decode(schema, parser->buffer, parser->buffer_len,
+                                                 &parser->pos, cmd->args, RESPB_MAX_ARGS, &argc);
+                if (result != 1) return result;
+                cmd->argc = argc < RESPB_MAX_ARGS ? argc : RESPB_MAX_ARGS;
+            } else if (cmd->module_id == RESPB_MODULE_JSON) {
                 /* JSON Module commands */
-                if (cmd->command_id == 0x0000) {
-                    /* JSON.SET: [2B keylen][key][2B pathlen][path][4B jsonlen][json][1B flags] */
-                    READ_STRING_2B(parser, &cmd->args[0]); /* key */
-                    READ_STRING_2B(parser, &cmd->args[1]); /* path */
-                    READ_STRING_4B(parser, &cmd->args[2]); /* json */
-                    CHECK_AVAIL(parser, 1); /* flags */
-                    parser->pos += 1;
-                    cmd->argc = 3;
-                } else if (cmd->command_id == 0x0001) {
-                    /* JSON.GET: [2B keylen][key][2B numpaths]([2B pathlen][path])... */
-                    READ_STRING_2B(parser, &cmd->args[0]); /* key */
-                    CHECK_AVAIL(parser, 2);
-                    uint16_t numpaths = read_u16_be(parser->buffer + parser->pos);
-                    parser->pos += 2;
-                    for (uint16_t i = 0; i < numpaths && i + 1 < RESPB_MAX_ARGS; i++) {
-                        READ_STRING_2B(parser, &cmd->args[i + 1]);
+                switch (cmd->command_id) {
+                    case 0x0000: /* JSON.SET: [2B keylen][key][2B pathlen][path][4B jsonlen][json][1B flags] */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* path */
+                        READ_STRING_4B(parser, &cmd->args[2]); /* json */
+                        READ_U8(parser, cmd->view.set.flags);
+                        cmd->argc = 3;
+                        break;
+                    case 0x0001: { /* JSON.GET: [2B keylen][key][2B numpaths]([2B pathlen][path])... */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        CHECK_AVAIL(parser, 2);
+                        uint16_t numpaths = read_u16_be(parser->buffer + parser->pos);
+                        parser->pos += 2;
+                        for (uint16_t i = 0; i < numpaths; i++) {
+                            READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
+                        }
+                        cmd->argc = 1 + (numpaths < RESPB_MAX_ARGS - 1 ? numpaths : RESPB_MAX_ARGS - 1);
+                        break;
+                    }
+                    case 0x0002: { /* JSON.MGET: [2B numkeys]([2B keylen][key])...[2B pathlen][path] */
+                        CHECK_AVAIL(parser, 2);
+                        uint16_t numkeys = read_u16_be(parser->buffer + parser->pos);
+                        parser->pos += 2;
+                        for (uint16_t i = 0; i < numkeys; i++) {
+                            READ_STRING_2B(parser, ARG_SLOT(cmd, i));
+                        }
+                        READ_STRING_2B(parser, ARG_SLOT(cmd, numkeys)); /* path */
+                        size_t total = (size_t)numkeys + 1;
+                        cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
+                        break;
+                    }
+                    case 0x0003: { /* JSON.MSET: [2B count]([2B keylen][key][2B pathlen][path][4B jsonlen][json])... */
+                        CHECK_AVAIL(parser, 2);
+                        uint16_t count = read_u16_be(parser->buffer + parser->pos);
+                        parser->pos += 2;
+                        for (uint16_t i = 0; i < count; i++) {
+                            READ_STRING_2B(parser, ARG_SLOT(cmd, i * 3));     /* key */
+                            READ_STRING_2B(parser, ARG_SLOT(cmd, i * 3 + 1)); /* path */
+                            READ_STRING_4B(parser, ARG_SLOT(cmd, i * 3 + 2)); /* json */
+                        }
+                        size_t total = (size_t)count * 3;
+                        cmd->argc = total < RESPB_MAX_ARGS ? total : RESPB_MAX_ARGS;
+                        break;
+                    }
+                    case 0x0008: { /* JSON.ARRAPPEND: [2B keylen][key][2B pathlen][path][2B count]([4B jsonlen][json])... */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* path */
+                        CHECK_AVAIL(parser, 2);
+                        uint16_t count = read_u16_be(parser->buffer + parser->pos);
+                        parser->pos += 2;
+                        for (uint16_t i = 0; i < count; i++) {
+                            READ_STRING_4B(parser, ARG_SLOT(cmd, i + 2));
+                        }
+                        cmd->argc = 2 + (count < RESPB_MAX_ARGS - 2 ? count : RESPB_MAX_ARGS - 2);
+                        break;
+                    }
+                    case 0x0009: /* JSON.ARRINDEX: [2B keylen][key][2B pathlen][path][4B jsonlen][json] */
+                    case 0x0011: /* JSON.STRAPPEND: [2B keylen][key][2B pathlen][path][4B jsonlen][json] */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* path */
+                        READ_STRING_4B(parser, &cmd->args[2]); /* json */
+                        cmd->argc = 3;
+                        break;
+                    case 0x000A: { /* JSON.ARRINSERT: [2B keylen][key][2B pathlen][path][8B index][2B count]([4B jsonlen][json])... */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* path */
+                        READ_I64(parser, cmd->view.index.value);
+                        CHECK_AVAIL(parser, 2);
+                        uint16_t count = read_u16_be(parser->buffer + parser->pos);
+                        parser->pos += 2;
+                        for (uint16_t i = 0; i < count; i++) {
+                            READ_STRING_4B(parser, ARG_SLOT(cmd, i + 2));
+                        }
+                        cmd->argc = 2 + (count < RESPB_MAX_ARGS - 2 ? count : RESPB_MAX_ARGS - 2);
+                        break;
                     }
-                    cmd->argc = 1 + (numpaths < RESPB_MAX_ARGS - 1 ? numpaths : RESPB_MAX_ARGS - 1);
-                } else {
-                    /* Generic JSON command - parse key only */
-                    READ_STRING_2B(parser, &cmd->args[0]);
-                    cmd->argc = 1;
+                    case 0x000D: /* JSON.ARRTRIM: [2B keylen][key][2B pathlen][path][8B start][8B stop] */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* path */
+                        READ_I64(parser, cmd->view.range.start);
+                        READ_I64(parser, cmd->view.range.stop);
+                        cmd->argc = 2;
+                        break;
+                    case 0x0012: /* JSON.NUMINCRBY: [2B keylen][key][2B pathlen][path][8B number] */
+                    case 0x0013: /* JSON.NUMMULTBY */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* path */
+                        READ_F64(parser, cmd->view.incrbyfloat.increment);
+                        cmd->argc = 2;
+                        break;
+                    case 0x0014: /* JSON.TOGGLE: [2B keylen][key][2B pathlen][path] */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* path */
+                        cmd->argc = 2;
+                        break;
+                    case 0x0015: /* JSON.DEBUG: [1B subcommand][2B keylen][key] */
+                        CHECK_AVAIL(parser, 1);
+                        parser->pos += 1; /* subcommand */
+                        READ_STRING_2B(parser, &cmd->args[0]);
+                        cmd->argc = 1;
+                        break;
+                    default:
+                        /* Key-only JSON commands */
+                        READ_STRING_2B(parser, &cmd->args[0]);
+                        cmd->argc = 1;
+                        break;
                 }
             } else if (cmd->module_id == RESPB_MODULE_BF) {
                 /* Bloom Filter commands */
-                if (cmd->command_id == 0x0000) {
-                    /* BF.ADD: [2B keylen][key][2B itemlen][item] */
-                    READ_STRING_2B(parser, &cmd->args[0]); /* key */
-                    READ_STRING_2B(parser, &cmd->args[1]); /* item */
-                    cmd->argc = 2;
-                } else if (cmd->command_id == 0x0002) {
-                    /* BF.EXISTS: [2B keylen][key][2B itemlen][item] */
-                    READ_STRING_2B(parser, &cmd->args[0]); /* key */
-                    READ_STRING_2B(parser, &cmd->args[1]); /* item */
-                    cmd->argc = 2;
-                } else {
-                    /* Generic BF command */
-                    READ_STRING_2B(parser, &cmd->args[0]);
-                    cmd->argc = 1;
+                switch (cmd->command_id) {
+                    case 0x0000: /* BF.ADD: [2B keylen][key][2B itemlen][item] */
+                    case 0x0002: /* BF.EXISTS: [2B keylen][key][2B itemlen][item] */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* item */
+                        cmd->argc = 2;
+                        break;
+                    case 0x0001: /* BF.MADD: [2B keylen][key][2B count]([2B itemlen][item])... */
+                    case 0x0003: /* BF.MEXISTS */
+                    case 0x0005: { /* BF.INSERT: [2B keylen][key][1B flags][2B count]([2B itemlen][item])... */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        if (cmd->command_id == 0x0005) {
+                            CHECK_AVAIL(parser, 1);
+                            parser->pos += 1; /* flags */
+                        }
+                        CHECK_AVAIL(parser, 2);
+                        uint16_t count = read_u16_be(parser->buffer + parser->pos);
+                        parser->pos += 2;
+                        for (uint16_t i = 0; i < count; i++) {
+                            READ_STRING_2B(parser, ARG_SLOT(cmd, i + 1));
+                        }
+                        cmd->argc = 1 + (count < RESPB_MAX_ARGS - 1 ? count : RESPB_MAX_ARGS - 1);
+                        break;
+                    }
+                    case 0x0004: /* BF.RESERVE: [2B keylen][key][8B error_rate][8B capacity][1B flags] */
+                        READ_STRING_2B(parser, &cmd->args[0]);
+                        CHECK_AVAIL(parser, 17);
+                        parser->pos += 17;
+                        cmd->argc = 1;
+                        break;
+                    case 0x0008: /* BF.LOAD: [2B keylen][key][4B datalen][data] */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* key */
+                        READ_STRING_4B(parser, &cmd->args[1]); /* data */
+                        cmd->argc = 2;
+                        break;
+                    default:
+                        /* Key-only BF commands */
+                        READ_STRING_2B(parser, &cmd->args[0]);
+                        cmd->argc = 1;
+                        break;
                 }
-            } else if (cmd->module_id == RESPB_MODULE_FT) {
+            } else {
                 /* Search/FT commands */
-                if (cmd->command_id == 0x0001) {
-                    /* FT.SEARCH: [2B idxlen][index][2B querylen][query] */
-                    READ_STRING_2B(parser, &cmd->args[0]); /* index */
-                    READ_STRING_2B(parser, &cmd->args[1]); /* query */
-                    cmd->argc = 2;
-                } else {
-                    /* Generic FT command */
-                    READ_STRING_2B(parser, &cmd->args[0]);
-                    cmd->argc = 1;
+                switch (cmd->command_id) {
+                    case 0x0001: /* FT.SEARCH: [2B idxlen][index][2B querylen][query] */
+                        READ_STRING_2B(parser, &cmd->args[0]); /* index */
+                        READ_STRING_2B(parser, &cmd->args[1]); /* query */
+                        cmd->argc = 2;
+                        break;
+                    case 0x0002: /* FT.DROPINDEX: [2B idxlen][index][1B flags] */
+                        READ_STRING_2B(parser, &cmd->args[0]);
+                        CHECK_AVAIL(parser, 1);
+                        parser->pos += 1;
+                        cmd->argc = 1;
+                        break;
+                    case 0x0004: /* FT._LIST: no payload */
+                        cmd->argc = 0;
+                        break;
+                    default:
+                        /* Index-only FT commands */
+                        READ_STRING_2B(parser, &cmd->args[0]);
+                        cmd->argc = 1;
+                        break;
                 }
-            } else {
-                /* Unknown module - try generic parsing */
-                READ_STRING_2B(parser, &cmd->args[0]);
-                cmd->argc = 1;
             }
             break;
         }
         
+        /* ===== Compressed frame (0xF001) ===== */
+        
+        case RESPB_OP_COMPRESSED: {
+            /* Decode the inflated frame instead; its args point into
+             * parser->inflate_buf */
+            respb_parser_t inner;
+            parser->pos -= 4;
+            int result = respb_inflate_frame(parser, &inner);
+            if (result != 1) return result;
+            if (respb_parse_command(&inner, cmd) != 1 || inner.pos != inner.buffer_len) return -1;
+            return 1;
+        }
+        
         /* ===== RESP Passthrough (0xFFFF) ===== */
         
         case RESPB_OP_RESP_PASSTHROUGH: {
@@ -1782,38 +2022,14 @@ int respb_parse_command(respb_parser_t *parser, respb_command_t *cmd) {
 }
 
 const char *respb_opcode_name(uint16_t opcode) {
+    /* Every core opcode, from the generated table */
+    if (opcode < RESPB_SCHEMA_CORE_LIMIT && respb_opcode_names[opcode]) {
+        return respb_opcode_names[opcode];
+    }
     switch (opcode) {
-        case RESPB_OP_GET: return "GET";
-        case RESPB_OP_SET: return "SET";
-        case RESPB_OP_APPEND: return "APPEND";
-        case RESPB_OP_DECR: return "DECR";
-        case RESPB_OP_INCR: return "INCR";
-        case RESPB_OP_MGET: return "MGET";
-        case RESPB_OP_MSET: return "MSET";
-        case RESPB_OP_DEL: return "DEL";
-        case RESPB_OP_EXISTS: return "EXISTS";
-        case RESPB_OP_LPUSH: return "LPUSH";
-        case RESPB_OP_RPUSH: return "RPUSH";
-        case RESPB_OP_LPOP: return "LPOP";
-        case RESPB_OP_RPOP: return "RPOP";
-        case RESPB_OP_LLEN: return "LLEN";
-        case RESPB_OP_LRANGE: return "LRANGE";
-        case RESPB_OP_SADD: return "SADD";
-        case RESPB_OP_SREM: return "SREM";
-        case RESPB_OP_SMEMBERS: return "SMEMBERS";
-        case RESPB_OP_SCARD: return "SCARD";
-        case RESPB_OP_ZADD: return "ZADD";
-        case RESPB_OP_ZREM: return "ZREM";
-        case RESPB_OP_ZSCORE: return "ZSCORE";
-        case RESPB_OP_ZRANGE: return "ZRANGE";
-        case RESPB_OP_HSET: return "HSET";
-        case RESPB_OP_HGET: return "HGET";
-        case RESPB_OP_HDEL: return "HDEL";
-        case RESPB_OP_HGETALL: return "HGETALL";
-        case RESPB_OP_PING: return "PING";
-        case RESPB_OP_MULTI: return "MULTI";
-        case RESPB_OP_EXEC: return "EXEC";
         case RESPB_OP_MODULE: return "MODULE";
+        case RESPB_OP_COMPRESSED: return "COMPRESSED";
+        case RESPB_OP_KEY_BIND: return "KEY_BIND";
         case RESPB_OP_RESP_PASSTHROUGH: return "RESP_PASSTHROUGH";
         default: return "UNKNOWN";
     }
@@ -0,0 +1,85 @@
+/*
+ * RESP Passthrough Decoder
+ * Borrowed-buffer counterpart of parseMultibulk(): length lines are parsed
+ * in place and bulk arguments become spans, so no sds or robj is created
+ */
+
+#include "respb_passthrough.h"
+#include <limits.h>
+
+/* Parse a "<prefix><integer>\r\n" line at *pos into *value.
+ * Returns 1 and advances *pos, 0 if the line is incomplete, -1 if malformed */
+static int resp_read_line(const uint8_t *buf, size_t len, size_t *pos,
+                          uint8_t prefix, long long *value) {
+    size_t p = *pos;
+    if (p >= len) return 0;
+    if (buf[p] != prefix) return -1;
+    p++;
+
+    int negative = 0;
+    if (p < len && buf[p] == '-') {
+        negative = 1;
+        p++;
+    }
+    size_t digits_start = p;
+    unsigned long long v = 0;
+    while (p < len && buf[p] >= '0' && buf[p] <= '9') {
+        /* 18 digits always fit a long long */
+        if (p - digits_start == 18) return -1;
+        v = v * 10 + (buf[p] - '0');
+        p++;
+    }
+
+    /* Still inside the line: wait for the CRLF unless the line is too long */
+    if (p >= len) return len - *pos > RESPB_RESP_MAX_LINE ? -1 : 0;
+    if (p == digits_start || buf[p] != '\r') return -1;
+    if (p + 1 >= len) return 0;
+    if (buf[p + 1] != '\n') return -1;
+
+    *value = negative ? -(long long)v : (long long)v;
+    *pos = p + 2;
+    return 1;
+}
+
+int respb_resp_parse(const uint8_t *buf, size_t len, size_t *posp,
+                     respb_arg_t *args, size_t max_args, size_t *argc_out) {
+    size_t pos = *posp;
+    long long count;
+    int result = resp_read_line(buf, len, &pos, '*', &count);
+    if (result != 1) return result;
+    if (count > INT_MAX) return -1;
+
+    /* Valkey treats "*0" and "*-1" as an empty command and moves on */
+    size_t argc = 0;
+    for (long long i = 0; i < count; i++) {
+        long long bulklen;
+        result = resp_read_line(buf, len, &pos, '$', &bulklen);
+        if (result != 1) return result;
+        if (bulklen < 0 || bulklen > RESPB_RESP_MAX_BULK) return -1;
+
+        size_t n = (size_t)bulklen;
+        if (n + 2 > len - pos) return 0;
+        if (buf[pos + n] != '\r' || buf[pos + n + 1] != '\n') return -1;
+        if (argc < max_args) {
+            args[argc].data = buf + pos;
+            args[argc].len = n;
+        }
+        argc++;
+        pos += n + 2;
+    }
+
+    *argc_out = argc;
+    *posp = pos;
+    return 1;
+}
+
+int respb_parse_passthrough(const respb_command_t *cmd, respb_arg_t *args,
+                            size_t max_args, size_t *argc) {
+    if (cmd->opcode != RESPB_OP_RESP_PASSTHROUGH) return -1;
+
+    /* The frame carried its full length, so an incomplete command is malformed */
+    size_t pos = 0;
+    if (respb_resp_parse(cmd->resp_data, cmd->resp_length, &pos,
+                         args, max_args, argc) != 1) return -1;
+    return pos == cmd->resp_length ? 1 : -1;
+}
@@ -0,0 +1,98 @@
+/*
+ * RESPB Pipeline Builder
+ * Encodes each command straight into the send buffer; frames are never
+ * copied between buffers except when unsent bytes are compacted
+ */
+
+#include "respb_pipeline.h"
+#include <stdlib.h>
+#include <string.h>
+
+void respb_pipeline_init(respb_pipeline_t *p) {
+    memset(p, 0, sizeof(*p));
+}
+
+void respb_pipeline_free(respb_pipeline_t *p) {
+    free(p->buf);
+    free(p->entries);
+    memset(p, 0, sizeof(*p));
+}
+
+/* Make room for size more bytes at tail: slide the unsent bytes to the
+ * front if that is enough, otherwise move them into a larger buffer */
+static int pipeline_reserve(respb_pipeline_t *p, size_t size) {
+    if (size <= p->cap - p->tail) return 1;
+    size_t pending = p->tail - p->head;
+    if (pending + size <= p->cap) {
+        memmove(p->buf, p->buf + p->head, pending);
+    } else {
+        size_t cap = p->cap ? p->cap : 4096;
+        while (cap < pending + size) cap *= 2;
+        uint8_t *buf = malloc(cap);
+        if (!buf) return 0;
+        if (pending) memcpy(buf, p->buf + p->head, pending);
+        free(p->buf);
+        p->buf = buf;
+        p->cap = cap;
+    }
+    p->base += p->head;
+    p->tail = pending;
+    p->head = 0;
+    return 1;
+}
+
+static int pipeline_reserve_entry(respb_pipeline_t *p) {
+    if (p->first + p->count < p->entry_cap) return 1;
+    if (p->first > 0) {
+        memmove(p->entries, p->entries + p->first, p->count * sizeof(*p->entries));
+        p->first = 0;
+        return 1;
+    }
+    size_t cap = p->entry_cap ? p->entry_cap * 2 : 64;
+    respb_pipeline_entry_t *entries = realloc(p->entries, cap * sizeof(*entries));
+    if (!entries) return 0;
+    p->entries = entries;
+    p->entry_cap = cap;
+    return 1;
+}
+
+int respb_pipeline_append(respb_pipeline_t *p, const respb_command_t *cmd) {
+    if (!pipeline_reserve_entry(p)) return 0;
+
+    /* Encode into the room behind tail; only a frame that does not fit there
+     * pays for respb_serialized_size() and a compaction or growth */
+    size_t size = p->buf ? respb_serialize_command(p->buf + p->tail, p->cap - p->tail, cmd) : 0;
+    if (size == 0) {
+        size = respb_serialized_size(cmd);
+        if (size == 0 || size > UINT32_MAX) return -1;
+        if (!pipeline_reserve(p, size)) return 0;
+        respb_serialize_command(p->buf + p->tail, size, cmd);
+    }
+    respb_pipeline_entry_t *e = &p->entries[p->first + p->count++];
+    e->offset = p->base + p->tail;
+    e->length = (uint32_t)size;
+    e->opcode = cmd->opcode;
+    e->mux_id = cmd->mux_id;
+    p->tail += size;
+    return 1;
+}
+
+void respb_pipeline_consume(respb_pipeline_t *p, size_t n) {
+    if (n > p->tail - p->head) n = p->tail - p->head;
+    p->head += n;
+
+    /* Drop entries that end at or before the first unsent byte */
+    uint64_t sent = p->base + p->head;
+    while (p->count > 0) {
+        const respb_pipeline_entry_t *e = &p->entries[p->first];
+        if (e->offset + e->length > sent) break;
+        p->first++;
+        p->count--;
+    }
+
+    if (p->head == p->tail) {
+        p->base += p->head;
+        p->head = p->tail = 0;
+        p->first = 0;
+    }
+}
@@ -0,0 +1,342 @@
+/*
+ * RESPB Reply Codec
+ * Reply frames decode into a flat node array whose strings point into the
+ * input buffer, so MGET/LRANGE/HGETALL replies cost no allocation or copy
+ */
+
+#include "respb_reply.h"
+#include "respb_passthrough.h"
+#include <string.h>
+
+/* Element tag -> reply type, 0xFF for unknown tags */
+static const uint8_t tag_types[8] = {
+    0xFF, RESPB_REPLY_BULK, RESPB_REPLY_INT, RESPB_REPLY_NULL,
+    RESPB_REPLY_ARRAY, RESPB_REPLY_STATUS, RESPB_REPLY_ERROR, 0xFF
+};
+
+/* Reply type -> element tag */
+static const uint8_t type_tags[6] = {
+    RESPB_REPLY_TAG_STATUS, RESPB_REPLY_TAG_ERROR, RESPB_REPLY_TAG_INT,
+    RESPB_REPLY_TAG_BULK, RESPB_REPLY_TAG_ARRAY, RESPB_REPLY_TAG_NULL
+};
+
+/* Arrays still being filled while decoding */
+typedef struct {
+    size_t node;
+    uint32_t left;
+} reply_frame_t;
+
+/* Store node as nodes[*n] (if there is room) and close every array it
+ * completes. Returns 1 when the whole reply is complete, 0 if more elements
+ * follow, -1 if nesting is too deep */
+static int reply_push(respb_reply_t *nodes, size_t max_nodes, size_t *n,
+                      const respb_reply_t *node, reply_frame_t *stack, int *depth) {
+    size_t index = (*n)++;
+    if (index < max_nodes) nodes[index] = *node;
+
+    if (node->type == RESPB_REPLY_ARRAY && node->count > 0) {
+        if (*depth == RESPB_REPLY_MAX_DEPTH) return -1;
+        stack[*depth].node = index;
+        stack[*depth].left = node->count;
+        (*depth)++;
+        return 0;
+    }
+
+    /* A finished value may be the last element of one or more arrays */
+    while (*depth > 0 && --stack[*depth - 1].left == 0) {
+        size_t open = stack[--(*depth)].node;
+        if (open < max_nodes) nodes[open].span = (uint32_t)(*n - open);
+    }
+    return *depth == 0;
+}
+
+int respb_reply_parse(const uint8_t *buf, size_t len, size_t *pos, uint16_t *mux_id,
+                      respb_reply_t *nodes, size_t max_nodes, size_t *nnodes) {
+    size_t p = *pos;
+    if (p > len || len - p < 4) return 0;
+    uint16_t opcode = respb_read_u16(buf + p);
+    if (opcode < RESPB_RESP_OK || opcode > RESPB_RESP_NULL) return -1;
+    uint16_t mux = respb_read_u16(buf + p + 2);
+    p += 4;
+
+    reply_frame_t stack[RESPB_REPLY_MAX_DEPTH];
+    int depth = 0;
+    size_t n = 0;
+    uint8_t type = (uint8_t)(opcode - RESPB_RESP_OK);
+    for (;;) {
+        /* The frame opcode types the first value; elements carry a tag */
+        if (n > 0) {
+            if (p >= len) return 0;
+            uint8_t tag = buf[p++];
+            type = tag < sizeof(tag_types) ? tag_types[tag] : 0xFF;
+            if (type == 0xFF) return -1;
+        }
+
+        respb_reply_t node = { .type = type, .span = 1 };
+        switch (type) {
+            case RESPB_REPLY_STATUS:
+            case RESPB_REPLY_ERROR:
+                if (len - p < 2) return 0;
+                node.len = respb_read_u16(buf + p);
+                p += 2;
+                if (node.len > len - p) return 0;
+                node.data = buf + p;
+                p += node.len;
+                break;
+            case RESPB_REPLY_INT:
+                if (len - p < 8) return 0;
+                node.integer = (int64_t)respb_read_u64(buf + p);
+                p += 8;
+                break;
+            case RESPB_REPLY_BULK: {
+                if (len - p < 4) return 0;
+                uint32_t blen = respb_read_u32(buf + p);
+                p += 4;
+                if (blen == RESPB_REPLY_NULL_BULK) {
+                    node.type = RESPB_REPLY_NULL;
+                    break;
+                }
+                if (blen > len - p) return 0;
+                node.data = buf + p;
+                node.len = blen;
+                p += blen;
+                break;
+            }
+            case RESPB_REPLY_ARRAY: {
+                if (len - p < 2) return 0;
+                uint16_t count = respb_read_u16(buf + p);
+                p += 2;
+                if (count == RESPB_REPLY_NULL_ARRAY) node.type = RESPB_REPLY_NULL;
+                else node.count = count;
+                break;
+            }
+            default:
+                break;
+        }
+
+        int done = reply_push(nodes, max_nodes, &n, &node, stack, &depth);
+        if (done < 0) return -1;
+        if (done) break;
+    }
+
+    if (mux_id) *mux_id = mux;
+    *nnodes = n;
+    *pos = p;
+    return 1;
+}
+
+/* Walk pre-order nodes checking they form exactly one reply: each array
+ * opens count more slots, each node fills one */
+static int reply_well_formed(const respb_reply_t *nodes, size_t nnodes) {
+    size_t open = 1;
+    for (size_t i = 0; i < nnodes; i++) {
+        if (open == 0 || nodes[i].type > RESPB_REPLY_NULL) return 0;
+        open--;
+        if (nodes[i].type == RESPB_REPLY_ARRAY) open += nodes[i].count;
+    }
+    return open == 0;
+}
+
+size_t respb_serialize_reply(uint8_t *buf, size_t buf_len, uint16_t mux_id,
+                             const respb_reply_t *nodes, size_t nnodes) {
+    if (!reply_well_formed(nodes, nnodes) || buf_len < 4) return 0;
+    respb_write_u16(buf, (uint16_t)(RESPB_RESP_OK + nodes[0].type));
+    respb_write_u16(buf + 2, mux_id);
+    size_t pos = 4;
+
+    for (size_t i = 0; i < nnodes; i++) {
+        const respb_reply_t *node = &nodes[i];
+        if (i > 0) {
+            if (pos >= buf_len) return 0;
+            buf[pos++] = type_tags[node->type];
+        }
+        switch (node->type) {
+            case RESPB_REPLY_STATUS:
+            case RESPB_REPLY_ERROR:
+                if (node->len > UINT16_MAX) return 0;
+                if (buf_len - pos < 2 + node->len) return 0;
+                respb_write_u16(buf + pos, (uint16_t)node->len);
+                memcpy(buf + pos + 2, node->data, node->len);
+                pos += 2 + node->len;
+                break;
+            case RESPB_REPLY_INT:
+                if (buf_len - pos < 8) return 0;
+                respb_write_u64(buf + pos, (uint64_t)node->integer);
+                pos += 8;
+                break;
+            case RESPB_REPLY_BULK:
+                if (node->len >= RESPB_REPLY_NULL_BULK) return 0;
+                if (buf_len - pos < 4 + node->len) return 0;
+                respb_write_u32(buf + pos, (uint32_t)node->len);
+                memcpy(buf + pos + 4, node->data, node->len);
+                pos += 4 + node->len;
+                break;
+            case RESPB_REPLY_ARRAY:
+                if (node->count >= RESPB_REPLY_NULL_ARRAY) return 0;
+                if (buf_len - pos < 2) return 0;
+                respb_write_u16(buf + pos, (uint16_t)node->count);
+                pos += 2;
+                break;
+            default:
+                break;
+        }
+    }
+    return pos;
+}
+
+/* Write "<prefix><value>\r\n". Returns the bytes written, 0 if it does not fit */
+static size_t resp_write_line(uint8_t *buf, size_t room, uint8_t prefix, int64_t value) {
+    char digits[20];
+    size_t n = 0;
+    uint64_t v = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+    do {
+        digits[n++] = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+
+    size_t size = 1 + (value < 0) + n + 2;
+    if (size > room) return 0;
+    *buf++ = prefix;
+    if (value < 0) *buf++ = '-';
+    while (n) *buf++ = (uint8_t)digits[--n];
+    buf[0] = '\r';
+    buf[1] = '\n';
+    return size;
+}
+
+size_t respb_reply_to_resp(uint8_t *buf, size_t buf_len,
+                           const respb_reply_t *nodes, size_t nnodes) {
+    if (!reply_well_formed(nodes, nnodes)) return 0;
+
+    size_t pos = 0;
+    for (size_t i = 0; i < nnodes; i++) {
+        const respb_reply_t *node = &nodes[i];
+        size_t room = buf_len - pos, n;
+        switch (node->type) {
+            case RESPB_REPLY_STATUS:
+            case RESPB_REPLY_ERROR:
+                if (room < 3 + node->len) return 0;
+                buf[pos] = node->type == RESPB_REPLY_STATUS ? '+' : '-';
+                memcpy(buf + pos + 1, node->data, node->len);
+                buf[pos + 1 + node->len] = '\r';
+                buf[pos + 2 + node->len] = '\n';
+                pos += 3 + node->len;
+                break;
+            case RESPB_REPLY_INT:
+                if (!(n = resp_write_line(buf + pos, room, ':', node->integer))) return 0;
+                pos += n;
+                break;
+            case RESPB_REPLY_BULK:
+                if (!(n = resp_write_line(buf + pos, room, '$', (int64_t)node->len))) return 0;
+                pos += n;
+                if (buf_len - pos < node->len + 2) return 0;
+                memcpy(buf + pos, node->data, node->len);
+                buf[pos + node->len] = '\r';
+                buf[pos + node->len + 1] = '\n';
+                pos += node->len + 2;
+                break;
+            case RESPB_REPLY_ARRAY:
+                if (!(n = resp_write_line(buf + pos, room, '*', node->count))) return 0;
+                pos += n;
+                break;
+            default:
+                if (room < 5) return 0;
+                memcpy(buf + pos, "$-1\r\n", 5);
+                pos += 5;
+                break;
+        }
+    }
+    return pos;
+}
+
+/* Find the CRLF ending the line that starts at p. Returns the offset of '\r',
+ * 0 if the line is incomplete, or (size_t)-1 if it is malformed */
+static size_t resp_line_end(const uint8_t *buf, size_t len, size_t p) {
+    const uint8_t *cr = memchr(buf + p, '\r', len - p);
+    if (!cr) return len - p > RESPB_RESP_MAX_LINE ? (size_t)-1 : 0;
+    size_t end = (size_t)(cr - buf);
+    if (end + 1 >= len) return 0;
+    return buf[end + 1] == '\n' ? end : (size_t)-1;
+}
+
+/* Parse the decimal integer in buf[p, end). Returns 1, or 0 if malformed */
+static int resp_integer(const uint8_t *buf, size_t p, size_t end, int64_t *value) {
+    int negative = 0;
+    if (p < end && buf[p] == '-') {
+        negative = 1;
+        p++;
+    }
+    /* 18 digits always fit an int64 */
+    if (p == end || end - p > 18) return 0;
+    uint64_t v = 0;
+    for (; p < end; p++) {
+        if (buf[p] < '0' || buf[p] > '9') return 0;
+        v = v * 10 + (buf[p] - '0');
+    }
+    *value = negative ? -(int64_t)v : (int64_t)v;
+    return 1;
+}
+
+int respb_resp_reply_parse(const uint8_t *buf, size_t len, size_t *pos,
+                           respb_reply_t *nodes, size_t max_nodes, size_t *nnodes) {
+    size_t p = *pos;
+    reply_frame_t stack[RESPB_REPLY_MAX_DEPTH];
+    int depth = 0;
+    size_t n = 0;
+    for (;;) {
+        if (p >= len) return 0;
+        size_t end = resp_line_end(buf, len, p + 1);
+        if (end == (size_t)-1) return -1;
+        if (end == 0) return 0;
+
+        respb_reply_t node = { .span = 1 };
+        int64_t value;
+        switch (buf[p]) {
+            case '+':
+            case '-':
+                node.type = buf[p] == '+' ? RESPB_REPLY_STATUS : RESPB_REPLY_ERROR;
+                node.data = buf + p + 1;
+                node.len = end - p - 1;
+                p = end + 2;
+                break;
+            case ':':
+                if (!resp_integer(buf, p + 1, end, &value)) return -1;
+                node.type = RESPB_REPLY_INT;
+                node.integer = value;
+                p = end + 2;
+                break;
+            case '$':
+                if (!resp_integer(buf, p + 1, end, &value)) return -1;
+                p = end + 2;
+                if (value < 0) {
+                    node.type = RESPB_REPLY_NULL;
+                    break;
+                }
+                if (value > RESPB_RESP_MAX_BULK) return -1;
+                if ((size_t)value + 2 > len - p) return 0;
+                if (buf[p + value] != '\r' || buf[p + value + 1] != '\n') return -1;
+                node.type = RESPB_REPLY_BULK;
+                node.data = buf + p;
+                node.len = (size_t)value;
+                p += (size_t)value + 2;
+                break;
+            case '*':
+                if (!resp_integer(buf, p + 1, end, &value)) return -1;
+                if (value > UINT32_MAX) return -1;
+                node.type = value < 0 ? RESPB_REPLY_NULL : RESPB_REPLY_ARRAY;
+                if (value > 0) node.count = (uint32_t)value;
+                p = end + 2;
+                break;
+            default:
+                return -1;
+        }
+
+        int done = reply_push(nodes, max_nodes, &n, &node, stack, &depth);
+        if (done < 0) return -1;
+        if (done) break;
+    }
+
+    *nnodes = n;
+    *pos = p;
+    return 1;
+}
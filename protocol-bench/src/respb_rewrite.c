@@ -0,0 +1,93 @@
+/*
+ * respb-rewrite - RESPB AOF compaction
+ * Writes an equivalent RESPB AOF without superseded writes, as
+ * BGREWRITEAOF does for a RESP AOF, but from the file alone
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "respb_compact.h"
+
+static void print_usage(const char *prog_name) {
+    printf("Usage: %s [options] <input.respb> <output.respb>\n", prog_name);
+    printf("\nOptions:\n");
+    printf("  -x FILE        Also write a frame index of the output\n");
+    printf("  -h             Show this help\n");
+    printf("\nSET, SETEX, PSETEX, DEL, UNLINK and GETDEL overwrite a key; earlier\n");
+    printf("writes to it are dropped unless a command that may read other keys\n");
+    printf("(RENAME, SUNIONSTORE, EVAL, passthrough frames) comes in between.\n");
+}
+
+int main(int argc, char **argv) {
+    const char *index_path = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "x:h")) != -1) {
+        switch (opt) {
+            case 'x':
+                index_path = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (argc - optind != 2) {
+        print_usage(argv[0]);
+        return 1;
+    }
+    const char *in_path = argv[optind], *out_path = argv[optind + 1];
+
+    respb_compact_stats_t stats;
+    respb_index_t index;
+    respb_index_init(&index, 0);
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result = respb_compact_file(in_path, out_path, index_path ? &index : NULL, &stats);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (result == 0) {
+        fprintf(stderr, "ERROR: %s -> %s: %s\n", in_path, out_path, strerror(errno));
+        respb_index_free(&index);
+        return 1;
+    }
+    if (result < 0) {
+        fprintf(stderr, "ERROR: Unknown, truncated or stateful frame at byte %zu of %s\n",
+                stats.error_pos, in_path);
+        respb_index_free(&index);
+        return 1;
+    }
+    if (index_path && !respb_index_save(&index, index_path)) {
+        fprintf(stderr, "ERROR: %s: %s\n", index_path, strerror(errno));
+        respb_index_free(&index);
+        return 1;
+    }
+
+    printf("Input:              %s\n", in_path);
+    printf("Output:             %s\n", out_path);
+    printf("Time elapsed:       %.3f seconds\n", elapsed);
+    printf("Commands read:      %llu (%.0f cmd/s)\n", (unsigned long long)stats.commands,
+           elapsed > 0 ? stats.commands / elapsed : 0.0);
+    printf("Commands written:   %llu\n", (unsigned long long)stats.kept);
+    printf("Keys tracked:       %llu (%.2f MB table)\n", (unsigned long long)stats.keys,
+           stats.memory / 1048576.0);
+    printf("Fences:             %llu\n", (unsigned long long)stats.fences);
+    printf("Input size:         %zu bytes (%.2f MB)\n", stats.in_bytes, stats.in_bytes / 1048576.0);
+    printf("Output size:        %zu bytes (%.2f MB)\n", stats.out_bytes, stats.out_bytes / 1048576.0);
+    if (stats.in_bytes > 0) {
+        printf("Total savings:      %.1f%%\n",
+               100.0 * ((double)stats.in_bytes - (double)stats.out_bytes) / stats.in_bytes);
+    }
+    if (index_path) {
+        printf("Index:              %s (%zu checkpoints)\n", index_path, index.npoints);
+    }
+    respb_index_free(&index);
+    return 0;
+}
@@ -0,0 +1,577 @@
+/*
+ * RESPB Table-Driven Decoder
+ * Walks the generated per-opcode field descriptors (respb_schema_table.c)
+ * with a single interpreter loop instead of a hand-written case per command
+ */
+
+#include "respb_schema.h"
+#include "respb_compress.h"
+#include "respb_keydict.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Computed goto is a GNU extension; other compilers use the switch */
+#if defined(__GNUC__) && !defined(RESPB_NO_COMPUTED_GOTO)
+#define RESPB_COMPUTED_GOTO 1
+#else
+#define RESPB_COMPUTED_GOTO 0
+#endif
+
+const respb_schema_t *respb_schema_lookup(uint16_t opcode) {
+    if (opcode >= RESPB_SCHEMA_CORE_LIMIT) return NULL;
+    uint16_t idx = respb_schema_core_index[opcode];
+    return idx ? &respb_schemas[idx - 1] : NULL;
+}
+
+const respb_schema_t *respb_command_lookup(const char *name, size_t len) {
+    uint32_t h = respb_name_hash(name, len);
+    uint32_t bucket = (uint32_t)(((uint64_t)h * respb_name_bucket_count) >> 32);
+    uint32_t seed = respb_name_seeds[bucket];
+    uint32_t slot = (uint32_t)(((uint64_t)respb_name_mix(h, seed) * respb_schema_count) >> 32);
+    const respb_schema_t *schema = &respb_schemas[respb_name_slots[slot]];
+
+    /* Every input lands on some slot, so confirm the name */
+    const char *expected = schema->name;
+    for (size_t i = 0; i < len; i++) {
+        uint8_t c = (uint8_t)name[i];
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        if (expected[i] == '\0' || (uint8_t)expected[i] != c) return NULL;
+    }
+    return expected[len] == '\0' ? schema : NULL;
+}
+
+/* Module registry: module_id -> dense command_id -> schema. It starts out as
+ * the generated tables and is copied to the heap on the first registration */
+static const respb_schema_module_t *registry = respb_schema_modules;
+static size_t registry_count = RESPB_SCHEMA_MODULE_LIMIT;
+static respb_schema_module_t *registry_heap = NULL;
+
+const respb_schema_t *respb_schema_lookup_module(uint16_t module_id, uint16_t command_id) {
+    if (module_id >= registry_count) return NULL;
+    const respb_schema_module_t *module = &registry[module_id];
+    if (command_id >= module->count) return NULL;
+    return module->commands[command_id];
+}
+
+/* The decoders trust their descriptors, so check what they rely on: known
+ * kinds, group bodies inside the schema and not nested, and an OPT gating a
+ * plain field of the same group */
+static int schema_valid(const respb_schema_t *schema) {
+    const respb_field_t *fields = schema->fields;
+    size_t nfields = schema->nfields;
+    size_t group_end = 0;
+    if (nfields > 0 && !fields) return 0;
+    for (size_t i = 0; i < nfields; i++) {
+        uint8_t kind = fields[i].kind;
+        size_t limit = i < group_end ? group_end : nfields;
+        if (kind >= RESPB_FIELD_KIND_COUNT) return 0;
+        if (kind == RESPB_FIELD_GROUP) {
+            if (i < group_end || fields[i].arg == 0 || i + fields[i].arg >= nfields) return 0;
+            group_end = i + 1 + fields[i].arg;
+        } else if (kind == RESPB_FIELD_OPT) {
+            if (i + 1 >= limit) return 0;
+            if (fields[i + 1].kind == RESPB_FIELD_GROUP ||
+                fields[i + 1].kind == RESPB_FIELD_OPT) return 0;
+        }
+    }
+    return 1;
+}
+
+static int registry_owns(uint16_t module_id, const respb_schema_t *const *commands) {
+    return module_id >= RESPB_SCHEMA_MODULE_LIMIT ||
+           commands != respb_schema_modules[module_id].commands;
+}
+
+int respb_register_module(uint16_t module_id, const respb_schema_t *schemas, size_t count) {
+    uint32_t ncommands = 0;
+    for (size_t i = 0; i < count; i++) {
+        if ((schemas[i].code >> 16) != module_id || !schema_valid(&schemas[i])) return -1;
+        uint32_t command_id = schemas[i].code & 0xFFFF;
+        if (command_id >= ncommands) ncommands = command_id + 1;
+    }
+
+    const respb_schema_t **commands = NULL;
+    if (count > 0) {
+        commands = calloc(ncommands, sizeof(*commands));
+        if (!commands) return 0;
+        for (size_t i = 0; i < count; i++) {
+            uint32_t command_id = schemas[i].code & 0xFFFF;
+            if (commands[command_id]) {
+                free(commands);
+                return -1;
+            }
+            commands[command_id] = &schemas[i];
+        }
+    }
+
+    /* Copy the generated tables on first use, grow to cover module_id */
+    if (!registry_heap || module_id >= registry_count) {
+        size_t new_count = module_id >= registry_count ? (size_t)module_id + 1 : registry_count;
+        respb_schema_module_t *heap = realloc(registry_heap, new_count * sizeof(*heap));
+        if (!heap) {
+            free(commands);
+            return 0;
+        }
+        if (!registry_heap) memcpy(heap, respb_schema_modules, sizeof(respb_schema_modules));
+        size_t old_count = registry_heap ? registry_count : RESPB_SCHEMA_MODULE_LIMIT;
+        memset(heap + old_count, 0, (new_count - old_count) * sizeof(*heap));
+        registry_heap = heap;
+        registry = heap;
+        registry_count = new_count;
+    }
+
+    respb_schema_module_t *module = &registry_heap[module_id];
+    if (module->commands && registry_owns(module_id, module->commands)) {
+        free((void *)module->commands);
+    }
+    module->commands = commands;
+    module->count = ncommands;
+    return 1;
+}
+
+size_t respb_schema_table_size(void) {
+    size_t size = respb_schema_field_count * sizeof(respb_field_t) +
+                  respb_schema_count * sizeof(respb_schema_t) +
+                  sizeof(respb_schema_core_index) +
+                  sizeof(respb_schema_modules);
+    for (int i = 0; i < RESPB_SCHEMA_MODULE_LIMIT; i++) {
+        size += respb_schema_modules[i].count * sizeof(respb_schema_t *);
+    }
+    return size;
+}
+
+int respb_schema_decode(const respb_schema_t *schema, const uint8_t *buf, size_t len,
+                        size_t *posp, respb_arg_t *args, size_t max_args, size_t *argc_out) {
+    return respb_schema_decode_flags(schema, 0, buf, len, posp, args, max_args, argc_out);
+}
+
+int respb_schema_decode_flags(const respb_schema_t *schema, uint8_t flags, const uint8_t *buf,
+                              size_t len, size_t *posp, respb_arg_t *args, size_t max_args,
+                              size_t *argc_out) {
+    return respb_schema_decode_at(schema, flags, buf, len, posp, args, max_args, argc_out, NULL);
+}
+
+int respb_schema_decode_at(const respb_schema_t *schema, uint8_t flags, const uint8_t *buf,
+                           size_t len, size_t *posp, respb_arg_t *args, size_t max_args,
+                           size_t *argc_out, respb_schema_at_t *at) {
+    const int varint = flags & RESPB_FLAG_VARINT;
+    const int keydict = flags & RESPB_FLAG_KEYDICT;
+    const respb_field_t *f = schema->fields;
+    const respb_field_t *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL;
+    const respb_field_t *group_end = NULL;
+    uint32_t group_left = 0;
+    uint8_t last_u8 = 0;
+    size_t argc = 0;
+    size_t pos = *posp;
+
+#if RESPB_COMPUTED_GOTO
+    static const void *const dispatch[RESPB_FIELD_KIND_COUNT] = {
+        [RESPB_FIELD_STR2] = &&L_STR2,
+        [RESPB_FIELD_STR4] = &&L_STR4,
+        [RESPB_FIELD_U8] = &&L_U8,
+        [RESPB_FIELD_U16] = &&L_U16,
+        [RESPB_FIELD_I64] = &&L_I64,
+        [RESPB_FIELD_F64] = &&L_F64,
+        [RESPB_FIELD_GROUP] = &&L_GROUP,
+        [RESPB_FIELD_OPT] = &&L_OPT,
+    };
+#define TARGET(kind) L_##kind: case RESPB_FIELD_##kind
+#define DISPATCH() goto *dispatch[f->kind]
+#else
+#define TARGET(kind) case RESPB_FIELD_##kind
+#define DISPATCH() goto dispatch_field
+#endif
+
+/* Step to the next descriptor, looping back while a group has repeats left */
+#define NEXT_FIELD() do { \
+    f++; \
+    if (f == group_end && --group_left) f = group_start; \
+    if (f == end) goto done; \
+    DISPATCH(); \
+} while (0)
+
+/* Varint length or count into n (uint32_t); returns 0 or -1 from the
+ * enclosing function when it is cut short or malformed */
+#define READ_VARINT(n) do { \
+    int used_ = respb_read_varint(buf + pos, len - pos, &(n)); \
+    if (used_ <= 0) return used_; \
+    pos += (size_t)used_; \
+} while (0)
+
+/* Spans past max_args are counted but not stored; the bytes are still consumed */
+#define STORE_ARG(ptr, n) do { \
+    if (argc < max_args) { \
+        args[argc].data = (ptr); \
+        args[argc].len = (n); \
+    } \
+    argc++; \
+} while (0)
+
+/* Numeric field at ptr (NULL when a flag leaves it out): one outside groups,
+ * or the first field of a group entry */
+#define STORE_AT(ptr) do { \
+    if (at && !group_left) { \
+        if (at->nfixed < RESPB_SCHEMA_AT_FIXED) at->fixed[at->nfixed] = (ptr); \
+        at->nfixed++; \
+    } else if (at && f == group_start) { \
+        if (at->nentries < RESPB_MAX_ARGS - 1) at->entry[at->nentries] = (ptr); \
+        at->nentries++; \
+    } \
+} while (0)
+
+    if (at) at->nfixed = at->nentries = 0;
+
+    if (varint && keydict) return -1;
+    if (f == end) goto done;
+
+#if !RESPB_COMPUTED_GOTO
+dispatch_field:
+#endif
+    switch (f->kind) {
+        TARGET(STR2): {
+            uint32_t n;
+            if (varint) {
+                READ_VARINT(n);
+            } else {
+                if (2 > len - pos) return 0;
+                n = respb_read_u16(buf + pos);
+                pos += 2;
+                if (n == RESPB_KEY_REF && keydict) {
+                    /* [2B key ID] instead of the bytes, left to the caller */
+                    if (2 > len - pos) return 0;
+                    STORE_ARG(NULL, respb_read_u16(buf + pos));
+                    pos += 2;
+                    NEXT_FIELD();
+                }
+            }
+            if (n > len - pos) return 0;
+            STORE_ARG(buf + pos, n);
+            pos += n;
+            NEXT_FIELD();
+        }
+
+        TARGET(STR4): {
+            uint32_t n;
+            if (varint) {
+                READ_VARINT(n);
+            } else {
+                if (4 > len - pos) return 0;
+                n = respb_read_u32(buf + pos);
+                pos += 4;
+            }
+            if (n > len - pos) return 0;
+            STORE_ARG(buf + pos, n);
+            pos += n;
+            NEXT_FIELD();
+        }
+
+        TARGET(U8): {
+            if (1 > len - pos) return 0;
+            STORE_AT(buf + pos);
+            last_u8 = buf[pos];
+            pos += 1;
+            NEXT_FIELD();
+        }
+
+        TARGET(U16): {
+            if (2 > len - pos) return 0;
+            STORE_AT(buf + pos);
+            pos += 2;
+            NEXT_FIELD();
+        }
+
+        TARGET(I64):
+        TARGET(F64): {
+            if (8 > len - pos) return 0;
+            STORE_AT(buf + pos);
+            pos += 8;
+            NEXT_FIELD();
+        }
+
+        TARGET(GROUP): {
+            uint32_t count;
+            if (varint) {
+                READ_VARINT(count);
+                if (count > 0xFFFF) return -1;
+            } else {
+                if (2 > len - pos) return 0;
+                count = respb_read_u16(buf + pos);
+                pos += 2;
+            }
+            if (count == 0) {
+                f += f->arg; /* land on the last body field, NEXT_FIELD steps past it */
+                NEXT_FIELD();
+            }
+            group_start = f + 1;
+            group_end = group_start + f->arg;
+            group_left = count;
+            f = group_start;
+            DISPATCH();
+        }
+
+        TARGET(OPT): {
+            if (!(last_u8 & f->arg)) {
+                f++; /* skip the gated field */
+                if (f->kind >= RESPB_FIELD_U8 && f->kind <= RESPB_FIELD_F64) STORE_AT(NULL);
+            }
+            NEXT_FIELD();
+        }
+
+        default:
+            return -1;
+    }
+
+#undef TARGET
+#undef DISPATCH
+#undef NEXT_FIELD
+#undef READ_VARINT
+#undef STORE_ARG
+#undef STORE_AT
+
+done:
+    *argc_out = argc;
+    *posp = pos;
+    return 1;
+}
+
+/* View members of each layout's numeric fields outside groups, in wire
+ * order: {field kind, offset in respb_view_t} */
+#define VIEW_FIELD(kind, member) {RESPB_FIELD_##kind, (uint8_t)offsetof(respb_view_t, member)}
+#define VIEW_SKIP(kind) {RESPB_FIELD_##kind, RESPB_VIEW_NONE}
+
+static const respb_field_t view_set[] = {VIEW_FIELD(U8, set.flags), VIEW_FIELD(I64, set.expiry)};
+static const respb_field_t view_incr[] = {VIEW_FIELD(I64, incr.increment)};
+static const respb_field_t view_incrbyfloat[] = {VIEW_FIELD(F64, incrbyfloat.increment)};
+static const respb_field_t view_setex[] = {VIEW_FIELD(I64, setex.ttl)};
+static const respb_field_t view_index[] = {VIEW_FIELD(I64, index.value)};
+static const respb_field_t view_setbit[] = {VIEW_FIELD(I64, index.value), VIEW_SKIP(U8)};
+static const respb_field_t view_range[] = {
+    VIEW_FIELD(I64, range.start), VIEW_FIELD(I64, range.stop), VIEW_FIELD(U8, range.flags)};
+static const respb_field_t view_score_range[] = {
+    VIEW_FIELD(F64, score_range.min), VIEW_FIELD(F64, score_range.max),
+    VIEW_FIELD(U8, score_range.flags)};
+static const respb_field_t view_expire[] = {VIEW_FIELD(I64, expire.time), VIEW_FIELD(U8, expire.flags)};
+static const respb_field_t view_zadd[] = {VIEW_FIELD(U8, zadd.flags)};
+static const respb_field_t view_scan[] = {VIEW_FIELD(I64, scan.cursor)};
+static const respb_field_t view_scan_flags[] = {VIEW_FIELD(I64, scan.cursor), VIEW_SKIP(U8)};
+static const respb_field_t view_timeout[] = {VIEW_FIELD(I64, timeout.timeout)};
+static const respb_field_t view_timeout_where[] = {
+    VIEW_SKIP(U8), VIEW_SKIP(U8), VIEW_FIELD(I64, timeout.timeout)};
+static const respb_field_t view_timeout_side[] = {VIEW_FIELD(I64, timeout.timeout), VIEW_SKIP(U8)};
+
+#undef VIEW_FIELD
+#undef VIEW_SKIP
+
+#define VIEW(name) (*count = sizeof(view_##name) / sizeof(view_##name[0]), view_##name)
+
+static const respb_field_t *view_candidates(const respb_schema_t *schema, size_t *count) {
+    *count = 0;
+    if (schema->flags & RESPB_SCHEMA_MODULE) {
+        switch (schema->code) {
+            case (uint32_t)RESPB_MODULE_JSON << 16 | 0x0000: return VIEW(set);  /* JSON.SET flags */
+            case (uint32_t)RESPB_MODULE_JSON << 16 | 0x000A: return VIEW(index);
+            case (uint32_t)RESPB_MODULE_JSON << 16 | 0x000D: return VIEW(range);
+            case (uint32_t)RESPB_MODULE_JSON << 16 | 0x0012:
+            case (uint32_t)RESPB_MODULE_JSON << 16 | 0x0013: return VIEW(incrbyfloat);
+            default: return NULL;
+        }
+    }
+    switch (schema->code) {
+        case RESPB_OP_SET:
+        case RESPB_OP_GETEX:
+        case RESPB_OP_HGETEX:
+        case RESPB_OP_HSETEX: return VIEW(set);
+        case RESPB_OP_INCRBY:
+        case RESPB_OP_DECRBY:
+        case RESPB_OP_HINCRBY: return VIEW(incr);
+        case RESPB_OP_INCRBYFLOAT:
+        case RESPB_OP_HINCRBYFLOAT:
+        case RESPB_OP_ZINCRBY: return VIEW(incrbyfloat);
+        case RESPB_OP_SETEX:
+        case RESPB_OP_PSETEX: return VIEW(setex);
+        case RESPB_OP_LINDEX:
+        case RESPB_OP_LSET:
+        case RESPB_OP_LREM:
+        case RESPB_OP_SETRANGE:
+        case RESPB_OP_GETBIT: return VIEW(index);
+        case RESPB_OP_SETBIT: return VIEW(setbit);
+        case RESPB_OP_GETRANGE:
+        case RESPB_OP_SUBSTR:
+        case RESPB_OP_LRANGE:
+        case RESPB_OP_LTRIM:
+        case RESPB_OP_ZRANGE:
+        case RESPB_OP_ZREVRANGE:
+        case RESPB_OP_ZREMRANGEBYRANK: return VIEW(range);
+        case RESPB_OP_ZCOUNT:
+        case RESPB_OP_ZRANGEBYSCORE:
+        case RESPB_OP_ZREVRANGEBYSCORE:
+        case RESPB_OP_ZREMRANGEBYSCORE: return VIEW(score_range);
+        case RESPB_OP_EXPIRE:
+        case RESPB_OP_PEXPIRE:
+        case RESPB_OP_EXPIREAT:
+        case RESPB_OP_PEXPIREAT:
+        case RESPB_OP_HEXPIRE:
+        case RESPB_OP_HPEXPIRE:
+        case RESPB_OP_HEXPIREAT:
+        case RESPB_OP_HPEXPIREAT: return VIEW(expire);
+        case RESPB_OP_ZADD:
+        case RESPB_OP_GEOADD: return VIEW(zadd);
+        case RESPB_OP_SCAN:
+        case RESPB_OP_SSCAN: return VIEW(scan);
+        case RESPB_OP_HSCAN:
+        case RESPB_OP_ZSCAN: return VIEW(scan_flags);
+        case RESPB_OP_BLPOP:
+        case RESPB_OP_BRPOP:
+        case RESPB_OP_BRPOPLPUSH:
+        case RESPB_OP_BZPOPMIN:
+        case RESPB_OP_BZPOPMAX: return VIEW(timeout);
+        case RESPB_OP_BLMOVE: return VIEW(timeout_where);
+        case RESPB_OP_BLMPOP:
+        case RESPB_OP_BZMPOP: return VIEW(timeout_side);
+        default: return NULL;
+    }
+}
+
+#undef VIEW
+
+const respb_field_t *respb_view_fields(const respb_schema_t *schema, size_t *count) {
+    static const respb_field_t none[1];
+    size_t avail;
+    const respb_field_t *view = view_candidates(schema, &avail);
+    size_t n = 0;
+    for (size_t i = 0; i < schema->nfields; i++) {
+        const respb_field_t *f = &schema->fields[i];
+        if (f->kind == RESPB_FIELD_GROUP) {
+            i += f->arg;
+        } else if (f->kind >= RESPB_FIELD_U8 && f->kind <= RESPB_FIELD_F64) {
+            if (n == avail || view[n].kind != f->kind) return NULL;
+            n++;
+        }
+    }
+    *count = n;
+    return n ? view : none;
+}
+
+void respb_view_fill(const respb_schema_t *schema, const respb_schema_at_t *at,
+                     respb_command_t *cmd) {
+    size_t nview;
+    const respb_field_t *view = respb_view_fields(schema, &nview);
+    if (!view || nview != at->nfixed || nview > RESPB_SCHEMA_AT_FIXED) return;
+    for (size_t i = 0; i < nview; i++) {
+        if (view[i].arg != RESPB_VIEW_NONE) respb_view_load(&cmd->view, view[i], at->fixed[i]);
+    }
+    if (!(schema->flags & RESPB_SCHEMA_MODULE) &&
+        (schema->code == RESPB_OP_ZADD || schema->code == RESPB_OP_GEOADD)) {
+        cmd->view.zadd.count = (uint16_t)at->nentries;
+        for (size_t i = 0; i < cmd->argc - 1; i++) {
+            cmd->view.zadd.at[i] = (uint32_t)(at->entry[i] - cmd->raw_payload);
+        }
+    }
+}
+
+int respb_parse_command_table(respb_parser_t *parser, respb_command_t *cmd) {
+    const uint8_t *buf = parser->buffer;
+    size_t len = parser->buffer_len;
+    size_t pos = parser->pos;
+
+    /* Header: [2B opcode][2B mux_id] */
+    if (len < 4 || pos > len - 4) return 0;
+    cmd->opcode = respb_read_u16(buf + pos);
+    cmd->mux_id = respb_read_u16(buf + pos + 2);
+    pos += 4;
+    cmd->argc = 0;
+    cmd->raw_payload = buf + pos;
+    size_t payload_start = pos;
+
+    const respb_schema_t *schema;
+    if (cmd->opcode == RESPB_OP_MODULE) {
+        if (4 > len - pos) return 0;
+        cmd->module_subcommand = respb_read_u32(buf + pos);
+        cmd->module_id = (cmd->module_subcommand >> 16) & 0xFFFF;
+        cmd->command_id = cmd->module_subcommand & 0xFFFF;
+        pos += 4;
+        schema = respb_schema_lookup_module(cmd->module_id, cmd->command_id);
+        if (!schema) {
+            fprintf(stderr, "RESPB Parser: Unknown module command 0x%08X at position %zu\n",
+                    cmd->module_subcommand, parser->pos);
+            return -1;
+        }
+    } else if (cmd->opcode == RESPB_OP_KEY_BIND) {
+        /* [2B key ID][2B keylen][key], applied to parser->keydict */
+        if (4 > len - pos) return 0;
+        uint16_t id = respb_read_u16(buf + pos);
+        uint16_t key_len = respb_read_u16(buf + pos + 2);
+        if (key_len > len - pos - 4) return 0;
+        if (!(parser->flags & RESPB_FLAG_KEYDICT) || !parser->keydict ||
+            respb_keydict_bind(parser->keydict, id, buf + pos + 4, key_len) != 1) {
+            fprintf(stderr, "RESPB Parser: Cannot bind key ID %u at position %zu\n", id, parser->pos);
+            return -1;
+        }
+        cmd->args[0].data = buf + pos + 4;
+        cmd->args[0].len = key_len;
+        cmd->argc = 1;
+        pos += 4 + key_len;
+        cmd->raw_payload_len = pos - payload_start;
+        parser->pos = pos;
+        return 1;
+    } else if (cmd->opcode == RESPB_OP_COMPRESSED) {
+        respb_parser_t inner;
+        int result = respb_inflate_frame(parser, &inner);
+        if (result != 1) return result;
+        if (respb_parse_command_table(&inner, cmd) != 1 || inner.pos != inner.buffer_len) return -1;
+        return 1;
+    } else if (cmd->opcode == RESPB_OP_RESP_PASSTHROUGH) {
+        /* [4B resp_length][RESP text], or a varint length */
+        uint32_t resp_length;
+        if (parser->flags & RESPB_FLAG_VARINT) {
+            int used = respb_read_varint(buf + pos, len - pos, &resp_length);
+            if (used <= 0) return used;
+            pos += (size_t)used;
+        } else {
+            if (4 > len - pos) return 0;
+            resp_length = respb_read_u32(buf + pos);
+            pos += 4;
+        }
+        if (resp_length > len - pos) return 0;
+        cmd->resp_length = resp_length;
+        cmd->resp_data = buf + pos;
+        pos += resp_length;
+        cmd->raw_payload_len = pos - payload_start;
+        parser->pos = pos;
+        return 1;
+    } else {
+        schema = respb_schema_lookup(cmd->opcode);
+        if (!schema) {
+            fprintf(stderr, "RESPB Parser: Unknown opcode 0x%04X at position %zu\n",
+                    cmd->opcode, parser->pos);
+            return -1;
+        }
+    }
+
+    size_t argc;
+    respb_schema_at_t at;
+    int result = respb_schema_decode_at(schema, parser->flags, buf, len, &pos,
+                                        cmd->args, RESPB_MAX_ARGS, &argc, &at);
+    if (result != 1) return result;
+    cmd->argc = argc < RESPB_MAX_ARGS ? argc : RESPB_MAX_ARGS;
+
+    /* The view the switch decoder fills, from the same fields */
+    respb_view_fill(schema, &at, cmd);
+    
+    /* Key references come back as {NULL, id} */
+    if (parser->flags & RESPB_FLAG_KEYDICT) {
+        for (size_t i = 0; i < cmd->argc; i++) {
+            if (cmd->args[i].data) continue;
+            uint32_t id = (uint32_t)cmd->args[i].len;
+            if (!parser->keydict || !respb_keydict_get(parser->keydict, id, &cmd->args[i])) {
+                fprintf(stderr, "RESPB Parser: Unbound key ID %u at position %zu\n", id, parser->pos);
+                return -1;
+            }
+        }
+    }
+    cmd->raw_payload_len = pos - payload_start;
+    parser->pos = pos;
+    return 1;
+}
@@ -4,6 +4,8 @@
  */
 
 #include "respb.h"
+#include "respb_schema.h"
+#include "respb_keydict.h"
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
@@ -44,6 +46,396 @@ size_t respb_serialize_module_header(uint8_t *buf, uint16_t mux_id, uint32_t sub
     return 8;
 }
 
+/* Gather state for respb_serialize_iov(): buf is the scratch buffer and
+ * scratch[start..pos) the segment not yet turned into an iovec */
+typedef struct {
+    struct iovec *iov;
+    size_t max_iov;
+    size_t iovcnt;
+    size_t start;
+} iov_writer_t;
+
+static int iov_push(iov_writer_t *w, const void *base, size_t len) {
+    if (len == 0) return 1;
+    if (w->iovcnt == w->max_iov) return 0;
+    w->iov[w->iovcnt].iov_base = (void *)base;
+    w->iov[w->iovcnt].iov_len = len;
+    w->iovcnt++;
+    return 1;
+}
+
+/* With a writer, strings of RESPB_IOV_COPY_MAX bytes or more are referenced
+ * in place and only their length prefix goes to buf. With RESPB_FLAG_VARINT,
+ * lengths and group counts are varints and STR2 lengths may exceed 64 KB.
+ * With a dictionary, STR2 strings bound in it go out as [0xFFFF][2B id] */
+static int encode_fields(const respb_schema_t *schema, uint8_t flags, uint8_t *buf, size_t len,
+                         size_t *posp, const respb_arg_t *args, size_t argc,
+                         const respb_num_t *nums, size_t nnums, iov_writer_t *w,
+                         const respb_keydict_t *dict) {
+    const int varint = flags & RESPB_FLAG_VARINT;
+    const respb_field_t *f = schema->fields;
+    const respb_field_t *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL;
+    const respb_field_t *group_end = NULL;
+    uint32_t group_left = 0;
+    uint8_t last_u8 = 0;
+    size_t a = 0, n = 0;
+    size_t pos = *posp;
+    if (pos > len) return 0;
+
+    /* Same walk as respb_schema_decode(), writing instead of reading */
+    while (f < end) {
+        switch (f->kind) {
+            case RESPB_FIELD_STR2:
+            case RESPB_FIELD_STR4: {
+                size_t width = f->kind == RESPB_FIELD_STR2 ? 2 : 4;
+                if (a == argc) return -1;
+                size_t arg_len = args[a].len;
+                if (dict && width == 2) {
+                    int id = respb_keydict_find(dict, args[a].data, arg_len);
+                    if (id >= 0) {
+                        if (4 > len - pos) return 0;
+                        respb_write_u16(buf + pos, RESPB_KEY_REF);
+                        respb_write_u16(buf + pos + 2, (uint16_t)id);
+                        pos += 4;
+                        a++;
+                        break;
+                    }
+                    /* An inline length of 0xFFFF would read as a reference */
+                    if (arg_len >= RESPB_KEY_REF) return -1;
+                }
+                if (arg_len > (width == 2 && !varint ? 0xFFFFu : 0xFFFFFFFFu)) return -1;
+                if (varint) width = respb_varint_size((uint32_t)arg_len);
+                int borrow = w && arg_len >= RESPB_IOV_COPY_MAX;
+                if (width > len - pos || (!borrow && arg_len > len - pos - width)) return 0;
+                if (varint) {
+                    respb_write_varint(buf + pos, (uint32_t)arg_len);
+                } else if (width == 2) {
+                    respb_write_u16(buf + pos, (uint16_t)arg_len);
+                } else {
+                    respb_write_u32(buf + pos, (uint32_t)arg_len);
+                }
+                pos += width;
+                if (borrow) {
+                    if (!iov_push(w, buf + w->start, pos - w->start) ||
+                        !iov_push(w, args[a++].data, arg_len)) return 0;
+                    w->start = pos;
+                    break;
+                }
+                memcpy(buf + pos, args[a++].data, arg_len);
+                pos += arg_len;
+                break;
+            }
+
+            case RESPB_FIELD_U8:
+                if (n == nnums || nums[n].u > 0xFF) return -1;
+                if (1 > len - pos) return 0;
+                buf[pos++] = last_u8 = (uint8_t)nums[n++].u;
+                break;
+
+            case RESPB_FIELD_U16:
+                if (n == nnums || nums[n].u > 0xFFFF) return -1;
+                if (2 > len - pos) return 0;
+                respb_write_u16(buf + pos, (uint16_t)nums[n++].u);
+                pos += 2;
+                break;
+
+            case RESPB_FIELD_I64:
+            case RESPB_FIELD_F64: {
+                if (n == nnums) return -1;
+                if (8 > len - pos) return 0;
+                uint64_t bits;
+                if (f->kind == RESPB_FIELD_I64) {
+                    bits = (uint64_t)nums[n++].i;
+                } else {
+                    memcpy(&bits, &nums[n++].f, sizeof(bits));
+                }
+                respb_write_u64(buf + pos, bits);
+                pos += 8;
+                break;
+            }
+
+            case RESPB_FIELD_GROUP: {
+                if (n == nnums || nums[n].u > 0xFFFF) return -1;
+                uint16_t count = (uint16_t)nums[n].u;
+                size_t width = varint ? respb_varint_size(count) : 2;
+                if (width > len - pos) return 0;
+                n++;
+                if (varint) {
+                    respb_write_varint(buf + pos, count);
+                } else {
+                    respb_write_u16(buf + pos, count);
+                }
+                pos += width;
+                if (count == 0) {
+                    f += f->arg + 1;
+                    continue;
+                }
+                group_start = f + 1;
+                group_end = group_start + f->arg;
+                group_left = count;
+                f = group_start;
+                continue;
+            }
+
+            case RESPB_FIELD_OPT:
+                if (!(last_u8 & f->arg)) f++; /* skip the gated field */
+                break;
+
+            default:
+                return -1;
+        }
+        f++;
+        if (f == group_end && --group_left) f = group_start;
+    }
+
+    if (a != argc || n != nnums) return -1;
+    *posp = pos;
+    return 1;
+}
+
+int respb_schema_encode(const respb_schema_t *schema, uint8_t *buf, size_t len, size_t *pos,
+                        const respb_arg_t *args, size_t argc,
+                        const respb_num_t *nums, size_t nnums) {
+    return encode_fields(schema, 0, buf, len, pos, args, argc, nums, nnums, NULL, NULL);
+}
+
+int respb_schema_encode_flags(const respb_schema_t *schema, uint8_t flags, uint8_t *buf,
+                              size_t len, size_t *pos, const respb_arg_t *args, size_t argc,
+                              const respb_num_t *nums, size_t nnums) {
+    return encode_fields(schema, flags, buf, len, pos, args, argc, nums, nnums, NULL, NULL);
+}
+
+size_t respb_serialize_schema(uint8_t *buf, size_t buf_len, const respb_schema_t *schema,
+                              uint16_t mux_id, const respb_arg_t *args, size_t argc,
+                              const respb_num_t *nums, size_t nnums) {
+    return respb_serialize_schema_flags(buf, buf_len, schema, 0, mux_id, args, argc, nums, nnums);
+}
+
+static size_t serialize_schema_dict(uint8_t *buf, size_t buf_len, const respb_schema_t *schema,
+                                   uint8_t flags, uint16_t mux_id, const respb_arg_t *args,
+                                   size_t argc, const respb_num_t *nums, size_t nnums,
+                                   const respb_keydict_t *dict) {
+    size_t pos;
+    if (schema->flags & RESPB_SCHEMA_MODULE) {
+        if (buf_len < 8) return 0;
+        pos = respb_serialize_module_header(buf, mux_id, schema->code);
+    } else {
+        if (buf_len < 4) return 0;
+        pos = respb_serialize_header(buf, (uint16_t)schema->code, mux_id);
+    }
+    if (encode_fields(schema, flags, buf, buf_len, &pos, args, argc, nums, nnums, NULL, dict) != 1) {
+        return 0;
+    }
+    return pos;
+}
+
+size_t respb_serialize_schema_flags(uint8_t *buf, size_t buf_len, const respb_schema_t *schema,
+                                    uint8_t flags, uint16_t mux_id, const respb_arg_t *args,
+                                    size_t argc, const respb_num_t *nums, size_t nnums) {
+    return serialize_schema_dict(buf, buf_len, schema, flags, mux_id, args, argc, nums, nnums, NULL);
+}
+
+/* Payload bytes for schema, mirroring encode_fields() without writing.
+ * Returns 1 with *size set, 0 if the values do not match the schema */
+static int schema_payload_size(const respb_schema_t *schema, const respb_arg_t *args, size_t argc,
+                               const respb_num_t *nums, size_t nnums, size_t *size) {
+    const respb_field_t *f = schema->fields;
+    const respb_field_t *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL;
+    const respb_field_t *group_end = NULL;
+    uint32_t group_left = 0;
+    uint8_t last_u8 = 0;
+    size_t a = 0, n = 0;
+    size_t total = 0;
+
+    while (f < end) {
+        switch (f->kind) {
+            case RESPB_FIELD_STR2:
+            case RESPB_FIELD_STR4:
+                if (a == argc) return 0;
+                if (args[a].len > (f->kind == RESPB_FIELD_STR2 ? 0xFFFFu : 0xFFFFFFFFu)) return 0;
+                total += (f->kind == RESPB_FIELD_STR2 ? 2 : 4) + args[a++].len;
+                break;
+
+            case RESPB_FIELD_U8:
+                if (n == nnums || nums[n].u > 0xFF) return 0;
+                last_u8 = (uint8_t)nums[n++].u;
+                total += 1;
+                break;
+
+            case RESPB_FIELD_U16:
+                if (n == nnums || nums[n++].u > 0xFFFF) return 0;
+                total += 2;
+                break;
+
+            case RESPB_FIELD_I64:
+            case RESPB_FIELD_F64:
+                if (n++ == nnums) return 0;
+                total += 8;
+                break;
+
+            case RESPB_FIELD_GROUP: {
+                if (n == nnums || nums[n].u > 0xFFFF) return 0;
+                uint16_t count = (uint16_t)nums[n++].u;
+                total += 2;
+                if (count == 0) {
+                    f += f->arg + 1;
+                    continue;
+                }
+                group_start = f + 1;
+                group_end = group_start + f->arg;
+                group_left = count;
+                f = group_start;
+                continue;
+            }
+
+            case RESPB_FIELD_OPT:
+                if (!(last_u8 & f->arg)) f++;
+                break;
+
+            default:
+                return 0;
+        }
+        f++;
+        if (f == group_end && --group_left) f = group_start;
+    }
+
+    if (a != argc || n != nnums) return 0;
+    *size = total;
+    return 1;
+}
+
+size_t respb_serialized_schema_size(const respb_schema_t *schema, const respb_arg_t *args,
+                                    size_t argc, const respb_num_t *nums, size_t nnums) {
+    size_t payload;
+    if (!schema_payload_size(schema, args, argc, nums, nnums, &payload)) return 0;
+    return (schema->flags & RESPB_SCHEMA_MODULE ? 8 : 4) + payload;
+}
+
+/* Size the group to fit argc: sets the group's repeat count, the number of
+ * numeric values when every OPT-gated field is present and the index of the
+ * group count among them. Returns 0 when argc cannot decide the count (two
+ * groups, as in EVAL, or a group without strings, as in BITFIELD); such
+ * commands need respb_serialize_schema() */
+static int command_shape(const respb_schema_t *schema, size_t argc,
+                         size_t *count, size_t *nnums, size_t *group_at) {
+    size_t fixed_args = 0, fixed_nums = 0;
+    size_t group_args = 0, group_nums = 0;
+    int groups = 0;
+    for (size_t i = 0; i < schema->nfields; i++) {
+        const respb_field_t *f = &schema->fields[i];
+        if (f->kind == RESPB_FIELD_OPT) {
+            continue;
+        } else if (f->kind == RESPB_FIELD_GROUP) {
+            if (groups++) return 0;
+            *group_at = fixed_nums++;
+            for (size_t j = i + 1; j <= i + f->arg; j++) {
+                if (schema->fields[j].kind <= RESPB_FIELD_STR4) {
+                    group_args++;
+                } else {
+                    group_nums++;
+                }
+            }
+            i += f->arg;
+        } else if (f->kind <= RESPB_FIELD_STR4) {
+            fixed_args++;
+        } else {
+            fixed_nums++;
+        }
+    }
+
+    *count = 0;
+    if (argc < fixed_args) return 0;
+    if (groups) {
+        if (group_args == 0) return 0;
+        *count = group_args == 1 ? argc - fixed_args : (argc - fixed_args) / group_args;
+        if (*count * group_args != argc - fixed_args) return 0;
+    } else if (argc != fixed_args) {
+        return 0;
+    }
+    *nnums = fixed_nums + *count * group_nums;
+    return 1;
+}
+
+/* respb_view_fields() for the encoders: NULL unless the view holds every field */
+static const respb_field_t *encode_view(const respb_schema_t *schema, size_t *count) {
+    const respb_field_t *view = respb_view_fields(schema, count);
+    for (size_t i = 0; view && i < *count; i++) {
+        if (view[i].arg == RESPB_VIEW_NONE) return NULL;
+    }
+    return view;
+}
+
+/* Numbers of entry r of a group body: ZADD's score, GEOADD's coordinates.
+ * They live in the parsed frame, so a command built by hand has none */
+static int group_numbers(const respb_schema_t *schema, const respb_command_t *cmd, size_t r,
+                         respb_num_t *nums) {
+    if ((schema->flags & RESPB_SCHEMA_MODULE) || !cmd->raw_payload) return 0;
+    if (schema->code == RESPB_OP_ZADD) {
+        nums[0].f = respb_zadd_score(cmd, r);
+        return 1;
+    }
+    if (schema->code == RESPB_OP_GEOADD) {
+        respb_geoadd_coords(cmd, r, &nums[0].f, &nums[1].f);
+        return 2;
+    }
+    return 0;
+}
+
+/* Numeric values of cmd in wire order: fields outside groups from cmd->view,
+ * dropping OPT-gated ones its flags leave out, the group count from argc.
+ * Returns 0 when the view does not hold every numeric field of the layout */
+static int command_numbers(const respb_schema_t *schema, const respb_command_t *cmd,
+                           respb_num_t *nums, size_t max_nums, size_t *nnums) {
+    size_t count, group_at = 0, nfixed;
+    const respb_field_t *view = encode_view(schema, &nfixed);
+    if (!view || !command_shape(schema, cmd->argc, &count, nnums, &group_at) ||
+        *nnums > max_nums) {
+        return 0;
+    }
+
+    size_t n = 0, v = 0;
+    uint8_t last_u8 = 0;
+    for (size_t i = 0; i < schema->nfields; i++) {
+        const respb_field_t *f = &schema->fields[i];
+        if (f->kind == RESPB_FIELD_OPT) {
+            if (!(last_u8 & f->arg)) {
+                i++;  /* gated field absent: skip it and its view member */
+                v++;
+            }
+        } else if (f->kind == RESPB_FIELD_GROUP) {
+            size_t body_nums = 0;
+            for (size_t j = i + 1; j <= i + f->arg; j++) {
+                if (schema->fields[j].kind > RESPB_FIELD_STR4) body_nums++;
+            }
+            nums[n++].u = count;
+            for (size_t r = 0; body_nums && r < count; r++) {
+                if (group_numbers(schema, cmd, r, nums + n) != (int)body_nums) return 0;
+                n += body_nums;
+            }
+            i += f->arg;
+        } else if (f->kind > RESPB_FIELD_STR4) {
+            nums[n] = respb_view_get(&cmd->view, view[v++]);
+            if (f->kind == RESPB_FIELD_U8) last_u8 = (uint8_t)nums[n].u;
+            n++;
+        }
+    }
+    *nnums = n;
+    return 1;
+}
+
+static size_t serialize_from_schema(uint8_t *buf, size_t buf_len, const respb_schema_t *schema,
+                                    const respb_command_t *cmd, uint8_t flags) {
+    respb_num_t nums[RESPB_MAX_ARGS * 3 + 16];
+    size_t nnums;
+    if (!schema || !command_numbers(schema, cmd, nums, sizeof(nums) / sizeof(nums[0]), &nnums)) {
+        return 0;
+    }
+    return respb_serialize_schema_flags(buf, buf_len, schema, flags, cmd->mux_id,
+                                        cmd->args, cmd->argc, nums, nnums);
+}
+
 size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command_t *cmd) {
     if (buf_len < 4) return 0; // Need at least header space
     
@@ -87,9 +479,8 @@ size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command
             memcpy(buf + pos, cmd->args[1].data, cmd->args[1].len);
             pos += cmd->args[1].len;
             
-            // Flags and expiry (defaults)
-            buf[pos++] = 0; // No flags
-            respb_write_u64(buf + pos, 0); // No expiry
+            buf[pos++] = cmd->view.set.flags;
+            respb_write_u64(buf + pos, (uint64_t)cmd->view.set.expiry);
             pos += 8;
             break;
         }
@@ -122,8 +513,7 @@ size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command
             memcpy(buf + pos, cmd->args[0].data, cmd->args[0].len);
             pos += cmd->args[0].len;
             
-            // Default increment of 1
-            respb_write_u64(buf + pos, 1);
+            respb_write_u64(buf + pos, (uint64_t)cmd->view.incr.increment);
             pos += 8;
             break;
         }
@@ -281,7 +671,9 @@ size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command
             pos = 0;
             pos += respb_serialize_module_header(buf + pos, cmd->mux_id, cmd->module_subcommand);
             
-            // Serialize module-specific payload based on module_id and command_id
+            // JSON.SET, BF.ADD and FT.SEARCH are written inline; every other
+            // module command, registered ones included, comes from its schema
+            const respb_schema_t *schema = respb_schema_lookup_module(cmd->module_id, cmd->command_id);
             if (cmd->module_id == RESPB_MODULE_JSON) {
                 // JSON.SET: key + path + json + flags
                 if (cmd->command_id == 0x0000 && cmd->argc >= 3) {
@@ -302,16 +694,9 @@ size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command
                     memcpy(buf + pos, cmd->args[2].data, cmd->args[2].len);
                     pos += cmd->args[2].len;
                     
-                    buf[pos++] = 0; // Flags
+                    buf[pos++] = cmd->view.set.flags;
                 } else {
-                    // Generic JSON command serialization
-                    for (size_t i = 0; i < cmd->argc; i++) {
-                        if (pos + 2 + cmd->args[i].len > buf_len) return 0;
-                        respb_write_u16(buf + pos, cmd->args[i].len);
-                        pos += 2;
-                        memcpy(buf + pos, cmd->args[i].data, cmd->args[i].len);
-                        pos += cmd->args[i].len;
-                    }
+                    return serialize_from_schema(buf, buf_len, schema, cmd, 0);
                 }
             } else if (cmd->module_id == RESPB_MODULE_BF) {
                 // BF.ADD: key + item
@@ -328,14 +713,7 @@ size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command
                     memcpy(buf + pos, cmd->args[1].data, cmd->args[1].len);
                     pos += cmd->args[1].len;
                 } else {
-                    // Generic BF command serialization
-                    for (size_t i = 0; i < cmd->argc; i++) {
-                        if (pos + 2 + cmd->args[i].len > buf_len) return 0;
-                        respb_write_u16(buf + pos, cmd->args[i].len);
-                        pos += 2;
-                        memcpy(buf + pos, cmd->args[i].data, cmd->args[i].len);
-                        pos += cmd->args[i].len;
-                    }
+                    return serialize_from_schema(buf, buf_len, schema, cmd, 0);
                 }
             } else if (cmd->module_id == RESPB_MODULE_FT) {
                 // FT.SEARCH: index + query
@@ -352,24 +730,10 @@ size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command
                     memcpy(buf + pos, cmd->args[1].data, cmd->args[1].len);
                     pos += cmd->args[1].len;
                 } else {
-                    // Generic FT command serialization
-                    for (size_t i = 0; i < cmd->argc; i++) {
-                        if (pos + 2 + cmd->args[i].len > buf_len) return 0;
-                        respb_write_u16(buf + pos, cmd->args[i].len);
-                        pos += 2;
-                        memcpy(buf + pos, cmd->args[i].data, cmd->args[i].len);
-                        pos += cmd->args[i].len;
-                    }
+                    return serialize_from_schema(buf, buf_len, schema, cmd, 0);
                 }
             } else {
-                // Unknown module - generic serialization
-                for (size_t i = 0; i < cmd->argc; i++) {
-                    if (pos + 2 + cmd->args[i].len > buf_len) return 0;
-                    respb_write_u16(buf + pos, cmd->args[i].len);
-                    pos += 2;
-                    memcpy(buf + pos, cmd->args[i].data, cmd->args[i].len);
-                    pos += cmd->args[i].len;
-                }
+                return serialize_from_schema(buf, buf_len, schema, cmd, 0);
             }
             break;
         }
@@ -395,22 +759,240 @@ size_t respb_serialize_command(uint8_t *buf, size_t buf_len, const respb_command
         }
         
         default:
-            // Unknown command - use RESP passthrough format
-            // This should not happen in normal operation, but provides fallback
-            if (pos + 2 > buf_len) return 0;
-            respb_write_u16(buf + pos, cmd->argc);
-            pos += 2;
-            
-            for (size_t i = 0; i < cmd->argc; i++) {
-                if (pos + 2 + cmd->args[i].len > buf_len) return 0;
-                respb_write_u16(buf + pos, cmd->args[i].len);
-                pos += 2;
-                memcpy(buf + pos, cmd->args[i].data, cmd->args[i].len);
-                pos += cmd->args[i].len;
-            }
-            break;
+            // Every other layout comes from the schema table
+            return serialize_from_schema(buf, buf_len, respb_schema_lookup(cmd->opcode), cmd, 0);
     }
     
     return pos;
 }
 
+size_t respb_serialize_command_flags(uint8_t *buf, size_t buf_len, const respb_command_t *cmd,
+                                     uint8_t flags) {
+    if (!(flags & RESPB_FLAG_VARINT)) return respb_serialize_command(buf, buf_len, cmd);
+    
+    if (cmd->opcode == RESPB_OP_RESP_PASSTHROUGH) {
+        size_t width = respb_varint_size(cmd->resp_length);
+        if (buf_len < 4 + width || cmd->resp_length > buf_len - 4 - width) return 0;
+        size_t pos = respb_serialize_header(buf, cmd->opcode, cmd->mux_id);
+        pos += respb_write_varint(buf + pos, cmd->resp_length);
+        memcpy(buf + pos, cmd->resp_data, cmd->resp_length);
+        return pos + cmd->resp_length;
+    }
+    
+    const respb_schema_t *schema = cmd->opcode == RESPB_OP_MODULE
+        ? respb_schema_lookup_module(cmd->module_id, cmd->command_id)
+        : respb_schema_lookup(cmd->opcode);
+    return serialize_from_schema(buf, buf_len, schema, cmd, flags);
+}
+
+size_t respb_serialize_command_dict(uint8_t *buf, size_t buf_len, const respb_command_t *cmd,
+                                    const respb_keydict_t *d) {
+    if (cmd->opcode == RESPB_OP_RESP_PASSTHROUGH) return respb_serialize_command(buf, buf_len, cmd);
+    
+    const respb_schema_t *schema = cmd->opcode == RESPB_OP_MODULE
+        ? respb_schema_lookup_module(cmd->module_id, cmd->command_id)
+        : respb_schema_lookup(cmd->opcode);
+    respb_num_t nums[RESPB_MAX_ARGS * 3 + 16];
+    size_t nnums;
+    if (!schema || !command_numbers(schema, cmd, nums, sizeof(nums) / sizeof(nums[0]), &nnums)) {
+        return 0;
+    }
+    return serialize_schema_dict(buf, buf_len, schema, 0, cmd->mux_id, cmd->args, cmd->argc,
+                                 nums, nnums, d);
+}
+
+size_t respb_serialize_iov(uint8_t *scratch, size_t scratch_len, struct iovec *iov,
+                           size_t max_iov, size_t *iovcnt, const respb_command_t *cmd) {
+    iov_writer_t w = {iov, max_iov, 0, 0};
+    const respb_schema_t *schema;
+    size_t pos;
+    
+    if (cmd->opcode == RESPB_OP_RESP_PASSTHROUGH) {
+        // [4B resp_length] in scratch, the RESP text referenced in place
+        if (scratch_len < 8) return 0;
+        pos = respb_serialize_header(scratch, cmd->opcode, cmd->mux_id);
+        respb_write_u32(scratch + pos, cmd->resp_length);
+        pos += 4;
+        if (!iov_push(&w, scratch, pos) || !iov_push(&w, cmd->resp_data, cmd->resp_length)) return 0;
+        *iovcnt = w.iovcnt;
+        return pos + cmd->resp_length;
+    }
+    
+    if (cmd->opcode == RESPB_OP_MODULE) {
+        if (scratch_len < 8) return 0;
+        schema = respb_schema_lookup_module(cmd->module_id, cmd->command_id);
+        pos = respb_serialize_module_header(scratch, cmd->mux_id, cmd->module_subcommand);
+    } else {
+        if (scratch_len < 4) return 0;
+        schema = respb_schema_lookup(cmd->opcode);
+        pos = respb_serialize_header(scratch, cmd->opcode, cmd->mux_id);
+    }
+    
+    respb_num_t nums[RESPB_MAX_ARGS * 3 + 16];
+    size_t nnums;
+    if (!schema || !command_numbers(schema, cmd, nums, sizeof(nums) / sizeof(nums[0]), &nnums)) {
+        return 0;
+    }
+    if (encode_fields(schema, 0, scratch, scratch_len, &pos, cmd->args, cmd->argc,
+                      nums, nnums, &w, NULL) != 1) return 0;
+    if (!iov_push(&w, scratch + w.start, pos - w.start)) return 0;
+    
+    size_t frame_len = 0;
+    for (size_t i = 0; i < w.iovcnt; i++) frame_len += iov[i].iov_len;
+    *iovcnt = w.iovcnt;
+    return frame_len;
+}
+
+/* respb_serialized_schema_size() of what serialize_from_schema() writes,
+ * without building the numbers: only the flags that gate fields are read */
+static size_t size_from_schema(const respb_schema_t *schema, const respb_command_t *cmd) {
+    size_t count, nnums, group_at, nfixed;
+    if (!schema) return 0;
+    const respb_field_t *view = encode_view(schema, &nfixed);
+    if (!view || !command_shape(schema, cmd->argc, &count, &nnums, &group_at)) return 0;
+
+    static const uint8_t width[RESPB_FIELD_KIND_COUNT] = {
+        [RESPB_FIELD_STR2] = 2, [RESPB_FIELD_STR4] = 4, [RESPB_FIELD_U8] = 1,
+        [RESPB_FIELD_U16] = 2, [RESPB_FIELD_I64] = 8, [RESPB_FIELD_F64] = 8,
+        [RESPB_FIELD_GROUP] = 2,
+    };
+    const respb_arg_t *arg = cmd->args;
+    size_t size = schema->flags & RESPB_SCHEMA_MODULE ? 8 : 4;
+    size_t v = 0;
+    uint8_t last_u8 = 0;
+    for (size_t i = 0; i < schema->nfields; i++) {
+        const respb_field_t *f = &schema->fields[i];
+        size_t repeat = 1, nbody = 1;
+        if (f->kind == RESPB_FIELD_OPT) {
+            if (!(last_u8 & f->arg)) {
+                i++;  /* gated field absent */
+                v++;
+            }
+            continue;
+        }
+        if (f->kind == RESPB_FIELD_GROUP) {
+            size += 2;
+            repeat = count;
+            nbody = f->arg;
+            f++;
+            i += nbody;
+            for (size_t k = 0; k < nbody; k++) {
+                /* Entry numbers come from the frame (group_numbers()) */
+                if (f[k].kind > RESPB_FIELD_STR4 && count && !cmd->raw_payload) return 0;
+            }
+        } else if (f->kind > RESPB_FIELD_STR4) {
+            if (f->kind == RESPB_FIELD_U8) last_u8 = (uint8_t)respb_view_get(&cmd->view, view[v]).u;
+            v++;
+        }
+        for (size_t r = 0; r < repeat; r++) {
+            for (size_t k = 0; k < nbody; k++) {
+                uint8_t kind = f[k].kind;
+                size += width[kind];
+                if (kind == RESPB_FIELD_STR2 || kind == RESPB_FIELD_STR4) {
+                    if (kind == RESPB_FIELD_STR2 && arg->len > 0xFFFF) return 0;
+                    size += arg++->len;
+                }
+            }
+        }
+    }
+    return size;
+}
+
+/* Sum of 2-byte length prefixes and bytes of args[first..argc) */
+static size_t args_size_2b(const respb_command_t *cmd, size_t first) {
+    size_t size = 0;
+    for (size_t i = first; i < cmd->argc; i++) size += 2 + cmd->args[i].len;
+    return size;
+}
+
+/* [2B][key][4B][value] pairs of args[first..argc) */
+static size_t pairs_size(const respb_command_t *cmd, size_t first) {
+    size_t size = 0;
+    for (size_t i = first; i + 1 < cmd->argc; i += 2) {
+        size += 2 + cmd->args[i].len + 4 + cmd->args[i + 1].len;
+    }
+    return size;
+}
+
+/* Must follow respb_serialize_command() case for case */
+size_t respb_serialized_size(const respb_command_t *cmd) {
+    const respb_arg_t *args = cmd->args;
+    switch (cmd->opcode) {
+        case RESPB_OP_GET:
+        case RESPB_OP_INCR:
+        case RESPB_OP_DECR:
+        case RESPB_OP_TTL:
+        case RESPB_OP_LLEN:
+        case RESPB_OP_SCARD:
+            if (cmd->argc < 1) return 0;
+            return 4 + 2 + args[0].len;
+        
+        case RESPB_OP_SET:
+            if (cmd->argc < 2) return 0;
+            return 4 + 2 + args[0].len + 4 + args[1].len + 9;
+        
+        case RESPB_OP_APPEND:
+            if (cmd->argc < 2) return 0;
+            return 4 + 2 + args[0].len + 4 + args[1].len;
+        
+        case RESPB_OP_INCRBY:
+        case RESPB_OP_DECRBY:
+            if (cmd->argc < 1) return 0;
+            return 4 + 2 + args[0].len + 8;
+        
+        case RESPB_OP_MGET:
+        case RESPB_OP_DEL:
+        case RESPB_OP_EXISTS:
+            return 4 + 2 + args_size_2b(cmd, 0);
+        
+        case RESPB_OP_MSET:
+            if (cmd->argc < 2 || cmd->argc % 2 != 0) return 0;
+            return 4 + 2 + pairs_size(cmd, 0);
+        
+        case RESPB_OP_LPUSH:
+        case RESPB_OP_RPUSH:
+        case RESPB_OP_SADD:
+            if (cmd->argc < 1) return 0;
+            return 4 + 2 + args[0].len + 2 + args_size_2b(cmd, 1);
+        
+        case RESPB_OP_HSET:
+            if (cmd->argc < 1 || (cmd->argc - 1) % 2 != 0) return 0;
+            return 4 + 2 + args[0].len + 2 + pairs_size(cmd, 1);
+        
+        case RESPB_OP_HGET:
+            if (cmd->argc < 2) return 0;
+            return 4 + 2 + args[0].len + 2 + args[1].len;
+        
+        case RESPB_OP_PING:
+        case RESPB_OP_MULTI:
+        case RESPB_OP_EXEC:
+            return 4;
+        
+        case RESPB_OP_MODULE:
+            if (cmd->module_id == RESPB_MODULE_JSON && cmd->command_id == 0x0000 && cmd->argc >= 3) {
+                return 8 + 2 + args[0].len + 2 + args[1].len + 4 + args[2].len + 1;
+            }
+            if ((cmd->module_id == RESPB_MODULE_BF && cmd->command_id == 0x0000 && cmd->argc >= 2) ||
+                (cmd->module_id == RESPB_MODULE_FT && cmd->command_id == 0x0001 && cmd->argc >= 2)) {
+                return 8 + 2 + args[0].len + 2 + args[1].len;
+            }
+            return size_from_schema(respb_schema_lookup_module(cmd->module_id, cmd->command_id), cmd);
+        
+        case RESPB_OP_RESP_PASSTHROUGH:
+            return 8 + (size_t)cmd->resp_length;
+        
+        default:
+            return size_from_schema(respb_schema_lookup(cmd->opcode), cmd);
+    }
+}
+
+size_t respb_serialized_size_batch(const respb_command_t *cmds, size_t count, size_t *sizes) {
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t size = respb_serialized_size(&cmds[i]);
+        if (size == 0) return 0;
+        if (sizes) sizes[i] = size;
+        total += size;
+    }
+    return total;
+}
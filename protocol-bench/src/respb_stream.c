@@ -0,0 +1,267 @@
+/*
+ * RESPB Streaming Parser
+ * Continues a frame across recv() boundaries from the saved opcode, field
+ * index and outstanding byte count instead of re-parsing from the header
+ */
+
+#include "respb_stream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void respb_stream_init(respb_stream_t *stream) {
+    memset(stream, 0, sizeof(*stream));
+}
+
+void respb_stream_reset(respb_stream_t *stream) {
+    stream->len = 0;
+    stream->need = 0;
+    stream->pos = 0;
+    stream->active = 0;
+    stream->stage = RESPB_STREAM_HEADER;
+    stream->schema = NULL;
+    stream->field = 0;
+    stream->group_start = 0;
+    stream->group_end = 0;
+    stream->group_left = 0;
+    stream->last_u8 = 0;
+}
+
+void respb_stream_free(respb_stream_t *stream) {
+    free(stream->buf);
+    memset(stream, 0, sizeof(*stream));
+}
+
+static int stream_reserve(respb_stream_t *s, size_t size) {
+    if (size <= s->cap) return 1;
+    size_t cap = s->cap ? s->cap : 256;
+    while (cap < size) cap *= 2;
+    uint8_t *buf = realloc(s->buf, cap);
+    if (!buf) return 0;
+    s->buf = buf;
+    s->cap = cap;
+    return 1;
+}
+
+/* Decode as far as the buffered bytes allow: 1 = frame complete,
+ * 0 = waiting for s->need bytes, -1 = unknown opcode */
+static int stream_advance(respb_stream_t *s) {
+    const uint8_t *buf = s->buf;
+    size_t len = s->len;
+    size_t pos = s->pos;
+
+    if (s->stage == RESPB_STREAM_HEADER) {
+        if (len < 4) {
+            s->need = 4;
+            return 0;
+        }
+        uint16_t opcode = respb_read_u16(buf);
+        const respb_schema_t *schema;
+        if (opcode == RESPB_OP_MODULE || opcode == RESPB_OP_RESP_PASSTHROUGH) {
+            if (len < 8) {
+                s->need = 8;
+                return 0;
+            }
+            uint32_t word = respb_read_u32(buf + 4);
+            if (opcode == RESPB_OP_RESP_PASSTHROUGH) {
+                s->stage = RESPB_STREAM_PASSTHROUGH;
+                s->need = 8 + (size_t)word;
+                s->pos = 8;
+                return len >= s->need;
+            }
+            schema = respb_schema_lookup_module(word >> 16, word & 0xFFFF);
+            if (!schema) {
+                fprintf(stderr, "RESPB Parser: Unknown module command 0x%08X\n", word);
+                return -1;
+            }
+            pos = 8;
+        } else {
+            schema = respb_schema_lookup(opcode);
+            if (!schema) {
+                fprintf(stderr, "RESPB Parser: Unknown opcode 0x%04X\n", opcode);
+                return -1;
+            }
+            pos = 4;
+        }
+        s->schema = schema;
+        s->stage = RESPB_STREAM_FIELDS;
+    }
+
+    if (s->stage == RESPB_STREAM_PASSTHROUGH) {
+        return len >= s->need;
+    }
+
+    const respb_field_t *fields = s->schema->fields;
+    uint16_t nfields = s->schema->nfields;
+
+    while (s->field < nfields) {
+        const respb_field_t *f = &fields[s->field];
+        switch (f->kind) {
+            case RESPB_FIELD_STR2:
+            case RESPB_FIELD_STR4: {
+                size_t width = f->kind == RESPB_FIELD_STR2 ? 2 : 4;
+                if (len - pos < width) {
+                    s->need = pos + width;
+                    goto wait;
+                }
+                size_t n = width == 2 ? respb_read_u16(buf + pos) : respb_read_u32(buf + pos);
+                if (len - pos - width < n) {
+                    s->need = pos + width + n;
+                    goto wait;
+                }
+                pos += width + n;
+                break;
+            }
+
+            case RESPB_FIELD_U8:
+                if (len - pos < 1) {
+                    s->need = pos + 1;
+                    goto wait;
+                }
+                s->last_u8 = buf[pos];
+                pos += 1;
+                break;
+
+            case RESPB_FIELD_U16:
+                if (len - pos < 2) {
+                    s->need = pos + 2;
+                    goto wait;
+                }
+                pos += 2;
+                break;
+
+            case RESPB_FIELD_I64:
+            case RESPB_FIELD_F64:
+                if (len - pos < 8) {
+                    s->need = pos + 8;
+                    goto wait;
+                }
+                pos += 8;
+                break;
+
+            case RESPB_FIELD_GROUP: {
+                if (len - pos < 2) {
+                    s->need = pos + 2;
+                    goto wait;
+                }
+                uint16_t count = respb_read_u16(buf + pos);
+                pos += 2;
+                if (count == 0) {
+                    s->field += f->arg + 1;
+                    continue;
+                }
+                s->group_start = s->field + 1;
+                s->group_end = s->field + 1 + f->arg;
+                s->group_left = count;
+                s->field++;
+                continue;
+            }
+
+            case RESPB_FIELD_OPT:
+                if (!(s->last_u8 & f->arg)) s->field++; /* skip the gated field */
+                break;
+
+            default:
+                return -1;
+        }
+        s->field++;
+        if (s->field == s->group_end && --s->group_left) s->field = s->group_start;
+    }
+
+    s->pos = pos;
+    return 1;
+
+wait:
+    s->pos = pos;
+    return 0;
+}
+
+/* Fill cmd from the complete frame in s->buf: one more walk over its
+ * fields, which sets the argument spans and the typed view together */
+static int stream_emit(respb_stream_t *s, respb_command_t *cmd) {
+    const uint8_t *buf = s->buf;
+
+    cmd->opcode = respb_read_u16(buf);
+    cmd->mux_id = respb_read_u16(buf + 2);
+    cmd->raw_payload = buf + 4;
+
+    if (s->stage == RESPB_STREAM_PASSTHROUGH) {
+        cmd->argc = 0;
+        cmd->resp_length = respb_read_u32(buf + 4);
+        cmd->resp_data = buf + 8;
+        cmd->raw_payload_len = s->need - 4;
+        return 1;
+    }
+
+    size_t pos = 4, argc;
+    if (cmd->opcode == RESPB_OP_MODULE) {
+        cmd->module_subcommand = respb_read_u32(buf + 4);
+        cmd->module_id = (cmd->module_subcommand >> 16) & 0xFFFF;
+        cmd->command_id = cmd->module_subcommand & 0xFFFF;
+        pos = 8;
+    }
+    respb_schema_at_t at;
+    if (respb_schema_decode_at(s->schema, 0, buf, s->pos, &pos, cmd->args, RESPB_MAX_ARGS,
+                               &argc, &at) != 1) {
+        return -1;
+    }
+    cmd->argc = argc < RESPB_MAX_ARGS ? argc : RESPB_MAX_ARGS;
+    respb_view_fill(s->schema, &at, cmd);
+    cmd->raw_payload_len = s->pos - 4;
+    return 1;
+}
+
+int respb_parser_feed(respb_stream_t *stream, const uint8_t *data, size_t len,
+                      size_t *consumed, respb_command_t *cmd) {
+    /* The resume state machine reads fixed-width prefixes only */
+    if (stream->flags & (RESPB_FLAG_VARINT | RESPB_FLAG_KEYDICT)) {
+        fprintf(stderr, "RESPB Parser: Stream parser does not support flags 0x%02X\n",
+                stream->flags);
+        *consumed = 0;
+        return -1;
+    }
+
+    if (!stream->active) {
+        /* Fast path: the whole frame is in this feed, decode it in place */
+        respb_parser_t parser;
+        respb_parser_init(&parser, data, len);
+        int result = respb_parse_command_table(&parser, cmd);
+        if (result != 0) {
+            *consumed = result == 1 ? parser.pos : 0;
+            return result;
+        }
+
+        /* Frame cut off: keep its bytes and remember how far they decode */
+        respb_stream_reset(stream);
+        if (!stream_reserve(stream, len)) return -1;
+        memcpy(stream->buf, data, len);
+        stream->len = len;
+        stream->active = 1;
+        *consumed = len;
+        return stream_advance(stream) < 0 ? -1 : 0;
+    }
+
+    /* Continue the pending frame, copying only the bytes it still needs */
+    size_t used = 0;
+    while (used < len) {
+        size_t take = stream->need - stream->len;
+        if (take > len - used) take = len - used;
+        if (!stream_reserve(stream, stream->need)) return -1;
+        memcpy(stream->buf + stream->len, data + used, take);
+        stream->len += take;
+        used += take;
+        if (stream->len < stream->need) break;
+
+        int result = stream_advance(stream);
+        if (result < 0) return -1;
+        if (result == 1) {
+            stream->active = 0;
+            if (stream_emit(stream, cmd) < 0) return -1;
+            *consumed = used;
+            return 1;
+        }
+    }
+
+    *consumed = used;
+    return 0;
+}
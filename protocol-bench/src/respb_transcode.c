@@ -0,0 +1,841 @@
+/*
+ * RESP <-> RESPB Transcoder
+ * Commands are split with respb_resp_parse() (Valkey's multibulk grammar
+ * and limits, without copying), mapped onto their schema with numbers
+ * parsed by Valkey's string2ll(), and written with respb_serialize_command().
+ * The reverse direction walks the same schema over a parsed frame
+ */
+
+#include "respb_transcode.h"
+#include "respb_schema.h"
+#include "respb_passthrough.h"
+#include "valkey_resp_parser.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define SET_FLAG_NX     0x01
+#define SET_FLAG_XX     0x02
+#define SET_FLAG_EX     0x04
+#define SET_FLAG_PX     0x08
+
+/* Commands checked at a guessed chunk start before it is used */
+#define BOUNDARY_PROBE  4
+
+static int parse_u16(const respb_arg_t *arg, respb_num_t *num) {
+    long long v;
+    if (!string2ll((const char *)arg->data, arg->len, &v) || v < 0 || v > 0xFFFF) return 0;
+    num->u = (uint64_t)v;
+    return 1;
+}
+
+static int parse_i64(const respb_arg_t *arg, respb_num_t *num) {
+    long long v;
+    if (!string2ll((const char *)arg->data, arg->len, &v)) return 0;
+    num->i = v;
+    return 1;
+}
+
+/* strtod() as Valkey's getDoubleFromObject() uses it: the whole text, no
+ * leading space, no NaN */
+static int parse_f64(const respb_arg_t *arg, respb_num_t *num) {
+    char text[64], *end;
+    if (arg->len == 0 || arg->len >= sizeof(text) || arg->data[0] == ' ') return 0;
+    memcpy(text, arg->data, arg->len);
+    text[arg->len] = '\0';
+    errno = 0;
+    double v = strtod(text, &end);
+    if ((size_t)(end - text) != arg->len || errno == ERANGE || isnan(v)) return 0;
+    num->f = v;
+    return 1;
+}
+
+static int is_option(const respb_arg_t *arg, const char *name) {
+    return arg->len == strlen(name) && strncasecmp((const char *)arg->data, name, arg->len) == 0;
+}
+
+static size_t serialize_strings(uint8_t *buf, size_t buf_len, uint16_t mux_id,
+                                const respb_schema_t *schema, const respb_arg_t *args, size_t argc) {
+    respb_command_t cmd;
+    memset(&cmd, 0, offsetof(respb_command_t, args));
+    memset(&cmd.view, 0, sizeof(cmd.view));
+    cmd.mux_id = mux_id;
+    cmd.argc = argc;
+    memcpy(cmd.args, args, argc * sizeof(*args));
+    if (schema->flags & RESPB_SCHEMA_MODULE) {
+        cmd.opcode = RESPB_OP_MODULE;
+        cmd.module_subcommand = schema->code;
+        cmd.module_id = (uint16_t)(schema->code >> 16);
+        cmd.command_id = (uint16_t)schema->code;
+    } else {
+        cmd.opcode = (uint16_t)schema->code;
+        cmd.module_subcommand = 0;
+        cmd.module_id = 0;
+        cmd.command_id = 0;
+    }
+    return respb_serialize_command(buf, buf_len, &cmd);
+}
+
+/* Option names of a command's flags byte, by bit. With value_bits, the
+ * field after the flags byte is the argument of whichever of those options
+ * is set (SET's EX/PX expiry), and 0 on the wire otherwise. Bits 0x01/0x02
+ * and 0x04/0x08 exclude each other, as NX/XX, GT/LT and EX/PX do */
+typedef struct {
+    uint32_t code;          /* schema->code */
+    uint8_t module;
+    uint8_t value_bits;
+    const char *names[4];
+} option_names_t;
+
+static const option_names_t option_names[] = {
+    {RESPB_OP_SET, 0, SET_FLAG_EX | SET_FLAG_PX, {"NX", "XX", "EX", "PX"}},
+    {RESPB_OP_ZADD, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {RESPB_OP_GEOADD, 0, 0, {"NX", "XX"}},
+    {RESPB_OP_EXPIRE, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {RESPB_OP_EXPIREAT, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {RESPB_OP_PEXPIRE, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {RESPB_OP_PEXPIREAT, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {RESPB_OP_HEXPIRE, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {RESPB_OP_HEXPIREAT, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {RESPB_OP_HPEXPIRE, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {RESPB_OP_HPEXPIREAT, 0, 0, {"NX", "XX", "GT", "LT"}},
+    {(uint32_t)RESPB_MODULE_JSON << 16, 1, 0, {"NX", "XX"}},   /* JSON.SET */
+};
+
+static const option_names_t *find_option_names(const respb_schema_t *schema) {
+    uint8_t module = (schema->flags & RESPB_SCHEMA_MODULE) != 0;
+    for (size_t i = 0; i < sizeof(option_names) / sizeof(option_names[0]); i++) {
+        if (option_names[i].code == schema->code && option_names[i].module == module) {
+            return &option_names[i];
+        }
+    }
+    return NULL;
+}
+
+/* Commands whose RESP form carries their first group's count as an argument
+ * ahead of the group, after keyword if set ("ZINTER numkeys key...", "HTTL
+ * key FIELDS numfields field..."). Elsewhere the count follows from the
+ * number of arguments */
+typedef struct {
+    uint16_t opcode;
+    const char *keyword;
+} counted_group_t;
+
+static const counted_group_t counted_groups[] = {
+    {RESPB_OP_LMPOP, NULL},       {RESPB_OP_BLMPOP, NULL},      {RESPB_OP_SINTERCARD, NULL},
+    {RESPB_OP_ZDIFF, NULL},       {RESPB_OP_ZDIFFSTORE, NULL},  {RESPB_OP_ZINTER, NULL},
+    {RESPB_OP_ZINTERSTORE, NULL}, {RESPB_OP_ZINTERCARD, NULL},  {RESPB_OP_ZUNION, NULL},
+    {RESPB_OP_ZUNIONSTORE, NULL}, {RESPB_OP_ZMPOP, NULL},       {RESPB_OP_BZMPOP, NULL},
+    {RESPB_OP_EVAL, NULL},        {RESPB_OP_EVALSHA, NULL},     {RESPB_OP_EVAL_RO, NULL},
+    {RESPB_OP_EVALSHA_RO, NULL},  {RESPB_OP_FCALL, NULL},       {RESPB_OP_FCALL_RO, NULL},
+    {RESPB_OP_HEXPIRE, "FIELDS"}, {RESPB_OP_HEXPIREAT, "FIELDS"}, {RESPB_OP_HEXPIRETIME, "FIELDS"},
+    {RESPB_OP_HPEXPIRE, "FIELDS"}, {RESPB_OP_HPEXPIREAT, "FIELDS"},
+    {RESPB_OP_HPEXPIRETIME, "FIELDS"}, {RESPB_OP_HPTTL, "FIELDS"}, {RESPB_OP_HTTL, "FIELDS"},
+    {RESPB_OP_HPERSIST, "FIELDS"}, {RESPB_OP_HGETEX, "FIELDS"},  {RESPB_OP_HSETEX, "FIELDS"},
+};
+
+static const counted_group_t *find_counted_group(const respb_schema_t *schema) {
+    if (schema->flags & RESPB_SCHEMA_MODULE) return NULL;
+    for (size_t i = 0; i < sizeof(counted_groups) / sizeof(counted_groups[0]); i++) {
+        if (counted_groups[i].opcode == schema->code) return &counted_groups[i];
+    }
+    return NULL;
+}
+
+/* Options at argv[*a] onto a flags byte, and the value of a value option */
+static int read_options(const option_names_t *opts, const respb_arg_t *argv, size_t argc,
+                        size_t *a, uint64_t *flags, respb_num_t *value) {
+    *flags = 0;
+    value->i = 0;
+    while (*a < argc) {
+        size_t bit = 0;
+        while (bit < 4 && !(opts->names[bit] && is_option(&argv[*a], opts->names[bit]))) bit++;
+        if (bit == 4 || *flags & (1u << bit)) break;
+        *flags |= 1u << bit;
+        (*a)++;
+        if (opts->value_bits & (1u << bit)) {
+            if (*a == argc || !parse_i64(&argv[*a], value)) return 0;
+            (*a)++;
+        }
+    }
+    return (*flags & 0x03) != 0x03 && (*flags & 0x0C) != 0x0C;
+}
+
+/* Walk the schema over argv: strings and numbers take one argument each,
+ * in wire order, a flags byte takes the options named for it, and a group
+ * repeats count times, from its count argument or to use up the arguments
+ * its tail leaves. Other U8 fields have no RESP argument of their own, so
+ * they may only come after the last argument, as 0 (OPT fields absent).
+ * Returns 0 when the arguments do not fit that shape */
+static size_t transcode_schema(uint8_t *buf, size_t buf_len, uint16_t mux_id,
+                               const respb_schema_t *schema, const respb_arg_t *argv, size_t argc) {
+    if (schema->flags & (RESPB_SCHEMA_TAIL | RESPB_SCHEMA_SUBCOMMAND)) return 0;
+
+    respb_arg_t args[RESPB_MAX_ARGS];
+    respb_num_t nums[RESPB_MAX_ARGS + 8];
+    const size_t max_nums = sizeof(nums) / sizeof(nums[0]);
+    size_t nargs = 0, nnums = 0, a = 0, counts = 0;
+    const respb_field_t *f = schema->fields, *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL, *group_end = NULL;
+    size_t group_left = 0;
+
+    while (f < end) {
+        switch (f->kind) {
+            case RESPB_FIELD_STR2:
+            case RESPB_FIELD_STR4:
+                if (a == argc) return 0;
+                args[nargs++] = argv[a++];
+                break;
+            case RESPB_FIELD_U16:
+            case RESPB_FIELD_I64:
+            case RESPB_FIELD_F64: {
+                if (a == argc || nnums == max_nums) return 0;
+                int ok = f->kind == RESPB_FIELD_U16 ? parse_u16(&argv[a], &nums[nnums])
+                       : f->kind == RESPB_FIELD_I64 ? parse_i64(&argv[a], &nums[nnums])
+                       : parse_f64(&argv[a], &nums[nnums]);
+                if (!ok) return 0;
+                nnums++;
+                a++;
+                break;
+            }
+            case RESPB_FIELD_U8: {
+                const option_names_t *opts = group_left ? NULL : find_option_names(schema);
+                if (nnums + 2 > max_nums) return 0;
+                if (!opts) {
+                    if (a != argc || group_left) return 0;
+                    nums[nnums++].u = 0;
+                    break;
+                }
+                respb_num_t value;
+                if (!read_options(opts, argv, argc, &a, &nums[nnums].u, &value)) return 0;
+                nnums++;
+                if (opts->value_bits) {
+                    nums[nnums++] = value;
+                    f++;    /* The value field is taken */
+                }
+                break;
+            }
+            case RESPB_FIELD_OPT:
+                f++;    /* Flags are 0: the gated field is absent */
+                break;
+            case RESPB_FIELD_GROUP: {
+                /* Arguments per repetition, and after the group */
+                size_t body = 0, tail = 0, count;
+                for (const respb_field_t *g = f + 1; g <= f + f->arg; g++) {
+                    if (g->kind == RESPB_FIELD_U8 || g->kind == RESPB_FIELD_OPT ||
+                        g->kind == RESPB_FIELD_GROUP) {
+                        return 0;
+                    }
+                    body++;
+                }
+                const counted_group_t *counted = counts ? NULL : find_counted_group(schema);
+                if (counted) {
+                    respb_num_t n;
+                    if (counted->keyword) {
+                        if (a == argc || !is_option(&argv[a], counted->keyword)) return 0;
+                        a++;
+                    }
+                    if (a == argc || !parse_u16(&argv[a], &n)) return 0;
+                    a++;
+                    count = n.u;
+                    if (count * body > argc - a) return 0;
+                } else {
+                    /* Only the last group can be sized by what is left */
+                    for (const respb_field_t *g = f + f->arg + 1; g < end; g++) {
+                        if (g->kind == RESPB_FIELD_GROUP) return 0;
+                        if (g->kind == RESPB_FIELD_OPT) g++;
+                        else if (g->kind != RESPB_FIELD_U8) tail++;
+                    }
+                    if (body == 0 || argc - a < tail) return 0;
+                    count = (argc - a - tail) / body;
+                    if ((count == 0 && counts == 0) || count > 0xFFFF ||
+                        count * body != argc - a - tail) {
+                        return 0;
+                    }
+                }
+                if (nnums == max_nums) return 0;
+                nums[nnums++].u = count;
+                counts++;
+                if (count == 0) {
+                    f += f->arg + 1;
+                    continue;
+                }
+                group_start = f + 1;
+                group_end = group_start + f->arg;
+                group_left = count;
+                f = group_start;
+                continue;
+            }
+            default:
+                return 0;
+        }
+        f++;
+        if (f == group_end && --group_left) f = group_start;
+    }
+    if (a != argc) return 0;
+
+    /* Strings and one implied count: the regular serializer, hand-written
+     * cases included */
+    if (nnums == counts && counts <= 1) {
+        return serialize_strings(buf, buf_len, mux_id, schema, args, nargs);
+    }
+    return respb_serialize_schema(buf, buf_len, schema, mux_id, args, nargs, nums, nnums);
+}
+
+size_t respb_transcode_command(uint8_t *buf, size_t buf_len, uint16_t mux_id,
+                               const respb_arg_t *argv, size_t argc,
+                               const uint8_t *resp, size_t resp_len, int *passthrough) {
+    *passthrough = 0;
+    if (argc >= 1 && argc <= RESPB_MAX_ARGS) {
+        const respb_schema_t *schema = respb_command_lookup((const char *)argv[0].data, argv[0].len);
+        if (schema) {
+            size_t n = transcode_schema(buf, buf_len, mux_id, schema, argv + 1, argc - 1);
+            if (n) return n;
+        }
+    }
+
+    *passthrough = 1;
+    if (resp_len > UINT32_MAX || buf_len < 8 || resp_len > buf_len - 8) return 0;
+    size_t pos = respb_serialize_header(buf, RESPB_OP_RESP_PASSTHROUGH, mux_id);
+    respb_write_u32(buf + pos, (uint32_t)resp_len);
+    memcpy(buf + pos + 4, resp, resp_len);
+    return pos + 4 + resp_len;
+}
+
+/* One chunk: commands starting in [start, limit) of the whole input */
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t start;
+    size_t limit;
+    size_t end;             /* Just past the last command */
+    uint8_t *out;
+    size_t out_len;
+    size_t out_cap;
+    uint64_t commands;
+    uint64_t passthrough;
+    int result;             /* 1, 0 out of memory, -1 bad input at end */
+} chunk_t;
+
+static void *transcode_chunk(void *arg) {
+    chunk_t *c = arg;
+    respb_arg_t argv[RESPB_MAX_ARGS];
+    size_t pos = c->start;
+    c->out_len = 0;
+    c->commands = 0;
+    c->passthrough = 0;
+    c->result = 1;
+
+    while (pos < c->limit) {
+        size_t cmd_start = pos, argc;
+        if (respb_resp_parse(c->data, c->len, &pos, argv, RESPB_MAX_ARGS, &argc) != 1) {
+            c->result = -1;     /* Malformed, or cut off by the end of input */
+            break;
+        }
+        if (argc == 0) continue;
+
+        size_t resp_len = pos - cmd_start;
+        size_t need = RESPB_TRANSCODE_BOUND(resp_len, argc);
+        if (need > c->out_cap - c->out_len) {
+            size_t cap = c->out_cap ? c->out_cap : 4096;
+            while (cap - c->out_len < need) cap *= 2;
+            uint8_t *out = realloc(c->out, cap);
+            if (!out) {
+                c->result = 0;
+                break;
+            }
+            c->out = out;
+            c->out_cap = cap;
+        }
+        int passthrough;
+        size_t n = respb_transcode_command(c->out + c->out_len, c->out_cap - c->out_len, 0,
+                                           argv, argc, c->data + cmd_start, resp_len,
+                                           &passthrough);
+        if (n == 0) {
+            c->result = -1;     /* Over 4 GB: no frame can carry it */
+            pos = cmd_start;
+            break;
+        }
+        c->out_len += n;
+        c->commands++;
+        c->passthrough += (uint64_t)passthrough;
+    }
+    c->end = pos;
+    return NULL;
+}
+
+/* First offset at or after from where BOUNDARY_PROBE commands (or all up
+ * to the end) parse, len if none. A wrong guess only costs a redo */
+static size_t guess_boundary(const uint8_t *data, size_t len, size_t from) {
+    for (size_t pos = from; pos < len; pos++) {
+        const uint8_t *star = memchr(data + pos, '*', len - pos);
+        if (!star) break;
+        pos = (size_t)(star - data);
+        if (pos > 0 && data[pos - 1] != '\n') continue;
+
+        size_t probe = pos, argc;
+        int n = 0;
+        while (n < BOUNDARY_PROBE && probe < len &&
+               respb_resp_parse(data, len, &probe, NULL, 0, &argc) == 1) {
+            n++;
+        }
+        if (n == BOUNDARY_PROBE || probe == len) return pos;
+    }
+    return len;
+}
+
+int respb_transcode_parallel(const uint8_t *data, size_t len, int nthreads, size_t chunk_size,
+                             respb_transcode_write_fn write, void *ctx,
+                             respb_transcode_stats_t *stats) {
+    respb_transcode_stats_t local;
+    if (!stats) stats = &local;
+    memset(stats, 0, sizeof(*stats));
+    if (nthreads < 1) nthreads = 1;
+    if (nthreads > RESPB_TRANSCODE_MAX_THREADS) nthreads = RESPB_TRANSCODE_MAX_THREADS;
+    if (chunk_size == 0) chunk_size = RESPB_TRANSCODE_DEFAULT_CHUNK;
+
+    chunk_t chunks[RESPB_TRANSCODE_MAX_THREADS];
+    pthread_t threads[RESPB_TRANSCODE_MAX_THREADS];
+    int started[RESPB_TRANSCODE_MAX_THREADS];
+    memset(chunks, 0, sizeof(chunks));
+    size_t done = 0;        /* Input transcoded and written so far */
+    int result = 1;
+
+    /* One window of nthreads chunks at a time, written in order */
+    while (result == 1 && done < len) {
+        int n = 0;
+        for (size_t base = done; n < nthreads && base < len; n++, base += chunk_size) {
+            chunk_t *c = &chunks[n];
+            c->data = data;
+            c->len = len;
+            c->start = n == 0 ? done : guess_boundary(data, len, base);
+            c->limit = chunk_size < len - base ? base + chunk_size : len;
+            started[n] = n > 0 && pthread_create(&threads[n], NULL, transcode_chunk, c) == 0;
+        }
+        transcode_chunk(&chunks[0]);
+        for (int i = 1; i < n; i++) {
+            if (started[i]) pthread_join(threads[i], NULL);
+            else transcode_chunk(&chunks[i]);
+        }
+
+        for (int i = 0; i < n && result == 1; i++) {
+            chunk_t *c = &chunks[i];
+            if (c->start != done) {
+                /* The guess was not where the previous chunk ended */
+                c->start = done;
+                transcode_chunk(c);
+                stats->resplits++;
+            }
+            if (c->result != 1) {
+                result = c->result;
+                stats->error_pos = c->end;
+                break;
+            }
+            if (c->out_len && !write(ctx, c->out, c->out_len)) result = 0;
+            stats->commands += c->commands;
+            stats->passthrough += c->passthrough;
+            stats->out_bytes += c->out_len;
+            stats->chunks++;
+            done = c->end;
+        }
+    }
+
+    for (int i = 0; i < nthreads; i++) free(chunks[i].out);
+    stats->in_bytes = done;
+    return result;
+}
+
+typedef struct {
+    FILE *out;
+    respb_index_t *index;
+} file_sink_t;
+
+static int write_file(void *ctx, const uint8_t *data, size_t len) {
+    file_sink_t *sink = ctx;
+    if (sink->index && respb_index_append(sink->index, data, len) != 1) return 0;
+    return fwrite(data, 1, len, sink->out) == len;
+}
+
+int respb_transcode_file(const char *in_path, const char *out_path, int nthreads,
+                         size_t chunk_size, respb_index_t *index,
+                         respb_transcode_stats_t *stats) {
+    int fd = open(in_path, O_RDONLY);
+    if (fd < 0) return 0;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return 0;
+    }
+    size_t len = (size_t)st.st_size;
+    const uint8_t *data = NULL;
+    if (len > 0) {
+        void *map = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            return 0;
+        }
+        data = map;
+    }
+    close(fd);
+
+    file_sink_t sink = {fopen(out_path, "wb"), index};
+    int result = 0;
+    if (sink.out) {
+        setvbuf(sink.out, NULL, _IOFBF, 1 << 20);
+        result = respb_transcode_parallel(data, len, nthreads, chunk_size, write_file, &sink, stats);
+        if (fclose(sink.out) != 0 && result == 1) result = 0;
+    }
+    if (data) munmap((void *)data, len);
+    return result;
+}
+
+/* RESPB -> RESP */
+
+/* RESP output: buf[pos..len), and with iov set, long strings referenced in
+ * place between scratch segments as respb_serialize_iov() does */
+typedef struct {
+    uint8_t *buf;
+    size_t len;
+    size_t pos;
+    struct iovec *iov;
+    size_t max_iov;
+    size_t iovcnt;
+    size_t start;           /* Scratch not yet in an iovec */
+    size_t total;           /* Referenced bytes */
+} resp_writer_t;
+
+static const char digit_pairs[201] =
+    "0001020304050607080910111213141516171819"
+    "2021222324252627282930313233343536373839"
+    "4041424344454647484950515253545556575859"
+    "6061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+/* Decimal digits of v into out, two at a time from the end as Valkey's
+ * ull2string() does. Returns the length (at most 20) */
+static size_t format_u64(char *out, uint64_t v) {
+    size_t n = 1;
+    for (uint64_t t = v; t >= 10; t /= 10) n++;
+    size_t i = n;
+    while (v >= 100) {
+        size_t d = (size_t)(v % 100) * 2;
+        v /= 100;
+        out[--i] = digit_pairs[d + 1];
+        out[--i] = digit_pairs[d];
+    }
+    if (v >= 10) {
+        out[1] = digit_pairs[v * 2 + 1];
+        out[0] = digit_pairs[v * 2];
+    } else {
+        out[0] = (char)('0' + v);
+    }
+    return n;
+}
+
+static size_t format_i64(char *out, int64_t v) {
+    if (v >= 0) return format_u64(out, (uint64_t)v);
+    out[0] = '-';
+    return 1 + format_u64(out + 1, 0 - (uint64_t)v);
+}
+
+/* Shortest text strtod() reads back as v, within the first of these that
+ * applies: integers, decimals of up to 9 places (m / 10^k is v exactly
+ * when the division rounds to it), then %.17g. Returns 0 for NaN */
+static size_t format_f64(char *out, double v) {
+    static const double pow10[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    const double exact = 9007199254740992.0;    /* 2^53 */
+    if (isnan(v)) return 0;
+    if (isinf(v)) {
+        memcpy(out, v > 0 ? "inf" : "-inf", v > 0 ? 3 : 4);
+        return v > 0 ? 3 : 4;
+    }
+    if (v == 0) {
+        if (signbit(v)) {
+            memcpy(out, "-0", 2);
+            return 2;
+        }
+        out[0] = '0';
+        return 1;
+    }
+    for (size_t k = 0; k < sizeof(pow10) / sizeof(pow10[0]); k++) {
+        double scaled = v * pow10[k];
+        if (fabs(scaled) >= exact) break;
+        double m = nearbyint(scaled);
+        if (m / pow10[k] != v) continue;
+        size_t n = 0;
+        if (m < 0) {
+            out[n++] = '-';
+            m = -m;
+        }
+        char digits[24];
+        size_t nd = format_u64(digits, (uint64_t)m);
+        if (k == 0) {
+            memcpy(out + n, digits, nd);
+            return n + nd;
+        }
+        if (nd <= k) {
+            /* 0.00ddd */
+            out[n++] = '0';
+            out[n++] = '.';
+            memset(out + n, '0', k - nd);
+            n += k - nd;
+            memcpy(out + n, digits, nd);
+            return n + nd;
+        }
+        memcpy(out + n, digits, nd - k);
+        n += nd - k;
+        out[n++] = '.';
+        memcpy(out + n, digits + nd - k, k);
+        return n + k;
+    }
+    return (size_t)snprintf(out, 32, "%.17g", v);
+}
+
+static int writer_push(resp_writer_t *w, const void *base, size_t len) {
+    if (len == 0) return 1;
+    if (w->iovcnt == w->max_iov) return 0;
+    w->iov[w->iovcnt].iov_base = (void *)base;
+    w->iov[w->iovcnt].iov_len = len;
+    w->iovcnt++;
+    return 1;
+}
+
+/* "<type><n>\r\n" */
+static int put_length(resp_writer_t *w, char type, size_t n) {
+    if (23 > w->len - w->pos) return 0;
+    w->buf[w->pos] = (uint8_t)type;
+    w->pos += 1 + format_u64((char *)w->buf + w->pos + 1, n);
+    memcpy(w->buf + w->pos, "\r\n", 2);
+    w->pos += 2;
+    return 1;
+}
+
+static int put_bulk(resp_writer_t *w, const uint8_t *data, size_t n) {
+    if (!put_length(w, '$', n)) return 0;
+    if (w->iov && n >= RESPB_IOV_COPY_MAX) {
+        if (!writer_push(w, w->buf + w->start, w->pos - w->start) || !writer_push(w, data, n)) {
+            return 0;
+        }
+        w->total += n;
+        w->start = w->pos;
+    } else {
+        if (n > w->len - w->pos) return 0;
+        memcpy(w->buf + w->pos, data, n);
+        w->pos += n;
+    }
+    if (2 > w->len - w->pos) return 0;
+    memcpy(w->buf + w->pos, "\r\n", 2);
+    w->pos += 2;
+    return 1;
+}
+
+static int put_text(resp_writer_t *w, const char *text, size_t n) {
+    return put_bulk(w, (const uint8_t *)text, n);
+}
+
+/* True if a field after f takes a RESP argument */
+static int takes_arguments(const respb_field_t *f, const respb_field_t *end) {
+    for (f++; f < end; f++) {
+        if (f->kind == RESPB_FIELD_OPT) f++;
+        else if (f->kind != RESPB_FIELD_U8) return 1;
+    }
+    return 0;
+}
+
+/* Walk the schema over cmd's raw payload, the inverse of
+ * transcode_schema(). With w NULL only counts the bulks into *count.
+ * Returns 1, 0 if w ran out of room, -1 if the frame has no RESP form */
+static int write_fields(const respb_schema_t *schema, const respb_command_t *cmd, uint8_t flags,
+                        resp_writer_t *w, size_t *count) {
+    const int varint = flags & RESPB_FLAG_VARINT;
+    const int keydict = flags & RESPB_FLAG_KEYDICT;
+    const uint8_t *p = cmd->raw_payload;
+    const size_t len = cmd->raw_payload_len;
+    size_t pos = schema->flags & RESPB_SCHEMA_MODULE ? 4 : 0;
+    const respb_field_t *f = schema->fields, *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL, *group_end = NULL;
+    uint32_t group_left = 0;
+    size_t a = 0, bulks = 0, groups = 0;
+    uint8_t last_u8 = 0;
+    int skip_value = 0;
+    char text[40];
+
+/* One bulk, or one more in the count */
+#define EMIT(data, n) do { \
+    if (w) { \
+        int r_ = put_bulk(w, (const uint8_t *)(data), (n)); \
+        if (r_ != 1) return r_; \
+    } \
+    bulks++; \
+} while (0)
+
+    if (len < pos || (varint && keydict)) return -1;
+    while (f < end) {
+        switch (f->kind) {
+            case RESPB_FIELD_STR2:
+            case RESPB_FIELD_STR4: {
+                /* The span comes from cmd (key references resolved); the
+                 * payload is only stepped over */
+                size_t width = f->kind == RESPB_FIELD_STR2 ? 2 : 4;
+                uint32_t n;
+                if (varint) {
+                    int used = respb_read_varint(p + pos, len - pos, &n);
+                    if (used <= 0) return -1;
+                    pos += (size_t)used;
+                } else {
+                    if (width > len - pos) return -1;
+                    n = width == 2 ? respb_read_u16(p + pos) : respb_read_u32(p + pos);
+                    pos += width;
+                    if (keydict && width == 2 && n == RESPB_KEY_REF) n = 2;
+                }
+                if (n > len - pos || a == cmd->argc) return -1;
+                pos += n;
+                EMIT(cmd->args[a].data, cmd->args[a].len);
+                a++;
+                break;
+            }
+            case RESPB_FIELD_U8: {
+                if (1 > len - pos) return -1;
+                uint8_t v = last_u8 = p[pos++];
+                const option_names_t *opts = group_left ? NULL : find_option_names(schema);
+                if (!opts) {
+                    if (v != 0 || group_left || takes_arguments(f, end)) return -1;
+                    break;
+                }
+                for (size_t bit = 0; bit < 8; bit++) {
+                    if (!(v & (1u << bit))) continue;
+                    if (bit >= 4 || !opts->names[bit]) return -1;
+                    EMIT(opts->names[bit], strlen(opts->names[bit]));
+                    if (opts->value_bits & (1u << bit)) {
+                        /* Its value is the next field */
+                        if (f + 1 == end || 8 > len - pos) return -1;
+                        EMIT(text, format_i64(text, (int64_t)respb_read_u64(p + pos)));
+                    }
+                }
+                skip_value = opts->value_bits != 0;
+                break;
+            }
+            case RESPB_FIELD_U16:
+                if (2 > len - pos) return -1;
+                EMIT(text, format_u64(text, respb_read_u16(p + pos)));
+                pos += 2;
+                break;
+            case RESPB_FIELD_I64:
+                if (8 > len - pos) return -1;
+                if (skip_value) {
+                    skip_value = 0;
+                } else {
+                    EMIT(text, format_i64(text, (int64_t)respb_read_u64(p + pos)));
+                }
+                pos += 8;
+                break;
+            case RESPB_FIELD_F64: {
+                if (8 > len - pos) return -1;
+                size_t n = format_f64(text, respb_read_f64(p + pos));
+                if (n == 0) return -1;
+                EMIT(text, n);
+                pos += 8;
+                break;
+            }
+            case RESPB_FIELD_OPT:
+                if (!(last_u8 & f->arg)) f++;   /* skip the gated field */
+                break;
+            case RESPB_FIELD_GROUP: {
+                uint32_t n;
+                if (varint) {
+                    int used = respb_read_varint(p + pos, len - pos, &n);
+                    if (used <= 0 || n > 0xFFFF) return -1;
+                    pos += (size_t)used;
+                } else {
+                    if (2 > len - pos) return -1;
+                    n = respb_read_u16(p + pos);
+                    pos += 2;
+                }
+                const counted_group_t *counted = groups++ ? NULL : find_counted_group(schema);
+                if (counted) {
+                    if (counted->keyword) EMIT(counted->keyword, strlen(counted->keyword));
+                    EMIT(text, format_u64(text, n));
+                }
+                if (n == 0) {
+                    f += f->arg + 1;
+                    continue;
+                }
+                group_start = f + 1;
+                group_end = group_start + f->arg;
+                group_left = n;
+                f = group_start;
+                continue;
+            }
+            default:
+                return -1;
+        }
+        f++;
+        if (f == group_end && --group_left) f = group_start;
+    }
+#undef EMIT
+
+    if (pos != len || a != cmd->argc) return -1;
+    *count = bulks;
+    return 1;
+}
+
+/* Both forms: plain when iov is NULL */
+static int to_resp(resp_writer_t *w, const respb_command_t *cmd, uint8_t flags, size_t *resp_len) {
+    if (cmd->opcode == RESPB_OP_RESP_PASSTHROUGH) {
+        if (w->iov) {
+            if (!writer_push(w, cmd->resp_data, cmd->resp_length)) return 0;
+            w->total += cmd->resp_length;
+        } else {
+            if (cmd->resp_length > w->len) return 0;
+            memcpy(w->buf, cmd->resp_data, cmd->resp_length);
+            w->pos = cmd->resp_length;
+        }
+        *resp_len = cmd->resp_length;
+        return 1;
+    }
+    if (cmd->opcode == RESPB_OP_KEY_BIND) {
+        *resp_len = 0;
+        return 1;
+    }
+
+    const respb_schema_t *schema = cmd->opcode == RESPB_OP_MODULE
+        ? respb_schema_lookup_module(cmd->module_id, cmd->command_id)
+        : respb_schema_lookup(cmd->opcode);
+    if (!schema || schema->flags & (RESPB_SCHEMA_TAIL | RESPB_SCHEMA_SUBCOMMAND)) return -1;
+
+    /* The multibulk length needs the bulk count up front */
+    size_t count;
+    int result = write_fields(schema, cmd, flags, NULL, &count);
+    if (result != 1) return result;
+    if (!put_length(w, '*', count + 1) || !put_text(w, schema->name, strlen(schema->name))) {
+        return 0;
+    }
+    result = write_fields(schema, cmd, flags, w, &count);
+    if (result != 1) return result;
+    if (w->iov && !writer_push(w, w->buf + w->start, w->pos - w->start)) return 0;
+    *resp_len = w->pos + w->total;
+    return 1;
+}
+
+int respb_to_resp(uint8_t *buf, size_t buf_len, const respb_command_t *cmd, uint8_t flags,
+                  size_t *resp_len) {
+    resp_writer_t w = {buf, buf_len, 0, NULL, 0, 0, 0, 0};
+    return to_resp(&w, cmd, flags, resp_len);
+}
+
+int respb_to_resp_iov(uint8_t *scratch, size_t scratch_len, struct iovec *iov, size_t max_iov,
+                      size_t *iovcnt, const respb_command_t *cmd, uint8_t flags,
+                      size_t *resp_len) {
+    resp_writer_t w = {scratch, scratch_len, 0, iov, max_iov, 0, 0, 0};
+    int result = to_resp(&w, cmd, flags, resp_len);
+    if (result == 1) *iovcnt = w.iovcnt;
+    return result;
+}
@@ -450,6 +450,19 @@ void valkey_client_init(valkey_client *c, const uint8_t *buf, size_t len) {
     c->net_input_bytes_curr_cmd = 0;
 }
 
+void valkey_client_feed(valkey_client *c, const uint8_t *buf, size_t len) {
+    /* Drop bytes of already parsed commands, as Valkey does after
+     * processInputBuffer(), then append the new read */
+    if (c->qb_pos > 0) {
+        sdsrange(c->querybuf, c->qb_pos, -1);
+        c->qb_pos = 0;
+    }
+    c->querybuf = sdsMakeRoomFor(c->querybuf, len);
+    memcpy(c->querybuf + sdslen(c->querybuf), buf, len);
+    sdsIncrLen(c->querybuf, len);
+    if (sdslen(c->querybuf) > c->querybuf_peak) c->querybuf_peak = sdslen(c->querybuf);
+}
+
 void valkey_client_free(valkey_client *c) {
     if (c->querybuf) {
         sdsfree(c->querybuf);
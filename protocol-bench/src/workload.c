@@ -4,6 +4,8 @@
  */
 
 #include "benchmark.h"
+#include "respb.h"
+#include "respb_reply.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -130,7 +132,7 @@ workload_t *workload_generate_synthetic(size_t target_size, workload_type_t type
             
             while (wl->size + 1100 < target_size) {
                 int header_len = snprintf((char *)temp_buf, sizeof(temp_buf),
-                    "*3\r\n$3\r\nSET\r\n$9\r\nlargekey%zu\r\n$1024\r\n",
+                    "*3\r\n$3\r\nSET\r\n$10\r\nlargekey%02zu\r\n$1024\r\n",
                     wl->size % 100);
                 
                 if (wl->size + header_len + 1024 + 2 > target_size) break;
@@ -195,6 +197,341 @@ workload_t *workload_generate_synthetic(size_t target_size, workload_type_t type
     return wl;
 }
 
+// Generate back-to-back MGET, MSET or SADD commands of nelems keys, pairs or
+// members, in RESP or RESPB encoding. At least one command is emitted even if
+// it exceeds target_size.
+workload_t *workload_generate_multikey(size_t target_size, uint16_t opcode,
+                                       size_t nelems, int respb) {
+    if (nelems == 0 || nelems > UINT16_MAX) return NULL;
+    
+    const char *name;
+    int pairs = 0, keyed = 0;
+    switch (opcode) {
+        case RESPB_OP_MGET: name = "MGET"; break;
+        case RESPB_OP_MSET: name = "MSET"; pairs = 1; break;
+        case RESPB_OP_SADD: name = "SADD"; keyed = 1; break;
+        default: return NULL;
+    }
+    
+    // key:NNNNNN and value:NNNNNN are 10 and 12 bytes; RESP sizes are upper bounds
+    size_t elem_size = respb ? (2 + 10) + (pairs ? 4 + 12 : 0)
+                             : (5 + 10 + 2) + (pairs ? 5 + 12 + 2 : 0);
+    size_t frame_size = 32 + nelems * elem_size;
+    size_t frames = target_size / frame_size;
+    if (frames == 0) frames = 1;
+    
+    workload_t *wl = (workload_t *)malloc(sizeof(workload_t));
+    if (!wl) return NULL;
+    
+    wl->data = (uint8_t *)malloc(frames * frame_size + 1); // + snprintf terminator
+    if (!wl->data) {
+        free(wl);
+        return NULL;
+    }
+    
+    wl->size = 0;
+    wl->current_pos = 0;
+    
+    for (size_t f = 0; f < frames; f++) {
+        uint8_t *p = wl->data + wl->size;
+        if (respb) {
+            p += respb_serialize_header(p, opcode, 0);
+            if (keyed) {
+                respb_write_u16(p, 10);
+                memcpy(p + 2, "set:000000", 10);
+                p += 12;
+            }
+            respb_write_u16(p, (uint16_t)nelems);
+            p += 2;
+            for (size_t i = 0; i < nelems; i++) {
+                respb_write_u16(p, 10);
+                p += 2;
+                snprintf((char *)p, 11, "key:%06zu", i);
+                p += 10;
+                if (pairs) {
+                    respb_write_u32(p, 12);
+                    p += 4;
+                    memcpy(p, "value:", 6);
+                    snprintf((char *)p + 6, 7, "%06zu", i);
+                    p += 12;
+                }
+            }
+        } else {
+            p += sprintf((char *)p, "*%zu\r\n$4\r\n%s\r\n",
+                         1 + keyed + nelems * (pairs ? 2 : 1), name);
+            if (keyed) p += sprintf((char *)p, "$10\r\nset:000000\r\n");
+            for (size_t i = 0; i < nelems; i++) {
+                p += sprintf((char *)p, "$10\r\nkey:%06zu\r\n", i);
+                if (pairs) p += sprintf((char *)p, "$12\r\nvalue:%06zu\r\n", i);
+            }
+        }
+        wl->size = p - wl->data;
+    }
+    
+    printf("Generated %s %s workload: %zu x %zu elements, %zu bytes\n",
+           respb ? "RESPB" : "RESP", name, frames, nelems, wl->size);
+    return wl;
+}
+
+// Generate RESPB frames cycling through GET, SET, DEL and MGET (the mixed
+// synthetic commands), sending percent of them as RESP passthrough frames
+// spread evenly through the stream and the rest as native frames
+workload_t *workload_generate_passthrough(size_t target_size, unsigned percent) {
+    if (percent > 100) return NULL;
+    
+    workload_t *wl = (workload_t *)malloc(sizeof(workload_t));
+    if (!wl) return NULL;
+    
+    wl->data = (uint8_t *)malloc(target_size);
+    if (!wl->data) {
+        free(wl);
+        return NULL;
+    }
+    
+    wl->size = 0;
+    wl->current_pos = 0;
+    
+    char key[16], value[16], resp[128];
+    size_t cmd_count = 0, passthrough = 0;
+    while (wl->size + 200 < target_size) {
+        snprintf(key, sizeof(key), "key_%02zu", cmd_count % 100);
+        snprintf(value, sizeof(value), "val_%02zu", cmd_count % 100);
+        
+        respb_command_t cmd;
+        memset(&cmd, 0, sizeof(cmd));
+        int len = 0;
+        switch (cmd_count % 4) {
+            case 0:
+                cmd.opcode = RESPB_OP_GET;
+                cmd.argc = 1;
+                len = snprintf(resp, sizeof(resp), "*2\r\n$3\r\nGET\r\n$6\r\n%s\r\n", key);
+                break;
+            case 1:
+                cmd.opcode = RESPB_OP_SET;
+                cmd.argc = 2;
+                len = snprintf(resp, sizeof(resp), "*3\r\n$3\r\nSET\r\n$6\r\n%s\r\n$6\r\n%s\r\n",
+                               key, value);
+                break;
+            case 2:
+                cmd.opcode = RESPB_OP_DEL;
+                cmd.argc = 1;
+                len = snprintf(resp, sizeof(resp), "*2\r\n$3\r\nDEL\r\n$6\r\n%s\r\n", key);
+                break;
+            case 3:
+                cmd.opcode = RESPB_OP_MGET;
+                cmd.argc = 3;
+                len = snprintf(resp, sizeof(resp),
+                               "*4\r\n$4\r\nMGET\r\n$5\r\nkey_0\r\n$5\r\nkey_1\r\n$5\r\nkey_2\r\n");
+                break;
+        }
+        
+        uint8_t *p = wl->data + wl->size;
+        size_t avail = target_size - wl->size;
+        size_t frame_len;
+        if ((cmd_count + 1) * percent / 100 != cmd_count * percent / 100) {
+            cmd.opcode = RESPB_OP_RESP_PASSTHROUGH;
+            cmd.resp_data = (const uint8_t *)resp;
+            cmd.resp_length = (uint32_t)len;
+            passthrough++;
+        } else if (cmd.opcode == RESPB_OP_MGET) {
+            static const char *mget_keys[] = {"key_0", "key_1", "key_2"};
+            for (size_t i = 0; i < 3; i++) {
+                cmd.args[i].data = (const uint8_t *)mget_keys[i];
+                cmd.args[i].len = 5;
+            }
+        } else {
+            cmd.args[0].data = (const uint8_t *)key;
+            cmd.args[0].len = 6;
+            cmd.args[1].data = (const uint8_t *)value;
+            cmd.args[1].len = 6;
+        }
+        frame_len = respb_serialize_command(p, avail, &cmd);
+        if (frame_len == 0) break;
+        wl->size += frame_len;
+        cmd_count++;
+    }
+    
+    printf("Generated RESPB workload with %u%% passthrough: %zu commands (%zu passthrough), %zu bytes\n",
+           percent, cmd_count, passthrough, wl->size);
+    return wl;
+}
+
+// Generate RESPB module frames cycling through subcommands[0..3], which carry
+// the JSON.SET, JSON.GET, BF.ADD and FT.SEARCH payload layouts in that order
+workload_t *workload_generate_modules(size_t target_size, const uint32_t subcommands[4]) {
+    workload_t *wl = (workload_t *)malloc(sizeof(workload_t));
+    if (!wl) return NULL;
+    
+    wl->data = (uint8_t *)malloc(target_size);
+    if (!wl->data) {
+        free(wl);
+        return NULL;
+    }
+    
+    wl->size = 0;
+    wl->current_pos = 0;
+    
+    size_t cmd_count = 0;
+    while (wl->size + 200 < target_size) {
+        uint8_t *p = wl->data + wl->size;
+        uint32_t subcommand = subcommands[cmd_count % 4];
+        respb_write_u16(p, RESPB_OP_MODULE);
+        respb_write_u16(p + 2, 0);
+        respb_write_u32(p + 4, subcommand);
+        p += 8;
+        
+        // key:XX and the other strings are fixed-size, so no length math below
+        respb_write_u16(p, 6);
+        snprintf((char *)p + 2, 7, "key:%02zu", cmd_count % 100);
+        p += 8;
+        switch (cmd_count % 4) {
+            case 0: // JSON.SET: [path][4B json][1B flags]
+                respb_write_u16(p, 1);
+                memcpy(p + 2, "$", 1);
+                respb_write_u32(p + 3, 13);
+                memcpy(p + 7, "{\"field\":123}", 13);
+                p[20] = 0;
+                p += 21;
+                break;
+            case 1: // JSON.GET: [2B numpaths][path]
+                respb_write_u16(p, 1);
+                respb_write_u16(p + 2, 7);
+                memcpy(p + 4, "$.field", 7);
+                p += 11;
+                break;
+            case 2: // BF.ADD: [item]
+                respb_write_u16(p, 8);
+                memcpy(p + 2, "item:abc", 8);
+                p += 10;
+                break;
+            case 3: // FT.SEARCH: [query]
+                respb_write_u16(p, 12);
+                memcpy(p + 2, "@title:hello", 12);
+                p += 14;
+                break;
+        }
+        wl->size = p - wl->data;
+        cmd_count++;
+    }
+    
+    printf("Generated RESPB module workload (0x%08X...): %zu commands, %zu bytes\n",
+           subcommands[0], cmd_count, wl->size);
+    return wl;
+}
+
+static const char *reply_kind_names[REPLY_KIND_COUNT] = {
+    "OK", "INT", "BULK", "NULL", "MGET", "LRANGE", "HGETALL", "EXEC", "MIXED"
+};
+
+const char *workload_reply_kind_name(reply_kind_t kind) {
+    return kind < REPLY_KIND_COUNT ? reply_kind_names[kind] : "?";
+}
+
+static void reply_leaf(respb_reply_t *node, uint8_t type, const char *data, size_t len) {
+    memset(node, 0, sizeof(*node));
+    node->type = type;
+    node->data = (const uint8_t *)data;
+    node->len = len;
+}
+
+// Fill nodes with reply number seq of the given shape; strings point into
+// names (100 slots of 16 bytes) or static text. Returns the node count
+static size_t reply_build(respb_reply_t *nodes, reply_kind_t kind, size_t seq,
+                          char (*names)[16]) {
+    static const char value[] =
+        "vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv";
+    static const char wrongtype[] =
+        "WRONGTYPE Operation against a key holding the wrong kind of value";
+    if (kind == REPLY_KIND_MIXED) kind = (reply_kind_t)(seq % REPLY_KIND_MIXED);
+
+    size_t n = 0, elems = 0;
+    switch (kind) {
+        case REPLY_KIND_OK:
+            reply_leaf(&nodes[n++], RESPB_REPLY_STATUS, "OK", 2);
+            break;
+        case REPLY_KIND_INT:
+            reply_leaf(&nodes[n++], RESPB_REPLY_INT, NULL, 0);
+            nodes[0].integer = (int64_t)(seq * 7919 % 1000000);
+            break;
+        case REPLY_KIND_BULK:
+            reply_leaf(&nodes[n++], RESPB_REPLY_BULK, value, 64);
+            break;
+        case REPLY_KIND_NULL:
+            reply_leaf(&nodes[n++], RESPB_REPLY_NULL, NULL, 0);
+            break;
+        case REPLY_KIND_MGET:
+        case REPLY_KIND_LRANGE:
+        case REPLY_KIND_HGETALL:
+            elems = kind == REPLY_KIND_MGET ? 10 : kind == REPLY_KIND_LRANGE ? 100 : 40;
+            reply_leaf(&nodes[n++], RESPB_REPLY_ARRAY, NULL, 0);
+            nodes[0].count = (uint32_t)elems;
+            for (size_t i = 0; i < elems; i++) {
+                if (kind == REPLY_KIND_MGET && i % 3 == 2) {
+                    reply_leaf(&nodes[n++], RESPB_REPLY_NULL, NULL, 0);
+                } else if (kind == REPLY_KIND_HGETALL && i % 2 == 0) {
+                    int len = snprintf(names[i], 16, "field:%02zu", i / 2);
+                    reply_leaf(&nodes[n++], RESPB_REPLY_BULK, names[i], (size_t)len);
+                } else if (kind == REPLY_KIND_LRANGE) {
+                    int len = snprintf(names[i], 16, "item:%zu", seq % 1000 + i);
+                    reply_leaf(&nodes[n++], RESPB_REPLY_BULK, names[i], (size_t)len);
+                } else {
+                    reply_leaf(&nodes[n++], RESPB_REPLY_BULK, value, 16);
+                }
+            }
+            break;
+        default:
+            reply_leaf(&nodes[n++], RESPB_REPLY_ARRAY, NULL, 0);
+            nodes[0].count = 4;
+            reply_leaf(&nodes[n++], RESPB_REPLY_STATUS, "OK", 2);
+            reply_leaf(&nodes[n++], RESPB_REPLY_INT, NULL, 0);
+            nodes[2].integer = (int64_t)seq;
+            reply_leaf(&nodes[n++], RESPB_REPLY_ARRAY, NULL, 0);
+            nodes[3].count = 2;
+            reply_leaf(&nodes[n++], RESPB_REPLY_BULK, value, 8);
+            reply_leaf(&nodes[n++], RESPB_REPLY_BULK, value, 12);
+            reply_leaf(&nodes[n++], RESPB_REPLY_ERROR, wrongtype, sizeof(wrongtype) - 1);
+            break;
+    }
+    return n;
+}
+
+// Generate a stream of replies of one shape, as RESPB reply frames
+// (respb=1) or RESP2 text (respb=0). The same seed yields the same replies
+// in both formats
+workload_t *workload_generate_replies(size_t target_size, reply_kind_t kind, int respb) {
+    if (kind >= REPLY_KIND_COUNT) return NULL;
+
+    workload_t *wl = (workload_t *)malloc(sizeof(workload_t));
+    if (!wl) return NULL;
+    
+    wl->data = (uint8_t *)malloc(target_size);
+    if (!wl->data) {
+        free(wl);
+        return NULL;
+    }
+    
+    wl->size = 0;
+    wl->current_pos = 0;
+    
+    respb_reply_t nodes[128];
+    char names[100][16];
+    size_t reply_count = 0;
+    for (;;) {
+        size_t n = reply_build(nodes, kind, reply_count, names);
+        uint8_t *p = wl->data + wl->size;
+        size_t avail = target_size - wl->size;
+        size_t len = respb ? respb_serialize_reply(p, avail, (uint16_t)reply_count, nodes, n)
+                           : respb_reply_to_resp(p, avail, nodes, n);
+        if (len == 0) break;
+        wl->size += len;
+        reply_count++;
+    }
+    
+    printf("Generated %s %s reply workload: %zu replies, %zu bytes\n",
+           respb ? "RESPB" : "RESP", reply_kind_names[kind], reply_count, wl->size);
+    return wl;
+}
+
 // Save workload to file
 int workload_save(const workload_t *wl, const char *filename) {
     FILE *f = fopen(filename, "wb");
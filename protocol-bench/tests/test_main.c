@@ -4,10 +4,30 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <assert.h>
+#include <math.h>
 #include "../include/respb.h"
+#include "../include/respb_schema.h"
+#include "../include/respb_batch.h"
+#include "../include/respb_stream.h"
+#include "../include/respb_args.h"
+#include "../include/respb_iter.h"
+#include "../include/respb_frame.h"
+#include "../include/respb_passthrough.h"
+#include "../include/respb_pipeline.h"
+#include "../include/respb_reply.h"
+#include "../include/respb_compress.h"
+#include "../include/respb_keydict.h"
+#include "../include/respb_handshake.h"
+#include "../include/respb_transcode.h"
+#include "../include/respb_aof.h"
+#include "../include/respb_index.h"
+#include "../include/respb_compact.h"
 #include "../include/valkey_resp_parser.h"
+#include "../include/hiredis_reader.h"
 
 int tests_passed = 0;
 int tests_failed = 0;
@@ -53,6 +73,14 @@ static size_t add_string_4b(uint8_t *buf, const char *str) {
     return 4 + len;
 }
 
+// Helper to add an IEEE-754 double
+static size_t add_f64(uint8_t *buf, double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    respb_write_u64(buf, bits);
+    return 8;
+}
+
 void test_resp_simple_get() {
     TEST("RESP simple GET (Valkey parser)");
     
@@ -2037,8 +2065,9 @@ void test_respb_zadd() {
     respb_parser_init(&parser, data, pos);
     respb_command_t cmd;
     
-    // Parser is simplified - only stores key, skips score/member pairs
-    if (respb_parse_command(&parser, &cmd) != 1 || cmd.opcode != RESPB_OP_ZADD || cmd.argc != 1) {
+    // Key and member; the score is read back in place
+    if (respb_parse_command(&parser, &cmd) != 1 || cmd.opcode != RESPB_OP_ZADD || cmd.argc != 2 ||
+        cmd.args[1].len != 6 || memcmp(cmd.args[1].data, "member", 6) != 0) {
         FAIL("Parse error");
         return;
     }
@@ -2544,6 +2573,7 @@ void test_respb_hscan() {
     data[pos + 7] = 0;  // 8-byte cursor
     pos += 8;
     // Optional pattern and count omitted
+    data[pos++] = 0x00;  // novalues
     
     respb_parser_t parser;
     respb_parser_init(&parser, data, pos);
@@ -2561,7 +2591,8 @@ void test_respb_hrandfield() {
     uint8_t data[200];
     size_t pos = build_header(data, RESPB_OP_HRANDFIELD, 0);
     pos += add_string_2b(data + pos, "hash");
-    // Optional count and withvalues omitted
+    // Optional count omitted
+    data[pos++] = 0x00;  // withvalues
     
     respb_parser_t parser;
     respb_parser_init(&parser, data, pos);
@@ -2994,7 +3025,8 @@ void test_respb_zrandmember() {
     uint8_t data[200];
     size_t pos = build_header(data, RESPB_OP_ZRANDMEMBER, 0);
     pos += add_string_2b(data + pos, "zset");
-    // Optional count and withscores omitted
+    // Optional count omitted
+    data[pos++] = 0x00;  // withscores
     
     respb_parser_t parser;
     respb_parser_init(&parser, data, pos);
@@ -3143,7 +3175,8 @@ void test_respb_zscan() {
     memset(data + pos, 0, 7);
     data[pos + 7] = 0;  // 8-byte cursor
     pos += 8;
-    // Optional pattern, count, noscores omitted
+    // Optional pattern and count omitted
+    data[pos++] = 0x00;  // noscores
     
     respb_parser_t parser;
     respb_parser_init(&parser, data, pos);
@@ -5167,7 +5200,8 @@ void test_respb_bitcount() {
     uint8_t data[200];
     size_t pos = build_header(data, RESPB_OP_BITCOUNT, 0);
     pos += add_string_2b(data + pos, "key");
-    // Optional start, end, unit omitted
+    // Optional start and end omitted
+    data[pos++] = 0x00;  // unit
     
     respb_parser_t parser;
     respb_parser_init(&parser, data, pos);
@@ -5186,7 +5220,8 @@ void test_respb_bitpos() {
     size_t pos = build_header(data, RESPB_OP_BITPOS, 0);
     pos += add_string_2b(data + pos, "key");
     data[pos++] = 0x01;  // bit
-    // Optional start, end, unit omitted
+    // Optional start and end omitted
+    data[pos++] = 0x00;  // unit
     
     respb_parser_t parser;
     respb_parser_init(&parser, data, pos);
@@ -5345,7 +5380,7 @@ void test_respb_geoadd() {
     respb_parser_init(&parser, data, pos);
     respb_command_t cmd;
     
-    if (respb_parse_command(&parser, &cmd) != 1 || cmd.opcode != RESPB_OP_GEOADD || cmd.argc != 1) {
+    if (respb_parse_command(&parser, &cmd) != 1 || cmd.opcode != RESPB_OP_GEOADD || cmd.argc != 2) {
         FAIL("Parse error");
         return;
     }
@@ -5571,7 +5606,7 @@ void test_respb_xadd() {
     respb_parser_init(&parser, data, pos);
     respb_command_t cmd;
     
-    if (respb_parse_command(&parser, &cmd) != 1 || cmd.opcode != RESPB_OP_XADD || cmd.argc != 3) {
+    if (respb_parse_command(&parser, &cmd) != 1 || cmd.opcode != RESPB_OP_XADD || cmd.argc != 4) {
         FAIL("Parse error");
         return;
     }
@@ -5662,7 +5697,8 @@ void test_respb_xreadgroup() {
     size_t pos = build_header(data, RESPB_OP_XREADGROUP, 0);
     pos += add_string_2b(data + pos, "group");
     pos += add_string_2b(data + pos, "consumer");
-    // Optional count, block, noack omitted
+    // Optional count and block omitted
+    data[pos++] = 0x00;  // noack
     data[pos++] = 0x00;
     data[pos++] = 0x01;  // numkeys
     pos += add_string_2b(data + pos, "key");
@@ -5836,7 +5872,8 @@ void test_respb_xautoclaim() {
     data[pos + 7] = 1000;  // 8-byte min_idle
     pos += 8;
     pos += add_string_2b(data + pos, "start");
-    // Optional count and justid omitted
+    // Optional count omitted
+    data[pos++] = 0x00;  // justid
     
     respb_parser_t parser;
     respb_parser_init(&parser, data, pos);
@@ -5938,6 +5975,3632 @@ void test_respb_error_unknown_opcode() {
     PASS();
 }
 
+// Table-Driven Decoder Tests
+void test_table_matches_switch() {
+    TEST("Table decoder matches switch (SET, MSET, HSET, JSON.SET)");
+    uint8_t data[512];
+    size_t pos = build_header(data, RESPB_OP_SET, 7);
+    pos += add_string_2b(data + pos, "key");
+    pos += add_string_4b(data + pos, "value");
+    memset(data + pos, 0, 9);  // flags + expiry
+    pos += 9;
+    pos += build_header(data + pos, RESPB_OP_MSET, 0);
+    data[pos++] = 0x00;
+    data[pos++] = 0x02;  // count
+    pos += add_string_2b(data + pos, "k1");
+    pos += add_string_4b(data + pos, "v1");
+    pos += add_string_2b(data + pos, "k2");
+    pos += add_string_4b(data + pos, "v2");
+    pos += build_header(data + pos, RESPB_OP_HSET, 0);
+    pos += add_string_2b(data + pos, "hash");
+    data[pos++] = 0x00;
+    data[pos++] = 0x01;  // count
+    pos += add_string_2b(data + pos, "field");
+    pos += add_string_4b(data + pos, "value");
+    pos += build_header(data + pos, RESPB_OP_MODULE, 0);
+    memset(data + pos, 0, 4);  // JSON.SET subcommand
+    pos += 4;
+    pos += add_string_2b(data + pos, "doc");
+    pos += add_string_2b(data + pos, "$");
+    pos += add_string_4b(data + pos, "{\"a\":1}");
+    data[pos++] = 0x00;  // flags
+    
+    respb_parser_t sw, tb;
+    respb_parser_init(&sw, data, pos);
+    respb_parser_init(&tb, data, pos);
+    for (int i = 0; i < 4; i++) {
+        respb_command_t a, b;
+        if (respb_parse_command(&sw, &a) != 1 || respb_parse_command_table(&tb, &b) != 1) {
+            FAIL("Parse error");
+            return;
+        }
+        if (a.opcode != b.opcode || a.mux_id != b.mux_id || a.argc != b.argc ||
+            sw.pos != tb.pos || a.raw_payload_len != b.raw_payload_len) {
+            FAIL("Decoders disagree");
+            return;
+        }
+        for (size_t j = 0; j < a.argc; j++) {
+            if (a.args[j].len != b.args[j].len || a.args[j].data != b.args[j].data) {
+                FAIL("Argument mismatch");
+                return;
+            }
+        }
+    }
+    if (tb.pos != pos) {
+        FAIL("Buffer not fully consumed");
+        return;
+    }
+    PASS();
+}
+
+void test_table_zadd_full_decode() {
+    TEST("Table decoder ZADD decodes every score/member pair");
+    uint8_t data[300];
+    size_t pos = build_header(data, RESPB_OP_ZADD, 0);
+    pos += add_string_2b(data + pos, "zset");
+    data[pos++] = 0x00;  // flags
+    data[pos++] = 0x00;
+    data[pos++] = 0x02;  // count
+    memset(data + pos, 0, 8);  // score
+    pos += 8;
+    pos += add_string_2b(data + pos, "m1");
+    memset(data + pos, 0, 8);  // score
+    pos += 8;
+    pos += add_string_2b(data + pos, "m2");
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, data, pos);
+    respb_command_t cmd;
+    
+    if (respb_parse_command_table(&parser, &cmd) != 1 || cmd.argc != 3 || parser.pos != pos ||
+        cmd.args[2].len != 2 || memcmp(cmd.args[2].data, "m2", 2) != 0) {
+        FAIL("Parse error");
+        return;
+    }
+    PASS();
+}
+
+void test_table_gated_expiry() {
+    TEST("Table decoder GETEX expiry gated by flags");
+    uint8_t data[64];
+    size_t pos = build_header(data, RESPB_OP_GETEX, 0);
+    pos += add_string_2b(data + pos, "key");
+    data[pos++] = 0x00;  // no expiry
+    size_t first_end = pos;
+    pos += build_header(data + pos, RESPB_OP_GETEX, 0);
+    pos += add_string_2b(data + pos, "key");
+    data[pos++] = 0x01;  // has expiry
+    memset(data + pos, 0, 8);
+    pos += 8;
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, data, pos);
+    respb_command_t cmd;
+    
+    if (respb_parse_command_table(&parser, &cmd) != 1 || parser.pos != first_end ||
+        respb_parse_command_table(&parser, &cmd) != 1 || parser.pos != pos || cmd.argc != 1) {
+        FAIL("Parse error");
+        return;
+    }
+    PASS();
+}
+
+void test_table_truncated_and_unknown() {
+    TEST("Table decoder incomplete and unknown frames");
+    uint8_t data[32];
+    size_t pos = build_header(data, RESPB_OP_MGET, 0);
+    data[pos++] = 0x00;
+    data[pos++] = 0x02;  // count 2, only one key present
+    pos += add_string_2b(data + pos, "key");
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, data, pos);
+    respb_command_t cmd;
+    
+    if (respb_parse_command_table(&parser, &cmd) != 0 || parser.pos != 0) {
+        FAIL("Should return 0 and leave position for incomplete");
+        return;
+    }
+    
+    pos = build_header(data, 0xBEEF, 0);
+    respb_parser_init(&parser, data, pos);
+    if (respb_parse_command_table(&parser, &cmd) != -1) {
+        FAIL("Should return -1 for unknown");
+        return;
+    }
+    PASS();
+}
+
+void test_schema_lookup_coverage() {
+    TEST("Schema lookup resolves every generated schema");
+    for (size_t i = 0; i < respb_schema_count; i++) {
+        const respb_schema_t *s = &respb_schemas[i];
+        const respb_schema_t *found = (s->flags & RESPB_SCHEMA_MODULE)
+            ? respb_schema_lookup_module(s->code >> 16, s->code & 0xFFFF)
+            : respb_schema_lookup((uint16_t)s->code);
+        if (found != s) {
+            FAIL(s->name);
+            return;
+        }
+    }
+    if (!respb_schema_lookup(RESPB_OP_GET) || respb_schema_lookup(RESPB_OP_RESP_PASSTHROUGH)) {
+        FAIL("Core lookup");
+        return;
+    }
+    PASS();
+}
+
+// Batch Parser Tests
+void test_batch_struct_of_arrays() {
+    TEST("Batch parse fills struct-of-arrays output");
+    uint8_t data[256];
+    size_t pos = build_header(data, RESPB_OP_GET, 1);
+    pos += add_string_2b(data + pos, "key");
+    size_t second = pos;
+    pos += build_header(data + pos, RESPB_OP_MGET, 2);
+    data[pos++] = 0x00;
+    data[pos++] = 0x02;  // count
+    pos += add_string_2b(data + pos, "a");
+    pos += add_string_2b(data + pos, "bb");
+    size_t third = pos;
+    pos += build_header(data + pos, RESPB_OP_MODULE, 3);
+    data[pos++] = 0x00;
+    data[pos++] = 0x01;  // BF module
+    data[pos++] = 0x00;
+    data[pos++] = 0x00;  // BF.ADD
+    pos += add_string_2b(data + pos, "bf");
+    pos += add_string_2b(data + pos, "item");
+    size_t complete = pos;
+    pos += build_header(data + pos, RESPB_OP_GET, 4);
+    data[pos++] = 0x00;  // truncated key length
+    
+    respb_batch_t batch;
+    if (!respb_batch_init(&batch, 8, 16)) {
+        FAIL("Init failed");
+        return;
+    }
+    size_t n = respb_parse_batch(data, pos, &batch, 8);
+    int ok = n == 3 && batch.status == 0 && batch.consumed == complete &&
+             ((uintptr_t)batch.opcodes % RESPB_CACHE_LINE) == 0 &&
+             ((uintptr_t)batch.args % RESPB_CACHE_LINE) == 0 &&
+             batch.opcodes[1] == RESPB_OP_MGET && batch.mux_ids[2] == 3 &&
+             batch.subcommands[2] == 0x00010000 &&
+             batch.frame_offsets[1] == second && batch.frame_offsets[2] == third &&
+             batch.frame_offsets[3] == complete &&
+             batch.arg_first[1] == 1 && batch.arg_first[2] == 3 && batch.arg_first[3] == 5 &&
+             batch.args[2].len == 2 && memcmp(batch.args[2].data, "bb", 2) == 0;
+    respb_batch_free(&batch);
+    if (!ok) {
+        FAIL("Wrong batch output");
+        return;
+    }
+    PASS();
+}
+
+void test_batch_limits() {
+    TEST("Batch parse stops at max frames and arg capacity");
+    uint8_t data[128];
+    size_t pos = 0;
+    for (int i = 0; i < 3; i++) {
+        pos += build_header(data + pos, RESPB_OP_MGET, 0);
+        data[pos++] = 0x00;
+        data[pos++] = 0x02;  // count
+        pos += add_string_2b(data + pos, "a");
+        pos += add_string_2b(data + pos, "b");
+    }
+    size_t frame_len = pos / 3;
+    
+    respb_batch_t batch;
+    if (!respb_batch_init(&batch, 8, 3)) {
+        FAIL("Init failed");
+        return;
+    }
+    // Arg capacity 3 fits one MGET (2 args) but not a second
+    size_t n1 = respb_parse_batch(data, pos, &batch, 8);
+    size_t consumed1 = batch.consumed;
+    int status1 = batch.status;
+    // Frame limit of 1 stops after the first frame
+    size_t n2 = respb_parse_batch(data, pos, &batch, 1);
+    int ok = n1 == 1 && consumed1 == frame_len && status1 == 1 &&
+             n2 == 1 && batch.consumed == frame_len;
+    
+    uint8_t bad[4];
+    build_header(bad, 0xBEEF, 0);
+    size_t n3 = respb_parse_batch(bad, sizeof(bad), &batch, 8);
+    ok = ok && n3 == 0 && batch.status == -1 && batch.consumed == 0;
+    respb_batch_free(&batch);
+    
+    // One MGET with more keys than the whole batch holds
+    pos = build_header(data, RESPB_OP_MGET, 0);
+    data[pos++] = 0x00;
+    data[pos++] = 0x03;  // count
+    pos += add_string_2b(data + pos, "a");
+    pos += add_string_2b(data + pos, "b");
+    pos += add_string_2b(data + pos, "c");
+    if (!respb_batch_init(&batch, 8, 2)) {
+        FAIL("Init failed");
+        return;
+    }
+    size_t n4 = respb_parse_batch(data, pos, &batch, 8);
+    ok = ok && n4 == 0 && batch.status == -2 && batch.consumed == 0;
+    respb_batch_free(&batch);
+    if (!ok) {
+        FAIL("Wrong limit handling");
+        return;
+    }
+    PASS();
+}
+
+// Streaming Parser Tests
+static size_t build_stream_frames(uint8_t *data) {
+    size_t pos = build_header(data, RESPB_OP_SET, 1);
+    pos += add_string_2b(data + pos, "key");
+    pos += add_string_4b(data + pos, "a fairly long value split over feeds");
+    memset(data + pos, 0, 9);  // flags + expiry
+    pos += 9;
+    pos += build_header(data + pos, RESPB_OP_ZADD, 2);
+    pos += add_string_2b(data + pos, "zset");
+    data[pos++] = 0x00;  // flags
+    data[pos++] = 0x00;
+    data[pos++] = 0x02;  // count
+    memset(data + pos, 0, 8);
+    pos += 8;
+    pos += add_string_2b(data + pos, "m1");
+    memset(data + pos, 0, 8);
+    pos += 8;
+    pos += add_string_2b(data + pos, "m2");
+    pos += build_header(data + pos, RESPB_OP_RESP_PASSTHROUGH, 3);
+    const char *resp = "*1\r\n$4\r\nPING\r\n";
+    pos += add_string_4b(data + pos, resp);
+    return pos;
+}
+
+void test_stream_byte_by_byte() {
+    TEST("Stream parser resumes frames fed one byte at a time");
+    uint8_t data[256];
+    size_t len = build_stream_frames(data);
+    
+    respb_stream_t stream;
+    respb_stream_init(&stream);
+    respb_command_t cmd;
+    size_t frames = 0;
+    int ok = 1;
+    for (size_t i = 0; i < len && ok; i++) {
+        size_t consumed;
+        int result = respb_parser_feed(&stream, data + i, 1, &consumed, &cmd);
+        if (consumed != 1 || result < 0) ok = 0;
+        if (result != 1) continue;
+        frames++;
+        if (frames == 1) {
+            ok = cmd.opcode == RESPB_OP_SET && cmd.argc == 2 && cmd.args[1].len == 36 &&
+                 memcmp(cmd.args[1].data, "a fairly long", 13) == 0;
+        } else if (frames == 2) {
+            ok = cmd.opcode == RESPB_OP_ZADD && cmd.mux_id == 2 && cmd.argc == 3 &&
+                 cmd.args[2].len == 2 && memcmp(cmd.args[2].data, "m2", 2) == 0;
+        } else {
+            ok = cmd.opcode == RESPB_OP_RESP_PASSTHROUGH && cmd.resp_length == 14 &&
+                 memcmp(cmd.resp_data, "*1\r\n", 4) == 0;
+        }
+    }
+    ok = ok && frames == 3 && respb_stream_pending(&stream) == 0;
+    respb_stream_free(&stream);
+    if (!ok) {
+        FAIL("Wrong streamed commands");
+        return;
+    }
+    PASS();
+}
+
+void test_stream_chunk_sizes() {
+    TEST("Stream parser agrees with table decoder for all chunk sizes");
+    uint8_t data[256];
+    size_t len = build_stream_frames(data);
+    
+    for (size_t chunk = 1; chunk <= len; chunk++) {
+        respb_stream_t stream;
+        respb_stream_init(&stream);
+        respb_parser_t parser;
+        respb_parser_init(&parser, data, len);
+        respb_command_t expected, cmd;
+        size_t frames = 0;
+        
+        for (size_t off = 0; off < len; off += chunk) {
+            size_t n = len - off < chunk ? len - off : chunk;
+            size_t used = 0;
+            while (used < n) {
+                size_t consumed;
+                int result = respb_parser_feed(&stream, data + off + used, n - used, &consumed, &cmd);
+                used += consumed;
+                if (result == 0) break;
+                if (result < 0 || respb_parse_command_table(&parser, &expected) != 1 ||
+                    expected.opcode != cmd.opcode || expected.argc != cmd.argc ||
+                    expected.raw_payload_len != cmd.raw_payload_len) {
+                    respb_stream_free(&stream);
+                    FAIL("Mismatch");
+                    return;
+                }
+                frames++;
+            }
+        }
+        respb_stream_free(&stream);
+        if (frames != 3) {
+            FAIL("Missing frames");
+            return;
+        }
+    }
+    PASS();
+}
+
+void test_stream_split_views() {
+    TEST("Stream parser fills the view of frames split across feeds");
+    uint8_t data[256], out[256];
+    size_t pos = build_header(data, RESPB_OP_ZADD, 2);
+    pos += add_string_2b(data + pos, "zset");
+    data[pos++] = 0x00;  // flags
+    data[pos++] = 0x00;
+    data[pos++] = 0x02;  // count
+    pos += add_f64(data + pos, 1.5);
+    pos += add_string_2b(data + pos, "m1");
+    pos += add_f64(data + pos, -2.25);
+    pos += add_string_2b(data + pos, "m2");
+    size_t zadd_len = pos;
+    pos += build_header(data + pos, RESPB_OP_SET, 3);
+    pos += add_string_2b(data + pos, "key");
+    pos += add_string_4b(data + pos, "value");
+    data[pos++] = 0x02;  // flags
+    respb_write_u64(data + pos, 5000);
+    pos += 8;
+    size_t len = pos;
+    
+    int ok = 1;
+    for (size_t split = 1; ok && split < len; split++) {
+        respb_stream_t stream;
+        respb_stream_init(&stream);
+        respb_command_t cmd;
+        size_t frames = 0, start = 0, off = 0;
+        while (ok && off < len) {
+            size_t end = off < split ? split : len;
+            size_t consumed;
+            memset(&cmd.view, 0xFF, sizeof(cmd.view));
+            int result = respb_parser_feed(&stream, data + off, end - off, &consumed, &cmd);
+            off += consumed;
+            if (result < 0) ok = 0;
+            if (result != 1) continue;
+            size_t frame_len = frames == 0 ? zadd_len : len - zadd_len;
+            if (frames == 0) {
+                ok = cmd.view.zadd.count == 2 && respb_zadd_score(&cmd, 0) == 1.5 &&
+                     respb_zadd_score(&cmd, 1) == -2.25;
+            } else {
+                ok = cmd.view.set.flags == 0x02 && cmd.view.set.expiry == 5000;
+            }
+            // Re-serializes from the view to the frame it came from
+            ok = ok && respb_serialize_command(out, sizeof(out), &cmd) == frame_len &&
+                 memcmp(out, data + start, frame_len) == 0;
+            start += frame_len;
+            frames++;
+        }
+        ok = ok && frames == 2 && respb_stream_pending(&stream) == 0;
+        respb_stream_free(&stream);
+    }
+    if (!ok) {
+        FAIL("Wrong view after a split feed");
+        return;
+    }
+    PASS();
+}
+
+// Argument Arena Tests
+static size_t build_mset(uint8_t *buf, uint16_t nkeys) {
+    size_t pos = build_header(buf, RESPB_OP_MSET, 0);
+    buf[pos++] = (nkeys >> 8) & 0xFF;
+    buf[pos++] = nkeys & 0xFF;
+    for (uint16_t i = 0; i < nkeys; i++) {
+        char key[16], val[16];
+        snprintf(key, sizeof(key), "k%05u", i);
+        snprintf(val, sizeof(val), "v%05u", i);
+        pos += add_string_2b(buf + pos, key);
+        pos += add_string_4b(buf + pos, val);
+    }
+    return pos;
+}
+
+void test_switch_consumes_past_max_args() {
+    TEST("Switch parser consumes MSET past RESPB_MAX_ARGS");
+    static uint8_t buf[8192];
+    size_t len = build_mset(buf, 100);
+    len += build_header(buf + len, RESPB_OP_GET, 7);
+    len += add_string_2b(buf + len, "after");
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, buf, len);
+    respb_command_t cmd;
+    if (respb_parse_command(&parser, &cmd) != 1 || cmd.argc != RESPB_MAX_ARGS) {
+        FAIL("MSET not parsed");
+        return;
+    }
+    if (respb_parse_command(&parser, &cmd) != 1 || cmd.opcode != RESPB_OP_GET ||
+        cmd.mux_id != 7 || parser.pos != len) {
+        FAIL("Parser out of sync after large MSET");
+        return;
+    }
+    PASS();
+}
+
+void test_compact_large_mset() {
+    TEST("Compact command holds all 20000 args of a 10k-key MSET");
+    static uint8_t buf[10000 * 18 + 64];
+    size_t len = build_mset(buf, 10000);
+    
+    respb_arena_t arena;
+    respb_arena_init(&arena, 16);
+    respb_parser_t parser;
+    respb_parser_init(&parser, buf, len);
+    respb_cmd_t cmd;
+    int result = respb_parse_compact(&parser, &cmd, &arena);
+    const respb_arg_t *args = respb_cmd_args(&cmd);
+    int ok = result == 1 && cmd.argc == 20000 && parser.pos == len &&
+             args[19998].len == 6 && memcmp(args[19998].data, "k09999", 6) == 0 &&
+             memcmp(args[19999].data, "v09999", 6) == 0;
+    
+    // Reset folds the grown chain into one block: the next parse reuses it
+    respb_arena_reset(&arena);
+    ok = ok && arena.head && !arena.head->prev && arena.head->capacity >= 20000;
+    respb_parser_init(&parser, buf, len);
+    ok = ok && respb_parse_compact(&parser, &cmd, &arena) == 1 &&
+         respb_cmd_args(&cmd) == arena.head->args;
+    respb_arena_free(&arena);
+    if (!ok) {
+        FAIL("Wrong large MSET decode");
+        return;
+    }
+    PASS();
+}
+
+void test_compact_inline_and_growth() {
+    TEST("Compact command keeps small frames inline and spans across growth");
+    static uint8_t buf[4096];
+    size_t len = build_mset(buf, 40);
+    size_t first_end = len;
+    len += build_mset(buf + len, 60);
+    len += build_header(buf + len, RESPB_OP_RESP_PASSTHROUGH, 0);
+    len += add_string_4b(buf + len, "*1\r\n$4\r\nPING\r\n");
+    len += build_mset(buf + len, 1);
+    
+    respb_arena_t arena;
+    respb_arena_init(&arena, 100);
+    respb_parser_t parser;
+    respb_parser_init(&parser, buf, len);
+    respb_cmd_t first, second, ping, small;
+    int ok = respb_parse_compact(&parser, &first, &arena) == 1 &&
+             parser.pos == first_end &&
+             respb_parse_compact(&parser, &second, &arena) == 1 &&
+             respb_parse_compact(&parser, &ping, &arena) == 1 &&
+             respb_parse_compact(&parser, &small, &arena) == 1 && parser.pos == len;
+    
+    // The second MSET did not fit the first block; the first one's spans must survive
+    ok = ok && first.argc == 80 && second.argc == 120 && arena.head->prev &&
+         memcmp(respb_cmd_args(&first)[79].data, "v00039", 6) == 0 &&
+         memcmp(respb_cmd_args(&second)[119].data, "v00059", 6) == 0;
+    ok = ok && ping.argc == 1 && ping.u.inline_args[0].len == 14 &&
+         small.argc == 2 && respb_cmd_args(&small) == small.u.inline_args &&
+         memcmp(small.u.inline_args[0].data, "k00000", 6) == 0;
+    ok = ok && sizeof(respb_cmd_t) < sizeof(respb_command_t) / 8;
+    respb_arena_free(&arena);
+    if (!ok) {
+        FAIL("Wrong compact decode");
+        return;
+    }
+    PASS();
+}
+
+// Argument Iterator Tests
+void test_iter_typed_fields() {
+    TEST("Iterator yields typed ZADD fields and matches table decoder spans");
+    uint8_t buf[128];
+    size_t pos = build_header(buf, RESPB_OP_ZADD, 5);
+    pos += add_string_2b(buf + pos, "zset");
+    buf[pos++] = 0x02;  // flags
+    buf[pos++] = 0x00;
+    buf[pos++] = 0x02;  // count
+    double score = 1.5;
+    uint64_t bits;
+    memcpy(&bits, &score, sizeof(bits));
+    respb_write_u64(buf + pos, bits);
+    pos += 8;
+    pos += add_string_2b(buf + pos, "m1");
+    respb_write_u64(buf + pos, 0);
+    pos += 8;
+    pos += add_string_2b(buf + pos, "m2");
+    
+    respb_arg_iter_t it;
+    respb_value_t v;
+    const uint8_t kinds[] = {RESPB_FIELD_STR2, RESPB_FIELD_U8, RESPB_FIELD_F64,
+                             RESPB_FIELD_STR2, RESPB_FIELD_F64, RESPB_FIELD_STR2};
+    int ok = respb_arg_iter_init(&it, buf, pos) == 1 && it.mux_id == 5;
+    for (size_t i = 0; ok && i < sizeof(kinds); i++) {
+        ok = respb_arg_iter_next(&it, &v) == 1 && v.kind == kinds[i];
+        if (ok && i == 1) ok = v.u == 0x02;
+        if (ok && i == 2) ok = v.f == 1.5;
+    }
+    ok = ok && respb_arg_iter_next(&it, &v) == 0 && it.pos == pos;
+    
+    // String spans line up with the table decoder's args[]
+    respb_parser_t parser;
+    respb_parser_init(&parser, buf, pos);
+    respb_command_t cmd;
+    respb_arg_t arg;
+    ok = ok && respb_parse_command_table(&parser, &cmd) == 1 &&
+         respb_arg_iter_init(&it, buf, pos) == 1;
+    for (size_t i = 0; ok && i < cmd.argc; i++) {
+        ok = respb_arg_iter_next_str(&it, &arg) == 1 && arg.data == cmd.args[i].data &&
+             arg.len == cmd.args[i].len;
+    }
+    ok = ok && respb_arg_iter_next_str(&it, &arg) == 0;
+    if (!ok) {
+        FAIL("Wrong iterated fields");
+        return;
+    }
+    PASS();
+}
+
+void test_iter_first_key_and_finish() {
+    TEST("Iterator reads the first key and skips to the next frame");
+    static uint8_t buf[4096];
+    size_t first = build_mset(buf, 100);
+    size_t len = first;
+    len += build_header(buf + len, RESPB_OP_RESP_PASSTHROUGH, 0);
+    len += add_string_4b(buf + len, "*1\r\n$4\r\nPING\r\n");
+    
+    respb_arg_iter_t it;
+    respb_arg_t key;
+    size_t frame_len;
+    int ok = respb_arg_iter_init(&it, buf, len) == 1 &&
+             respb_arg_iter_next_str(&it, &key) == 1 && key.len == 6 &&
+             memcmp(key.data, "k00000", 6) == 0 &&
+             respb_arg_iter_finish(&it, &frame_len) == 1 && frame_len == first;
+    ok = ok && respb_arg_iter_init(&it, buf + first, len - first) == 1 &&
+         respb_arg_iter_next_str(&it, &key) == 1 && key.len == 14 &&
+         respb_arg_iter_finish(&it, &frame_len) == 1 && frame_len == len - first;
+    if (!ok) {
+        FAIL("Wrong first key or frame length");
+        return;
+    }
+    PASS();
+}
+
+void test_iter_truncated_and_unknown() {
+    TEST("Iterator reports truncated frames and unknown opcodes");
+    uint8_t buf[64];
+    size_t len = build_header(buf, RESPB_OP_MGET, 0);
+    buf[len++] = 0x00;
+    buf[len++] = 0x02;  // two keys, only one present
+    len += add_string_2b(buf + len, "key1");
+    
+    respb_arg_iter_t it;
+    respb_value_t v;
+    size_t frame_len;
+    int ok = respb_arg_iter_init(&it, buf, len) == 1 &&
+             respb_arg_iter_next(&it, &v) == 1 && respb_arg_iter_next(&it, &v) == -1 &&
+             respb_arg_iter_init(&it, buf, len) == 1 &&
+             respb_arg_iter_finish(&it, &frame_len) == 0 &&
+             respb_arg_iter_init(&it, buf, 3) == 0;
+    build_header(buf, 0x04FF, 0);
+    ok = ok && respb_arg_iter_init(&it, buf, len) == -1;
+    if (!ok) {
+        FAIL("Wrong error handling");
+        return;
+    }
+    PASS();
+}
+
+// Typed View Tests
+void test_view_set_incrby_expire() {
+    TEST("Views carry SET/GETEX expiry, INCRBY and EXPIRE fields");
+    uint8_t data[256];
+    size_t pos = build_header(data, RESPB_OP_SET, 0);
+    pos += add_string_2b(data + pos, "key");
+    pos += add_string_4b(data + pos, "value");
+    data[pos++] = 0x02;  // flags
+    respb_write_u64(data + pos, 5000);
+    pos += 8;
+    pos += build_header(data + pos, RESPB_OP_INCRBY, 0);
+    pos += add_string_2b(data + pos, "counter");
+    respb_write_u64(data + pos, (uint64_t)-7);
+    pos += 8;
+    pos += build_header(data + pos, RESPB_OP_EXPIRE, 0);
+    pos += add_string_2b(data + pos, "key");
+    respb_write_u64(data + pos, 60);
+    pos += 8;
+    data[pos++] = 0x01;  // flags
+    pos += build_header(data + pos, RESPB_OP_GETEX, 0);
+    pos += add_string_2b(data + pos, "key");
+    data[pos++] = 0x00;  // no expiry
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, data, pos);
+    respb_command_t set, incr, expire, getex;
+    int ok = respb_parse_command(&parser, &set) == 1 &&
+             respb_parse_command(&parser, &incr) == 1 &&
+             respb_parse_command(&parser, &expire) == 1 &&
+             respb_parse_command(&parser, &getex) == 1 && parser.pos == pos;
+    ok = ok && set.view.set.flags == 0x02 && set.view.set.expiry == 5000 &&
+         incr.view.incr.increment == -7 &&
+         expire.view.expire.time == 60 && expire.view.expire.flags == 0x01 &&
+         getex.view.set.flags == 0x00 && getex.view.set.expiry == 0;
+    if (!ok) {
+        FAIL("Wrong view fields");
+        return;
+    }
+    PASS();
+}
+
+void test_view_scores() {
+    TEST("ZADD scores and ZRANGEBYSCORE bounds decode as doubles");
+    uint8_t data[256];
+    size_t pos = build_header(data, RESPB_OP_ZADD, 0);
+    pos += add_string_2b(data + pos, "zset");
+    data[pos++] = 0x00;  // flags
+    data[pos++] = 0x00;
+    data[pos++] = 0x02;  // count
+    pos += add_f64(data + pos, 1.5);
+    pos += add_string_2b(data + pos, "m1");
+    pos += add_f64(data + pos, -2.25);
+    pos += add_string_2b(data + pos, "m2");
+    pos += build_header(data + pos, RESPB_OP_ZRANGEBYSCORE, 0);
+    pos += add_string_2b(data + pos, "zset");
+    pos += add_f64(data + pos, -1.0);
+    pos += add_f64(data + pos, 10.5);
+    data[pos++] = 0x01;  // flags
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, data, pos);
+    respb_command_t zadd, range;
+    int ok = respb_parse_command(&parser, &zadd) == 1 &&
+             respb_parse_command(&parser, &range) == 1 && parser.pos == pos;
+    ok = ok && zadd.argc == 3 && zadd.view.zadd.count == 2 &&
+         respb_zadd_score(&zadd, 0) == 1.5 && respb_zadd_score(&zadd, 1) == -2.25 &&
+         zadd.args[2].len == 2 && memcmp(zadd.args[2].data, "m2", 2) == 0;
+    ok = ok && range.view.score_range.min == -1.0 && range.view.score_range.max == 10.5 &&
+         range.view.score_range.flags == 0x01;
+    if (!ok) {
+        FAIL("Wrong scores");
+        return;
+    }
+    PASS();
+}
+
+// Frame for a schema with every U8 set to u8 and every group repeated count times
+static size_t build_schema_frame(const respb_schema_t *schema, uint8_t *buf, uint8_t u8, uint16_t count) {
+    size_t pos;
+    if (schema->flags & RESPB_SCHEMA_MODULE) {
+        pos = build_header(buf, RESPB_OP_MODULE, 0);
+        respb_write_u32(buf + pos, schema->code);
+        pos += 4;
+    } else {
+        pos = build_header(buf, (uint16_t)schema->code, 0);
+    }
+    const respb_field_t *f = schema->fields;
+    const respb_field_t *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL, *group_end = NULL;
+    uint16_t left = 0;
+    uint8_t last_u8 = 0;
+    while (f < end) {
+        switch (f->kind) {
+            case RESPB_FIELD_STR2: pos += add_string_2b(buf + pos, "s"); break;
+            case RESPB_FIELD_STR4: pos += add_string_4b(buf + pos, "v"); break;
+            case RESPB_FIELD_U8: buf[pos++] = last_u8 = u8; break;
+            case RESPB_FIELD_U16: respb_write_u16(buf + pos, 7); pos += 2; break;
+            case RESPB_FIELD_I64:
+            case RESPB_FIELD_F64: respb_write_u64(buf + pos, 3); pos += 8; break;
+            case RESPB_FIELD_GROUP:
+                respb_write_u16(buf + pos, count);
+                pos += 2;
+                if (count == 0) {
+                    f += f->arg + 1;
+                    continue;
+                }
+                group_start = f + 1;
+                group_end = group_start + f->arg;
+                left = count;
+                f = group_start;
+                continue;
+            case RESPB_FIELD_OPT:
+                if (!(last_u8 & f->arg)) f++;
+                break;
+        }
+        f++;
+        if (f == group_end && --left) f = group_start;
+    }
+    return pos;
+}
+
+void test_switch_matches_table_all_schemas() {
+    TEST("Switch decoder matches table decoder for every schema");
+    uint8_t data[1024];
+    for (size_t i = 0; i < respb_schema_count; i++) {
+        const respb_schema_t *schema = &respb_schemas[i];
+        for (int variant = 0; variant < 6; variant++) {
+            uint16_t count = (uint16_t)(variant >> 1) * 2;  // 0, 2, 4
+            size_t len = build_schema_frame(schema, data, variant & 1 ? 0x01 : 0x00, count);
+            respb_parser_t sw, tb;
+            respb_command_t a, b;
+            respb_parser_init(&sw, data, len);
+            respb_parser_init(&tb, data, len);
+            memset(&a.view, 0xA5, sizeof(a.view));
+            memset(&b.view, 0x5A, sizeof(b.view));
+            int ok = respb_parse_command(&sw, &a) == 1 && respb_parse_command_table(&tb, &b) == 1 &&
+                     sw.pos == tb.pos && a.argc == b.argc;
+            for (size_t j = 0; ok && j < a.argc; j++) {
+                ok = a.args[j].data == b.args[j].data && a.args[j].len == b.args[j].len;
+            }
+            
+            /* Both fill the same view members with the same values */
+            size_t nview;
+            const respb_field_t *view = respb_view_fields(schema, &nview);
+            for (size_t k = 0; ok && view && k < nview; k++) {
+                if (view[k].arg == RESPB_VIEW_NONE) continue;
+                ok = respb_view_get(&a.view, view[k]).u == respb_view_get(&b.view, view[k]).u;
+            }
+            if (ok && (schema == respb_schema_lookup(RESPB_OP_ZADD) ||
+                       schema == respb_schema_lookup(RESPB_OP_GEOADD))) {
+                ok = a.view.zadd.count == count && b.view.zadd.count == count;
+            }
+            if (!ok) {
+                FAIL(schema->name);
+                return;
+            }
+        }
+    }
+    PASS();
+}
+
+
+// Frame Scanner Tests
+void test_frame_peek_matches_decoder() {
+    TEST("Frame scanner sizes frames like the table decoder");
+    uint8_t data[512];
+    size_t len = build_stream_frames(data);
+    len += build_header(data + len, RESPB_OP_MODULE, 9);
+    respb_write_u32(data + len, 0x00010001);  // BF.MADD
+    len += 4;
+    len += add_string_2b(data + len, "bf");
+    data[len++] = 0x00;
+    data[len++] = 0x02;  // count
+    len += add_string_2b(data + len, "a");
+    len += add_string_2b(data + len, "b");
+    
+    static const uint16_t opcodes[] = {RESPB_OP_SET, RESPB_OP_ZADD,
+                                       RESPB_OP_RESP_PASSTHROUGH, RESPB_OP_MODULE};
+    respb_parser_t parser;
+    respb_parser_init(&parser, data, len);
+    size_t pos = 0;
+    int ok = 1;
+    for (size_t i = 0; ok && i < 4; i++) {
+        respb_frame_info_t info;
+        respb_command_t cmd;
+        size_t frame_len;
+        ok = respb_peek_frame(data + pos, len - pos, &info) == 1 &&
+             respb_frame_length(data + pos, len - pos, &frame_len) == 1 &&
+             respb_parse_command_table(&parser, &cmd) == 1 &&
+             info.opcode == opcodes[i] && info.mux_id == cmd.mux_id &&
+             info.length == frame_len && pos + info.length == parser.pos;
+        if (ok && info.opcode == RESPB_OP_MODULE) ok = info.module_subcommand == 0x00010001;
+        pos += info.length;
+    }
+    if (!ok || pos != len) {
+        FAIL("Frame boundaries differ");
+        return;
+    }
+    PASS();
+}
+
+void test_frame_truncated_and_unknown() {
+    TEST("Frame scanner reports truncated frames and unknown opcodes");
+    uint8_t data[256];
+    size_t len = build_stream_frames(data);
+    respb_frame_info_t info;
+    size_t first;
+    int ok = respb_frame_length(data, len, &first) == 1;
+    for (size_t cut = 0; ok && cut < first; cut++) {
+        ok = respb_peek_frame(data, cut, &info) == 0;
+    }
+    build_header(data, 0x04FF, 0);
+    ok = ok && respb_peek_frame(data, len, &info) == -1;
+    if (!ok) {
+        FAIL("Wrong result for short or unknown frame");
+        return;
+    }
+    PASS();
+}
+
+void test_frame_flags() {
+    TEST("Frame scanner sizes bind frames, key references and varint lengths");
+    respb_keydict_t dict;
+    if (!respb_keydict_init(&dict, 16, 1024)) {
+        FAIL("Failed to allocate key dictionary");
+        return;
+    }
+    uint8_t wire[256];
+    respb_command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_MSET;
+    cmd.mux_id = 4;
+    cmd.argc = 4;
+    cmd.args[0].data = (const uint8_t *)"user:1000";
+    cmd.args[0].len = 9;
+    cmd.args[1].data = (const uint8_t *)"v1";
+    cmd.args[1].len = 2;
+    cmd.args[2].data = (const uint8_t *)"other";
+    cmd.args[2].len = 5;
+    cmd.args[3].data = (const uint8_t *)"v2";
+    cmd.args[3].len = 2;
+    size_t bind = respb_serialize_key_bind(wire, sizeof(wire), 4, 3, (const uint8_t *)"user:1000", 9);
+    int ok = bind > 0 && respb_keydict_bind(&dict, 3, (const uint8_t *)"user:1000", 9) == 1;
+    size_t n = ok ? respb_serialize_command_dict(wire + bind, sizeof(wire) - bind, &cmd, &dict) : 0;
+    respb_frame_info_t info;
+    ok = ok && n > 0 &&
+         respb_peek_frame(wire, bind + n, &info) == 1 && info.length == bind &&
+         info.opcode == RESPB_OP_KEY_BIND && info.mux_id == 4 &&
+         respb_peek_frame_flags(wire + bind, n, RESPB_FLAG_KEYDICT, &info) == 1 &&
+         info.length == n && info.opcode == RESPB_OP_MSET;
+    for (size_t cut = 0; ok && cut < bind; cut++) {
+        ok = respb_peek_frame(wire, cut, &info) == 0;
+    }
+    
+    n = respb_serialize_command_flags(wire, sizeof(wire), &cmd, RESPB_FLAG_VARINT);
+    ok = ok && n > 0 && respb_peek_frame_flags(wire, n, RESPB_FLAG_VARINT, &info) == 1 &&
+         info.length == n &&
+         respb_peek_frame_flags(wire, n, RESPB_FLAG_VARINT | RESPB_FLAG_KEYDICT, &info) == -1;
+    respb_keydict_free(&dict);
+    if (!ok) {
+        FAIL("Wrong frame length");
+        return;
+    }
+    PASS();
+}
+
+// Zero-copy RESP Tests
+void test_resp_borrowed_matches_valkey() {
+    TEST("Borrowed RESP parse yields Valkey's arguments without copying");
+    const char *text = "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$3\r\nbar\r\n"
+                       "*2\r\n$3\r\nGET\r\n$0\r\n\r\n";
+    const uint8_t *buf = (const uint8_t *)text;
+    size_t len = strlen(text);
+    
+    valkey_client client;
+    valkey_client_init(&client, buf, len);
+    respb_arg_t args[4];
+    size_t pos = 0, argc;
+    int ok = 1;
+    for (int n = 0; n < 2 && ok; n++) {
+        ok = valkey_parse_command(&client) == 1 &&
+             respb_resp_parse(buf, len, &pos, args, 4, &argc) == 1 &&
+             argc == (size_t)client.argc && pos == client.qb_pos;
+        for (size_t i = 0; ok && i < argc; i++) {
+            const char *expected = client.argv[i]->ptr;
+            ok = args[i].data >= buf && args[i].data + args[i].len <= buf + len &&
+                 args[i].len == strlen(expected) &&
+                 memcmp(args[i].data, expected, args[i].len) == 0;
+        }
+        for (int i = 0; i < client.argc; i++) decrRefCount(client.argv[i]);
+        client.argc = 0;
+    }
+    valkey_client_free(&client);
+    ok = ok && pos == len && args[1].len == 0;
+    if (!ok) {
+        FAIL("Spans differ from the Valkey parser");
+        return;
+    }
+    PASS();
+}
+
+void test_resp_borrowed_partial_and_errors() {
+    TEST("Borrowed RESP parse waits on partial input and rejects bad framing");
+    const char *text = "*3\r\n$3\r\nSET\r\n$3\r\nfoo\r\n$3\r\nbar\r\n";
+    const uint8_t *buf = (const uint8_t *)text;
+    size_t len = strlen(text);
+    respb_arg_t args[2];
+    size_t pos, argc;
+    int ok = 1;
+    for (size_t cut = 0; ok && cut < len; cut++) {
+        pos = 0;
+        ok = respb_resp_parse(buf, cut, &pos, args, 2, &argc) == 0 && pos == 0;
+    }
+    /* Only the first max_args spans are stored, but all are counted */
+    pos = 0;
+    ok = ok && respb_resp_parse(buf, len, &pos, args, 2, &argc) == 1 && argc == 3 &&
+         args[1].len == 3 && memcmp(args[1].data, "foo", 3) == 0;
+    
+    static const char *bad[] = {
+        "$3\r\nSET\r\n",                    /* Not a multibulk */
+        "*1\r\n+PING\r\n",                   /* Not a bulk */
+        "*1\r\n$4\r\nPINGXX",                /* Bulk without CRLF */
+        "*1\r\n$-1\r\n",                     /* Negative bulk length */
+        "*x\r\n",                             /* Not a number */
+        "*1\r\n$9999999999999999999\r\n",    /* Too long */
+    };
+    for (size_t i = 0; ok && i < sizeof(bad) / sizeof(bad[0]); i++) {
+        pos = 0;
+        ok = respb_resp_parse((const uint8_t *)bad[i], strlen(bad[i]), &pos,
+                              args, 2, &argc) == -1;
+    }
+    pos = 0;
+    ok = ok && respb_resp_parse((const uint8_t *)"*0\r\n", 4, &pos, args, 2, &argc) == 1 &&
+         argc == 0 && pos == 4;
+    if (!ok) {
+        FAIL("Wrong result for partial or malformed RESP");
+        return;
+    }
+    PASS();
+}
+
+void test_parse_passthrough_frame() {
+    TEST("Passthrough frame payload decodes in place");
+    uint8_t data[128];
+    size_t len = build_header(data, RESPB_OP_RESP_PASSTHROUGH, 5);
+    len += add_string_4b(data + len, "*2\r\n$3\r\nGET\r\n$3\r\nfoo\r\n");
+    
+    respb_parser_t parser;
+    respb_command_t cmd;
+    respb_arg_t args[4];
+    size_t argc;
+    respb_parser_init(&parser, data, len);
+    int ok = respb_parse_command(&parser, &cmd) == 1 &&
+             respb_parse_passthrough(&cmd, args, 4, &argc) == 1 && argc == 2 &&
+             args[1].data == data + 8 + 17 && memcmp(args[1].data, "foo", 3) == 0;
+    
+    /* Trailing bytes after the command are not one command */
+    cmd.resp_length -= 1;
+    ok = ok && respb_parse_passthrough(&cmd, args, 4, &argc) == -1;
+    cmd.resp_length += 1;
+    cmd.opcode = RESPB_OP_GET;
+    ok = ok && respb_parse_passthrough(&cmd, args, 4, &argc) == -1;
+    if (!ok) {
+        FAIL("Wrong passthrough decode");
+        return;
+    }
+    PASS();
+}
+
+// Schema Serializer Tests
+
+/* The numeric values build_schema_frame() writes, in wire order */
+static size_t schema_frame_numbers(const respb_schema_t *schema, uint8_t u8, uint16_t count,
+                                   respb_num_t *nums) {
+    const respb_field_t *f = schema->fields;
+    const respb_field_t *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL, *group_end = NULL;
+    uint16_t left = 0;
+    size_t n = 0;
+    uint64_t three = 3;
+    while (f < end) {
+        switch (f->kind) {
+            case RESPB_FIELD_U8: nums[n++].u = u8; break;
+            case RESPB_FIELD_U16: nums[n++].u = 7; break;
+            case RESPB_FIELD_I64: nums[n++].i = 3; break;
+            case RESPB_FIELD_F64: memcpy(&nums[n++].f, &three, sizeof(three)); break;
+            case RESPB_FIELD_GROUP:
+                nums[n++].u = count;
+                if (count == 0) {
+                    f += f->arg + 1;
+                    continue;
+                }
+                group_start = f + 1;
+                group_end = group_start + f->arg;
+                left = count;
+                f = group_start;
+                continue;
+            case RESPB_FIELD_OPT:
+                if (!(u8 & f->arg)) f++;
+                break;
+        }
+        f++;
+        if (f == group_end && --left) f = group_start;
+    }
+    return n;
+}
+
+void test_schema_encode_all_schemas() {
+    TEST("Schema encoder reproduces every command layout byte for byte");
+    uint8_t frame[1024], out[1024];
+    respb_arg_t args[64];
+    respb_num_t nums[64];
+    for (size_t i = 0; i < respb_schema_count; i++) {
+        const respb_schema_t *schema = &respb_schemas[i];
+        for (int variant = 0; variant < 6; variant++) {
+            uint8_t u8 = variant & 1 ? 0x01 : 0x00;
+            uint16_t count = (uint16_t)(variant >> 1) * 2;  // 0, 2, 4
+            size_t len = build_schema_frame(schema, frame, u8, count);
+            size_t pos = schema->flags & RESPB_SCHEMA_MODULE ? 8 : 4;
+            size_t argc;
+            size_t nnums = schema_frame_numbers(schema, u8, count, nums);
+            int ok = respb_schema_decode(schema, frame, len, &pos, args, 64, &argc) == 1 &&
+                     respb_serialize_schema(out, sizeof(out), schema, 0, args, argc,
+                                            nums, nnums) == len &&
+                     memcmp(out, frame, len) == 0;
+            if (!ok) {
+                FAIL(schema->name);
+                return;
+            }
+        }
+    }
+    PASS();
+}
+
+void test_serialize_command_any_opcode() {
+    TEST("respb_serialize_command() covers opcodes without a hand-written case");
+    respb_command_t cmd, parsed;
+    memset(&cmd, 0, sizeof(cmd));
+    static const char *strs[] = {"hash", "f1", "f2", "f3"};
+    for (size_t i = 0; i < 4; i++) {
+        cmd.args[i].data = (const uint8_t *)strs[i];
+        cmd.args[i].len = strlen(strs[i]);
+    }
+    uint8_t buf[256];
+    respb_parser_t parser;
+    
+    /* HMGET: key + counted group sized from argc */
+    cmd.opcode = RESPB_OP_HMGET;
+    cmd.argc = 4;
+    size_t len = respb_serialize_command(buf, sizeof(buf), &cmd);
+    respb_parser_init(&parser, buf, len);
+    int ok = len > 0 && respb_parse_command(&parser, &parsed) == 1 && parser.pos == len &&
+             parsed.argc == 4 && memcmp(parsed.args[3].data, "f3", 2) == 0;
+    
+    /* JSON.GET: module command without an inline case */
+    cmd.opcode = RESPB_OP_MODULE;
+    cmd.module_id = RESPB_MODULE_JSON;
+    cmd.command_id = 0x0001;
+    cmd.module_subcommand = 0x00000001;
+    cmd.argc = 3;
+    len = respb_serialize_command(buf, sizeof(buf), &cmd);
+    respb_parser_init(&parser, buf, len);
+    ok = ok && len > 0 && respb_parse_command(&parser, &parsed) == 1 && parser.pos == len &&
+         parsed.argc == 3 && parsed.module_subcommand == 0x00000001;
+    
+    /* EVAL has two groups: argc cannot split keys from args */
+    cmd.opcode = RESPB_OP_EVAL;
+    ok = ok && respb_serialize_command(buf, sizeof(buf), &cmd) == 0;
+    if (!ok) {
+        FAIL("Schema fallback failed");
+        return;
+    }
+    PASS();
+}
+
+void test_schema_encode_rejects() {
+    TEST("Schema encoder rejects mismatched values and short buffers");
+    const respb_schema_t *set = respb_schema_lookup(RESPB_OP_SET);
+    respb_arg_t args[2] = {{(const uint8_t *)"k", 1}, {(const uint8_t *)"v", 1}};
+    respb_num_t nums[2];
+    nums[0].u = 0;
+    nums[1].i = -5;
+    uint8_t buf[64];
+    size_t pos = 4;
+    
+    int ok = respb_schema_encode(set, buf, sizeof(buf), &pos, args, 2, nums, 2) == 1 &&
+             pos == 4 + 3 + 5 + 9 && (int64_t)respb_read_u64(buf + pos - 8) == -5;
+    pos = 4;
+    ok = ok && respb_schema_encode(set, buf, 10, &pos, args, 2, nums, 2) == 0 && pos == 4;
+    ok = ok && respb_schema_encode(set, buf, sizeof(buf), &pos, args, 1, nums, 2) == -1;
+    ok = ok && respb_schema_encode(set, buf, sizeof(buf), &pos, args, 2, nums, 1) == -1;
+    nums[0].u = 0x100;  /* flags is a U8 */
+    ok = ok && respb_schema_encode(set, buf, sizeof(buf), &pos, args, 2, nums, 2) == -1;
+    nums[0].u = 0;
+    args[0].len = 0x10000;  /* keys have a 2-byte length */
+    ok = ok && respb_schema_encode(set, buf, sizeof(buf), &pos, args, 2, nums, 2) == -1 && pos == 4;
+    if (!ok) {
+        FAIL("Bad encode accepted");
+        return;
+    }
+    PASS();
+}
+
+/* Arguments and distinct numbers for schema with flags u8 and count entries
+ * per group, in wire order. expect[] gets the value each view field should
+ * hold (0 where a flag leaves the field out) */
+static void view_frame_values(const respb_schema_t *schema, uint8_t u8, uint16_t count,
+                              respb_arg_t *args, size_t *argc, respb_num_t *nums,
+                              size_t *nnums, respb_num_t *expect) {
+    const respb_field_t *f = schema->fields;
+    const respb_field_t *end = f + schema->nfields;
+    const respb_field_t *group_start = NULL, *group_end = NULL;
+    uint16_t left = 0;
+    size_t a = 0, n = 0, e = 0;
+    while (f < end) {
+        respb_num_t num = {0};
+        int numeric = f->kind >= RESPB_FIELD_U8 && f->kind <= RESPB_FIELD_F64;
+        int grouped = left && f >= group_start && f < group_end;
+        switch (f->kind) {
+            case RESPB_FIELD_STR2:
+            case RESPB_FIELD_STR4:
+                args[a].data = (const uint8_t *)"abcdefghij" + a % 6;
+                args[a].len = 1 + a % 4;
+                a++;
+                break;
+            case RESPB_FIELD_U8: num.u = u8; break;
+            case RESPB_FIELD_U16: num.u = 700 + n; break;
+            case RESPB_FIELD_I64: num.i = -1000 - (int64_t)n * 37; break;
+            case RESPB_FIELD_F64: num.f = 0.25 + (double)n * 1.5; break;
+            case RESPB_FIELD_GROUP:
+                nums[n++].u = count;
+                if (count == 0) {
+                    f += f->arg + 1;
+                    continue;
+                }
+                group_start = f + 1;
+                group_end = group_start + f->arg;
+                left = count;
+                f = group_start;
+                continue;
+            case RESPB_FIELD_OPT:
+                if (!(u8 & f->arg)) {
+                    f++;
+                    expect[e++].u = 0;
+                }
+                break;
+        }
+        if (numeric) {
+            nums[n++] = num;
+            if (!grouped) expect[e++] = num;
+        }
+        f++;
+        if (f == group_end && --left) f = group_start;
+    }
+    *argc = a;
+    *nnums = n;
+}
+
+void test_serialize_view_numbers() {
+    TEST("Serializers write the numeric fields of the parsed view");
+    uint8_t frame[1024], out[1024], scratch[1024];
+    struct iovec iov[16];
+    respb_arg_t args[64];
+    respb_num_t nums[64], expect[8];
+    respb_keydict_t dict;
+    respb_pipeline_t pipe;
+    respb_keydict_init(&dict, 16, 1024);
+    respb_pipeline_init(&pipe);
+    int ok = 1;
+    size_t covered = 0;
+    const char *failed = "SETBIT serialized";
+    for (size_t i = 0; ok && i < respb_schema_count; i++) {
+        const respb_schema_t *schema = &respb_schemas[i];
+        size_t nview;
+        const respb_field_t *view = respb_view_fields(schema, &nview);
+        int whole = view && nview > 0;
+        for (size_t k = 0; whole && k < nview; k++) whole = view[k].arg != RESPB_VIEW_NONE;
+        if (!whole) continue;
+        covered++;
+        for (int variant = 0; ok && variant < 2; variant++) {
+            /* 0x05 has and 0x04 lacks the 0x01 bit that gates expiries */
+            uint8_t u8 = variant ? 0x04 : 0x05;
+            size_t argc, nnums;
+            view_frame_values(schema, u8, 2, args, &argc, nums, &nnums, expect);
+            size_t len = respb_serialize_schema(frame, sizeof(frame), schema, 9, args, argc,
+                                                nums, nnums);
+            respb_parser_t parser;
+            respb_command_t cmd, again;
+            respb_parser_init(&parser, frame, len);
+            ok = len > 0 && respb_parse_command(&parser, &cmd) == 1;
+
+            /* Every serializer reproduces the frame byte for byte */
+            size_t n = respb_serialize_command(out, sizeof(out), &cmd);
+            ok = ok && n == len && memcmp(out, frame, len) == 0 &&
+                 respb_serialized_size(&cmd) == len;
+            n = respb_serialize_command_dict(out, sizeof(out), &cmd, &dict);
+            ok = ok && n == len && memcmp(out, frame, len) == 0;
+            size_t iovcnt, flat = 0;
+            n = respb_serialize_iov(scratch, sizeof(scratch), iov, 16, &iovcnt, &cmd);
+            ok = ok && n == len;
+            for (size_t k = 0; ok && k < iovcnt; k++) {
+                memcpy(out + flat, iov[k].iov_base, iov[k].iov_len);
+                flat += iov[k].iov_len;
+            }
+            ok = ok && flat == len && memcmp(out, frame, len) == 0;
+            const uint8_t *pending;
+            ok = ok && respb_pipeline_append(&pipe, &cmd) == 1 &&
+                 respb_pipeline_pending(&pipe, &pending) == len &&
+                 memcmp(pending, frame, len) == 0;
+            respb_pipeline_consume(&pipe, len);
+
+            /* And the frame parses back to the numbers that went in */
+            respb_parser_init(&parser, out, len);
+            ok = ok && respb_parse_command(&parser, &again) == 1;
+            for (size_t k = 0; ok && k < nview; k++) {
+                ok = respb_view_get(&again.view, view[k]).u == expect[k].u;
+            }
+            if (ok && schema == respb_schema_lookup(RESPB_OP_ZADD)) {
+                ok = respb_zadd_score(&again, 0) == nums[2].f && respb_zadd_score(&again, 1) == nums[3].f;
+            }
+            if (ok && schema == respb_schema_lookup(RESPB_OP_GEOADD)) {
+                double lon, lat;
+                respb_geoadd_coords(&again, 1, &lon, &lat);
+                ok = lon == nums[4].f && lat == nums[5].f;
+            }
+            if (!ok) failed = schema->name;
+        }
+    }
+
+    /* SETBIT's bit has no place in the view: refused, not written as 0 */
+    const respb_schema_t *setbit = respb_schema_lookup(RESPB_OP_SETBIT);
+    size_t argc, nnums;
+    view_frame_values(setbit, 1, 0, args, &argc, nums, &nnums, expect);
+    size_t len = respb_serialize_schema(frame, sizeof(frame), setbit, 0, args, argc, nums, nnums);
+    respb_parser_t parser;
+    respb_command_t cmd;
+    respb_parser_init(&parser, frame, len);
+    ok = ok && respb_parse_command(&parser, &cmd) == 1 &&
+         respb_serialize_command(out, sizeof(out), &cmd) == 0 && respb_serialized_size(&cmd) == 0 &&
+         respb_pipeline_append(&pipe, &cmd) == -1;
+    respb_pipeline_free(&pipe);
+    respb_keydict_free(&dict);
+    if (!ok) {
+        FAIL(failed);
+        return;
+    }
+    if (covered < 40) {
+        FAIL("Too few layouts with view fields");
+        return;
+    }
+    PASS();
+}
+
+/* Command struct for schema with argc copies of a short string */
+static void schema_command(respb_command_t *cmd, const respb_schema_t *schema, size_t argc) {
+    memset(cmd, 0, sizeof(*cmd));
+    if (schema->flags & RESPB_SCHEMA_MODULE) {
+        cmd->opcode = RESPB_OP_MODULE;
+        cmd->module_subcommand = schema->code;
+        cmd->module_id = (uint16_t)(schema->code >> 16);
+        cmd->command_id = (uint16_t)schema->code;
+    } else {
+        cmd->opcode = (uint16_t)schema->code;
+    }
+    cmd->argc = argc;
+    for (size_t i = 0; i < argc; i++) {
+        cmd->args[i].data = (const uint8_t *)"argument";
+        cmd->args[i].len = 1 + i % 8;
+    }
+}
+
+void test_serialized_size_exact() {
+    TEST("respb_serialized_size() is the exact respb_serialize_command() size");
+    uint8_t buf[512];
+    respb_command_t cmd;
+    for (size_t i = 0; i < respb_schema_count; i++) {
+        for (size_t argc = 0; argc <= 7; argc++) {
+            schema_command(&cmd, &respb_schemas[i], argc);
+            size_t written = respb_serialize_command(buf, sizeof(buf), &cmd);
+            size_t size = respb_serialized_size(&cmd);
+            int ok = size == written;
+            /* Exactly size bytes is enough, one less is not */
+            if (ok && size > 0) {
+                ok = respb_serialize_command(buf, size, &cmd) == size &&
+                     respb_serialize_command(buf, size - 1, &cmd) == 0;
+            }
+            if (!ok) {
+                FAIL(respb_schemas[i].name);
+                return;
+            }
+        }
+    }
+    PASS();
+}
+
+void test_serialized_size_batch() {
+    TEST("Batch size sums frames and rejects unserializable commands");
+    respb_command_t cmds[3];
+    schema_command(&cmds[0], respb_schema_lookup(RESPB_OP_SET), 2);
+    schema_command(&cmds[1], respb_schema_lookup(RESPB_OP_ZREM), 3);
+    memset(&cmds[2], 0, sizeof(cmds[2]));
+    cmds[2].opcode = RESPB_OP_RESP_PASSTHROUGH;
+    cmds[2].resp_data = (const uint8_t *)"*1\r\n$4\r\nPING\r\n";
+    cmds[2].resp_length = 14;
+    
+    size_t sizes[3];
+    uint8_t buf[256];
+    size_t total = respb_serialized_size_batch(cmds, 3, sizes);
+    size_t pos = 0;
+    int ok = total > 0 && sizes[2] == 22;
+    for (size_t i = 0; ok && i < 3; i++) {
+        size_t n = respb_serialize_command(buf + pos, total - pos, &cmds[i]);
+        ok = n == sizes[i];
+        pos += n;
+    }
+    ok = ok && pos == total;
+    
+    /* EVAL group counts cannot come from argc */
+    schema_command(&cmds[1], respb_schema_lookup(RESPB_OP_EVAL), 3);
+    ok = ok && respb_serialized_size_batch(cmds, 3, NULL) == 0;
+    if (!ok) {
+        FAIL("Wrong batch size");
+        return;
+    }
+    PASS();
+}
+
+
+// Pipeline Builder Tests
+void test_pipeline_append_and_flush() {
+    TEST("Pipeline encodes commands back to back with their mux_ids and offsets");
+    respb_pipeline_t p;
+    respb_pipeline_init(&p);
+    uint8_t expected[1024];
+    size_t expected_len = 0;
+    respb_command_t cmd;
+    int ok = 1;
+    for (uint16_t i = 0; ok && i < 10; i++) {
+        schema_command(&cmd, respb_schema_lookup(i % 2 ? RESPB_OP_SET : RESPB_OP_MGET), 2);
+        cmd.mux_id = (uint16_t)(100 + i);
+        size_t n = respb_serialize_command(expected + expected_len,
+                                           sizeof(expected) - expected_len, &cmd);
+        ok = n > 0 && respb_pipeline_append(&p, &cmd) == 1;
+        const respb_pipeline_entry_t *e = respb_pipeline_entry(&p, i);
+        ok = ok && e->offset == expected_len && e->length == n &&
+             e->mux_id == 100 + i && e->opcode == cmd.opcode;
+        expected_len += n;
+    }
+    
+    const uint8_t *data;
+    size_t len = respb_pipeline_pending(&p, &data);
+    ok = ok && p.count == 10 && len == expected_len && memcmp(data, expected, len) == 0;
+    
+    /* A full flush empties the pipeline and rewinds the buffer */
+    respb_pipeline_consume(&p, len);
+    ok = ok && p.count == 0 && respb_pipeline_pending(&p, &data) == 0 && p.tail == 0;
+    respb_pipeline_free(&p);
+    if (!ok) {
+        FAIL("Wrong pipeline contents");
+        return;
+    }
+    PASS();
+}
+
+void test_pipeline_partial_writes() {
+    TEST("Pipeline survives partial writes, compaction and growth");
+    respb_pipeline_t p;
+    respb_pipeline_init(&p);
+    static uint8_t value[3000];
+    memset(value, 'v', sizeof(value));
+    respb_command_t cmd;
+    schema_command(&cmd, respb_schema_lookup(RESPB_OP_SET), 2);
+    cmd.args[1].data = value;
+    cmd.args[1].len = sizeof(value);
+    size_t frame = respb_serialized_size(&cmd);
+    
+    /* Two frames, then a write that ends inside the second */
+    int ok = respb_pipeline_append(&p, &cmd) == 1 && respb_pipeline_append(&p, &cmd) == 1;
+    respb_pipeline_consume(&p, frame + 10);
+    ok = ok && p.count == 1 && respb_pipeline_entry(&p, 0)->offset == frame;
+    
+    /* The next append no longer fits behind tail: the unsent tail of frame 2
+     * moves to the front, offsets keep counting from the stream start */
+    ok = ok && respb_pipeline_append(&p, &cmd) == 1 && p.head == 0 &&
+         respb_pipeline_entry(&p, 1)->offset == 2 * frame;
+    
+    /* Growth keeps the unsent bytes */
+    for (int i = 0; ok && i < 8; i++) ok = respb_pipeline_append(&p, &cmd) == 1;
+    const uint8_t *data;
+    size_t len = respb_pipeline_pending(&p, &data);
+    ok = ok && p.count == 10 && len == 10 * frame - 10 &&
+         respb_read_u16(data + frame - 10) == RESPB_OP_SET &&
+         respb_read_u16(data + 9 * frame - 10) == RESPB_OP_SET;
+    respb_pipeline_free(&p);
+    if (!ok) {
+        FAIL("Pipeline lost bytes");
+        return;
+    }
+    PASS();
+}
+
+void test_pipeline_rejects_unencodable() {
+    TEST("Pipeline leaves its buffer untouched when a command cannot be encoded");
+    respb_pipeline_t p;
+    respb_pipeline_init(&p);
+    respb_command_t cmd;
+    schema_command(&cmd, respb_schema_lookup(RESPB_OP_GET), 1);
+    int ok = respb_pipeline_append(&p, &cmd) == 1;
+    schema_command(&cmd, respb_schema_lookup(RESPB_OP_EVAL), 3);
+    ok = ok && respb_pipeline_append(&p, &cmd) == -1 && p.count == 1 && p.tail == 4 + 2 + 1;
+    respb_pipeline_free(&p);
+    if (!ok) {
+        FAIL("Bad command was queued");
+        return;
+    }
+    PASS();
+}
+
+
+// Reply Codec Tests
+
+/* EXEC-style reply: [bulk, null, int, [status, error], empty bulk, empty array] */
+static size_t sample_reply(respb_reply_t *nodes) {
+    memset(nodes, 0, 9 * sizeof(*nodes));
+    nodes[0].type = RESPB_REPLY_ARRAY;
+    nodes[0].count = 6;
+    nodes[1].type = RESPB_REPLY_BULK;
+    nodes[1].data = (const uint8_t *)"value";
+    nodes[1].len = 5;
+    nodes[2].type = RESPB_REPLY_NULL;
+    nodes[3].type = RESPB_REPLY_INT;
+    nodes[3].integer = -42;
+    nodes[4].type = RESPB_REPLY_ARRAY;
+    nodes[4].count = 2;
+    nodes[5].type = RESPB_REPLY_STATUS;
+    nodes[5].data = (const uint8_t *)"QUEUED";
+    nodes[5].len = 6;
+    nodes[6].type = RESPB_REPLY_ERROR;
+    nodes[6].data = (const uint8_t *)"ERR no such key";
+    nodes[6].len = 15;
+    nodes[7].type = RESPB_REPLY_BULK;
+    nodes[7].data = (const uint8_t *)"";
+    nodes[8].type = RESPB_REPLY_ARRAY;
+    return 9;
+}
+
+/* Same type, count, integer and bytes in every node */
+static int same_reply(const respb_reply_t *a, const respb_reply_t *b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (a[i].type != b[i].type || a[i].count != b[i].count ||
+            a[i].integer != b[i].integer || a[i].len != b[i].len) return 0;
+        if (a[i].len && memcmp(a[i].data, b[i].data, a[i].len) != 0) return 0;
+    }
+    return 1;
+}
+
+void test_reply_round_trip() {
+    TEST("Reply frames round-trip nested arrays and nulls without copying");
+    respb_reply_t in[9], out[16];
+    size_t n = sample_reply(in), nnodes = 0, pos = 0;
+    uint8_t buf[256];
+    uint16_t mux_id = 0;
+    size_t len = respb_serialize_reply(buf, sizeof(buf), 7, in, n);
+    int ok = len > 0 && respb_read_u16(buf) == RESPB_RESP_ARRAY &&
+             respb_reply_parse(buf, len, &pos, &mux_id, out, 16, &nnodes) == 1 &&
+             pos == len && mux_id == 7 && nnodes == n && same_reply(in, out, n);
+    
+    /* Spans: the root covers everything, the inner array its two elements */
+    ok = ok && out[0].span == 9 && out[4].span == 3 && out[5].span == 1 && out[8].span == 1;
+    ok = ok && out[1].data >= buf && out[1].data < buf + len;
+    
+    /* Top-level null bulk and null array decode as NULL, like a 0x8005 frame */
+    static const uint8_t nulls[] = {0x80, 0x03, 0, 1, 0xFF, 0xFF, 0xFF, 0xFF,
+                                    0x80, 0x04, 0, 2, 0xFF, 0xFF,
+                                    0x80, 0x05, 0, 3};
+    pos = 0;
+    for (int i = 0; ok && i < 3; i++) {
+        ok = respb_reply_parse(nulls, sizeof(nulls), &pos, &mux_id, out, 16, &nnodes) == 1 &&
+             nnodes == 1 && out[0].type == RESPB_REPLY_NULL && mux_id == i + 1;
+    }
+    ok = ok && pos == sizeof(nulls);
+    if (!ok) {
+        FAIL("Decoded reply differs");
+        return;
+    }
+    PASS();
+}
+
+void test_reply_matches_resp() {
+    TEST("RESPB and RESP2 replies decode to the same nodes");
+    respb_reply_t in[9], from_respb[16], from_resp[16];
+    size_t n = sample_reply(in), pos = 0, nb = 0, nr = 0;
+    uint8_t frame[256], text[256];
+    size_t frame_len = respb_serialize_reply(frame, sizeof(frame), 0, in, n);
+    size_t text_len = respb_reply_to_resp(text, sizeof(text), in, n);
+    static const char expected[] =
+        "*6\r\n$5\r\nvalue\r\n$-1\r\n:-42\r\n*2\r\n+QUEUED\r\n-ERR no such key\r\n$0\r\n\r\n*0\r\n";
+    int ok = text_len == sizeof(expected) - 1 && memcmp(text, expected, text_len) == 0;
+    ok = ok && respb_reply_parse(frame, frame_len, &pos, NULL, from_respb, 16, &nb) == 1;
+    pos = 0;
+    ok = ok && respb_resp_reply_parse(text, text_len, &pos, from_resp, 16, &nr) == 1 &&
+         pos == text_len && nb == nr && same_reply(from_respb, from_resp, nb);
+    for (size_t i = 0; ok && i < nb; i++) ok = from_respb[i].span == from_resp[i].span;
+    
+    /* *-1 is a null array in RESP2 */
+    pos = 0;
+    ok = ok && respb_resp_reply_parse((const uint8_t *)"*-1\r\n", 5, &pos, from_resp, 16, &nr) == 1 &&
+         nr == 1 && from_resp[0].type == RESPB_REPLY_NULL;
+    if (!ok) {
+        FAIL("Trees differ between protocols");
+        return;
+    }
+    PASS();
+}
+
+void test_reply_partial_and_malformed() {
+    TEST("Reply decoders wait on partial input and reject malformed replies");
+    respb_reply_t in[9], out[64];
+    size_t n = sample_reply(in), pos, nnodes;
+    uint8_t frame[256], text[256];
+    size_t frame_len = respb_serialize_reply(frame, sizeof(frame), 0, in, n);
+    size_t text_len = respb_reply_to_resp(text, sizeof(text), in, n);
+    int ok = frame_len > 0 && text_len > 0;
+    for (size_t cut = 0; ok && cut < frame_len; cut++) {
+        pos = 0;
+        ok = respb_reply_parse(frame, cut, &pos, NULL, out, 64, &nnodes) == 0 && pos == 0;
+    }
+    for (size_t cut = 0; ok && cut < text_len; cut++) {
+        pos = 0;
+        ok = respb_resp_reply_parse(text, cut, &pos, out, 64, &nnodes) == 0 && pos == 0;
+    }
+    
+    /* Too few nodes: the count is still reported */
+    pos = 0;
+    ok = ok && respb_reply_parse(frame, frame_len, &pos, NULL, out, 3, &nnodes) == 1 && nnodes == n;
+    
+    /* Request opcode, unknown element tag, bad RESP type byte */
+    static const uint8_t get_frame[] = {0x00, 0x00, 0, 0, 0, 1, 'k'};
+    static const uint8_t bad_tag[] = {0x80, 0x04, 0, 0, 0, 1, 0x09};
+    pos = 0;
+    ok = ok && respb_reply_parse(get_frame, sizeof(get_frame), &pos, NULL, out, 64, &nnodes) == -1;
+    ok = ok && respb_reply_parse(bad_tag, sizeof(bad_tag), &pos, NULL, out, 64, &nnodes) == -1;
+    ok = ok && respb_resp_reply_parse((const uint8_t *)"!3\r\nerr\r\n", 9, &pos, out, 64, &nnodes) == -1;
+    ok = ok && respb_resp_reply_parse((const uint8_t *)"$3\r\nabcd\r\n", 10, &pos, out, 64, &nnodes) == -1;
+    
+    /* Nesting deeper than RESPB_REPLY_MAX_DEPTH */
+    uint8_t deep[512], *p = deep;
+    respb_write_u16(p, RESPB_RESP_ARRAY);
+    respb_write_u16(p + 2, 0);
+    respb_write_u16(p + 4, 1);
+    p += 6;
+    for (int i = 0; i < RESPB_REPLY_MAX_DEPTH; i++) {
+        *p++ = RESPB_REPLY_TAG_ARRAY;
+        respb_write_u16(p, 1);
+        p += 2;
+    }
+    *p++ = RESPB_REPLY_TAG_NULL;
+    ok = ok && respb_reply_parse(deep, (size_t)(p - deep), &pos, NULL, out, 64, &nnodes) == -1;
+    
+    /* Encoder: counts must match the nodes, lengths must fit their fields */
+    in[0].count = 7;
+    ok = ok && respb_serialize_reply(frame, sizeof(frame), 0, in, n) == 0;
+    in[0].count = 6;
+    ok = ok && respb_serialize_reply(frame, frame_len - 1, 0, in, n) == 0;
+    in[5].len = 70000;
+    ok = ok && respb_serialize_reply(frame, sizeof(frame), 0, in, n) == 0;
+    if (!ok) {
+        FAIL("Partial or malformed reply accepted");
+        return;
+    }
+    PASS();
+}
+
+
+// hiredis Reader Tests
+
+/* Compare a redisReply tree with pre-order nodes; returns nodes consumed or 0 */
+static size_t reply_matches_nodes(const redisReply *r, const respb_reply_t *nodes) {
+    static const int types[] = {REDIS_REPLY_STATUS, REDIS_REPLY_ERROR, REDIS_REPLY_INTEGER,
+                                REDIS_REPLY_STRING, REDIS_REPLY_ARRAY, REDIS_REPLY_NIL};
+    if (r->type != types[nodes[0].type]) return 0;
+    if (r->type == REDIS_REPLY_INTEGER) return r->integer == nodes[0].integer;
+    if (r->type != REDIS_REPLY_ARRAY) {
+        return r->len == nodes[0].len && (r->len == 0 || memcmp(r->str, nodes[0].data, r->len) == 0);
+    }
+    if (r->elements != nodes[0].count) return 0;
+    size_t used = 1;
+    for (size_t i = 0; i < r->elements; i++) {
+        size_t n = reply_matches_nodes(r->element[i], nodes + used);
+        if (n == 0) return 0;
+        used += n;
+    }
+    return used;
+}
+
+void test_hiredis_reader_matches_nodes() {
+    TEST("hiredis reader builds the same reply as the RESPB decoder, fed byte by byte");
+    respb_reply_t in[9];
+    size_t n = sample_reply(in);
+    uint8_t text[256];
+    size_t text_len = respb_reply_to_resp(text, sizeof(text), in, n);
+    redisReader *r = redisReaderCreate();
+    void *reply = NULL;
+    int ok = r != NULL && text_len > 0;
+    for (size_t i = 0; ok && i < text_len; i++) {
+        ok = redisReaderFeed(r, (const char *)text + i, 1) == REDIS_OK &&
+             redisReaderGetReply(r, &reply) == REDIS_OK && (reply != NULL) == (i == text_len - 1);
+    }
+    ok = ok && reply_matches_nodes(reply, in) == n;
+    freeReplyObject(reply);
+    redisReaderFree(r);
+    if (!ok) {
+        FAIL("Reply tree differs");
+        return;
+    }
+    PASS();
+}
+
+void test_hiredis_reader_allocations() {
+    TEST("hiredis reader allocates per element and rejects bad type bytes");
+    redisReader *r = redisReaderCreate();
+    static const char mget[] = "*3\r\n$1\r\na\r\n$-1\r\n$2\r\nbc\r\n";
+    void *reply = NULL;
+    int ok = r != NULL && redisReaderFeed(r, mget, sizeof(mget) - 1) == REDIS_OK;
+    unsigned long long allocs = hiredis_alloc_count, frees = hiredis_free_count;
+    ok = ok && redisReaderGetReply(r, &reply) == REDIS_OK && reply != NULL;
+    
+    /* Array + element vector, nil, and reply + copy for each string */
+    ok = ok && hiredis_alloc_count - allocs == 2 + 1 + 2 * 2;
+    freeReplyObject(reply);
+    ok = ok && hiredis_free_count - frees == 7;
+    
+    ok = ok && redisReaderFeed(r, "!oops\r\n", 7) == REDIS_OK &&
+         redisReaderGetReply(r, &reply) == REDIS_ERR && r->err == REDIS_ERR_PROTOCOL;
+    redisReaderFree(r);
+    if (!ok) {
+        FAIL("Unexpected allocation count or error handling");
+        return;
+    }
+    PASS();
+}
+
+
+// Varint Length Tests
+
+void test_varint_helpers() {
+    TEST("Varint helpers round-trip 32-bit lengths and reject bad encodings");
+    static const uint32_t values[] = {0, 1, 127, 128, 300, 16383, 16384, 65535, 65536, 0xFFFFFFFFu};
+    uint8_t buf[8];
+    uint32_t val;
+    int ok = 1;
+    for (size_t i = 0; ok && i < sizeof(values) / sizeof(values[0]); i++) {
+        size_t n = respb_write_varint(buf, values[i]);
+        ok = n == respb_varint_size(values[i]) && n <= RESPB_VARINT_MAX &&
+             respb_read_varint(buf, n, &val) == (int)n && val == values[i] &&
+             respb_read_varint(buf, n - 1, &val) == 0;
+    }
+    
+    /* 300 is 0xAC 0x02; a fifth byte above 0x0F and a sixth byte overflow */
+    static const uint8_t wide[] = {0xFF, 0xFF, 0xFF, 0xFF, 0x1F};
+    static const uint8_t endless[] = {0x80, 0x80, 0x80, 0x80, 0x80, 0x00};
+    ok = ok && respb_write_varint(buf, 300) == 2 && buf[0] == 0xAC && buf[1] == 0x02 &&
+         respb_read_varint(wide, sizeof(wide), &val) == -1 &&
+         respb_read_varint(endless, sizeof(endless), &val) == -1;
+    if (!ok) {
+        FAIL("Varint encode/decode mismatch");
+        return;
+    }
+    PASS();
+}
+
+void test_varint_command_round_trip() {
+    TEST("Varint-mode frames are smaller and decode to the same arguments");
+    static uint8_t big[70000];
+    memset(big, 'k', sizeof(big));
+    static const uint8_t resp[] = "*1\r\n$4\r\nPING\r\n";
+    static const char *words[] = {"a", "1", "b", "2"};
+    static uint8_t fixed[80000], varint[80000];
+    respb_command_t cmds[5], parsed;
+    memset(cmds, 0, sizeof(cmds));
+    cmds[0].opcode = RESPB_OP_GET;
+    cmds[1].opcode = RESPB_OP_SET;
+    cmds[2].opcode = RESPB_OP_MSET;
+    cmds[3].opcode = RESPB_OP_MODULE;
+    cmds[3].module_id = RESPB_MODULE_BF;  /* BF.ADD */
+    cmds[3].module_subcommand = (uint32_t)RESPB_MODULE_BF << 16;
+    cmds[0].argc = 1;
+    cmds[1].argc = 2;
+    cmds[3].argc = 2;
+    cmds[2].argc = 4;
+    for (size_t c = 0; c < 4; c++) {
+        for (size_t a = 0; a < cmds[c].argc; a++) {
+            cmds[c].args[a].data = (const uint8_t *)words[a];
+            cmds[c].args[a].len = 1;
+        }
+    }
+    cmds[4].opcode = RESPB_OP_RESP_PASSTHROUGH;
+    cmds[4].resp_data = resp;
+    cmds[4].resp_length = sizeof(resp) - 1;
+    
+    int ok = 1;
+    for (size_t c = 0; ok && c < 5; c++) {
+        size_t f = respb_serialize_command(fixed, sizeof(fixed), &cmds[c]);
+        size_t v = respb_serialize_command_flags(varint, sizeof(varint), &cmds[c], RESPB_FLAG_VARINT);
+        respb_parser_t parser;
+        respb_parser_init(&parser, varint, v);
+        parser.flags = RESPB_FLAG_VARINT;
+        ok = f > 0 && v > 0 && v < f && respb_parse_command(&parser, &parsed) == 1 &&
+             parser.pos == v && parsed.opcode == cmds[c].opcode;
+        if (ok && c == 4) {
+            ok = parsed.resp_length == cmds[4].resp_length &&
+                 memcmp(parsed.resp_data, resp, parsed.resp_length) == 0;
+        }
+        for (size_t a = 0; ok && c < 4 && a < cmds[c].argc; a++) {
+            ok = parsed.argc == cmds[c].argc && parsed.args[a].len == 1 &&
+                 parsed.args[a].data[0] == words[a][0];
+        }
+    }
+    
+    /* Same MSET bytes as respb_converter.py --varint */
+    static const uint8_t mset[] = {0x00, 0x0D, 0x00, 0x00, 0x02, 0x01, 'a', 0x01, '1',
+                                   0x01, 'b', 0x01, '2'};
+    ok = ok && respb_serialize_command_flags(varint, sizeof(varint), &cmds[2],
+                                             RESPB_FLAG_VARINT) == sizeof(mset) &&
+         memcmp(varint, mset, sizeof(mset)) == 0;
+    
+    /* A 70000-byte key is past a 2-byte length field; its varint takes 3 bytes */
+    cmds[0].args[0].data = big;
+    cmds[0].args[0].len = sizeof(big);
+    size_t v = respb_serialize_command_flags(varint, sizeof(varint), &cmds[0], RESPB_FLAG_VARINT);
+    respb_parser_t parser;
+    respb_parser_init(&parser, varint, v);
+    parser.flags = RESPB_FLAG_VARINT;
+    ok = ok && v == 4 + 3 + sizeof(big) && respb_parse_command(&parser, &parsed) == 1 &&
+         parsed.args[0].len == sizeof(big);
+    if (!ok) {
+        FAIL("Varint round trip failed");
+        return;
+    }
+    PASS();
+}
+
+void test_varint_truncated_and_malformed() {
+    TEST("Varint decoder waits for truncated frames and rejects malformed lengths");
+    respb_command_t cmd, parsed;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_SET;
+    cmd.argc = 2;
+    cmd.args[0].data = (const uint8_t *)"key";
+    cmd.args[0].len = 3;
+    cmd.args[1].data = (const uint8_t *)"value";
+    cmd.args[1].len = 5;
+    uint8_t buf[64];
+    size_t n = respb_serialize_command_flags(buf, sizeof(buf), &cmd, RESPB_FLAG_VARINT);
+    int ok = n > 0;
+    for (size_t len = 0; ok && len < n; len++) {
+        respb_parser_t parser;
+        respb_parser_init(&parser, buf, len);
+        parser.flags = RESPB_FLAG_VARINT;
+        ok = respb_parse_command(&parser, &parsed) == 0 && parser.pos == 0;
+    }
+    
+    /* GET whose key length never terminates */
+    static const uint8_t bad[] = {0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x01};
+    respb_parser_t parser;
+    respb_parser_init(&parser, bad, sizeof(bad));
+    parser.flags = RESPB_FLAG_VARINT;
+    ok = ok && respb_parse_command(&parser, &parsed) == -1;
+    if (!ok) {
+        FAIL("Unexpected result on truncated or malformed input");
+        return;
+    }
+    PASS();
+}
+
+void test_varint_fixed_width_decoders() {
+    TEST("Compact and stream decoders reject VARINT and KEYDICT");
+    respb_command_t cmd, parsed;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_SET;
+    cmd.argc = 2;
+    cmd.args[0].data = (const uint8_t *)"key";
+    cmd.args[0].len = 3;
+    cmd.args[1].data = (const uint8_t *)"value";
+    cmd.args[1].len = 5;
+    uint8_t buf[64];
+    size_t n = respb_serialize_command_flags(buf, sizeof(buf), &cmd, RESPB_FLAG_VARINT);
+    int ok = n > 0;
+    
+    respb_arena_t arena;
+    respb_arena_init(&arena, 16);
+    respb_cmd_t compact;
+    static const uint8_t flags[] = {RESPB_FLAG_VARINT, RESPB_FLAG_KEYDICT};
+    for (size_t i = 0; ok && i < sizeof(flags); i++) {
+        respb_parser_t parser;
+        respb_parser_init(&parser, buf, n);
+        parser.flags = flags[i];
+        ok = respb_parse_compact(&parser, &compact, &arena) == -1 && parser.pos == 0;
+        
+        respb_stream_t stream;
+        respb_stream_init(&stream);
+        stream.flags = flags[i];
+        size_t consumed;
+        ok = ok && respb_parser_feed(&stream, buf, n, &consumed, &parsed) == -1 && consumed == 0;
+        respb_stream_free(&stream);
+    }
+    
+    /* The compression flag leaves the frame encoding alone */
+    n = respb_serialize_command(buf, sizeof(buf), &cmd);
+    respb_parser_t parser;
+    respb_parser_init(&parser, buf, n);
+    parser.flags = RESPB_FLAG_COMPRESS;
+    ok = ok && respb_parse_compact(&parser, &compact, &arena) == 1 && compact.argc == 2;
+    respb_arena_free(&arena);
+    if (!ok) {
+        FAIL("Flags not rejected");
+        return;
+    }
+    PASS();
+}
+
+
+// Frame Compression Tests
+
+/* JSON-like text, or random bytes */
+static void fill_test_value(uint8_t *value, size_t len, int random) {
+    uint32_t seed = 7;
+    for (size_t i = 0; i < len; i++) {
+        seed = seed * 1103515245 + 12345;
+        value[i] = random ? (uint8_t)(seed >> 16) : (uint8_t)"{\"id\":12,\"tag\":\"ab\"},"[i % 21];
+        if (!random && i % 97 == 0) value[i] = (uint8_t)('0' + (seed >> 16) % 10);
+    }
+}
+
+void test_lz4_round_trip() {
+    TEST("LZ4 blocks round-trip and malformed blocks are rejected");
+    static uint8_t src[20000], block[24000], out[20000];
+    static uint32_t table[1 << RESPB_LZ4_HASH_LOG];
+    static const size_t lens[] = {0, 5, 13, 100, 4096, 20000};
+    int ok = 1;
+    for (int kind = 0; ok && kind < 3; kind++) {
+        if (kind < 2) fill_test_value(src, sizeof(src), kind);
+        else memset(src, 'a', sizeof(src));     /* Offset-1 overlapping matches */
+        for (size_t i = 0; ok && i < sizeof(lens) / sizeof(lens[0]); i++) {
+            size_t n = respb_lz4_compress(src, lens[i], block, sizeof(block), table, 1 + kind * 7);
+            ok = n > 0 && respb_lz4_decompress(block, n, out, lens[i]) == 1 &&
+                 memcmp(out, src, lens[i]) == 0;
+            if (ok && kind != 1 && lens[i] >= 4096) ok = n < lens[i] / 2;
+        }
+    }
+    
+    /* Too small a cap, a truncated block, a wrong size and a zero offset */
+    memset(src, 'a', 4096);
+    size_t n = respb_lz4_compress(src, 4096, block, sizeof(block), table, 1);
+    static const uint8_t zero_offset[] = {0x10, 'a', 0x00, 0x00, 0x00};
+    ok = ok && respb_lz4_compress(src, 4096, block + n, n - 1, table, 1) == 0 &&
+         respb_lz4_decompress(block, n - 1, out, 4096) == -1 &&
+         respb_lz4_decompress(block, n, out, 4095) == -1 &&
+         respb_lz4_decompress(block, n, out, 4097) == -1 &&
+         respb_lz4_decompress(zero_offset, sizeof(zero_offset), out, 6) == -1;
+    if (!ok) {
+        FAIL("LZ4 round trip or bounds check failed");
+        return;
+    }
+    PASS();
+}
+
+void test_compressed_frame_round_trip() {
+    TEST("Large values go out as 0xF001 frames and parse transparently");
+    static uint8_t value[4096], random_value[4096], wire[16384], plain[16384], inflate[8192];
+    fill_test_value(value, sizeof(value), 0);
+    fill_test_value(random_value, sizeof(random_value), 1);
+    respb_compressor_t c;
+    respb_compressor_init(&c, RESPB_COMPRESS_DEFAULT_THRESHOLD, 1);
+    
+    respb_command_t cmd, parsed;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_MODULE;  /* JSON.SET doc $ value */
+    cmd.mux_id = 7;
+    cmd.module_id = RESPB_MODULE_JSON;
+    cmd.argc = 3;
+    cmd.args[0].data = (const uint8_t *)"doc";
+    cmd.args[0].len = 3;
+    cmd.args[1].data = (const uint8_t *)"$";
+    cmd.args[1].len = 1;
+    cmd.args[2].data = value;
+    cmd.args[2].len = sizeof(value);
+    size_t raw = respb_serialize_command(plain, sizeof(plain), &cmd);
+    size_t n = respb_serialize_compressed(&c, wire, sizeof(wire), &cmd, 0);
+    respb_frame_info_t info;
+    int ok = raw > 0 && n > 0 && n < raw / 2 && respb_read_u16(wire) == RESPB_OP_COMPRESSED &&
+             respb_peek_frame(wire, n, &info) == 1 && info.length == n && info.mux_id == 7;
+    
+    /* Both decoders inflate and decode the frame inside */
+    for (int decoder = 0; ok && decoder < 2; decoder++) {
+        respb_parser_t parser;
+        respb_parser_init(&parser, wire, n);
+        parser.inflate_buf = inflate;
+        parser.inflate_cap = sizeof(inflate);
+        int result = decoder ? respb_parse_command_table(&parser, &parsed)
+                             : respb_parse_command(&parser, &parsed);
+        ok = result == 1 && parser.pos == n && parsed.opcode == RESPB_OP_MODULE &&
+             parsed.mux_id == 7 && parsed.argc == 3 && parsed.args[2].len == sizeof(value) &&
+             memcmp(parsed.args[2].data, value, sizeof(value)) == 0;
+    }
+    
+    /* Under the threshold or incompressible: the plain frame */
+    cmd.args[2].data = random_value;
+    raw = respb_serialize_command(plain, sizeof(plain), &cmd);
+    n = respb_serialize_compressed(&c, wire, sizeof(wire), &cmd, 0);
+    ok = ok && n == raw && memcmp(wire, plain, raw) == 0;
+    cmd.args[2].data = value;
+    cmd.args[2].len = 512;
+    raw = respb_serialize_command(plain, sizeof(plain), &cmd);
+    n = respb_serialize_compressed(&c, wire, sizeof(wire), &cmd, 0);
+    ok = ok && n == raw && memcmp(wire, plain, raw) == 0;
+    respb_compressor_free(&c);
+    if (!ok) {
+        FAIL("Compressed frame round trip failed");
+        return;
+    }
+    PASS();
+}
+
+void test_compressed_frame_errors() {
+    TEST("Compressed frames need an inflate buffer, whole input and one matching frame");
+    static uint8_t value[2048], wire[4096], inflate[4096], nested[4096];
+    fill_test_value(value, sizeof(value), 0);
+    respb_compressor_t c;
+    respb_compressor_init(&c, 0, 1);
+    respb_command_t cmd, parsed;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_SET;
+    cmd.mux_id = 3;
+    cmd.argc = 2;
+    cmd.args[0].data = (const uint8_t *)"key";
+    cmd.args[0].len = 3;
+    cmd.args[1].data = value;
+    cmd.args[1].len = sizeof(value);
+    size_t n = respb_serialize_compressed(&c, wire, sizeof(wire), &cmd, 0);
+    int ok = n > RESPB_COMPRESSED_HEADER_SIZE && respb_read_u16(wire) == RESPB_OP_COMPRESSED;
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, wire, n);
+    ok = ok && respb_parse_command(&parser, &parsed) == -1;   /* No inflate buffer */
+    parser.inflate_buf = inflate;
+    parser.inflate_cap = 100;
+    parser.pos = 0;
+    ok = ok && respb_parse_command(&parser, &parsed) == -1;   /* Too small */
+    parser.inflate_cap = sizeof(inflate);
+    for (size_t len = 0; ok && len < n; len += 97) {
+        parser.buffer_len = len;
+        parser.pos = 0;
+        ok = respb_parse_command(&parser, &parsed) == 0 && parser.pos == 0;
+    }
+    
+    /* Outer mux_id differs from the inner frame's */
+    wire[3] ^= 1;
+    parser.buffer_len = n;
+    parser.pos = 0;
+    ok = ok && respb_parse_command(&parser, &parsed) == -1;
+    wire[3] ^= 1;
+    
+    /* A compressed frame inside a compressed frame, as one literal run */
+    size_t m = respb_serialize_header(nested, RESPB_OP_COMPRESSED, 3) + 8;
+    size_t block = m;
+    nested[m++] = 0xF0;
+    for (size_t rest = n - 15; ; rest -= 255) {
+        nested[m++] = rest < 255 ? (uint8_t)rest : 255;
+        if (rest < 255) break;
+    }
+    memcpy(nested + m, wire, n);
+    m += n;
+    respb_write_u32(nested + 4, (uint32_t)n);
+    respb_write_u32(nested + 8, (uint32_t)(m - block));
+    respb_parser_init(&parser, nested, m);
+    parser.inflate_buf = inflate;
+    parser.inflate_cap = sizeof(inflate);
+    ok = ok && respb_lz4_decompress(nested + block, m - block, inflate, n) == 1 &&
+         respb_parse_command(&parser, &parsed) == -1;
+    respb_compressor_free(&c);
+    if (!ok) {
+        FAIL("Unexpected result on a bad compressed frame");
+        return;
+    }
+    PASS();
+}
+
+
+// Key Dictionary Tests
+
+void test_keydict_bind_find() {
+    TEST("Key dictionary binds, finds, rebinds and rejects out-of-range IDs");
+    respb_keydict_t d;
+    if (!respb_keydict_init(&d, 64, 4096)) {
+        FAIL("Failed to allocate key dictionary");
+        return;
+    }
+    char key[32];
+    int ok = respb_keydict_find(&d, (const uint8_t *)"k0", 2) == -1;
+    for (uint32_t id = 0; ok && id < 64; id++) {
+        int len = snprintf(key, sizeof(key), "user:%u", id * 31);
+        ok = respb_keydict_bind(&d, id, (const uint8_t *)key, (size_t)len) == 1;
+    }
+    ok = ok && d.count == 64 && respb_keydict_bind(&d, 64, (const uint8_t *)"x", 1) == -1;
+    
+    /* Rebinding the same key is a no-op; a new key drops the old one from
+     * the index without losing keys that probed past it */
+    size_t used = d.bytes_used;
+    ok = ok && respb_keydict_bind(&d, 5, (const uint8_t *)"user:155", 8) == 1 && d.bytes_used == used;
+    for (uint32_t id = 0; ok && id < 64; id += 3) {
+        int len = snprintf(key, sizeof(key), "renamed:%u", id);
+        ok = respb_keydict_bind(&d, id, (const uint8_t *)key, (size_t)len) == 1;
+    }
+    for (uint32_t id = 0; ok && id < 64; id++) {
+        int len = id % 3 ? snprintf(key, sizeof(key), "user:%u", id * 31)
+                         : snprintf(key, sizeof(key), "renamed:%u", id);
+        respb_arg_t arg;
+        ok = respb_keydict_find(&d, (const uint8_t *)key, (size_t)len) == (int)id &&
+             respb_keydict_get(&d, id, &arg) == 1 && arg.len == (size_t)len &&
+             memcmp(arg.data, key, (size_t)len) == 0;
+    }
+    ok = ok && d.count == 64 && respb_keydict_find(&d, (const uint8_t *)"user:0", 6) == -1;
+    
+    /* Key bytes are bounded; reset unbinds everything */
+    respb_arg_t arg;
+    static uint8_t big[4096];
+    ok = ok && respb_keydict_bind(&d, 1, big, sizeof(big)) == -1;
+    respb_keydict_reset(&d);
+    ok = ok && d.count == 0 && respb_keydict_get(&d, 0, &arg) == 0 &&
+         respb_keydict_find(&d, (const uint8_t *)"renamed:0", 9) == -1;
+    respb_keydict_free(&d);
+    if (!ok) {
+        FAIL("Key dictionary bookkeeping failed");
+        return;
+    }
+    PASS();
+}
+
+void test_keydict_reclaim() {
+    TEST("Key dictionary reclaims the bytes of replaced keys");
+    respb_keydict_t d;
+    if (!respb_keydict_init(&d, 8, 64)) {
+        FAIL("Failed to allocate key dictionary");
+        return;
+    }
+    char key[32];
+    int ok = 1;
+    for (uint32_t id = 0; ok && id < 4; id++) {
+        snprintf(key, sizeof(key), "key:%012u", id);
+        ok = respb_keydict_bind(&d, id, (const uint8_t *)key, 16) == 1;
+    }
+    
+    /* The buffer is full of live keys, yet rebinding goes on well past it */
+    for (uint32_t round = 0; ok && round < 1000; round++) {
+        snprintf(key, sizeof(key), "key:%012u", 100 + round);
+        ok = respb_keydict_bind(&d, 1 + round % 2, (const uint8_t *)key, 16) == 1 &&
+             d.bytes_used <= 64 && d.count == 4;
+    }
+    for (uint32_t id = 0; ok && id < 4; id++) {
+        uint32_t n = id == 1 ? 1098 : id == 2 ? 1099 : id;
+        snprintf(key, sizeof(key), "key:%012u", n);
+        respb_arg_t arg;
+        ok = respb_keydict_find(&d, (const uint8_t *)key, 16) == (int)id &&
+             respb_keydict_get(&d, id, &arg) == 1 && arg.len == 16 &&
+             memcmp(arg.data, key, 16) == 0;
+    }
+    ok = ok && respb_keydict_find(&d, (const uint8_t *)"key:000000000100", 16) == -1;
+    
+    /* Only the live keys count against the limit */
+    ok = ok && respb_keydict_bind(&d, 4, (const uint8_t *)"x", 1) == -1 &&
+         respb_keydict_bind(&d, 3, (const uint8_t *)"key:000000000003-overflow", 25) == -1 &&
+         respb_keydict_bind(&d, 3, (const uint8_t *)"short", 5) == 1 &&
+         respb_keydict_bind(&d, 4, (const uint8_t *)"x", 1) == 1 &&
+         respb_keydict_find(&d, (const uint8_t *)"short", 5) == 3 &&
+         respb_keydict_find(&d, (const uint8_t *)"key:000000000000", 16) == 0;
+    respb_keydict_free(&d);
+    if (!ok) {
+        FAIL("Replaced key bytes were not reclaimed");
+        return;
+    }
+    PASS();
+}
+
+void test_keydict_round_trip() {
+    TEST("Bound keys go out as 2-byte IDs and parse back to the key");
+    respb_keydict_t sender, receiver;
+    if (!respb_keydict_init(&sender, 16, 1024) || !respb_keydict_init(&receiver, 16, 1024)) {
+        FAIL("Failed to allocate key dictionaries");
+        return;
+    }
+    static const char key[] = "real:geo:1020770485687275522";
+    uint8_t wire[512], plain[256];
+    respb_command_t cmd, parsed;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_MSET;
+    cmd.mux_id = 9;
+    cmd.argc = 4;
+    cmd.args[0].data = (const uint8_t *)key;
+    cmd.args[0].len = 28;
+    cmd.args[1].data = (const uint8_t *)"v1";
+    cmd.args[1].len = 2;
+    cmd.args[2].data = (const uint8_t *)"other";
+    cmd.args[2].len = 5;
+    cmd.args[3].data = (const uint8_t *)"v2";
+    cmd.args[3].len = 2;
+    size_t raw = respb_serialize_command(plain, sizeof(plain), &cmd);
+    
+    /* Unbound: the same bytes as the plain frame */
+    size_t n = respb_serialize_command_dict(wire, sizeof(wire), &cmd, &sender);
+    int ok = raw > 0 && n == raw && memcmp(wire, plain, raw) == 0;
+    
+    /* A bind frame, then the command with the key as a reference */
+    size_t bind = respb_serialize_key_bind(wire, sizeof(wire), 9, 7, (const uint8_t *)key, 28);
+    ok = ok && bind == 8 + 28 && respb_keydict_bind(&sender, 7, (const uint8_t *)key, 28) == 1;
+    n = respb_serialize_command_dict(wire + bind, sizeof(wire) - bind, &cmd, &sender);
+    ok = ok && n == raw - 28 + 2;
+    
+    respb_parser_t parser;
+    respb_parser_init(&parser, wire, bind + n);
+    parser.flags = RESPB_FLAG_KEYDICT;
+    parser.keydict = &receiver;
+    ok = ok && respb_parse_command(&parser, &parsed) == 1 && parsed.opcode == RESPB_OP_KEY_BIND &&
+         parsed.argc == 1 && parsed.args[0].len == 28 && receiver.count == 1 &&
+         respb_parse_command(&parser, &parsed) == 1 && parser.pos == bind + n &&
+         parsed.opcode == RESPB_OP_MSET && parsed.mux_id == 9 && parsed.argc == 4;
+    for (size_t i = 0; ok && i < 4; i++) {
+        ok = parsed.args[i].len == cmd.args[i].len &&
+             memcmp(parsed.args[i].data, cmd.args[i].data, cmd.args[i].len) == 0;
+    }
+    ok = ok && parsed.args[0].data != wire + bind;  /* Resolved from the dictionary */
+    respb_keydict_free(&sender);
+    respb_keydict_free(&receiver);
+    if (!ok) {
+        FAIL("Key reference round trip failed");
+        return;
+    }
+    PASS();
+}
+
+void test_keydict_varint_views() {
+    TEST("VARINT and KEYDICT frames fill the typed view");
+    respb_keydict_t sender, receiver;
+    if (!respb_keydict_init(&sender, 16, 1024) || !respb_keydict_init(&receiver, 16, 1024)) {
+        FAIL("Failed to allocate key dictionaries");
+        return;
+    }
+    uint8_t wire[256];
+    respb_command_t cmd, parsed;
+    respb_parser_t parser;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.args[0].data = (const uint8_t *)"session:42";
+    cmd.args[0].len = 10;
+    cmd.argc = 1;
+    
+    /* VARINT: EXPIRE seconds and flags, ZRANGEBYSCORE bounds */
+    cmd.opcode = RESPB_OP_EXPIRE;
+    cmd.view.expire.time = 60;
+    cmd.view.expire.flags = 0x02;
+    size_t n = respb_serialize_command_flags(wire, sizeof(wire), &cmd, RESPB_FLAG_VARINT);
+    respb_parser_init(&parser, wire, n);
+    parser.flags = RESPB_FLAG_VARINT;
+    memset(&parsed.view, 0xA5, sizeof(parsed.view));
+    int ok = n > 0 && respb_parse_command(&parser, &parsed) == 1 &&
+             parsed.view.expire.time == 60 && parsed.view.expire.flags == 0x02;
+    cmd.opcode = RESPB_OP_ZRANGEBYSCORE;
+    cmd.view.score_range.min = -1.0;
+    cmd.view.score_range.max = 10.5;
+    cmd.view.score_range.flags = 0x01;
+    n = respb_serialize_command_flags(wire, sizeof(wire), &cmd, RESPB_FLAG_VARINT);
+    respb_parser_init(&parser, wire, n);
+    parser.flags = RESPB_FLAG_VARINT;
+    ok = ok && n > 0 && respb_parse_command(&parser, &parsed) == 1 &&
+         parsed.view.score_range.min == -1.0 && parsed.view.score_range.max == 10.5 &&
+         parsed.view.score_range.flags == 0x01;
+    
+    /* KEYDICT: GETEX with and without its flag-gated expiry */
+    size_t bind = respb_serialize_key_bind(wire, sizeof(wire), 0, 3, cmd.args[0].data, 10);
+    ok = ok && respb_keydict_bind(&sender, 3, cmd.args[0].data, 10) == 1;
+    cmd.opcode = RESPB_OP_GETEX;
+    cmd.view.set.flags = 0x01;
+    cmd.view.set.expiry = 5000;
+    n = respb_serialize_command_dict(wire + bind, sizeof(wire) - bind, &cmd, &sender);
+    respb_parser_init(&parser, wire, bind + n);
+    parser.flags = RESPB_FLAG_KEYDICT;
+    parser.keydict = &receiver;
+    memset(&parsed.view, 0xA5, sizeof(parsed.view));
+    ok = ok && n == 4 + 4 + 1 + 8 && respb_parse_command(&parser, &parsed) == 1 &&
+         respb_parse_command(&parser, &parsed) == 1 && parsed.opcode == RESPB_OP_GETEX &&
+         parsed.args[0].len == 10 && parsed.view.set.flags == 0x01 &&
+         parsed.view.set.expiry == 5000;
+    cmd.view.set.flags = 0x00;
+    n = respb_serialize_command_dict(wire, sizeof(wire), &cmd, &sender);
+    respb_parser_init(&parser, wire, n);
+    parser.flags = RESPB_FLAG_KEYDICT;
+    parser.keydict = &receiver;
+    memset(&parsed.view, 0xA5, sizeof(parsed.view));
+    ok = ok && n == 4 + 4 + 1 && respb_parse_command(&parser, &parsed) == 1 &&
+         parsed.view.set.flags == 0x00 && parsed.view.set.expiry == 0;
+    respb_keydict_free(&sender);
+    respb_keydict_free(&receiver);
+    if (!ok) {
+        FAIL("Wrong view from the table decoder");
+        return;
+    }
+    PASS();
+}
+
+void test_keydict_scores() {
+    TEST("ZADD scores and GEOADD coordinates survive member references and varints");
+    respb_keydict_t sender, receiver;
+    if (!respb_keydict_init(&sender, 16, 1024) || !respb_keydict_init(&receiver, 16, 1024)) {
+        FAIL("Failed to allocate key dictionaries");
+        return;
+    }
+    uint8_t data[256], wire[256];
+    size_t len = build_header(data, RESPB_OP_ZADD, 0);
+    len += add_string_2b(data + len, "board");
+    data[len++] = 0x00;  // flags
+    data[len++] = 0x00;
+    data[len++] = 0x02;  // count
+    len += add_f64(data + len, 1.5);
+    len += add_string_2b(data + len, "alice");
+    len += add_f64(data + len, -2.25);
+    len += add_string_2b(data + len, "bob");
+    size_t geo = len;
+    len += build_header(data + len, RESPB_OP_GEOADD, 0);
+    len += add_string_2b(data + len, "places");
+    data[len++] = 0x00;  // flags
+    data[len++] = 0x00;
+    data[len++] = 0x02;  // count
+    len += add_f64(data + len, 13.361389);
+    len += add_f64(data + len, 38.115556);
+    len += add_string_2b(data + len, "alice");
+    len += add_f64(data + len, -0.1276);
+    len += add_f64(data + len, 51.5072);
+    len += add_string_2b(data + len, "bob");
+    
+    respb_parser_t parser;
+    respb_command_t zadd, geoadd, parsed;
+    respb_parser_init(&parser, data, len);
+    int ok = respb_parse_command(&parser, &zadd) == 1 && respb_parse_command(&parser, &geoadd) == 1 &&
+             parser.pos == len;
+    
+    /* "alice" goes out as a 2-byte reference, so the score no longer sits
+     * a fixed distance before the member's bytes */
+    size_t bind = respb_serialize_key_bind(wire, sizeof(wire), 0, 5, (const uint8_t *)"alice", 5);
+    ok = ok && respb_keydict_bind(&sender, 5, (const uint8_t *)"alice", 5) == 1;
+    size_t n = respb_serialize_command_dict(wire + bind, sizeof(wire) - bind, &zadd, &sender);
+    respb_parser_init(&parser, wire, bind + n);
+    parser.flags = RESPB_FLAG_KEYDICT;
+    parser.keydict = &receiver;
+    ok = ok && n == geo - 5 + 2 && respb_parse_command(&parser, &parsed) == 1 &&
+         respb_parse_command(&parser, &parsed) == 1 && parsed.argc == 3 &&
+         parsed.view.zadd.count == 2 && parsed.args[1].len == 5 &&
+         respb_zadd_score(&parsed, 0) == 1.5 && respb_zadd_score(&parsed, 1) == -2.25;
+    n = respb_serialize_command_dict(wire, sizeof(wire), &geoadd, &sender);
+    respb_parser_init(&parser, wire, n);
+    parser.flags = RESPB_FLAG_KEYDICT;
+    parser.keydict = &receiver;
+    double lon, lat;
+    ok = ok && n > 0 && respb_parse_command(&parser, &parsed) == 1 && parsed.argc == 3;
+    respb_geoadd_coords(&parsed, 0, &lon, &lat);
+    ok = ok && lon == 13.361389 && lat == 38.115556;
+    respb_geoadd_coords(&parsed, 1, &lon, &lat);
+    ok = ok && lon == -0.1276 && lat == 51.5072;
+    
+    /* Varint member lengths move the numbers too */
+    n = respb_serialize_command_flags(wire, sizeof(wire), &zadd, RESPB_FLAG_VARINT);
+    respb_parser_init(&parser, wire, n);
+    parser.flags = RESPB_FLAG_VARINT;
+    ok = ok && n > 0 && respb_parse_command(&parser, &parsed) == 1 &&
+         respb_zadd_score(&parsed, 0) == 1.5 && respb_zadd_score(&parsed, 1) == -2.25;
+    n = respb_serialize_command_flags(wire, sizeof(wire), &geoadd, RESPB_FLAG_VARINT);
+    respb_parser_init(&parser, wire, n);
+    parser.flags = RESPB_FLAG_VARINT;
+    ok = ok && n > 0 && respb_parse_command(&parser, &parsed) == 1;
+    respb_geoadd_coords(&parsed, 1, &lon, &lat);
+    ok = ok && lon == -0.1276 && lat == 51.5072;
+    respb_keydict_free(&sender);
+    respb_keydict_free(&receiver);
+    if (!ok) {
+        FAIL("Wrong numbers after a reference or varint");
+        return;
+    }
+    PASS();
+}
+
+void test_keydict_errors() {
+    TEST("Unbound IDs, binds without a dictionary and VARINT with KEYDICT are rejected");
+    respb_keydict_t d;
+    if (!respb_keydict_init(&d, 16, 1024)) {
+        FAIL("Failed to allocate key dictionary");
+        return;
+    }
+    uint8_t wire[128], bind_frame[64];
+    respb_command_t cmd, parsed;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_GET;
+    cmd.argc = 1;
+    cmd.args[0].data = (const uint8_t *)"counter";
+    cmd.args[0].len = 7;
+    respb_keydict_bind(&d, 3, (const uint8_t *)"counter", 7);
+    size_t n = respb_serialize_command_dict(wire, sizeof(wire), &cmd, &d);
+    size_t bind = respb_serialize_key_bind(bind_frame, sizeof(bind_frame), 0, 3,
+                                           (const uint8_t *)"counter", 7);
+    
+    /* The receiver never saw the bind */
+    respb_keydict_reset(&d);
+    respb_parser_t parser;
+    respb_parser_init(&parser, wire, n);
+    parser.flags = RESPB_FLAG_KEYDICT;
+    parser.keydict = &d;
+    int ok = n == 8 && respb_parse_command(&parser, &parsed) == -1;
+    
+    /* Truncated frames wait for more input */
+    for (size_t len = 0; ok && len < n; len++) {
+        respb_parser_init(&parser, wire, len);
+        parser.flags = RESPB_FLAG_KEYDICT;
+        parser.keydict = &d;
+        ok = respb_parse_command(&parser, &parsed) == 0 && parser.pos == 0;
+    }
+    for (size_t len = 0; ok && len < bind; len++) {
+        respb_parser_init(&parser, bind_frame, len);
+        parser.flags = RESPB_FLAG_KEYDICT;
+        parser.keydict = &d;
+        ok = respb_parse_command(&parser, &parsed) == 0 && d.count == 0;
+    }
+    
+    /* A bind needs the flag and a dictionary; VARINT excludes KEYDICT */
+    respb_parser_init(&parser, bind_frame, bind);
+    parser.keydict = &d;
+    ok = ok && respb_parse_command_table(&parser, &parsed) == -1;
+    respb_parser_init(&parser, bind_frame, bind);
+    parser.flags = RESPB_FLAG_KEYDICT;
+    ok = ok && respb_parse_command(&parser, &parsed) == -1;
+    respb_parser_init(&parser, wire, n);
+    parser.flags = RESPB_FLAG_KEYDICT | RESPB_FLAG_VARINT;
+    parser.keydict = &d;
+    ok = ok && respb_parse_command(&parser, &parsed) == -1;
+    respb_keydict_free(&d);
+    if (!ok) {
+        FAIL("Unexpected result on a bad key reference");
+        return;
+    }
+    PASS();
+}
+
+
+// Handshake Tests
+
+void test_detect_protocol() {
+    TEST("Protocol detection from the first bytes of a connection");
+    static const uint8_t hello[] = {RESPB_MAGIC_0, RESPB_MAGIC_1, RESPB_VERSION, 0x00};
+    static const uint8_t bad_magic[] = {RESPB_MAGIC_0, 'x'};
+    int ok = respb_detect_protocol(hello, 0) == RESPB_PROTO_UNKNOWN &&
+             respb_detect_protocol(hello, 1) == RESPB_PROTO_UNKNOWN &&
+             respb_detect_protocol(hello, 2) == RESPB_PROTO_RESPB &&
+             respb_detect_protocol((const uint8_t *)"*1\r\n$4\r\nPING\r\n", 1) == RESPB_PROTO_RESP &&
+             respb_detect_protocol((const uint8_t *)"PING\r\n", 6) == RESPB_PROTO_RESP &&
+             respb_detect_protocol(bad_magic, 2) == RESPB_PROTO_INVALID;
+    if (!ok) {
+        FAIL("Wrong protocol detected");
+        return;
+    }
+    PASS();
+}
+
+void test_handshake_upgrade() {
+    TEST("Handshake upgrades whole or split hellos and negotiates flags");
+    uint8_t wire[64], reply[64], flags = 0;
+    respb_command_t cmd, parsed;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_GET;
+    cmd.argc = 1;
+    cmd.args[0].data = (const uint8_t *)"key";
+    cmd.args[0].len = 3;
+    size_t n = respb_write_handshake(wire, RESPB_VERSION, RESPB_FLAG_VARINT | RESPB_FLAG_COMPRESS);
+    n += respb_serialize_command_flags(wire + n, sizeof(wire) - n, &cmd, RESPB_FLAG_VARINT);
+    
+    /* Whole hello and command in one read; the server lacks compression */
+    respb_handshake_t hs;
+    size_t consumed, reply_len;
+    respb_handshake_init(&hs, RESPB_FLAG_VARINT);
+    int ok = respb_handshake_feed(&hs, wire, n, &consumed, reply, &reply_len) == 1 &&
+             hs.state == RESPB_HS_RESPB && consumed == RESPB_HANDSHAKE_SIZE &&
+             hs.flags == RESPB_FLAG_VARINT && reply_len == RESPB_HANDSHAKE_SIZE &&
+             respb_read_handshake_ack(reply, reply_len - 1, &flags) == 0 &&
+             respb_read_handshake_ack(reply, reply_len, &flags) == 1 && flags == RESPB_FLAG_VARINT;
+    respb_parser_t parser;
+    respb_parser_init(&parser, wire + consumed, n - consumed);
+    respb_handshake_apply(&hs, &parser);
+    ok = ok && respb_parse_command(&parser, &parsed) == 1 && parsed.opcode == RESPB_OP_GET &&
+         parser.pos == n - consumed;
+    
+    /* One byte per read */
+    respb_handshake_init(&hs, RESPB_FLAGS_SUPPORTED);
+    size_t pos = 0;
+    for (int result = 0; ok && result == 0; pos += consumed) {
+        result = respb_handshake_feed(&hs, wire + pos, 1, &consumed, reply, &reply_len);
+        ok = result == 1 ? pos + consumed == RESPB_HANDSHAKE_SIZE : result == 0 && consumed == 1;
+    }
+    ok = ok && hs.flags == (RESPB_FLAG_VARINT | RESPB_FLAG_COMPRESS) &&
+         respb_handshake_feed(&hs, wire + pos, n - pos, &consumed, reply, &reply_len) == 1 &&
+         consumed == 0 && reply_len == 0;
+    
+    /* RESP consumes nothing and gets no reply */
+    static const char resp[] = "*1\r\n$4\r\nPING\r\n";
+    respb_handshake_init(&hs, RESPB_FLAGS_SUPPORTED);
+    ok = ok && respb_handshake_feed(&hs, wire, 0, &consumed, reply, &reply_len) == 0 &&
+         respb_handshake_feed(&hs, (const uint8_t *)resp, sizeof(resp) - 1, &consumed,
+                              reply, &reply_len) == 1 &&
+         hs.state == RESPB_HS_RESP && consumed == 0 && reply_len == 0;
+    respb_handshake_apply(&hs, &parser);
+    ok = ok && parser.flags == 0;
+    if (!ok) {
+        FAIL("Handshake upgrade failed");
+        return;
+    }
+    PASS();
+}
+
+void test_handshake_refused() {
+    TEST("Bad magic, versions and flags are refused with a RESP error");
+    static const uint8_t hellos[][RESPB_HANDSHAKE_SIZE] = {
+        {RESPB_MAGIC_0, 'x', RESPB_VERSION, 0x00},
+        {RESPB_MAGIC_0, RESPB_MAGIC_1, 0x02, 0x00},
+        {RESPB_MAGIC_0, RESPB_MAGIC_1, RESPB_VERSION, 0x80},
+        {RESPB_MAGIC_0, RESPB_MAGIC_1, RESPB_VERSION, RESPB_FLAG_VARINT | RESPB_FLAG_KEYDICT},
+        {RESPB_MAGIC_0, RESPB_MAGIC_1, RESPB_VERSION, RESPB_FLAG_KEYDICT},
+    };
+    uint8_t reply[64], flags;
+    size_t consumed, reply_len;
+    int ok = 1;
+    for (size_t i = 0; ok && i < sizeof(hellos) / sizeof(hellos[0]); i++) {
+        /* Offered flags lack KEYDICT, which the client already encodes with */
+        for (size_t split = 1; ok && split <= RESPB_HANDSHAKE_SIZE; split += 3) {
+            respb_handshake_t hs;
+            respb_handshake_init(&hs, RESPB_FLAG_VARINT | RESPB_FLAG_COMPRESS);
+            int result = respb_handshake_feed(&hs, hellos[i], split, &consumed, reply, &reply_len);
+            if (result == 0) {
+                result = respb_handshake_feed(&hs, hellos[i] + split, RESPB_HANDSHAKE_SIZE - split,
+                                              &consumed, reply, &reply_len);
+            }
+            ok = result == -1 && hs.state == RESPB_HS_FAILED &&
+                 reply_len == strlen(RESPB_HANDSHAKE_ERROR) &&
+                 memcmp(reply, RESPB_HANDSHAKE_ERROR, reply_len) == 0 &&
+                 respb_read_handshake_ack(reply, reply_len, &flags) == -1 &&
+                 respb_handshake_feed(&hs, hellos[i], 0, &consumed, reply, &reply_len) == -1;
+        }
+    }
+    if (!ok) {
+        FAIL("Bad handshake accepted");
+        return;
+    }
+    PASS();
+}
+
+
+// Transcoder Tests
+
+/* Transcode one RESP command held in text */
+static size_t transcode_text(const char *text, uint8_t *buf, size_t buf_len, int *passthrough) {
+    respb_arg_t argv[RESPB_MAX_ARGS];
+    size_t pos = 0, argc;
+    if (respb_resp_parse((const uint8_t *)text, strlen(text), &pos, argv, RESPB_MAX_ARGS, &argc) != 1) {
+        return 0;
+    }
+    return respb_transcode_command(buf, buf_len, 0, argv, argc, (const uint8_t *)text, pos,
+                                   passthrough);
+}
+
+void test_transcode_commands() {
+    TEST("RESP commands transcode to their RESPB layout or to passthrough");
+    uint8_t buf[2048];
+    respb_command_t parsed;
+    respb_parser_t parser;
+    int passthrough;
+    
+    /* SET options become the flags byte and expiry */
+    size_t n = transcode_text("*6\r\n$3\r\nset\r\n$1\r\nk\r\n$2\r\nvv\r\n$2\r\nnx\r\n$2\r\nEX\r\n"
+                              "$2\r\n60\r\n", buf, sizeof(buf), &passthrough);
+    respb_parser_init(&parser, buf, n);
+    int ok = n > 0 && !passthrough && respb_parse_command(&parser, &parsed) == 1 &&
+             parsed.opcode == RESPB_OP_SET && parsed.argc == 2 && parsed.args[1].len == 2 &&
+             parsed.view.set.flags == 0x05 && parsed.view.set.expiry == 60 && parser.pos == n;
+    
+    /* Numbers from their decimal text, groups sized by the arguments */
+    n = transcode_text("*3\r\n$6\r\nINCRBY\r\n$1\r\nc\r\n$2\r\n-7\r\n", buf, sizeof(buf), &passthrough);
+    respb_parser_init(&parser, buf, n);
+    ok = ok && n == 4 + 3 + 8 && !passthrough && respb_parse_command(&parser, &parsed) == 1 &&
+         parsed.opcode == RESPB_OP_INCRBY && parsed.view.incr.increment == -7;
+    n = transcode_text("*6\r\n$4\r\nHSET\r\n$1\r\nh\r\n$1\r\na\r\n$1\r\n1\r\n$1\r\nb\r\n$1\r\n2\r\n",
+                       buf, sizeof(buf), &passthrough);
+    respb_parser_init(&parser, buf, n);
+    ok = ok && !passthrough && respb_parse_command(&parser, &parsed) == 1 &&
+         parsed.opcode == RESPB_OP_HSET && parsed.argc == 5 && parsed.args[4].data[0] == '2';
+    n = transcode_text("*4\r\n$8\r\nJSON.SET\r\n$3\r\ndoc\r\n$1\r\n$\r\n$2\r\n{}\r\n",
+                       buf, sizeof(buf), &passthrough);
+    respb_parser_init(&parser, buf, n);
+    ok = ok && !passthrough && respb_parse_command(&parser, &parsed) == 1 &&
+         parsed.opcode == RESPB_OP_MODULE && parsed.module_id == RESPB_MODULE_JSON &&
+         parsed.argc == 3 && parser.pos == n;
+    
+    /* No layout for these arguments: the RESP text, unchanged */
+    static const char *const wrapped[] = {
+        "*2\r\n$7\r\nUNKNOWN\r\n$1\r\nx\r\n",
+        "*4\r\n$3\r\nSET\r\n$1\r\nk\r\n$1\r\nv\r\n$7\r\nKEEPTTL\r\n",
+        "*5\r\n$3\r\nSET\r\n$1\r\nk\r\n$1\r\nv\r\n$2\r\nNX\r\n$2\r\nXX\r\n",
+        "*3\r\n$6\r\nINCRBY\r\n$1\r\nc\r\n$2\r\n07\r\n",
+        "*5\r\n$4\r\nZADD\r\n$1\r\nz\r\n$2\r\nCH\r\n$1\r\n1\r\n$1\r\nm\r\n",
+        "*1\r\n$4\r\nMGET\r\n",
+    };
+    for (size_t i = 0; ok && i < sizeof(wrapped) / sizeof(wrapped[0]); i++) {
+        size_t len = strlen(wrapped[i]);
+        n = transcode_text(wrapped[i], buf, sizeof(buf), &passthrough);
+        ok = passthrough && n == 8 + len && respb_read_u16(buf) == RESPB_OP_RESP_PASSTHROUGH &&
+             respb_read_u32(buf + 4) == len && memcmp(buf + 8, wrapped[i], len) == 0;
+    }
+    if (!ok) {
+        FAIL("Unexpected transcoding");
+        return;
+    }
+    PASS();
+}
+
+static int transcode_collect(void *ctx, const uint8_t *data, size_t len) {
+    uint8_t **out = ctx;
+    memcpy(*out, data, len);
+    *out += len;
+    return 1;
+}
+
+static int transcode_refuse(void *ctx, const uint8_t *data, size_t len) {
+    (void)ctx;
+    (void)data;
+    (void)len;
+    return 0;
+}
+
+/* RESP text whose values look like command boundaries */
+static size_t build_tricky_aof(char *aof) {
+    static const char value[] = "x\r\n*1\r\n$4\r\nPING";
+    size_t len = 0;
+    for (int i = 0; i < 200; i++) {
+        len += (size_t)sprintf(aof + len, i % 3 ? "*3\r\n$3\r\nSET\r\n$4\r\nk%03d\r\n$%d\r\n%s\r\n"
+                                                : "*3\r\n$6\r\nAPPEND\r\n$4\r\nk%03d\r\n$%d\r\n%s\r\n",
+                               i, (int)strlen(value), value);
+    }
+    return len;
+}
+
+void test_transcode_parallel_order() {
+    TEST("Parallel transcoding matches one thread despite misleading boundaries");
+    static char aof[16384];
+    static uint8_t one[16384], many[16384];
+    size_t len = build_tricky_aof(aof);
+    uint8_t *out = one;
+    respb_transcode_stats_t stats1, stats;
+    int ok = respb_transcode_parallel((const uint8_t *)aof, len, 1, 0, transcode_collect, &out,
+                                      &stats1) == 1 && stats1.commands == 200 &&
+             stats1.passthrough == 0 && stats1.in_bytes == len &&
+             stats1.out_bytes == (size_t)(out - one);
+    
+    /* Small chunks put guesses inside values; each must be caught */
+    for (size_t chunk = 16; ok && chunk <= 4096; chunk *= 4) {
+        out = many;
+        ok = respb_transcode_parallel((const uint8_t *)aof, len, 4, chunk, transcode_collect, &out,
+                                      &stats) == 1 && stats.commands == 200 &&
+             stats.out_bytes == stats1.out_bytes && memcmp(one, many, stats.out_bytes) == 0;
+        if (ok && chunk == 16) ok = stats.resplits > 0;
+    }
+    if (!ok) {
+        FAIL("Parallel output differs from the sequential output");
+        return;
+    }
+    PASS();
+}
+
+void test_transcode_errors() {
+    TEST("Transcoder reports truncated and malformed input and stopped writers");
+    static char aof[16384];
+    static uint8_t outbuf[16384];
+    size_t len = build_tricky_aof(aof);
+    uint8_t *out = outbuf;
+    respb_transcode_stats_t stats;
+    
+    /* Cut inside the last command: the error is at its start */
+    size_t last = len;
+    while (last > 0 && !(aof[last - 1] == '\n' && aof[last] == '*' && aof[last + 1] == '3' &&
+                         aof[last + 4] == '$')) {
+        last--;
+    }
+    int ok = last > 0 &&
+             respb_transcode_parallel((const uint8_t *)aof, len - 3, 2, 256, transcode_collect,
+                                      &out, &stats) == -1 && stats.error_pos == last;
+    out = outbuf;
+    ok = ok && respb_transcode_parallel((const uint8_t *)"GET k\r\n", 7, 1, 0, transcode_collect,
+                                        &out, &stats) == -1 && stats.error_pos == 0;
+    ok = ok && respb_transcode_parallel((const uint8_t *)aof, len, 2, 512, transcode_refuse, NULL,
+                                        &stats) == 0;
+    out = outbuf;
+    ok = ok && respb_transcode_parallel((const uint8_t *)"*0\r\n", 4, 1, 0, transcode_collect,
+                                        &out, &stats) == 1 && stats.commands == 0 && out == outbuf;
+    if (!ok) {
+        FAIL("Unexpected result on bad input");
+        return;
+    }
+    PASS();
+}
+
+
+// RESPB -> RESP Tests
+
+/* RESP multibulk of argv[0..argc) into out */
+static size_t format_resp(char *out, size_t argc, const char *const *argv) {
+    size_t len = (size_t)sprintf(out, "*%zu\r\n", argc);
+    for (size_t i = 0; i < argc; i++) {
+        len += (size_t)sprintf(out + len, "$%zu\r\n%s\r\n", strlen(argv[i]), argv[i]);
+    }
+    return len;
+}
+
+/* Parse the one frame in frame[0..len) with flags and write it as RESP */
+static int frame_to_resp(const uint8_t *frame, size_t len, uint8_t flags, respb_keydict_t *dict,
+                         uint8_t *out, size_t out_len, size_t *resp_len) {
+    respb_parser_t parser;
+    respb_command_t cmd;
+    respb_parser_init(&parser, frame, len);
+    parser.flags = flags;
+    parser.keydict = dict;
+    if (respb_parse_command(&parser, &cmd) != 1 || parser.pos != len) return -2;
+    return respb_to_resp(out, out_len, &cmd, flags, resp_len);
+}
+
+void test_to_resp_round_trip() {
+    TEST("RESP -> RESPB -> RESP gives back the same commands");
+    static const struct {
+        size_t argc;
+        const char *argv[10];
+    } commands[] = {
+        {6, {"SET", "k", "vv", "NX", "EX", "60"}},
+        {3, {"SET", "k", "v"}},
+        {3, {"INCRBY", "c", "-7"}},
+        {6, {"HSET", "h", "a", "1", "b", "2"}},
+        {5, {"JSON.SET", "doc", "$", "{}", "XX"}},
+        {7, {"ZADD", "z", "NX", "1.5", "m", "-2", "n"}},
+        {5, {"ZINTERSTORE", "dst", "2", "a", "b"}},
+        {6, {"EVAL", "return", "2", "k1", "k2", "a1"}},
+        {6, {"HTTL", "h", "FIELDS", "2", "a", "b"}},
+        {5, {"GEOADD", "g", "13.361389", "38.115556", "Palermo"}},
+        {4, {"EXPIRE", "k", "60", "GT"}},
+        {4, {"MGET", "a", "b", "c"}},
+        {3, {"UNKNOWN", "x", "y"}},
+    };
+    char text[512];
+    uint8_t frame[1024], out[1024], scratch[256], gathered[1024];
+    struct iovec iov[16];
+    int ok = 1;
+    for (size_t i = 0; ok && i < sizeof(commands) / sizeof(commands[0]); i++) {
+        size_t len = format_resp(text, commands[i].argc, commands[i].argv);
+        int passthrough;
+        size_t n = transcode_text(text, frame, sizeof(frame), &passthrough);
+        size_t resp_len = 0, iovcnt = 0, gathered_len = 0;
+        ok = n > 0 && passthrough == (i == sizeof(commands) / sizeof(commands[0]) - 1) &&
+             frame_to_resp(frame, n, 0, NULL, out, sizeof(out), &resp_len) == 1 &&
+             resp_len == len && memcmp(out, text, len) == 0;
+        
+        respb_parser_t parser;
+        respb_command_t cmd;
+        respb_parser_init(&parser, frame, n);
+        ok = ok && respb_parse_command(&parser, &cmd) == 1 &&
+             respb_to_resp_iov(scratch, sizeof(scratch), iov, 16, &iovcnt, &cmd, 0, &resp_len) == 1;
+        for (size_t v = 0; ok && v < iovcnt; v++) {
+            memcpy(gathered + gathered_len, iov[v].iov_base, iov[v].iov_len);
+            gathered_len += iov[v].iov_len;
+        }
+        ok = ok && gathered_len == len && resp_len == len && memcmp(gathered, text, len) == 0;
+    }
+    
+    /* Varint lengths and key references give the same text */
+    const char *mset[] = {"MSET", "k1", "v1", "k2", "v2"};
+    size_t len = format_resp(text, 5, mset);
+    respb_command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_MSET;
+    cmd.argc = 4;
+    for (size_t i = 0; i < 4; i++) {
+        cmd.args[i].data = (const uint8_t *)mset[i + 1];
+        cmd.args[i].len = 2;
+    }
+    respb_keydict_t dict;
+    size_t resp_len = 0;
+    ok = ok && respb_keydict_init(&dict, 16, 256) &&
+         respb_keydict_bind(&dict, 3, (const uint8_t *)"k2", 2) == 1;
+    size_t n = ok ? respb_serialize_command_flags(frame, sizeof(frame), &cmd, RESPB_FLAG_VARINT) : 0;
+    ok = ok && n > 0 && frame_to_resp(frame, n, RESPB_FLAG_VARINT, NULL, out, sizeof(out),
+                                      &resp_len) == 1 && resp_len == len &&
+         memcmp(out, text, len) == 0;
+    n = ok ? respb_serialize_command_dict(frame, sizeof(frame), &cmd, &dict) : 0;
+    ok = ok && n > 0 && frame_to_resp(frame, n, RESPB_FLAG_KEYDICT, &dict, out, sizeof(out),
+                                      &resp_len) == 1 && resp_len == len &&
+         memcmp(out, text, len) == 0;
+    respb_keydict_free(&dict);
+    if (!ok) {
+        FAIL("Round trip changed a command");
+        return;
+    }
+    PASS();
+}
+
+void test_to_resp_numbers() {
+    TEST("Numbers written as RESP read back to the same RESPB fields");
+    static const double scores[] = {0.1, -2.5, 3, 1e-300, 1e300, 12345.678901, -0.0,
+                                    1.0 / 3, 0.000123, 9007199254740993.0, -1e22};
+    static const int64_t increments[] = {0, -1, 9223372036854775807LL, -9223372036854775807LL - 1};
+    const respb_schema_t *zadd = respb_command_lookup("ZADD", 4);
+    const respb_schema_t *incrby = respb_command_lookup("INCRBY", 6);
+    uint8_t frame[256], again[256], out[256];
+    respb_arg_t args[2] = {{(const uint8_t *)"z", 1}, {(const uint8_t *)"m", 1}};
+    int ok = zadd && incrby;
+    
+    /* Each frame to RESP and back to RESPB again, bit for bit */
+    for (size_t i = 0; ok && i < sizeof(scores) / sizeof(scores[0]) + 4; i++) {
+        size_t n;
+        if (i < sizeof(scores) / sizeof(scores[0])) {
+            respb_num_t nums[3] = {{.u = 0}, {.u = 1}, {.f = scores[i]}};
+            n = respb_serialize_schema(frame, sizeof(frame), zadd, 0, args, 2, nums, 3);
+        } else {
+            respb_num_t nums[1] = {{.i = increments[i - sizeof(scores) / sizeof(scores[0])]}};
+            n = respb_serialize_schema(frame, sizeof(frame), incrby, 0, args, 1, nums, 1);
+        }
+        size_t resp_len;
+        int passthrough;
+        out[0] = 0;
+        ok = n > 0 && frame_to_resp(frame, n, 0, NULL, out, sizeof(out) - 1, &resp_len) == 1;
+        if (ok) out[resp_len] = '\0';
+        ok = ok && transcode_text((const char *)out, again, sizeof(again), &passthrough) == n &&
+             !passthrough && memcmp(again, frame, n) == 0;
+    }
+    
+    /* Short decimals stay short */
+    respb_num_t nums[3] = {{.u = 0}, {.u = 1}, {.f = 0.1}};
+    size_t resp_len, n = respb_serialize_schema(frame, sizeof(frame), zadd, 0, args, 2, nums, 3);
+    ok = ok && frame_to_resp(frame, n, 0, NULL, out, sizeof(out), &resp_len) == 1 &&
+         memmem(out, resp_len, "$3\r\n0.1\r\n", 9) != NULL;
+    if (!ok) {
+        FAIL("A number did not survive the round trip");
+        return;
+    }
+    PASS();
+}
+
+void test_to_resp_errors() {
+    TEST("RESPB -> RESP reports short buffers and frames without a RESP form");
+    uint8_t frame[256], out[256], scratch[64];
+    struct iovec iov[2];
+    int passthrough;
+    size_t resp_len, iovcnt;
+    size_t n = transcode_text("*6\r\n$3\r\nSET\r\n$1\r\nk\r\n$2\r\nvv\r\n$2\r\nNX\r\n$2\r\nPX\r\n"
+                              "$3\r\n100\r\n", frame, sizeof(frame), &passthrough);
+    
+    /* Every short buffer fails cleanly */
+    int ok = n > 0 && frame_to_resp(frame, n, 0, NULL, out, sizeof(out), &resp_len) == 1;
+    size_t full = resp_len;
+    for (size_t len = 0; ok && len < full; len++) {
+        ok = frame_to_resp(frame, n, 0, NULL, out, len, &resp_len) == 0;
+    }
+    
+    /* A value long enough to be referenced needs more iovecs than given */
+    static uint8_t value[4096];
+    memset(value, 'v', sizeof(value));
+    const respb_schema_t *set = respb_command_lookup("SET", 3);
+    respb_arg_t args[2] = {{(const uint8_t *)"k", 1}, {value, sizeof(value)}};
+    respb_num_t nums[2] = {{.u = 0}, {.i = 0}};
+    static uint8_t big[8192];
+    n = respb_serialize_schema(big, sizeof(big), set, 0, args, 2, nums, 2);
+    respb_parser_t parser;
+    respb_command_t cmd;
+    respb_parser_init(&parser, big, n);
+    ok = ok && respb_parse_command(&parser, &cmd) == 1 &&
+         respb_to_resp_iov(scratch, sizeof(scratch), iov, 2, &iovcnt, &cmd, 0, &resp_len) == 0;
+    
+    /* An unnamed flag bit, a subcommand, a NaN */
+    nums[0].u = 0x10;
+    args[1].len = 2;
+    n = respb_serialize_schema(frame, sizeof(frame), set, 0, args, 2, nums, 2);
+    ok = ok && n > 0 && frame_to_resp(frame, n, 0, NULL, out, sizeof(out), &resp_len) == -1;
+    const respb_schema_t *zadd = respb_command_lookup("ZADD", 4);
+    respb_num_t znums[3] = {{.u = 0}, {.u = 1}, {.f = NAN}};
+    n = respb_serialize_schema(frame, sizeof(frame), zadd, 0, args, 2, znums, 3);
+    ok = ok && n > 0 && frame_to_resp(frame, n, 0, NULL, out, sizeof(out), &resp_len) == -1;
+    uint8_t client[] = {0x03, 0x07, 0x00, 0x00, 0x01};
+    ok = ok && frame_to_resp(client, sizeof(client), 0, NULL, out, sizeof(out), &resp_len) == -1;
+    if (!ok) {
+        FAIL("Unexpected result");
+        return;
+    }
+    PASS();
+}
+
+
+// AOF Loader Tests
+
+#define AOF_TEST_COMMANDS 1000
+
+/* RESPB AOF of AOF_TEST_COMMANDS SET and INCRBY frames; sets *starts to each
+ * frame's offset */
+static size_t build_respb_aof(uint8_t *out, size_t *starts) {
+    static char aof[65536];
+    size_t len = 0;
+    for (int i = 0; i < AOF_TEST_COMMANDS; i++) {
+        len += (size_t)sprintf(aof + len, i % 7 ? "*3\r\n$3\r\nSET\r\n$5\r\nk%04d\r\n$1\r\nv\r\n"
+                                                : "*3\r\n$6\r\nINCRBY\r\n$5\r\nc%04d\r\n$1\r\n3\r\n", i);
+    }
+    uint8_t *end = out;
+    if (respb_transcode_parallel((const uint8_t *)aof, len, 1, 0, transcode_collect, &end, NULL) != 1) {
+        return 0;
+    }
+    size_t pos = 0, frame_len;
+    for (int i = 0; i < AOF_TEST_COMMANDS; i++) {
+        starts[i] = pos;
+        if (respb_frame_length(out + pos, (size_t)(end - out) - pos, &frame_len) != 1) return 0;
+        pos += frame_len;
+    }
+    return (size_t)(end - out);
+}
+
+typedef struct {
+    const uint8_t *base;
+    uint64_t log[AOF_TEST_COMMANDS];
+    size_t count;
+    size_t stop_after;      /* Refuse once this many commands were applied */
+} aof_log_t;
+
+static int aof_log_apply(void *ctx, const respb_command_t *cmds, size_t count) {
+    aof_log_t *log = ctx;
+    if (log->stop_after && log->count >= log->stop_after) return 0;
+    for (size_t i = 0; i < count && log->count < AOF_TEST_COMMANDS; i++) {
+        log->log[log->count++] = (uint64_t)cmds[i].opcode << 32 |
+                                 (uint64_t)(cmds[i].args[0].data - log->base);
+    }
+    return 1;
+}
+
+void test_aof_parallel_order() {
+    TEST("Parallel AOF load applies frames in file order");
+    static uint8_t respb[65536];
+    static size_t starts[AOF_TEST_COMMANDS];
+    static aof_log_t one, many;
+    size_t len = build_respb_aof(respb, starts);
+    respb_aof_stats_t stats;
+    one.base = many.base = respb;
+    int ok = len > 0 && respb_aof_load(respb, len, 1, aof_log_apply, &one, &stats) == 1 &&
+             stats.commands == AOF_TEST_COMMANDS && stats.bytes == len &&
+             stats.batches == (AOF_TEST_COMMANDS + RESPB_AOF_BATCH - 1) / RESPB_AOF_BATCH &&
+             (one.log[7] >> 32) == RESPB_OP_INCRBY && (one.log[8] >> 32) == RESPB_OP_SET;
+    for (int threads = 2; ok && threads <= 8; threads *= 2) {
+        many.count = 0;
+        ok = respb_aof_load(respb, len, threads, aof_log_apply, &many, &stats) == 1 &&
+             many.count == AOF_TEST_COMMANDS &&
+             memcmp(one.log, many.log, sizeof(one.log)) == 0;
+    }
+    if (!ok) {
+        FAIL("Parallel load differs from the sequential load");
+        return;
+    }
+    PASS();
+}
+
+void test_aof_bad_frames() {
+    TEST("AOF load stops at a truncated or unknown frame after applying the rest");
+    static uint8_t respb[65536], bad[65536];
+    static size_t starts[AOF_TEST_COMMANDS];
+    static aof_log_t log;
+    size_t len = build_respb_aof(respb, starts);
+    respb_aof_stats_t stats;
+    log.base = respb;
+    
+    /* Cut inside the last frame: everything before it is applied */
+    int ok = len > 0 && respb_aof_load(respb, len - 1, 4, aof_log_apply, &log, &stats) == -1 &&
+             stats.error_pos == starts[AOF_TEST_COMMANDS - 1] &&
+             stats.commands == AOF_TEST_COMMANDS - 1 && log.count == AOF_TEST_COMMANDS - 1;
+    
+    /* An unknown opcode in the middle, on one thread and on several */
+    memcpy(bad, respb, len);
+    respb_write_u16(bad + starts[300], 0x7F00);
+    for (int threads = 1; ok && threads <= 4; threads *= 4) {
+        log.base = bad;
+        log.count = 0;
+        ok = respb_aof_load(bad, len, threads, aof_log_apply, &log, &stats) == -1 &&
+             stats.error_pos == starts[300] && stats.commands == 300 && log.count == 300;
+    }
+    
+    /* Key bind frames need a connection's dictionary */
+    uint8_t bind[] = {0xF0, 0x02, 0x00, 0x00, 0x00, 0x01, 0x00, 0x01, 'k'};
+    ok = ok && respb_aof_load(bind, sizeof(bind), 1, aof_log_apply, &log, &stats) == -1 &&
+         stats.error_pos == 0 && stats.commands == 0;
+    if (!ok) {
+        FAIL("Unexpected result on a bad frame");
+        return;
+    }
+    PASS();
+}
+
+void test_aof_stop_and_empty() {
+    TEST("AOF load stops when the applier refuses and accepts an empty file");
+    static uint8_t respb[65536];
+    static size_t starts[AOF_TEST_COMMANDS];
+    static aof_log_t log;
+    size_t len = build_respb_aof(respb, starts);
+    respb_aof_stats_t stats;
+    log.base = respb;
+    log.stop_after = RESPB_AOF_BATCH;
+    int ok = len > 0 && respb_aof_load(respb, len, 4, aof_log_apply, &log, &stats) == 0 &&
+             log.count == RESPB_AOF_BATCH && stats.commands == RESPB_AOF_BATCH;
+    ok = ok && respb_aof_load(respb, 0, 4, aof_log_apply, &log, &stats) == 1 &&
+         stats.commands == 0 && stats.batches == 0;
+    ok = ok && respb_aof_load_file("/nonexistent/aof.respb", 2, aof_log_apply, &log, &stats) == 0;
+    if (!ok) {
+        FAIL("Unexpected result");
+        return;
+    }
+    PASS();
+}
+
+// Frame Index Tests
+
+void test_index_seek() {
+    TEST("Frame index seeks to every command and splits at checkpoints");
+    static uint8_t respb[65536];
+    static size_t starts[AOF_TEST_COMMANDS];
+    size_t len = build_respb_aof(respb, starts), offset;
+    respb_index_t idx;
+    respb_index_init(&idx, 64);
+    
+    /* Appended in blocks that do not line up with the checkpoints */
+    int ok = len > 0 && respb_index_append(&idx, respb, starts[100]) == 1 &&
+             respb_index_append(&idx, respb + starts[100], len - starts[100]) == 1 &&
+             idx.commands == AOF_TEST_COMMANDS && idx.bytes == len && idx.npoints == 16 &&
+             idx.points[15].ordinal == 960 && idx.points[15].offset == starts[960];
+    for (uint64_t i = 0; ok && i < AOF_TEST_COMMANDS; i++) {
+        ok = respb_index_seek(&idx, respb, len, i, &offset) == 1 && offset == starts[i];
+    }
+    ok = ok && respb_index_seek(&idx, respb, len, AOF_TEST_COMMANDS, &offset) == 0;
+    
+    /* Every 7th command is an INCRBY */
+    ok = ok && respb_index_count(&idx, RESPB_OP_INCRBY, 0, idx.npoints) == 143 &&
+         respb_index_count(&idx, RESPB_OP_SET, 0, idx.npoints) == 857 &&
+         respb_index_count(&idx, RESPB_OP_INCRBY, 0, 1) == 10;
+    
+    uint64_t cuts[5];
+    size_t n = respb_index_split(&idx, 4, cuts);
+    ok = ok && n == 4 && cuts[0] == 0 && cuts[4] == len;
+    for (size_t i = 1; ok && i < n; i++) {
+        size_t j = 0;
+        while (j < idx.npoints && idx.points[j].offset != cuts[i]) j++;
+        ok = cuts[i] > cuts[i - 1] && j < idx.npoints && cuts[i] <= len / 4 * i &&
+             cuts[i] + len / 8 > len / 4 * i;
+    }
+    respb_index_free(&idx);
+    if (!ok) {
+        FAIL("Wrong offset, count or split");
+        return;
+    }
+    PASS();
+}
+
+void test_index_save_load() {
+    TEST("Frame index survives save and load, and appends resume after a load");
+    static uint8_t respb[65536];
+    static size_t starts[AOF_TEST_COMMANDS];
+    size_t len = build_respb_aof(respb, starts), offset;
+    const char *whole_path = "/tmp/respb_test_whole.idx", *resumed_path = "/tmp/respb_test_resumed.idx";
+    respb_index_t whole, part;
+    respb_index_init(&whole, 100);
+    respb_index_init(&part, 100);
+    
+    /* Saved mid-interval, loaded, then extended: same file as in one go */
+    int ok = len > 0 && respb_index_append(&whole, respb, len) == 1 &&
+             respb_index_save(&whole, whole_path) == 1 &&
+             respb_index_append(&part, respb, starts[550]) == 1 &&
+             respb_index_save(&part, resumed_path) == 1;
+    respb_index_free(&part);
+    ok = ok && respb_index_load(&part, resumed_path) == 1 && part.commands == 550 &&
+         part.npoints == 6 && respb_index_count(&part, RESPB_OP_INCRBY, 5, 6) == 7 &&
+         respb_index_append(&part, respb + starts[550], len - starts[550]) == 1 &&
+         respb_index_save(&part, resumed_path) == 1;
+    
+    FILE *a = fopen(whole_path, "rb"), *b = fopen(resumed_path, "rb");
+    static uint8_t bytes_a[8192], bytes_b[8192];
+    size_t na = a ? fread(bytes_a, 1, sizeof(bytes_a), a) : 0;
+    size_t nb = b ? fread(bytes_b, 1, sizeof(bytes_b), b) : 0;
+    if (a) fclose(a);
+    if (b) fclose(b);
+    ok = ok && na > 40 && na == nb && memcmp(bytes_a, bytes_b, na) == 0;
+    
+    respb_index_free(&part);
+    ok = ok && respb_index_load(&part, whole_path) == 1 && part.interval == 100 &&
+         respb_index_seek(&part, respb, len, 777, &offset) == 1 && offset == starts[777];
+    respb_index_free(&whole);
+    respb_index_free(&part);
+    remove(whole_path);
+    remove(resumed_path);
+    if (!ok) {
+        FAIL("Loaded index differs");
+        return;
+    }
+    PASS();
+}
+
+void test_index_errors() {
+    TEST("Frame index rejects bad frames and corrupt index files");
+    static uint8_t respb[65536];
+    static size_t starts[AOF_TEST_COMMANDS];
+    size_t len = build_respb_aof(respb, starts), offset;
+    const char *path = "/tmp/respb_test_bad.idx";
+    respb_index_t idx;
+    respb_index_init(&idx, 0);
+    
+    /* A frame cut short, and an unknown opcode */
+    int ok = len > 0 && idx.interval == RESPB_INDEX_DEFAULT_INTERVAL &&
+             respb_index_append(&idx, respb, starts[10] + 3) == -1 && idx.commands == 10;
+    respb_index_free(&idx);
+    respb_write_u16(respb + starts[20], 0x7F00);
+    ok = ok && respb_index_append(&idx, respb, len) == -1 && idx.commands == 20 &&
+         respb_index_seek(&idx, respb, len, 19, &offset) == 1 &&
+         respb_index_seek(&idx, respb, len, 21, &offset) == -1;
+
+    /* Flip a count: the histogram no longer adds up */
+    static uint8_t bytes[8192];
+    ok = ok && respb_index_save(&idx, path) == 1;
+    FILE *f = fopen(path, "rb");
+    size_t n = f ? fread(bytes, 1, sizeof(bytes), f) : 0;
+    if (f) fclose(f);
+    if (n > 0) {
+        bytes[n - 1] ^= 1;
+        f = fopen(path, "wb");
+        if (f) {
+            fwrite(bytes, 1, n, f);
+            fclose(f);
+        }
+    }
+    ok = ok && n == 40 + 20 + 2 * 6 && respb_index_load(&idx, path) == -1 && idx.npoints == 0;
+    f = fopen(path, "wb");
+    if (f) {
+        fwrite("RESPBIDX", 1, 8, f);
+        fclose(f);
+    }
+    ok = ok && respb_index_load(&idx, path) == -1 &&
+         respb_index_load(&idx, "/nonexistent/respb.idx") == 0;
+    respb_index_free(&idx);
+    remove(path);
+    if (!ok) {
+        FAIL("Bad input accepted");
+        return;
+    }
+    PASS();
+}
+
+// AOF Compaction Tests
+
+/* RESPB frames for the RESP commands texts[0..n) */
+static size_t compact_frames(const char *const *texts, size_t n, uint8_t *out) {
+    size_t len = 0;
+    int passthrough;
+    for (size_t i = 0; i < n; i++) {
+        size_t frame_len = transcode_text(texts[i], out + len, 4096, &passthrough);
+        if (frame_len == 0) return 0;
+        len += frame_len;
+    }
+    return len;
+}
+
+/* Keyspace model replaying the commands the compaction tests generate */
+#define MODEL_KEYS 6
+typedef struct {
+    int type;               /* 0 missing, 1 string, 2 hash */
+    char value[256];
+    int64_t ttl;            /* -1 for none */
+} model_key_t;
+
+typedef struct {
+    model_key_t keys[2][MODEL_KEYS];
+    uint16_t db;
+} model_t;
+
+static model_key_t *model_key(model_t *m, const respb_arg_t *key) {
+    return key->len == 1 && key->data[0] >= 'a' && key->data[0] < 'a' + MODEL_KEYS
+        ? &m->keys[m->db][key->data[0] - 'a'] : NULL;
+}
+
+static int model_replay(model_t *m, const uint8_t *data, size_t len) {
+    respb_parser_t parser;
+    respb_command_t cmd;
+    memset(m, 0, sizeof(*m));
+    for (int d = 0; d < 2; d++) {
+        for (int k = 0; k < MODEL_KEYS; k++) m->keys[d][k].ttl = -1;
+    }
+    respb_parser_init(&parser, data, len);
+    while (parser.pos < len) {
+        if (respb_parse_command(&parser, &cmd) != 1) return 0;
+        model_key_t *k = cmd.argc > 0 ? model_key(m, &cmd.args[0]) : NULL;
+        switch (cmd.opcode) {
+            case RESPB_OP_SELECT:
+                m->db = respb_read_u16(cmd.raw_payload);
+                break;
+            case RESPB_OP_SET:
+                if ((cmd.view.set.flags & 0x01) && k->type) break;
+                if ((cmd.view.set.flags & 0x02) && !k->type) break;
+                k->type = 1;
+                snprintf(k->value, sizeof(k->value), "%.*s", (int)cmd.args[1].len,
+                         (const char *)cmd.args[1].data);
+                k->ttl = cmd.view.set.flags & 0x04 ? cmd.view.set.expiry : -1;
+                break;
+            case RESPB_OP_DEL:
+                for (size_t i = 0; i < cmd.argc; i++) {
+                    model_key_t *d = model_key(m, &cmd.args[i]);
+                    d->type = 0;
+                    d->value[0] = 0;
+                    d->ttl = -1;
+                }
+                break;
+            case RESPB_OP_EXPIRE:
+                if (k->type) k->ttl = cmd.view.expire.time;
+                break;
+            case RESPB_OP_INCRBY:
+                if (k->type == 2) break;
+                snprintf(k->value, sizeof(k->value), "%lld",
+                         (long long)((k->type ? atoll(k->value) : 0) + cmd.view.incr.increment));
+                k->type = 1;
+                break;
+            case RESPB_OP_HSET:
+                if (k->type == 1) break;
+                k->type = 2;
+                if (strlen(k->value) < 200) {
+                    strncat(k->value, (const char *)cmd.args[1].data, cmd.args[1].len);
+                }
+                break;
+            case RESPB_OP_RENAME: {
+                model_key_t *dst = model_key(m, &cmd.args[1]);
+                if (!k->type || k == dst) break;
+                *dst = *k;
+                k->type = 0;
+                k->value[0] = 0;
+                k->ttl = -1;
+                break;
+            }
+            case RESPB_OP_MULTI:
+            case RESPB_OP_EXEC:
+                break;
+            default:
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* Same keys, values and TTLs; bytes past a value's end may differ */
+static int model_equal(const model_t *a, const model_t *b) {
+    for (int d = 0; d < 2; d++) {
+        for (int k = 0; k < MODEL_KEYS; k++) {
+            const model_key_t *x = &a->keys[d][k], *y = &b->keys[d][k];
+            if (x->type != y->type || x->ttl != y->ttl || strcmp(x->value, y->value) != 0) return 0;
+        }
+    }
+    return 1;
+}
+
+static int compact_collect(void *ctx, const uint8_t *data, size_t len) {
+    uint8_t **out = ctx;
+    memcpy(*out, data, len);
+    *out += len;
+    return 1;
+}
+
+void test_compact_equivalent() {
+    TEST("Compacted AOF replays to the same keyspace");
+    static uint8_t respb[1 << 18], compacted[1 << 18];
+    static char text[256];
+    int ok = 1;
+    for (uint32_t seed = 1; ok && seed <= 20; seed++) {
+        uint32_t r = seed;
+        size_t len = 0;
+        int passthrough;
+        for (int i = 0; ok && i < 2000; i++) {
+            r = r * 1103515245 + 12345;
+            uint32_t op = (r >> 16) % 100;
+            char key[2] = {(char)('a' + (r >> 8) % MODEL_KEYS), 0}, other[2] = {(char)('a' + (r >> 4) % MODEL_KEYS), 0};
+            char num[16];
+            snprintf(num, sizeof(num), "%u", (r >> 20) % 50 + 1);
+            const char *argv[6];
+            size_t argc;
+            /* Seeds above 10 have no fences, so everything superseded goes */
+            if (op < 30) {
+                argv[0] = "SET"; argv[1] = key; argv[2] = num; argc = 3;
+            } else if (op < 38) {
+                argv[0] = "SET"; argv[1] = key; argv[2] = "v"; argv[3] = op & 1 ? "NX" : "XX"; argc = 4;
+            } else if (op < 44) {
+                argv[0] = "SET"; argv[1] = key; argv[2] = "w"; argv[3] = "EX"; argv[4] = num; argc = 5;
+            } else if (op < 54) {
+                argv[0] = "DEL"; argv[1] = key; argv[2] = other; argc = op & 1 ? 3 : 2;
+            } else if (op < 64) {
+                argv[0] = "EXPIRE"; argv[1] = key; argv[2] = num; argc = 3;
+            } else if (op < 76) {
+                argv[0] = "INCRBY"; argv[1] = key; argv[2] = num; argc = 3;
+            } else if (op < 84) {
+                argv[0] = "HSET"; argv[1] = key; argv[2] = num; argv[3] = "x"; argc = 4;
+            } else if (op < 90) {
+                argv[0] = "SELECT"; argv[1] = op & 1 ? "1" : "0"; argc = 2;
+            } else if (op < 95) {
+                argv[0] = op & 1 ? "MULTI" : "EXEC"; argc = 1;
+            } else if (seed <= 10) {
+                argv[0] = "RENAME"; argv[1] = key; argv[2] = other; argc = 3;
+            } else {
+                argv[0] = "SET"; argv[1] = key; argv[2] = num; argc = 3;
+            }
+            format_resp(text, argc, argv);
+            size_t n = transcode_text(text, respb + len, sizeof(respb) - len, &passthrough);
+            ok = n > 0 && !passthrough;
+            len += n;
+        }
+        uint8_t *out = compacted;
+        respb_compact_stats_t stats;
+        static model_t before, after;
+        ok = ok && respb_compact(respb, len, compact_collect, &out, &stats) == 1 &&
+             stats.commands == 2000 && stats.out_bytes == (size_t)(out - compacted) &&
+             stats.out_bytes < (seed <= 10 ? len / 3 * 2 : len / 16) &&
+             model_replay(&before, respb, len) && model_replay(&after, compacted, stats.out_bytes) &&
+             model_equal(&before, &after);
+    }
+    if (!ok) {
+        FAIL("Compacted AOF replays differently");
+        return;
+    }
+    PASS();
+}
+
+void test_compact_cases() {
+    TEST("Compaction drops superseded writes and keeps those a fence reads");
+    static const char *const overwrite[] = {
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n1\r\n",
+        "*3\r\n$6\r\nINCRBY\r\n$1\r\na\r\n$1\r\n2\r\n",
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n3\r\n",
+    };
+    static const char *const fenced[] = {
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n1\r\n",
+        "*3\r\n$6\r\nRENAME\r\n$1\r\na\r\n$1\r\nb\r\n",
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n2\r\n",
+    };
+    static const char *const deleted[] = {
+        "*1\r\n$5\r\nMULTI\r\n",
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n1\r\n",
+        "*3\r\n$6\r\nEXPIRE\r\n$1\r\na\r\n$2\r\n10\r\n",
+        "*1\r\n$4\r\nEXEC\r\n",
+        "*2\r\n$3\r\nDEL\r\n$1\r\na\r\n",
+    };
+    static const char *const databases[] = {
+        "*2\r\n$6\r\nSELECT\r\n$1\r\n1\r\n",
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n1\r\n",
+        "*2\r\n$6\r\nSELECT\r\n$1\r\n0\r\n",
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n2\r\n",
+        "*2\r\n$6\r\nSELECT\r\n$1\r\n1\r\n",
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n3\r\n",
+    };
+    static uint8_t in[8192], expect[8192], outbuf[8192];
+    respb_compact_stats_t stats;
+    
+    /* Only the last SET is left */
+    size_t len = compact_frames(overwrite, 3, in);
+    size_t want = compact_frames(overwrite + 2, 1, expect);
+    uint8_t *out = outbuf;
+    int ok = len > 0 && respb_compact(in, len, compact_collect, &out, &stats) == 1 &&
+             stats.kept == 1 && stats.keys == 1 && (size_t)(out - outbuf) == want &&
+             memcmp(outbuf, expect, want) == 0;
+    
+    /* RENAME reads the first SET */
+    len = compact_frames(fenced, 3, in);
+    out = outbuf;
+    ok = ok && respb_compact(in, len, compact_collect, &out, &stats) == 1 && stats.kept == 3 &&
+         stats.fences == 1 && (size_t)(out - outbuf) == len && memcmp(outbuf, in, len) == 0;
+    
+    /* Deleted before anything kept gave it a value: nothing left, the
+     * emptied MULTI/EXEC included */
+    len = compact_frames(deleted, 5, in);
+    out = outbuf;
+    ok = ok && respb_compact(in, len, compact_collect, &out, &stats) == 1 && stats.kept == 0 &&
+         out == outbuf;
+    
+    /* Keys are per database; SELECT only where the database changes */
+    len = compact_frames(databases, 6, in);
+    want = compact_frames(databases + 3, 3, expect);
+    out = outbuf;
+    ok = ok && respb_compact(in, len, compact_collect, &out, &stats) == 1 && stats.kept == 3 &&
+         stats.keys == 2 && (size_t)(out - outbuf) == want && memcmp(outbuf, expect, want) == 0;
+    if (!ok) {
+        FAIL("Unexpected output");
+        return;
+    }
+    PASS();
+}
+
+void test_compact_errors() {
+    TEST("Compaction reports bad frames and stopped writers");
+    static const char *const texts[] = {
+        "*3\r\n$3\r\nSET\r\n$1\r\na\r\n$1\r\n1\r\n",
+        "*3\r\n$3\r\nSET\r\n$1\r\nb\r\n$1\r\n2\r\n",
+    };
+    static uint8_t in[8192], outbuf[8192];
+    respb_compact_stats_t stats;
+    size_t len = compact_frames(texts, 2, in), first;
+    uint8_t *out = outbuf;
+    int ok = len > 0 && respb_frame_length(in, len, &first) == 1 &&
+             respb_compact(in, len - 1, compact_collect, &out, &stats) == -1 &&
+             stats.error_pos == first && out == outbuf;
+    
+    /* Compressed frames hold their own arguments */
+    uint8_t compressed[] = {0xF0, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x01, 0x00};
+    ok = ok && respb_compact(compressed, sizeof(compressed), compact_collect, &out, &stats) == -1 &&
+         stats.error_pos == 0;
+    ok = ok && respb_compact(in, len, transcode_refuse, NULL, &stats) == 0;
+    ok = ok && respb_compact(in, 0, compact_collect, &out, &stats) == 1 && stats.kept == 0 &&
+         out == outbuf;
+    ok = ok && respb_compact_file("/nonexistent/aof.respb", "/tmp/respb_test_out.respb", NULL,
+                                  &stats) == 0;
+    if (!ok) {
+        FAIL("Unexpected result");
+        return;
+    }
+    PASS();
+}
+
+// Scatter/Gather Serializer Tests
+
+/* Concatenate iov[0..n) into out */
+static size_t gather_iov(const struct iovec *iov, size_t n, uint8_t *out) {
+    size_t len = 0;
+    for (size_t i = 0; i < n; i++) {
+        memcpy(out + len, iov[i].iov_base, iov[i].iov_len);
+        len += iov[i].iov_len;
+    }
+    return len;
+}
+
+void test_serialize_iov_matches_copy() {
+    TEST("Scatter/gather frames match respb_serialize_command() byte for byte");
+    static uint8_t value[4096], flat[8192], gathered[8192];
+    memset(value, 'v', sizeof(value));
+    uint8_t scratch[256];
+    struct iovec iov[8];
+    size_t iovcnt;
+    respb_command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.args[0].data = (const uint8_t *)"key";
+    cmd.args[0].len = 3;
+    
+    /* SET, PUBLISH and JSON.SET with a large value: the value is borrowed */
+    static const uint16_t opcodes[] = {RESPB_OP_SET, RESPB_OP_PUBLISH, RESPB_OP_MODULE};
+    int ok = 1;
+    for (size_t i = 0; ok && i < 3; i++) {
+        cmd.opcode = opcodes[i];
+        cmd.args[1].data = (const uint8_t *)"$";  /* JSON.SET path */
+        cmd.args[1].len = 1;
+        size_t value_arg = cmd.opcode == RESPB_OP_MODULE ? 2 : 1;
+        cmd.argc = value_arg + 1;
+        cmd.args[value_arg].data = value;
+        cmd.args[value_arg].len = sizeof(value);
+        size_t flat_len = respb_serialize_command(flat, sizeof(flat), &cmd);
+        size_t len = respb_serialize_iov(scratch, sizeof(scratch), iov, 8, &iovcnt, &cmd);
+        ok = flat_len > 0 && len == flat_len && gather_iov(iov, iovcnt, gathered) == len &&
+             memcmp(gathered, flat, len) == 0 && iovcnt >= 2 && iov[1].iov_base == value;
+    }
+    
+    /* Small values stay in scratch: one iovec */
+    cmd.opcode = RESPB_OP_SET;
+    cmd.argc = 2;
+    cmd.args[1].len = 16;
+    size_t flat_len = respb_serialize_command(flat, sizeof(flat), &cmd);
+    ok = ok && respb_serialize_iov(scratch, sizeof(scratch), iov, 8, &iovcnt, &cmd) == flat_len &&
+         iovcnt == 1 && memcmp(iov[0].iov_base, flat, flat_len) == 0;
+    if (!ok) {
+        FAIL("Gathered frame differs");
+        return;
+    }
+    PASS();
+}
+
+void test_serialize_iov_limits() {
+    TEST("Scatter/gather serializer reports short scratch and iovec arrays");
+    static uint8_t value[1024];
+    uint8_t scratch[64];
+    struct iovec iov[4];
+    size_t iovcnt = 0;
+    respb_command_t cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.opcode = RESPB_OP_MSET;
+    cmd.argc = 4;
+    for (size_t i = 0; i < 4; i++) {
+        cmd.args[i].data = value;
+        cmd.args[i].len = i % 2 ? sizeof(value) : 8;
+    }
+    
+    /* Two borrowed values: header+key, value, key, value */
+    int ok = respb_serialize_iov(scratch, sizeof(scratch), iov, 4, &iovcnt, &cmd) ==
+                 4 + 2 + 2 * (2 + 8 + 4 + sizeof(value)) && iovcnt == 4;
+    ok = ok && respb_serialize_iov(scratch, sizeof(scratch), iov, 3, &iovcnt, &cmd) == 0;
+    ok = ok && respb_serialize_iov(scratch, 12, iov, 4, &iovcnt, &cmd) == 0;
+    
+    /* Passthrough RESP text is referenced, not copied */
+    cmd.opcode = RESPB_OP_RESP_PASSTHROUGH;
+    cmd.resp_data = (const uint8_t *)"*1\r\n$4\r\nPING\r\n";
+    cmd.resp_length = 14;
+    ok = ok && respb_serialize_iov(scratch, sizeof(scratch), iov, 4, &iovcnt, &cmd) == 22 &&
+         iovcnt == 2 && iov[1].iov_base == (void *)cmd.resp_data;
+    if (!ok) {
+        FAIL("Wrong iovec layout");
+        return;
+    }
+    PASS();
+}
+
+
+// Module Registry Tests
+static const respb_field_t registry_fields[] = {
+    {RESPB_FIELD_STR2, 0},      /* key */
+    {RESPB_FIELD_U8, 0},        /* flags */
+    {RESPB_FIELD_OPT, 0x01},
+    {RESPB_FIELD_I64, 0},       /* ttl, if flags & 0x01 */
+    {RESPB_FIELD_GROUP, 1},     /* count */
+    {RESPB_FIELD_STR4, 0},      /* value */
+};
+
+static const respb_schema_t registry_schemas[] = {
+    {"TEST.PUT", 0x01000005, registry_fields, 6, RESPB_SCHEMA_MODULE},
+    {"TEST.GET", 0x01000000, registry_fields, 1, RESPB_SCHEMA_MODULE},
+};
+
+void test_register_module_decodes() {
+    TEST("Registered module commands decode in every decoder");
+    uint8_t data[128];
+    size_t len = build_header(data, RESPB_OP_MODULE, 4);
+    respb_write_u32(data + len, 0x01000005);
+    len += 4;
+    len += add_string_2b(data + len, "k");
+    data[len++] = 0x01;
+    respb_write_u64(data + len, 60);
+    len += 8;
+    respb_write_u16(data + len, 2);
+    len += 2;
+    len += add_string_4b(data + len, "v1");
+    len += add_string_4b(data + len, "v2");
+    
+    int ok = respb_register_module(0x0100, registry_schemas, 2) == 1 &&
+             respb_schema_lookup_module(0x0100, 0x0005) == &registry_schemas[0] &&
+             respb_schema_lookup_module(0x0100, 0x0000) == &registry_schemas[1] &&
+             respb_schema_lookup_module(0x0100, 0x0001) == NULL;
+    
+    respb_parser_t parser;
+    respb_command_t cmd;
+    respb_parser_init(&parser, data, len);
+    ok = ok && respb_parse_command(&parser, &cmd) == 1 && parser.pos == len &&
+         cmd.argc == 3 && cmd.module_id == 0x0100 && cmd.command_id == 0x0005 &&
+         cmd.args[2].len == 2 && memcmp(cmd.args[2].data, "v2", 2) == 0;
+    respb_parser_init(&parser, data, len);
+    ok = ok && respb_parse_command_table(&parser, &cmd) == 1 && parser.pos == len &&
+         cmd.argc == 3;
+    size_t frame_len;
+    ok = ok && respb_frame_length(data, len, &frame_len) == 1 && frame_len == len;
+    
+    /* Unregistered again: the frame is an unknown module command */
+    ok = ok && respb_register_module(0x0100, NULL, 0) == 1 &&
+         respb_schema_lookup_module(0x0100, 0x0005) == NULL;
+    respb_parser_init(&parser, data, len);
+    ok = ok && respb_parse_command(&parser, &cmd) == -1;
+    if (!ok) {
+        FAIL("Registered command decoded wrongly");
+        return;
+    }
+    PASS();
+}
+
+void test_register_module_rejects_bad_schemas() {
+    TEST("Module registration rejects malformed descriptors");
+    static const respb_field_t bad_kind[] = {{RESPB_FIELD_KIND_COUNT, 0}};
+    static const respb_field_t group_past_end[] = {{RESPB_FIELD_GROUP, 2}, {RESPB_FIELD_STR2, 0}};
+    static const respb_field_t nested_group[] = {
+        {RESPB_FIELD_GROUP, 2}, {RESPB_FIELD_GROUP, 1}, {RESPB_FIELD_STR2, 0}};
+    static const respb_field_t opt_last[] = {{RESPB_FIELD_U8, 0}, {RESPB_FIELD_OPT, 1}};
+    static const respb_field_t opt_out_of_group[] = {
+        {RESPB_FIELD_U8, 0}, {RESPB_FIELD_GROUP, 1}, {RESPB_FIELD_OPT, 1}, {RESPB_FIELD_STR2, 0}};
+    const respb_schema_t bad[] = {
+        {"BAD", 0x01000000, bad_kind, 1, 0},
+        {"BAD", 0x01000000, group_past_end, 2, 0},
+        {"BAD", 0x01000000, nested_group, 3, 0},
+        {"BAD", 0x01000000, opt_last, 2, 0},
+        {"BAD", 0x01000000, opt_out_of_group, 4, 0},
+        {"BAD", 0x02000000, registry_fields, 1, 0},  /* Wrong module_id */
+    };
+    int ok = respb_register_module(0x0100, registry_schemas, 2) == 1;
+    for (size_t i = 0; ok && i < sizeof(bad) / sizeof(bad[0]); i++) {
+        ok = respb_register_module(0x0100, &bad[i], 1) == -1;
+    }
+    const respb_schema_t duplicate[] = {registry_schemas[1], registry_schemas[1]};
+    ok = ok && respb_register_module(0x0100, duplicate, 2) == -1;
+    
+    /* Failed registrations leave the module as it was */
+    ok = ok && respb_schema_lookup_module(0x0100, 0x0005) == &registry_schemas[0];
+    respb_register_module(0x0100, NULL, 0);
+    if (!ok) {
+        FAIL("Bad descriptor accepted");
+        return;
+    }
+    PASS();
+}
+
+void test_replace_generated_module() {
+    TEST("Unknown module commands fail; generated modules can be replaced");
+    uint8_t data[64];
+    size_t len = build_header(data, RESPB_OP_MODULE, 0);
+    respb_write_u32(data + len, 0x00010000);  /* BF.ADD */
+    len += 4;
+    len += add_string_2b(data + len, "bf");
+    len += add_string_2b(data + len, "item");
+    
+    /* Undefined BF command: no key-only guess that would desync the stream */
+    respb_parser_t parser;
+    respb_command_t cmd;
+    respb_write_u32(data + 4, 0x000100FF);
+    respb_parser_init(&parser, data, len);
+    int ok = respb_parse_command(&parser, &cmd) == -1;
+    respb_write_u32(data + 4, 0x00010000);
+    
+    /* Register BF.ADD as key-only: the switch decoder must follow */
+    const respb_schema_t key_only = {"BF.ADD", 0x00010000, registry_fields, 1, 0};
+    ok = ok && respb_register_module(RESPB_MODULE_BF, &key_only, 1) == 1;
+    respb_parser_init(&parser, data, len);
+    ok = ok && respb_parse_command(&parser, &cmd) == 1 && cmd.argc == 1 && parser.pos == 12;
+    
+    /* Restore the generated BF schemas (contiguous in respb_schemas[]) */
+    size_t first = 0, count = 0;
+    for (size_t i = 0; i < respb_schema_count; i++) {
+        if ((respb_schemas[i].flags & RESPB_SCHEMA_MODULE) &&
+            (respb_schemas[i].code >> 16) == RESPB_MODULE_BF) {
+            if (count++ == 0) first = i;
+        }
+    }
+    ok = ok && respb_register_module(RESPB_MODULE_BF, &respb_schemas[first], count) == 1;
+    respb_parser_init(&parser, data, len);
+    ok = ok && respb_parse_command(&parser, &cmd) == 1 && cmd.argc == 2 && parser.pos == len;
+    if (!ok) {
+        FAIL("Wrong module dispatch");
+        return;
+    }
+    PASS();
+}
+
+// Command Name Tests
+
+void test_command_lookup_names() {
+    TEST("Every command name resolves in any case; opcodes map back to names");
+    char name[64];
+    for (size_t i = 0; i < respb_schema_count; i++) {
+        const respb_schema_t *schema = &respb_schemas[i];
+        size_t len = strlen(schema->name);
+        if (respb_command_lookup(schema->name, len) != schema) {
+            FAIL(schema->name);
+            return;
+        }
+        /* lower case, then alternating case */
+        for (int pass = 0; pass < 2; pass++) {
+            for (size_t j = 0; j < len; j++) {
+                int lower = pass == 0 || (j & 1);
+                name[j] = lower ? (char)tolower((uint8_t)schema->name[j]) : schema->name[j];
+            }
+            if (respb_command_lookup(name, len) != schema) {
+                FAIL(schema->name);
+                return;
+            }
+        }
+        if (!(schema->flags & RESPB_SCHEMA_MODULE) &&
+            strcmp(respb_opcode_name((uint16_t)schema->code), schema->name) != 0) {
+            FAIL("Opcode name mismatch");
+            return;
+        }
+    }
+    PASS();
+}
+
+void test_command_lookup_misses() {
+    TEST("Unknown, truncated and extended command names miss");
+    static const char embedded_nul[] = {'G', 'E', 'T', '\0', 'X'};
+    int ok = respb_command_lookup("GETX", 4) == NULL;
+    ok = ok && respb_command_lookup("GE", 2) == NULL;
+    ok = ok && respb_command_lookup("", 0) == NULL;
+    ok = ok && respb_command_lookup("CLIENT KILL", 11) == NULL;
+    ok = ok && respb_command_lookup("JSON.SETX", 9) == NULL;
+    ok = ok && respb_command_lookup(embedded_nul, sizeof(embedded_nul)) == NULL;
+    /* Length, not the terminator, bounds the name */
+    const respb_schema_t *get = respb_command_lookup("GETDEL", 3);
+    ok = ok && get && get->code == RESPB_OP_GET;
+    if (!ok) {
+        FAIL("Bogus name resolved");
+        return;
+    }
+    PASS();
+}
+
+
 int main() {
     printf("\n");
     printf("=========================================================\n");
@@ -6281,6 +9944,133 @@ int main() {
     test_respb_error_truncated();
     test_respb_error_unknown_opcode();
     
+    printf("\nTable-Driven Decoder (5):\n");
+    test_table_matches_switch();
+    test_table_zadd_full_decode();
+    test_table_gated_expiry();
+    test_table_truncated_and_unknown();
+    test_schema_lookup_coverage();
+    
+    printf("\nBatch Parser (2):\n");
+    test_batch_struct_of_arrays();
+    test_batch_limits();
+    
+    printf("\nStreaming Parser (3):\n");
+    test_stream_byte_by_byte();
+    test_stream_chunk_sizes();
+    test_stream_split_views();
+    
+    printf("\nArgument Arena (3):\n");
+    test_switch_consumes_past_max_args();
+    test_compact_large_mset();
+    test_compact_inline_and_growth();
+    
+    printf("\nArgument Iterator (3):\n");
+    test_iter_typed_fields();
+    test_iter_first_key_and_finish();
+    test_iter_truncated_and_unknown();
+    
+    printf("\nTyped Views (3):\n");
+    test_view_set_incrby_expire();
+    test_view_scores();
+    test_switch_matches_table_all_schemas();
+    
+    printf("\nFrame Scanner (3):\n");
+    test_frame_peek_matches_decoder();
+    test_frame_truncated_and_unknown();
+    test_frame_flags();
+    
+    printf("\nZero-copy RESP (3):\n");
+    test_resp_borrowed_matches_valkey();
+    test_resp_borrowed_partial_and_errors();
+    test_parse_passthrough_frame();
+    
+    printf("\nSchema Serializer (4):\n");
+    test_schema_encode_all_schemas();
+    test_serialize_command_any_opcode();
+    test_schema_encode_rejects();
+    test_serialize_view_numbers();
+    
+    printf("\nSerialized Size (2):\n");
+    test_serialized_size_exact();
+    test_serialized_size_batch();
+    
+    printf("\nPipeline Builder (3):\n");
+    test_pipeline_append_and_flush();
+    test_pipeline_partial_writes();
+    test_pipeline_rejects_unencodable();
+    
+    printf("\nReply Codec (3):\n");
+    test_reply_round_trip();
+    test_reply_matches_resp();
+    test_reply_partial_and_malformed();
+    
+    printf("\nhiredis Reader (2):\n");
+    test_hiredis_reader_matches_nodes();
+    test_hiredis_reader_allocations();
+    
+    printf("\nVarint Lengths (4):\n");
+    test_varint_helpers();
+    test_varint_command_round_trip();
+    test_varint_truncated_and_malformed();
+    test_varint_fixed_width_decoders();
+    
+    printf("\nFrame Compression (3):\n");
+    test_lz4_round_trip();
+    test_compressed_frame_round_trip();
+    test_compressed_frame_errors();
+    
+    printf("\nKey Dictionary (6):\n");
+    test_keydict_bind_find();
+    test_keydict_reclaim();
+    test_keydict_round_trip();
+    test_keydict_varint_views();
+    test_keydict_scores();
+    test_keydict_errors();
+    
+    printf("\nHandshake (3):\n");
+    test_detect_protocol();
+    test_handshake_upgrade();
+    test_handshake_refused();
+    
+    printf("\nTranscoder (3):\n");
+    test_transcode_commands();
+    test_transcode_parallel_order();
+    test_transcode_errors();
+    
+    printf("\nRESPB -> RESP (3):\n");
+    test_to_resp_round_trip();
+    test_to_resp_numbers();
+    test_to_resp_errors();
+    
+    printf("\nAOF Loader (3):\n");
+    test_aof_parallel_order();
+    test_aof_bad_frames();
+    test_aof_stop_and_empty();
+    
+    printf("\nFrame Index (3):\n");
+    test_index_seek();
+    test_index_save_load();
+    test_index_errors();
+    
+    printf("\nAOF Compaction (3):\n");
+    test_compact_equivalent();
+    test_compact_cases();
+    test_compact_errors();
+    
+    printf("\nScatter/Gather Serializer (2):\n");
+    test_serialize_iov_matches_copy();
+    test_serialize_iov_limits();
+    
+    printf("\nModule Registry (3):\n");
+    test_register_module_decodes();
+    test_register_module_rejects_bad_schemas();
+    test_replace_generated_module();
+    
+    printf("\nCommand Names (2):\n");
+    test_command_lookup_names();
+    test_command_lookup_misses();
+    
     printf("\nSerialization (1):\n");
     test_serialization_roundtrip();
     
@@ -6297,4 +10087,3 @@ int main() {
     
     return tests_failed > 0 ? 1 : 0;
 }
-
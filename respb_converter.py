@@ -19,6 +19,11 @@ from enum import Enum
 MODULE_OPCODE = 0xF000
 RESP_PASSTHROUGH_OPCODE = 0xFFFF
 
+# Connection handshake: [2B magic][1B version][1B flags]
+RESPB_MAGIC = b'\xD3\xC1'
+RESPB_VERSION = 0x01
+RESPB_FLAG_VARINT = 0x01    # Lengths and counts as LEB128 varints
+
 # Module ID constants
 JSON_MODULE_ID = 0x0000
 BF_MODULE_ID = 0x0001
@@ -344,20 +349,46 @@ class RESPParser:
 class RESPBSerializer:
     """Serialize commands to RESPB binary format."""
     
-    def __init__(self, mux_id: int = 0):
+    def __init__(self, mux_id: int = 0, varint: bool = False):
         self.mux_id = mux_id
+        self.varint = varint
         load_command_opcodes()
     
+    def handshake(self) -> bytes:
+        """Encode the handshake that announces this serializer's flags."""
+        flags = RESPB_FLAG_VARINT if self.varint else 0
+        return RESPB_MAGIC + bytes([RESPB_VERSION, flags])
+    
+    @staticmethod
+    def encode_varint(value: int) -> bytes:
+        """Encode an unsigned LEB128 varint (7 bits per byte, low bits first)."""
+        out = bytearray()
+        while value >= 0x80:
+            out.append((value & 0x7F) | 0x80)
+            value >>= 7
+        out.append(value)
+        return bytes(out)
+    
+    def encode_count(self, count: int) -> bytes:
+        """Encode an element count (2 bytes, or a varint in varint mode)."""
+        if self.varint:
+            return self.encode_varint(count)
+        return struct.pack('!H', count)
+    
     def encode_header(self, opcode: int) -> bytes:
         """Encode RESPB frame header (opcode + mux_id)."""
         return struct.pack('!HH', opcode, self.mux_id)
     
     def encode_string_2b(self, data: bytes) -> bytes:
         """Encode a string with 2-byte length prefix."""
+        if self.varint:
+            return self.encode_varint(len(data)) + data
         return struct.pack('!H', len(data)) + data
     
     def encode_string_4b(self, data: bytes) -> bytes:
         """Encode a string with 4-byte length prefix."""
+        if self.varint:
+            return self.encode_varint(len(data)) + data
         return struct.pack('!I', len(data)) + data
     
     def encode_int64(self, value: int) -> bytes:
@@ -416,7 +447,7 @@ class RESPBSerializer:
         
         # Multi-key commands: MGET, DEL, EXISTS, etc.
         elif cmd in ['MGET', 'DEL', 'UNLINK', 'EXISTS', 'KEYS']:
-            frame += struct.pack('!H', len(command.args))  # count
+            frame += self.encode_count(len(command.args))  # count
             for arg in command.args:
                 frame += self.encode_string_2b(arg)
             return frame
@@ -424,7 +455,7 @@ class RESPBSerializer:
         # MSET command
         elif cmd in ['MSET', 'MSETNX']:
             num_pairs = len(command.args) // 2
-            frame += struct.pack('!H', num_pairs)
+            frame += self.encode_count(num_pairs)
             for i in range(0, len(command.args), 2):
                 if i + 1 < len(command.args):
                     frame += self.encode_string_2b(command.args[i])      # key
@@ -435,7 +466,7 @@ class RESPBSerializer:
         elif cmd in ['LPUSH', 'RPUSH', 'LPUSHX', 'RPUSHX']:
             if len(command.args) >= 2:
                 frame += self.encode_string_2b(command.args[0])  # key
-                frame += struct.pack('!H', len(command.args) - 1)  # count
+                frame += self.encode_count(len(command.args) - 1)  # count
                 for arg in command.args[1:]:
                     frame += self.encode_string_2b(arg)
             return frame
@@ -458,7 +489,7 @@ class RESPBSerializer:
         elif cmd == 'SADD':
             if len(command.args) >= 2:
                 frame += self.encode_string_2b(command.args[0])  # key
-                frame += struct.pack('!H', len(command.args) - 1)  # count
+                frame += self.encode_count(len(command.args) - 1)  # count
                 for arg in command.args[1:]:
                     frame += self.encode_string_2b(arg)
             return frame
@@ -475,7 +506,7 @@ class RESPBSerializer:
                 frame += self.encode_string_2b(command.args[0])  # key
                 frame += b'\x00'  # flags
                 num_pairs = (len(command.args) - 1) // 2
-                frame += struct.pack('!H', num_pairs)
+                frame += self.encode_count(num_pairs)
                 for i in range(1, len(command.args), 2):
                     if i + 1 < len(command.args):
                         score = float(command.args[i])
@@ -508,7 +539,7 @@ class RESPBSerializer:
             if len(command.args) >= 3:
                 frame += self.encode_string_2b(command.args[0])  # key
                 num_pairs = (len(command.args) - 1) // 2
-                frame += struct.pack('!H', num_pairs)
+                frame += self.encode_count(num_pairs)
                 for i in range(1, len(command.args), 2):
                     if i + 1 < len(command.args):
                         frame += self.encode_string_2b(command.args[i])      # field
@@ -524,7 +555,7 @@ class RESPBSerializer:
         elif cmd == 'HDEL':
             if len(command.args) >= 2:
                 frame += self.encode_string_2b(command.args[0])  # key
-                frame += struct.pack('!H', len(command.args) - 1)  # count
+                frame += self.encode_count(len(command.args) - 1)  # count
                 for arg in command.args[1:]:
                     frame += self.encode_string_2b(arg)
             return frame
@@ -537,7 +568,7 @@ class RESPBSerializer:
             return frame
         
         elif cmd in ['SUBSCRIBE', 'UNSUBSCRIBE']:
-            frame += struct.pack('!H', len(command.args))  # count
+            frame += self.encode_count(len(command.args))  # count
             for arg in command.args:
                 frame += self.encode_string_2b(arg)
             return frame
@@ -590,7 +621,7 @@ class RESPBSerializer:
             if len(command.args) >= 1:
                 frame += self.encode_string_2b(command.args[0])  # key
                 num_paths = len(command.args) - 1
-                frame += struct.pack('!H', num_paths)
+                frame += self.encode_count(num_paths)
                 for path in command.args[1:]:
                     frame += self.encode_string_2b(path)
             return frame
@@ -678,12 +709,17 @@ class RESPBSerializer:
         """Serialize using RESP passthrough opcode (0xFFFF) for unknown commands.
         
         Format: [0xFFFF][mux_id][4B resp_length][RESP text data...]
+        (a varint resp_length in varint mode)
         """
         # Generate RESP text format
         resp_data = command.to_resp_text()
         
         # 8-byte header: opcode (2B) + mux_id (2B) + resp_length (4B)
-        frame = struct.pack('!HHI', RESP_PASSTHROUGH_OPCODE, self.mux_id, len(resp_data))
+        frame = self.encode_header(RESP_PASSTHROUGH_OPCODE)
+        if self.varint:
+            frame += self.encode_varint(len(resp_data))
+        else:
+            frame += struct.pack('!I', len(resp_data))
         
         # Append raw RESP text data
         frame += resp_data
@@ -801,8 +837,12 @@ def run_demo():
     print(f"Average savings:    {(total_resp - total_respb) / len(results):.1f} bytes per command")
 
 
-def convert_aof_file(input_file, output_file):
-    """Convert AOF file from RESP to RESPB format."""
+def convert_aof_file(input_file, output_file, varint=False):
+    """Convert AOF file from RESP to RESPB format.
+    
+    With varint=True, lengths and counts are written as varints and the
+    output starts with the handshake that announces RESPB_FLAG_VARINT.
+    """
     import os
     import time
     
@@ -811,6 +851,8 @@ def convert_aof_file(input_file, output_file):
     print("=" * 70)
     print(f"Input:  {input_file}")
     print(f"Output: {output_file}")
+    if varint:
+        print("Mode:   varint lengths")
     
     # Get file size for progress tracking
     try:
@@ -824,7 +866,7 @@ def convert_aof_file(input_file, output_file):
     print()
     
     parser = RESPParser()
-    serializer = RESPBSerializer()
+    serializer = RESPBSerializer(varint=varint)
     
     total_resp = 0
     total_respb = 0
@@ -839,6 +881,9 @@ def convert_aof_file(input_file, output_file):
             buffer = b""
             chunk_size = 1024 * 1024  # Read 1MB at a time
             
+            if varint:
+                f_out.write(serializer.handshake())
+            
             while True:
                 # Read more data
                 chunk = f_in.read(chunk_size)
@@ -983,6 +1028,9 @@ Examples:
   
   # Convert AOF file
   python3 respb_converter.py -i mendeley/appendonly.aof -o mendeley/appendonly.respb
+  
+  # Convert with varint lengths (output starts with the handshake)
+  python3 respb_converter.py -i mendeley/appendonly.aof -o mendeley/appendonly.respb --varint
         """
     )
     
@@ -992,6 +1040,8 @@ Examples:
     parser.add_argument('-o', '--output',
                        help='Output RESPB binary file',
                        default=None)
+    parser.add_argument('--varint', action='store_true',
+                       help='Encode lengths and counts as varints')
     
     args = parser.parse_args()
     
@@ -999,7 +1049,7 @@ Examples:
     if args.input is None and args.output is None:
         run_demo()
     elif args.input and args.output:
-        convert_aof_file(args.input, args.output)
+        convert_aof_file(args.input, args.output, args.varint)
     else:
         parser.error("Both --input and --output are required for file conversion")
 